@@ -54,6 +54,8 @@ RTCPCompoundPacket::RTCPCompoundPacket(RTPRawPacket &rawpack, RTPMemoryManager *
 {
 	compoundpacket = 0;
 	compoundpacketlength = 0;
+	freecallback = 0;
+	freecallbackparam = 0;
 	error = 0;
 	
 	if (rawpack.IsRTP())
@@ -72,6 +74,8 @@ RTCPCompoundPacket::RTCPCompoundPacket(RTPRawPacket &rawpack, RTPMemoryManager *
 	compoundpacket = rawpack.GetData();
 	compoundpacketlength = rawpack.GetDataLength();
 	deletepacket = true;
+	freecallback = rawpack.GetDataFreeCallback();
+	freecallbackparam = rawpack.GetDataFreeCallbackParameter();
 
 	rawpack.ZeroData();
 	
@@ -82,6 +86,8 @@ RTCPCompoundPacket::RTCPCompoundPacket(uint8_t *packet, size_t packetlen, bool d
 {
 	compoundpacket = 0;
 	compoundpacketlength = 0;
+	freecallback = 0;
+	freecallbackparam = 0;
 	
 	error = ParseData(packet,packetlen);
 	if (error < 0)
@@ -98,6 +104,8 @@ RTCPCompoundPacket::RTCPCompoundPacket(RTPMemoryManager *mgr) : RTPMemoryObject(
 {
 	compoundpacket = 0;
 	compoundpacketlength = 0;
+	freecallback = 0;
+	freecallbackparam = 0;
 	error = 0;
 	deletepacket = true;
 }
@@ -201,7 +209,12 @@ RTCPCompoundPacket::~RTCPCompoundPacket()
 {
 	ClearPacketList();
 	if (compoundpacket && deletepacket)
-		RTPDeleteByteArray(compoundpacket,GetMemoryManager());
+	{
+		if (freecallback)
+			freecallback(compoundpacket,freecallbackparam);
+		else
+			RTPDeleteByteArray(compoundpacket,GetMemoryManager());
+	}
 }
 
 void RTCPCompoundPacket::ClearPacketList()
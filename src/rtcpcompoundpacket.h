@@ -41,12 +41,12 @@
 #include "rtpconfig.h"
 #include "rtptypes.h"
 #include "rtpmemoryobject.h"
+#include "rtprawpacket.h"
 #include <list>
 
 namespace jrtplib
 {
 
-class RTPRawPacket;
 class RTCPPacket;
 
 /** Represents an RTCP compound packet. */
@@ -101,6 +101,8 @@ protected:
 	uint8_t *compoundpacket;
 	size_t compoundpacketlength;
 	bool deletepacket;
+	RTPRawPacketFreeCallback freecallback;
+	void *freecallbackparam;
 	
 	std::list<RTCPPacket *> rtcppacklist;
 	std::list<RTCPPacket *>::const_iterator rtcppackit;
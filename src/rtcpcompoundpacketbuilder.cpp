@@ -60,13 +60,31 @@ RTCPCompoundPacketBuilder::RTCPCompoundPacketBuilder(RTPMemoryManager *mgr) : RT
 	buffer = 0;
 	external = false;
 	arebuilding = false;
+
+	inplace = false;
+	inplacebuffer = 0;
+	inplaceotherbuffer = 0;
+	inplacebuffersize = 0;
+	reportlength = 0;
+	otherlength = 0;
+	reportheaderoffset = 0;
+	reportblockcount = 0;
+	inplacesection = NoSection;
+	sdesheaderoffset = 0;
+	sdeschunkcount = 0;
+	sdesitembytes = 0;
+	sdeschunkopen = false;
 }
 
 RTCPCompoundPacketBuilder::~RTCPCompoundPacketBuilder()
 {
-	if (external)
-		compoundpacket = 0; // make sure RTCPCompoundPacket doesn't delete the external buffer
+	if (external || inplace)
+		compoundpacket = 0; // make sure RTCPCompoundPacket doesn't delete the external or reused buffer
 	ClearBuildBuffers();
+	if (inplacebuffer)
+		RTPDeleteByteArray(inplacebuffer,GetMemoryManager());
+	if (inplaceotherbuffer)
+		RTPDeleteByteArray(inplaceotherbuffer,GetMemoryManager());
 }
 
 void RTCPCompoundPacketBuilder::ClearBuildBuffers()
@@ -118,6 +136,7 @@ int RTCPCompoundPacketBuilder::InitBuild(size_t maxpacketsize)
 	maximumpacketsize = maxpacketsize;
 	buffer = 0;
 	external = false;
+	inplace = false;
 	byesize = 0;
 	appsize = 0;
 #ifdef RTP_SUPPORT_RTCPUNKNOWN
@@ -141,6 +160,7 @@ int RTCPCompoundPacketBuilder::InitBuild(void *externalbuffer,size_t buffersize)
 	maximumpacketsize = buffersize;
 	buffer = (uint8_t *)externalbuffer;
 	external = true;
+	inplace = false;
 	byesize = 0;
 	appsize = 0;
 #ifdef RTP_SUPPORT_RTCPUNKNOWN
@@ -151,6 +171,140 @@ int RTCPCompoundPacketBuilder::InitBuild(void *externalbuffer,size_t buffersize)
 	return 0;
 }
 
+int RTCPCompoundPacketBuilder::InitBuildInPlace(size_t maxpacketsize)
+{
+	// A previous in place build can always be replaced, even if it didn't finish
+	if (arebuilding && !inplace)
+		return ERR_RTP_RTCPCOMPPACKBUILDER_ALREADYBUILDING;
+	if (compoundpacket && !inplace)
+		return ERR_RTP_RTCPCOMPPACKBUILDER_ALREADYBUILT;
+
+	if (maxpacketsize < RTP_MINPACKETSIZE)
+		return ERR_RTP_RTCPCOMPPACKBUILDER_MAXPACKETSIZETOOSMALL;
+
+	if (inplacebuffersize < maxpacketsize)
+	{
+		if (inplacebuffer)
+			RTPDeleteByteArray(inplacebuffer,GetMemoryManager());
+		if (inplaceotherbuffer)
+			RTPDeleteByteArray(inplaceotherbuffer,GetMemoryManager());
+		inplacebuffersize = 0;
+		inplaceotherbuffer = 0;
+		
+		inplacebuffer = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPCOMPOUNDPACKET) uint8_t[maxpacketsize];
+		if (inplacebuffer == 0)
+			return ERR_RTP_OUTOFMEM;
+		inplaceotherbuffer = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPCOMPOUNDPACKET) uint8_t[maxpacketsize];
+		if (inplaceotherbuffer == 0)
+		{
+			RTPDeleteByteArray(inplacebuffer,GetMemoryManager());
+			inplacebuffer = 0;
+			return ERR_RTP_OUTOFMEM;
+		}
+		inplacebuffersize = maxpacketsize;
+	}
+
+	compoundpacket = 0;
+	compoundpacketlength = 0;
+	report.Clear();
+
+	maximumpacketsize = maxpacketsize;
+	buffer = 0;
+	external = false;
+	inplace = true;
+	reportlength = 0;
+	otherlength = 0;
+	reportheaderoffset = 0;
+	reportblockcount = 0;
+	inplacesection = NoSection;
+	sdesheaderoffset = 0;
+	sdeschunkcount = 0;
+	sdesitembytes = 0;
+	sdeschunkopen = false;
+
+	arebuilding = true;
+	return 0;
+}
+
+static inline size_t GetSDESChunkClosingBytes(size_t itembytes)
+{
+	// The item list ends with a zero byte and is padded to a 32 bit boundary
+	size_t x = itembytes+1;
+	size_t r = x%sizeof(uint32_t);
+
+	if (r != 0)
+		x += (sizeof(uint32_t)-r);
+	return x-itembytes;
+}
+
+size_t RTCPCompoundPacketBuilder::GetInPlaceLength() const
+{
+	size_t len = reportlength+otherlength;
+
+	if (sdeschunkopen)
+		len += GetSDESChunkClosingBytes(sdesitembytes);
+	return len;
+}
+
+void RTCPCompoundPacketBuilder::StartInPlaceSection(InPlaceSection section)
+{
+	if (inplacesection == SDESSection && section != SDESSection)
+		FinishInPlaceSDESPacket();
+	inplacesection = section;
+}
+
+void RTCPCompoundPacketBuilder::CloseInPlaceSDESChunk()
+{
+	if (!sdeschunkopen)
+		return;
+
+	size_t num = GetSDESChunkClosingBytes(sdesitembytes);
+
+	memset(inplaceotherbuffer+otherlength,0,num);
+	otherlength += num;
+	sdeschunkopen = false;
+}
+
+void RTCPCompoundPacketBuilder::FinishInPlaceSDESPacket()
+{
+	CloseInPlaceSDESChunk();
+	if (sdeschunkcount == 0)
+		return;
+
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)(inplaceotherbuffer+sdesheaderoffset);
+	size_t numwords = (otherlength-sdesheaderoffset)/sizeof(uint32_t);
+
+	hdr->count = sdeschunkcount;
+	hdr->length = htons((uint16_t)(numwords-1));
+	sdeschunkcount = 0;
+}
+
+void RTCPCompoundPacketBuilder::AddInPlaceReportHeader(bool isSR)
+{
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)(inplacebuffer+reportlength);
+	size_t len = (isSR)?report.headerlength:sizeof(uint32_t); // sender info, or just the SSRC
+
+	hdr->version = 2;
+	hdr->padding = 0;
+	hdr->count = 0;
+	hdr->length = 0;
+	hdr->packettype = (isSR)?RTP_RTCPTYPE_SR:RTP_RTCPTYPE_RR;
+	memcpy(inplacebuffer+reportlength+sizeof(RTCPCommonHeader),report.headerdata,len);
+
+	reportheaderoffset = reportlength;
+	reportlength += sizeof(RTCPCommonHeader)+len;
+	reportblockcount = 0;
+}
+
+void RTCPCompoundPacketBuilder::FinishInPlaceReport()
+{
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)(inplacebuffer+reportheaderoffset);
+	size_t numwords = (reportlength-reportheaderoffset)/sizeof(uint32_t);
+
+	hdr->count = reportblockcount;
+	hdr->length = htons((uint16_t)(numwords-1));
+}
+
 int RTCPCompoundPacketBuilder::StartSenderReport(uint32_t senderssrc,const RTPNTPTime &ntptimestamp,uint32_t rtptimestamp,
                                                  uint32_t packetcount,uint32_t octetcount)
 {
@@ -165,6 +319,8 @@ int RTCPCompoundPacketBuilder::StartSenderReport(uint32_t senderssrc,const RTPNT
 #else
 	size_t totalsize = byesize+appsize+unknownsize+sdes.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
+	if (inplace)
+		totalsize = GetInPlaceLength();
 	size_t sizeleft = maximumpacketsize-totalsize;
 	size_t neededsize = sizeof(RTCPCommonHeader)+sizeof(uint32_t)+sizeof(RTCPSenderReport);
 	
@@ -186,6 +342,8 @@ int RTCPCompoundPacketBuilder::StartSenderReport(uint32_t senderssrc,const RTPNT
 	sr->packetcount = htonl(packetcount);
 	sr->octetcount = htonl(octetcount);
 
+	if (inplace)
+		AddInPlaceReportHeader(true);
 	return 0;
 }
 
@@ -201,6 +359,8 @@ int RTCPCompoundPacketBuilder::StartReceiverReport(uint32_t senderssrc)
 #else
 	size_t totalsize = byesize+appsize+unknownsize+sdes.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
+	if (inplace)
+		totalsize = GetInPlaceLength();
 	size_t sizeleft = maximumpacketsize-totalsize;
 	size_t neededsize = sizeof(RTCPCommonHeader)+sizeof(uint32_t);
 	
@@ -215,6 +375,8 @@ int RTCPCompoundPacketBuilder::StartReceiverReport(uint32_t senderssrc)
 	uint32_t *ssrc = (uint32_t *)report.headerdata;
 	*ssrc = htonl(senderssrc);
 
+	if (inplace)
+		AddInPlaceReportHeader(false);
 	return 0;
 }
 
@@ -226,19 +388,42 @@ int RTCPCompoundPacketBuilder::AddReportBlock(uint32_t ssrc,uint8_t fractionlost
 	if (report.headerlength == 0)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_REPORTNOTSTARTED;
 
+	uint8_t *buf;
+
+	if (inplace)
+	{
+		// a new receiver report packet is needed after 31 report blocks
+		bool newreport = (reportblockcount == 31);
+		size_t neededsize = sizeof(RTCPReceiverReport);
+
+		if (newreport)
+			neededsize += sizeof(RTCPCommonHeader)+sizeof(uint32_t);
+		if ((GetInPlaceLength()+neededsize) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+
+		if (newreport)
+		{
+			FinishInPlaceReport();
+			AddInPlaceReportHeader(false);
+		}
+		buf = inplacebuffer+reportlength;
+	}
+	else
+	{
 #ifndef RTP_SUPPORT_RTCPUNKNOWN
-	size_t totalothersize = byesize+appsize+sdes.NeededBytes();
+		size_t totalothersize = byesize+appsize+sdes.NeededBytes();
 #else
-	size_t totalothersize = byesize+appsize+unknownsize+sdes.NeededBytes();
+		size_t totalothersize = byesize+appsize+unknownsize+sdes.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
-	size_t reportsizewithextrablock = report.NeededBytesWithExtraReportBlock();
+		size_t reportsizewithextrablock = report.NeededBytesWithExtraReportBlock();
 	
-	if ((totalothersize+reportsizewithextrablock) > maximumpacketsize)
-		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+		if ((totalothersize+reportsizewithextrablock) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
 
-	uint8_t *buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPRECEIVERREPORT) uint8_t[sizeof(RTCPReceiverReport)];
-	if (buf == 0)
-		return ERR_RTP_OUTOFMEM;
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPRECEIVERREPORT) uint8_t[sizeof(RTCPReceiverReport)];
+		if (buf == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 	
 	RTCPReceiverReport *rr = (RTCPReceiverReport *)buf;
 	uint32_t *packlost = (uint32_t *)&packetslost;
@@ -254,7 +439,13 @@ int RTCPCompoundPacketBuilder::AddReportBlock(uint32_t ssrc,uint8_t fractionlost
 	rr->lsr = htonl(lsr);
 	rr->dlsr = htonl(dlsr);
 
-	report.reportblocks.push_back(Buffer(buf,sizeof(RTCPReceiverReport)));
+	if (inplace)
+	{
+		reportlength += sizeof(RTCPReceiverReport);
+		reportblockcount++;
+	}
+	else
+		report.reportblocks.push_back(Buffer(buf,sizeof(RTCPReceiverReport)));
 	return 0;
 }
 
@@ -263,6 +454,48 @@ int RTCPCompoundPacketBuilder::AddSDESSource(uint32_t ssrc)
 	if (!arebuilding)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTBUILDING;
 
+	if (inplace)
+	{
+		if (inplacesection > SDESSection)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER;
+
+		// a new SDES packet is needed for the first chunk and after 31 chunks;
+		// the chunk itself needs at least the SSRC and four zero bytes
+		bool newpacket = (sdeschunkcount == 0 || sdeschunkcount == 31);
+		size_t neededsize = sizeof(uint32_t)*2;
+
+		if (newpacket)
+			neededsize += sizeof(RTCPCommonHeader);
+		if ((GetInPlaceLength()+neededsize) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+
+		StartInPlaceSection(SDESSection);
+		CloseInPlaceSDESChunk();
+		if (newpacket)
+		{
+			FinishInPlaceSDESPacket();
+
+			RTCPCommonHeader *hdr = (RTCPCommonHeader *)(inplaceotherbuffer+otherlength);
+
+			hdr->version = 2;
+			hdr->padding = 0;
+			hdr->count = 0;
+			hdr->length = 0;
+			hdr->packettype = RTP_RTCPTYPE_SDES;
+			sdesheaderoffset = otherlength;
+			otherlength += sizeof(RTCPCommonHeader);
+		}
+
+		uint32_t *ssrcptr = (uint32_t *)(inplaceotherbuffer+otherlength);
+
+		*ssrcptr = htonl(ssrc);
+		otherlength += sizeof(uint32_t);
+		sdeschunkcount++;
+		sdeschunkopen = true;
+		sdesitembytes = 0;
+		return 0;
+	}
+
 #ifndef RTP_SUPPORT_RTCPUNKNOWN
 	size_t totalotherbytes = byesize+appsize+report.NeededBytes();
 #else
@@ -284,7 +517,7 @@ int RTCPCompoundPacketBuilder::AddSDESNormalItem(RTCPSDESPacket::ItemType t,cons
 {
 	if (!arebuilding)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTBUILDING;
-	if (sdes.sdessources.empty())
+	if ((inplace && !sdeschunkopen) || (!inplace && sdes.sdessources.empty()))
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOCURRENTSOURCE;
 
 	uint8_t itemid;
@@ -316,23 +549,31 @@ int RTCPCompoundPacketBuilder::AddSDESNormalItem(RTCPSDESPacket::ItemType t,cons
 		return ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDITEMTYPE;
 	}
 
+	uint8_t *buf;
+	size_t len = sizeof(RTCPSDESHeader)+(size_t)itemlength;
+
+	if (inplace)
+	{
+		if ((reportlength+otherlength+len+GetSDESChunkClosingBytes(sdesitembytes+len)) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+		buf = inplaceotherbuffer+otherlength;
+	}
+	else
+	{
 #ifndef RTP_SUPPORT_RTCPUNKNOWN
-	size_t totalotherbytes = byesize+appsize+report.NeededBytes();
+		size_t totalotherbytes = byesize+appsize+report.NeededBytes();
 #else
-	size_t totalotherbytes = byesize+appsize+unknownsize+report.NeededBytes();
+		size_t totalotherbytes = byesize+appsize+unknownsize+report.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
-	size_t sdessizewithextraitem = sdes.NeededBytesWithExtraItem(itemlength);
-
-	if ((sdessizewithextraitem+totalotherbytes) > maximumpacketsize)
-		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+		size_t sdessizewithextraitem = sdes.NeededBytesWithExtraItem(itemlength);
 
-	uint8_t *buf;
-	size_t len;
+		if ((sdessizewithextraitem+totalotherbytes) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
 
-	buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPSDESBLOCK) uint8_t[sizeof(RTCPSDESHeader)+(size_t)itemlength];
-	if (buf == 0)
-		return ERR_RTP_OUTOFMEM;
-	len = sizeof(RTCPSDESHeader)+(size_t)itemlength;
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPSDESBLOCK) uint8_t[len];
+		if (buf == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 
 	RTCPSDESHeader *sdeshdr = (RTCPSDESHeader *)(buf);
 
@@ -341,7 +582,13 @@ int RTCPCompoundPacketBuilder::AddSDESNormalItem(RTCPSDESPacket::ItemType t,cons
 	if (itemlength != 0)
 		memcpy((buf + sizeof(RTCPSDESHeader)),itemdata,(size_t)itemlength);
 
-	sdes.AddItem(buf,len);
+	if (inplace)
+	{
+		otherlength += len;
+		sdesitembytes += len;
+	}
+	else
+		sdes.AddItem(buf,len);
 	return 0;
 }
 
@@ -351,30 +598,38 @@ int RTCPCompoundPacketBuilder::AddSDESPrivateItem(const void *prefixdata,uint8_t
 {
 	if (!arebuilding)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTBUILDING;
-	if (sdes.sdessources.empty())
+	if ((inplace && !sdeschunkopen) || (!inplace && sdes.sdessources.empty()))
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOCURRENTSOURCE;
 
 	size_t itemlength = ((size_t)prefixlength)+1+((size_t)valuelength);
 	if (itemlength > 255)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_TOTALITEMLENGTHTOOBIG;
 	
+	uint8_t *buf;
+	size_t len = sizeof(RTCPSDESHeader)+(size_t)itemlength;
+
+	if (inplace)
+	{
+		if ((reportlength+otherlength+len+GetSDESChunkClosingBytes(sdesitembytes+len)) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+		buf = inplaceotherbuffer+otherlength;
+	}
+	else
+	{
 #ifndef RTP_SUPPORT_RTCPUNKNOWN
-	size_t totalotherbytes = byesize+appsize+report.NeededBytes();
+		size_t totalotherbytes = byesize+appsize+report.NeededBytes();
 #else
-	size_t totalotherbytes = byesize+appsize+unknownsize+report.NeededBytes();
+		size_t totalotherbytes = byesize+appsize+unknownsize+report.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
-	size_t sdessizewithextraitem = sdes.NeededBytesWithExtraItem(itemlength);
-
-	if ((sdessizewithextraitem+totalotherbytes) > maximumpacketsize)
-		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
+		size_t sdessizewithextraitem = sdes.NeededBytesWithExtraItem(itemlength);
 
-	uint8_t *buf;
-	size_t len;
+		if ((sdessizewithextraitem+totalotherbytes) > maximumpacketsize)
+			return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
 
-	buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPSDESBLOCK) uint8_t[sizeof(RTCPSDESHeader)+itemlength];
-	if (buf == 0)
-		return ERR_RTP_OUTOFMEM;
-	len = sizeof(RTCPSDESHeader)+(size_t)itemlength;
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPSDESBLOCK) uint8_t[len];
+		if (buf == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 
 	RTCPSDESHeader *sdeshdr = (RTCPSDESHeader *)(buf);
 
@@ -387,7 +642,13 @@ int RTCPCompoundPacketBuilder::AddSDESPrivateItem(const void *prefixdata,uint8_t
 	if (valuelength != 0)
 		memcpy((buf+sizeof(RTCPSDESHeader)+1+(size_t)prefixlength),valuedata,(size_t)valuelength);
 
-	sdes.AddItem(buf,len);
+	if (inplace)
+	{
+		otherlength += len;
+		sdesitembytes += len;
+	}
+	else
+		sdes.AddItem(buf,len);
 	return 0;
 }
 #endif // RTP_SUPPORT_SDESPRIV
@@ -399,6 +660,8 @@ int RTCPCompoundPacketBuilder::AddBYEPacket(uint32_t *ssrcs,uint8_t numssrcs,con
 
 	if (numssrcs > 31)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_TOOMANYSSRCS;
+	if (inplace && inplacesection > BYESection)
+		return ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER;
 	
 	size_t packsize = sizeof(RTCPCommonHeader)+sizeof(uint32_t)*((size_t)numssrcs);
 	size_t zerobytes = 0;
@@ -422,15 +685,25 @@ int RTCPCompoundPacketBuilder::AddBYEPacket(uint32_t *ssrcs,uint8_t numssrcs,con
 	size_t totalotherbytes = appsize+unknownsize+byesize+sdes.NeededBytes()+report.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
 
+	if (inplace)
+		totalotherbytes = GetInPlaceLength();
 	if ((totalotherbytes + packsize) > maximumpacketsize)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
 
 	uint8_t *buf;
 	size_t numwords;
 	
-	buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPBYEPACKET) uint8_t[packsize];
-	if (buf == 0)
-		return ERR_RTP_OUTOFMEM;
+	if (inplace)
+	{
+		StartInPlaceSection(BYESection);
+		buf = inplaceotherbuffer+otherlength;
+	}
+	else
+	{
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPBYEPACKET) uint8_t[packsize];
+		if (buf == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 
 	RTCPCommonHeader *hdr = (RTCPCommonHeader *)buf;
 
@@ -458,8 +731,13 @@ int RTCPCompoundPacketBuilder::AddBYEPacket(uint32_t *ssrcs,uint8_t numssrcs,con
 			buf[packsize-1-i] = 0;
 	}
 
-	byepackets.push_back(Buffer(buf,packsize));
-	byesize += packsize;
+	if (inplace)
+		otherlength += packsize;
+	else
+	{
+		byepackets.push_back(Buffer(buf,packsize));
+		byesize += packsize;
+	}
 	
 	return 0;
 }
@@ -472,6 +750,8 @@ int RTCPCompoundPacketBuilder::AddAPPPacket(uint8_t subtype,uint32_t ssrc,const
 		return ERR_RTP_RTCPCOMPPACKBUILDER_ILLEGALSUBTYPE;
 	if ((appdatalen%4) != 0)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_ILLEGALAPPDATALENGTH;
+	if (inplace && inplacesection > APPSection)
+		return ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER;
 
 	size_t appdatawords = appdatalen/4;
 
@@ -485,14 +765,24 @@ int RTCPCompoundPacketBuilder::AddAPPPacket(uint8_t subtype,uint32_t ssrc,const
 	size_t totalotherbytes = appsize+unknownsize+byesize+sdes.NeededBytes()+report.NeededBytes();
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
 
+	if (inplace)
+		totalotherbytes = GetInPlaceLength();
 	if ((totalotherbytes + packsize) > maximumpacketsize)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
 
 	uint8_t *buf;
 	
-	buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPAPPPACKET) uint8_t[packsize];
-	if (buf == 0)
-		return ERR_RTP_OUTOFMEM;
+	if (inplace)
+	{
+		StartInPlaceSection(APPSection);
+		buf = inplaceotherbuffer+otherlength;
+	}
+	else
+	{
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTCPAPPPACKET) uint8_t[packsize];
+		if (buf == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 
 	RTCPCommonHeader *hdr = (RTCPCommonHeader *)buf;
 
@@ -514,8 +804,13 @@ int RTCPCompoundPacketBuilder::AddAPPPacket(uint8_t subtype,uint32_t ssrc,const
 	if (appdatalen > 0)
 		memcpy((buf+sizeof(RTCPCommonHeader)+sizeof(uint32_t)*2),appdata,appdatalen);
 
-	apppackets.push_back(Buffer(buf,packsize));
-	appsize += packsize;
+	if (inplace)
+		otherlength += packsize;
+	else
+	{
+		apppackets.push_back(Buffer(buf,packsize));
+		appsize += packsize;
+	}
 	
 	return 0;
 }
@@ -526,6 +821,8 @@ int RTCPCompoundPacketBuilder::AddUnknownPacket(uint8_t payload_type, uint8_t su
 {
 	if (!arebuilding)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTBUILDING;
+	if (inplace && inplacesection > UnknownSection)
+		return ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER;
 
 	size_t datawords = len/4;
 
@@ -535,12 +832,24 @@ int RTCPCompoundPacketBuilder::AddUnknownPacket(uint8_t payload_type, uint8_t su
 	size_t packsize = sizeof(RTCPCommonHeader)+sizeof(uint32_t)+len;
 	size_t totalotherbytes = appsize+unknownsize+byesize+sdes.NeededBytes()+report.NeededBytes();
 
+	if (inplace)
+		totalotherbytes = GetInPlaceLength();
 	if ((totalotherbytes + packsize) > maximumpacketsize)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT;
 
-	uint8_t *buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPUNKNOWNPACKET) uint8_t[packsize];
-	if (buf == 0)
-		return ERR_RTP_OUTOFMEM;
+	uint8_t *buf;
+	
+	if (inplace)
+	{
+		StartInPlaceSection(UnknownSection);
+		buf = inplaceotherbuffer+otherlength;
+	}
+	else
+	{
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPUNKNOWNPACKET) uint8_t[packsize];
+		if (buf == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 
 	RTCPCommonHeader *hdr = (RTCPCommonHeader *)buf;
 
@@ -556,8 +865,13 @@ int RTCPCompoundPacketBuilder::AddUnknownPacket(uint8_t payload_type, uint8_t su
 	if (len > 0)
 		memcpy((buf+sizeof(RTCPCommonHeader)+sizeof(uint32_t)),data,len);
 
-	unknownpackets.push_back(Buffer(buf,packsize));
-	unknownsize += packsize;
+	if (inplace)
+		otherlength += packsize;
+	else
+	{
+		unknownpackets.push_back(Buffer(buf,packsize));
+		unknownsize += packsize;
+	}
 	
 	return 0;
 }
@@ -571,6 +885,23 @@ int RTCPCompoundPacketBuilder::EndBuild()
 	if (report.headerlength == 0)
 		return ERR_RTP_RTCPCOMPPACKBUILDER_NOREPORTPRESENT;
 	
+	if (inplace)
+	{
+		// Fill in the remaining header fields and put the other packets
+		// behind the reports
+		
+		if (inplacesection == SDESSection)
+			FinishInPlaceSDESPacket();
+		FinishInPlaceReport();
+		if (otherlength > 0)
+			memcpy(inplacebuffer+reportlength,inplaceotherbuffer,otherlength);
+
+		compoundpacket = inplacebuffer;
+		compoundpacketlength = reportlength+otherlength;
+		arebuilding = false;
+		return 0;
+	}
+
 	uint8_t *buf;
 	size_t len;
 	
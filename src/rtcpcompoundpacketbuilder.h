@@ -74,6 +74,23 @@ public:
 	 *  can contain \c buffersize bytes.
 	 */
 	int InitBuild(void *externalbuffer,size_t buffersize);
+
+	/** Starts building an RTCP compound packet with maximum size \c maxpacketsize, directly in a buffer of the builder.
+	 *  Starts building an RTCP compound packet with maximum size \c maxpacketsize. Instead of storing each report
+	 *  block, SDES item or other packet separately and copying everything together in EndBuild, the data is 
+	 *  written directly into a buffer that's owned by the builder; the header fields which depend on what follows 
+	 *  are filled in when a packet is complete. The buffer is kept when the next compound packet is built by 
+	 *  calling this function again on the same instance, so once it has been allocated, building a packet this
+	 *  way doesn't need any memory allocations. This also means that the data of the previous packet is no 
+	 *  longer valid after this call.
+	 *
+	 *  When building a packet this way, the SDES information, APP packets, unknown packets and BYE packets must
+	 *  be added in this order (the report can be started and report blocks can be added at any time), 
+	 *  otherwise \c ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER is returned. Also, to avoid allocating instances
+	 *  of the separate RTCP packets, the list of individual RTCP packets is not filled in: GotoFirstPacket 
+	 *  and GetNextPacket can't be used to inspect the result.
+	 */
+	int InitBuildInPlace(size_t maxpacketsize);
 	
 	/** Adds a sender report to the compound packet.
 	 *  Tells the packet builder that the packet should start with a sender report which will contain
@@ -376,6 +393,24 @@ private:
 	uint8_t *buffer;
 	bool external;
 	bool arebuilding;
+
+	// Used by InitBuildInPlace: the report packets are written in 'inplacebuffer',
+	// the other packets in 'inplaceotherbuffer', and in EndBuild the latter part
+	// is appended to the reports
+	enum InPlaceSection { NoSection, SDESSection, APPSection, UnknownSection, BYESection };
+
+	bool inplace;
+	uint8_t *inplacebuffer;
+	uint8_t *inplaceotherbuffer;
+	size_t inplacebuffersize;
+	size_t reportlength, otherlength;
+	size_t reportheaderoffset;
+	uint8_t reportblockcount;
+	InPlaceSection inplacesection;
+	size_t sdesheaderoffset;
+	uint8_t sdeschunkcount;
+	size_t sdesitembytes;
+	bool sdeschunkopen;
 	
 	Report report;
 	SDES sdes;
@@ -392,6 +427,12 @@ private:
 #endif // RTP_SUPPORT_RTCPUNKNOWN 
 	
 	void ClearBuildBuffers();
+	size_t GetInPlaceLength() const;
+	void StartInPlaceSection(InPlaceSection section);
+	void CloseInPlaceSDESChunk();
+	void FinishInPlaceSDESPacket();
+	void AddInPlaceReportHeader(bool isSR);
+	void FinishInPlaceReport();
 };
 
 } // end namespace
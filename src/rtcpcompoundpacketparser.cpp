@@ -0,0 +1,436 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtcpcompoundpacketparser.h"
+#include "rtpstructs.h"
+#include "rtpdefines.h"
+#include "rtperrors.h"
+#ifdef RTP_SUPPORT_NETINET_IN
+	#include <netinet/in.h>
+#endif // RTP_SUPPORT_NETINET_IN
+
+#include "rtpdebug.h"
+
+namespace jrtplib
+{
+
+RTCPCompoundPacketParser::RTCPCompoundPacketParser()
+{
+	curpacket = 0;
+	curpacketlength = 0;
+}
+
+RTCPCompoundPacketParser::~RTCPCompoundPacketParser()
+{
+}
+
+int RTCPCompoundPacketParser::Validate(const uint8_t *data,size_t datalen)
+{
+	// These are the same checks as in RTCPCompoundPacket::ParseData
+
+	bool first = true;
+
+	if (datalen < sizeof(RTCPCommonHeader))
+		return ERR_RTP_RTCPCOMPOUND_INVALIDPACKET;
+
+	do
+	{
+		const RTCPCommonHeader *rtcphdr = (const RTCPCommonHeader *)data;
+		size_t length;
+
+		if (rtcphdr->version != RTP_VERSION) // check version
+			return ERR_RTP_RTCPCOMPOUND_INVALIDPACKET;
+		if (first)
+		{
+			// Check if first packet is SR or RR
+			
+			first = false;
+			if ( ! (rtcphdr->packettype == RTP_RTCPTYPE_SR || rtcphdr->packettype == RTP_RTCPTYPE_RR))
+				return ERR_RTP_RTCPCOMPOUND_INVALIDPACKET;
+		}
+
+		length = (size_t)ntohs(rtcphdr->length);
+		length++;
+		length *= sizeof(uint32_t);
+
+		if (length > datalen) // invalid length field
+			return ERR_RTP_RTCPCOMPOUND_INVALIDPACKET;
+		if (rtcphdr->padding && length != datalen) // only the last packet can be padded
+			return ERR_RTP_RTCPCOMPOUND_INVALIDPACKET;
+
+		datalen -= length;
+		data += length;
+	} while (datalen >= sizeof(RTCPCommonHeader));
+
+	if (datalen != 0) // some remaining bytes
+		return ERR_RTP_RTCPCOMPOUND_INVALIDPACKET;
+	return 0;
+}
+
+bool RTCPCompoundPacketParser::ContainsBYE(const uint8_t *data,size_t datalen)
+{
+	while (datalen >= sizeof(RTCPCommonHeader))
+	{
+		const RTCPCommonHeader *rtcphdr = (const RTCPCommonHeader *)data;
+		size_t length = ((size_t)ntohs(rtcphdr->length)+1)*sizeof(uint32_t);
+
+		if (rtcphdr->packettype == RTP_RTCPTYPE_BYE)
+			return true;
+		if (length > datalen)
+			break;
+		datalen -= length;
+		data += length;
+	}
+	return false;
+}
+
+// Returns the length of an RTCP packet without its padding, or 0 if the
+// padding is not valid
+static inline size_t GetUnpaddedLength(const uint8_t *data,size_t length)
+{
+	const RTCPCommonHeader *hdr = (const RTCPCommonHeader *)data;
+
+	if (!hdr->padding)
+		return length;
+
+	uint8_t padcount = data[length-1];
+	if ((padcount & 0x03) != 0) // not a multiple of four! (see rfc 3550 p 37)
+		return 0;
+	if (((size_t)padcount) >= length)
+		return 0;
+	return length-(size_t)padcount;
+}
+
+int RTCPCompoundPacketParser::Parse(uint8_t *data,size_t datalen)
+{
+	int status;
+
+	if ((status = Validate(data,datalen)) < 0)
+		return status;
+
+	while (datalen > 0)
+	{
+		RTCPCommonHeader *rtcphdr = (RTCPCommonHeader *)data;
+		uint8_t packettype = rtcphdr->packettype;
+		size_t length = ((size_t)ntohs(rtcphdr->length)+1)*sizeof(uint32_t);
+		size_t len = GetUnpaddedLength(data,length);
+
+		curpacket = data;
+		curpacketlength = length;
+		
+		switch (packettype)
+		{
+		case RTP_RTCPTYPE_SR:
+		case RTP_RTCPTYPE_RR:
+			status = (len == 0)?OnUnknownPacketFormat(packettype):ParseReport(data,len,(packettype == RTP_RTCPTYPE_SR));
+			break;
+		case RTP_RTCPTYPE_SDES:
+			status = (len == 0)?OnUnknownPacketFormat(packettype):ParseSDES(data,len);
+			break;
+		case RTP_RTCPTYPE_BYE:
+			status = (len == 0)?OnUnknownPacketFormat(packettype):ParseBYE(data,len);
+			break;
+		case RTP_RTCPTYPE_APP:
+			status = (len == 0)?OnUnknownPacketFormat(packettype):ParseAPP(data,len);
+			break;
+		default:
+			status = OnUnknownPacketType(packettype);
+		}
+
+		if (status < 0)
+			break;
+
+		datalen -= length;
+		data += length;
+	}
+
+	curpacket = 0;
+	curpacketlength = 0;
+	return (status < 0)?status:0;
+}
+
+int RTCPCompoundPacketParser::ParseReport(uint8_t *data,size_t len,bool issr)
+{
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)data;
+	int count = (int)hdr->count;
+	size_t expectedlength = sizeof(RTCPCommonHeader)+sizeof(uint32_t)+sizeof(RTCPReceiverReport)*(size_t)count;
+
+	if (issr)
+		expectedlength += sizeof(RTCPSenderReport);
+	if (expectedlength != len)
+		return OnUnknownPacketFormat(hdr->packettype);
+
+	uint32_t senderssrc = ntohl(*((uint32_t *)(data+sizeof(RTCPCommonHeader))));
+	uint8_t *reports = data+sizeof(RTCPCommonHeader)+sizeof(uint32_t);
+	int status;
+
+	if (issr)
+	{
+		RTCPSenderReport *sr = (RTCPSenderReport *)reports;
+
+		status = OnSenderInfo(senderssrc,RTPNTPTime(ntohl(sr->ntptime_msw),ntohl(sr->ntptime_lsw)),ntohl(sr->rtptimestamp),
+		                      ntohl(sr->packetcount),ntohl(sr->octetcount));
+		if (status < 0)
+			return status;
+		reports += sizeof(RTCPSenderReport);
+	}
+
+	for (int i = 0 ; i < count ; i++)
+	{
+		RTCPReceiverReport *rr = (RTCPReceiverReport *)(reports+sizeof(RTCPReceiverReport)*i);
+		uint32_t lost = ((uint32_t)rr->packetslost[2])|(((uint32_t)rr->packetslost[1])<<8)|(((uint32_t)rr->packetslost[0])<<16);
+
+		if ((lost&0x00800000) != 0) // test for negative number
+			lost |= 0xFF000000;
+
+		status = OnReportBlock(senderssrc,ntohl(rr->ssrc),rr->fractionlost,(int32_t)lost,ntohl(rr->exthighseqnr),
+		                       ntohl(rr->jitter),ntohl(rr->lsr),ntohl(rr->dlsr));
+		if (status < 0)
+			return status;
+	}
+	return OnEndOfReport(senderssrc);
+}
+
+// The same checks as in the RTCPSDESPacket constructor, without the padding
+static bool IsValidSDESPacket(const uint8_t *data,size_t len)
+{
+	const RTCPCommonHeader *hdr = (const RTCPCommonHeader *)data;
+
+	if (hdr->count == 0)
+		return (len == sizeof(RTCPCommonHeader));
+
+	int ssrccount = (int)(hdr->count);
+	const uint8_t *chunk;
+	size_t chunkoffset;
+
+	if (len < sizeof(RTCPCommonHeader))
+		return false;
+
+	len -= sizeof(RTCPCommonHeader);
+	chunk = data+sizeof(RTCPCommonHeader);
+
+	while ((ssrccount > 0) && (len > 0))
+	{
+		if (len < (sizeof(uint32_t)*2)) // chunk must contain at least a SSRC identifier
+			return false;            // and a (possibly empty) item
+
+		len -= sizeof(uint32_t);
+		chunkoffset = sizeof(uint32_t);
+
+		bool done = false;
+		while (!done)
+		{
+			if (len < 1) // at least a zero byte (end of item list) should be there
+				return false;
+
+			const RTCPSDESHeader *sdeshdr = (const RTCPSDESHeader *)(chunk+chunkoffset);
+			if (sdeshdr->sdesid == 0) // end of item list
+			{
+				len--;
+				chunkoffset++;
+
+				size_t r = (chunkoffset&0x03);
+				if (r != 0)
+				{
+					size_t addoffset = 4-r;
+
+					if (addoffset > len)
+						return false;
+					len -= addoffset;
+					chunkoffset += addoffset;
+				}
+				done = true;
+			}
+			else
+			{
+				if (len < sizeof(RTCPSDESHeader))
+					return false;
+
+				len -= sizeof(RTCPSDESHeader);
+				chunkoffset += sizeof(RTCPSDESHeader);
+
+				size_t itemlen = (size_t)(sdeshdr->length);
+				if (itemlen > len)
+					return false;
+
+				len -= itemlen;
+				chunkoffset += itemlen;
+			}
+		}
+
+		ssrccount--;
+		chunk += chunkoffset;
+	}
+
+	// check for remaining bytes
+	if (len > 0 || ssrccount > 0)
+		return false;
+	return true;
+}
+
+static RTCPSDESPacket::ItemType GetSDESItemType(uint8_t sdesid)
+{
+	switch (sdesid)
+	{
+	case RTCP_SDES_ID_CNAME:
+		return RTCPSDESPacket::CNAME;
+	case RTCP_SDES_ID_NAME:
+		return RTCPSDESPacket::NAME;
+	case RTCP_SDES_ID_EMAIL:
+		return RTCPSDESPacket::EMAIL;
+	case RTCP_SDES_ID_PHONE:
+		return RTCPSDESPacket::PHONE;
+	case RTCP_SDES_ID_LOCATION:
+		return RTCPSDESPacket::LOC;
+	case RTCP_SDES_ID_TOOL:
+		return RTCPSDESPacket::TOOL;
+	case RTCP_SDES_ID_NOTE:
+		return RTCPSDESPacket::NOTE;
+	case RTCP_SDES_ID_PRIVATE:
+		return RTCPSDESPacket::PRIV;
+	}
+	return RTCPSDESPacket::Unknown;
+}
+
+int RTCPCompoundPacketParser::ParseSDES(uint8_t *data,size_t len)
+{
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)data;
+
+	if (!IsValidSDESPacket(data,len))
+		return OnUnknownPacketFormat(hdr->packettype);
+
+	int count = (int)hdr->count;
+	uint8_t *chunk = data+sizeof(RTCPCommonHeader);
+	int status;
+
+	for (int i = 0 ; i < count ; i++)
+	{
+		uint32_t ssrc = ntohl(*((uint32_t *)chunk));
+		size_t offset = sizeof(uint32_t);
+		RTCPSDESHeader *sdeshdr = (RTCPSDESHeader *)(chunk+offset);
+
+		while (sdeshdr->sdesid != 0)
+		{
+			uint8_t *itemdata = chunk+offset+sizeof(RTCPSDESHeader);
+			size_t itemlen = (size_t)(sdeshdr->length);
+
+			if (sdeshdr->sdesid != RTCP_SDES_ID_PRIVATE)
+			{
+				if ((status = OnSDESItem(ssrc,GetSDESItemType(sdeshdr->sdesid),itemdata,itemlen)) < 0)
+					return status;
+			}
+#ifdef RTP_SUPPORT_SDESPRIV
+			else
+			{
+				// An item with an invalid prefix length is reported as an empty one,
+				// like RTCPSDESPacket does
+				uint8_t *prefixdata = 0;
+				uint8_t *valuedata = 0;
+				size_t prefixlen = 0;
+				size_t valuelen = 0;
+
+				if (itemlen > 0 && (size_t)itemdata[0] <= itemlen-1)
+				{
+					prefixlen = (size_t)itemdata[0];
+					valuelen = itemlen-prefixlen-1;
+					if (prefixlen > 0)
+						prefixdata = itemdata+1;
+					if (valuelen > 0)
+						valuedata = itemdata+1+prefixlen;
+				}
+				if ((status = OnSDESPrivateItem(ssrc,prefixdata,prefixlen,valuedata,valuelen)) < 0)
+					return status;
+			}
+#endif // RTP_SUPPORT_SDESPRIV
+
+			offset += sizeof(RTCPSDESHeader)+itemlen;
+			sdeshdr = (RTCPSDESHeader *)(chunk+offset);
+		}
+
+		if ((status = OnEndOfSDESChunk(ssrc)) < 0)
+			return status;
+
+		offset++; // for the zero byte
+		if ((offset&0x03) != 0)
+			offset += (4-(offset&0x03));
+		chunk += offset;
+	}
+	return 0;
+}
+
+int RTCPCompoundPacketParser::ParseBYE(uint8_t *data,size_t len)
+{
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)data;
+	size_t ssrclen = ((size_t)(hdr->count))*sizeof(uint32_t) + sizeof(RTCPCommonHeader);
+	uint8_t *reasondata = 0;
+	size_t reasonlen = 0;
+
+	if (ssrclen > len)
+		return OnUnknownPacketFormat(hdr->packettype);
+	if (ssrclen < len) // there's probably a reason for leaving
+	{
+		reasonlen = (size_t)data[ssrclen];
+		if (reasonlen > (len-ssrclen-1))
+			return OnUnknownPacketFormat(hdr->packettype);
+		if (reasonlen > 0)
+			reasondata = data+ssrclen+1;
+	}
+
+	uint32_t *ssrcs = (uint32_t *)(data+sizeof(RTCPCommonHeader));
+	int count = (int)hdr->count;
+	int status;
+
+	for (int i = 0 ; i < count ; i++)
+	{
+		if ((status = OnBYE(ntohl(ssrcs[i]),reasondata,reasonlen)) < 0)
+			return status;
+	}
+	return 0;
+}
+
+int RTCPCompoundPacketParser::ParseAPP(uint8_t *data,size_t len)
+{
+	RTCPCommonHeader *hdr = (RTCPCommonHeader *)data;
+
+	if (len < (sizeof(RTCPCommonHeader)+sizeof(uint32_t)*2))
+		return OnUnknownPacketFormat(hdr->packettype);
+
+	size_t appdatalen = len-(sizeof(RTCPCommonHeader)+sizeof(uint32_t)*2);
+	uint32_t ssrc = ntohl(*((uint32_t *)(data+sizeof(RTCPCommonHeader))));
+	uint8_t *name = data+sizeof(RTCPCommonHeader)+sizeof(uint32_t);
+	uint8_t *appdata = (appdatalen == 0)?0:(data+sizeof(RTCPCommonHeader)+sizeof(uint32_t)*2);
+
+	return OnAPPPacket(hdr->count,ssrc,name,appdata,appdatalen);
+}
+
+} // end namespace
+
@@ -0,0 +1,149 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtcpcompoundpacketparser.h
+ */
+
+#ifndef RTCPCOMPOUNDPACKETPARSER_H
+
+#define RTCPCOMPOUNDPACKETPARSER_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtptimeutilities.h"
+#include "rtcpsdespacket.h"
+
+namespace jrtplib
+{
+
+/** Walks through an RTCP compound packet without creating RTCPPacket instances.
+ *  Unlike RTCPCompoundPacket, this class doesn't allocate an RTCPPacket instance for each packet in
+ *  the compound packet: the Parse function reads the information directly from the data and
+ *  passes it to the On... member functions, which can be overridden in a derived class. The packets
+ *  are checked in the same way as by the RTCPCompoundPacket and RTCPPacket classes, so a packet for
+ *  which IsKnownFormat would return \c false is passed to OnUnknownPacketFormat instead.
+ */
+class JRTPLIB_IMPORTEXPORT RTCPCompoundPacketParser
+{
+public:
+	RTCPCompoundPacketParser();
+	virtual ~RTCPCompoundPacketParser();
+
+	/** Checks if the \c datalen bytes in \c data form a valid RTCP compound packet.
+	 *  Checks if the \c datalen bytes in \c data form a valid RTCP compound packet. The same checks
+	 *  are performed as in the RTCPCompoundPacket constructor, and ERR_RTP_RTCPCOMPOUND_INVALIDPACKET
+	 *  is returned if the packet is not valid.
+	 */
+	static int Validate(const uint8_t *data,size_t datalen);
+
+	/** Returns \c true if the valid RTCP compound packet in \c data with length \c datalen contains a BYE packet. */
+	static bool ContainsBYE(const uint8_t *data,size_t datalen);
+
+	/** Walks through the RTCP compound packet in \c data with length \c datalen.
+	 *  Walks through the RTCP compound packet in \c data with length \c datalen and calls the On...
+	 *  member functions for the information it contains, in the order in which it appears in the 
+	 *  packet. If the compound packet is not valid, none of these functions are called and
+	 *  ERR_RTP_RTCPCOMPOUND_INVALIDPACKET is returned. If one of the functions returns a negative
+	 *  value, parsing stops and that value is returned. The data itself is not modified.
+	 */
+	int Parse(uint8_t *data,size_t datalen);
+protected:
+	/** During a call to one of the On... functions, returns the data of the RTCP packet being processed. */
+	uint8_t *GetCurrentPacketData() const										{ return curpacket; }
+
+	/** During a call to one of the On... functions, returns the length of the RTCP packet being processed. */
+	size_t GetCurrentPacketLength() const										{ return curpacketlength; }
+
+	/** Is called for the sender information at the start of a sender report of \c senderssrc. */
+	virtual int OnSenderInfo(uint32_t senderssrc,const RTPNTPTime &ntptime,uint32_t rtptime,
+	                         uint32_t packetcount,uint32_t octetcount);
+
+	/** Is called for each report block about \c ssrc in a sender or receiver report of \c senderssrc. */
+	virtual int OnReportBlock(uint32_t senderssrc,uint32_t ssrc,uint8_t fractionlost,int32_t lostpackets,
+	                          uint32_t exthighseqnr,uint32_t jitter,uint32_t lsr,uint32_t dlsr);
+
+	/** Is called when all report blocks in a sender or receiver report of \c senderssrc have been processed. */
+	virtual int OnEndOfReport(uint32_t senderssrc);
+
+	/** Is called for each non-private item of type \c t in the SDES chunk of \c ssrc.
+	 *  Is called for each non-private item of type \c t in the SDES chunk of \c ssrc. Items with
+	 *  an unknown identifier are reported with type RTCPSDESPacket::Unknown.
+	 */
+	virtual int OnSDESItem(uint32_t ssrc,RTCPSDESPacket::ItemType t,const uint8_t *itemdata,size_t itemlength);
+#ifdef RTP_SUPPORT_SDESPRIV
+	/** Is called for each private item in the SDES chunk of \c ssrc. */
+	virtual int OnSDESPrivateItem(uint32_t ssrc,const uint8_t *prefixdata,size_t prefixlength,
+	                              const uint8_t *valuedata,size_t valuelength);
+#endif // RTP_SUPPORT_SDESPRIV
+
+	/** Is called when all items in the SDES chunk of \c ssrc have been processed. */
+	virtual int OnEndOfSDESChunk(uint32_t ssrc);
+
+	/** Is called for each SSRC \c ssrc in a BYE packet; the reason for leaving is the same for all of them. */
+	virtual int OnBYE(uint32_t ssrc,const uint8_t *reasondata,size_t reasonlength);
+
+	/** Is called for an APP packet with subtype \c subtype from \c ssrc; \c name points to four bytes. */
+	virtual int OnAPPPacket(uint8_t subtype,uint32_t ssrc,const uint8_t *name,const uint8_t *appdata,size_t appdatalength);
+
+	/** Is called for a packet with an unknown packet type \c packettype. */
+	virtual int OnUnknownPacketType(uint8_t packettype);
+
+	/** Is called for a packet of type \c packettype of which the contents are not valid. */
+	virtual int OnUnknownPacketFormat(uint8_t packettype);
+private:
+	int ParseReport(uint8_t *data,size_t len,bool issr);
+	int ParseSDES(uint8_t *data,size_t len);
+	int ParseBYE(uint8_t *data,size_t len);
+	int ParseAPP(uint8_t *data,size_t len);
+
+	uint8_t *curpacket;
+	size_t curpacketlength;
+};
+
+inline int RTCPCompoundPacketParser::OnSenderInfo(uint32_t,const RTPNTPTime &,uint32_t,uint32_t,uint32_t)			{ return 0; }
+inline int RTCPCompoundPacketParser::OnReportBlock(uint32_t,uint32_t,uint8_t,int32_t,uint32_t,uint32_t,uint32_t,uint32_t)	{ return 0; }
+inline int RTCPCompoundPacketParser::OnEndOfReport(uint32_t)								{ return 0; }
+inline int RTCPCompoundPacketParser::OnSDESItem(uint32_t,RTCPSDESPacket::ItemType,const uint8_t *,size_t)		{ return 0; }
+#ifdef RTP_SUPPORT_SDESPRIV
+inline int RTCPCompoundPacketParser::OnSDESPrivateItem(uint32_t,const uint8_t *,size_t,const uint8_t *,size_t)		{ return 0; }
+#endif // RTP_SUPPORT_SDESPRIV
+inline int RTCPCompoundPacketParser::OnEndOfSDESChunk(uint32_t)								{ return 0; }
+inline int RTCPCompoundPacketParser::OnBYE(uint32_t,const uint8_t *,size_t)						{ return 0; }
+inline int RTCPCompoundPacketParser::OnAPPPacket(uint8_t,uint32_t,const uint8_t *,const uint8_t *,size_t)		{ return 0; }
+inline int RTCPCompoundPacketParser::OnUnknownPacketType(uint8_t)							{ return 0; }
+inline int RTCPCompoundPacketParser::OnUnknownPacketFormat(uint8_t)							{ return 0; }
+
+} // end namespace
+
+#endif // RTCPCOMPOUNDPACKETPARSER_H
+
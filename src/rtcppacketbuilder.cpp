@@ -47,6 +47,8 @@ RTCPPacketBuilder::RTCPPacketBuilder(RTPSources &s,RTPPacketBuilder &pb,RTPMemor
 	: RTPMemoryObject(mgr),sources(s),rtppacketbuilder(pb),prevbuildtime(0,0),transmissiondelay(0,0),ownsdesinfo(mgr)
 {
 	init = false;
+	buildinplace = false;
+	inplacepacket = 0;
 	timeinit.Dummy();
 }
 
@@ -76,6 +78,7 @@ int RTCPPacketBuilder::Init(size_t maxpacksize,double tsunit,const void *cname,s
 		return status;
 	
 	ClearAllSourceFlags();
+	packetnumber = 0;
 	
 	interval_name = -1;
 	interval_email = -1;
@@ -98,9 +101,18 @@ void RTCPPacketBuilder::Destroy()
 	if (!init)
 		return;
 	ownsdesinfo.Clear();
+	if (inplacepacket)
+		RTPDelete(inplacepacket,GetMemoryManager());
+	inplacepacket = 0;
 	init = false;
 }
 
+void RTCPPacketBuilder::DeletePacket(RTCPCompoundPacket *pack)
+{
+	if (pack != inplacepacket)
+		RTPDelete(pack,GetMemoryManager());
+}
+
 int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 {
 	if (!init)
@@ -113,13 +125,29 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 	
 	*pack = 0;
 	
-	rtcpcomppack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPCOMPOUNDPACKETBUILDER) RTCPCompoundPacketBuilder(GetMemoryManager());
-	if (rtcpcomppack == 0)
-		return ERR_RTP_OUTOFMEM;
+	if (buildinplace)
+	{
+		// The same builder and its buffers are used for every packet
+		if (inplacepacket == 0)
+		{
+			inplacepacket = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPCOMPOUNDPACKETBUILDER) RTCPCompoundPacketBuilder(GetMemoryManager());
+			if (inplacepacket == 0)
+				return ERR_RTP_OUTOFMEM;
+		}
+		rtcpcomppack = inplacepacket;
+		status = rtcpcomppack->InitBuildInPlace(maxpacketsize);
+	}
+	else
+	{
+		rtcpcomppack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTCPCOMPOUNDPACKETBUILDER) RTCPCompoundPacketBuilder(GetMemoryManager());
+		if (rtcpcomppack == 0)
+			return ERR_RTP_OUTOFMEM;
+		status = rtcpcomppack->InitBuild(maxpacketsize);
+	}
 	
-	if ((status = rtcpcomppack->InitBuild(maxpacketsize)) < 0)
+	if (status < 0)
 	{
-		RTPDelete(rtcpcomppack,GetMemoryManager());
+		DeletePacket(rtcpcomppack);
 		return status;
 	}
 	
@@ -132,6 +160,8 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 	uint32_t ssrc = rtppacketbuilder.GetSSRC();
 	RTPTime curtime = RTPTime::CurrentTime();
 
+	packetnumber++;
+
 	if (sender)
 	{
 		RTPTime rtppacktime = rtppacketbuilder.GetPacketTime();
@@ -148,7 +178,7 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 
 		if ((status = rtcpcomppack->StartSenderReport(ssrc,ntptimestamp,rtptimestamp,packcount,octetcount)) < 0)
 		{
-			RTPDelete(rtcpcomppack,GetMemoryManager());
+			DeletePacket(rtcpcomppack);
 			if (status == ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT)
 				return ERR_RTP_RTCPPACKETBUILDER_PACKETFILLEDTOOSOON;
 			return status;
@@ -158,7 +188,7 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 	{
 		if ((status = rtcpcomppack->StartReceiverReport(ssrc)) < 0)
 		{
-			RTPDelete(rtcpcomppack,GetMemoryManager());
+			DeletePacket(rtcpcomppack);
 			if (status == ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT)
 				return ERR_RTP_RTCPPACKETBUILDER_PACKETFILLEDTOOSOON;
 			return status;
@@ -172,14 +202,14 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 
 	if ((status = rtcpcomppack->AddSDESSource(ssrc)) < 0)
 	{
-		RTPDelete(rtcpcomppack,GetMemoryManager());
+		DeletePacket(rtcpcomppack);
 		if (status == ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT)
 			return ERR_RTP_RTCPPACKETBUILDER_PACKETFILLEDTOOSOON;
 		return status;
 	}
 	if ((status = rtcpcomppack->AddSDESNormalItem(RTCPSDESPacket::CNAME,owncname,owncnamelen)) < 0)
 	{
-		RTPDelete(rtcpcomppack,GetMemoryManager());
+		DeletePacket(rtcpcomppack);
 		if (status == ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT)
 			return ERR_RTP_RTCPPACKETBUILDER_PACKETFILLEDTOOSOON;
 		return status;
@@ -192,13 +222,13 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 
 		if ((status = FillInReportBlocks(rtcpcomppack,curtime,sources.GetTotalCount(),&full,&added,&skipped,&atendoflist)) < 0)
 		{
-			RTPDelete(rtcpcomppack,GetMemoryManager());
+			DeletePacket(rtcpcomppack);
 			return status;
 		}
 		
 		if (full && added == 0)
 		{
-			RTPDelete(rtcpcomppack,GetMemoryManager());
+			DeletePacket(rtcpcomppack);
 			return ERR_RTP_RTCPPACKETBUILDER_PACKETFILLEDTOOSOON;
 		}
 	
@@ -227,7 +257,7 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 			
 			if ((status = FillInSDES(rtcpcomppack,&full,&processedall,&itemcount)) < 0)
 			{
-				RTPDelete(rtcpcomppack,GetMemoryManager());
+				DeletePacket(rtcpcomppack);
 				return status;
 			}
 
@@ -245,7 +275,7 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 					 
 					if ((status = FillInReportBlocks(rtcpcomppack,curtime,skipped,&full,&added,&skipped,&atendoflist)) < 0)
 					{
-						RTPDelete(rtcpcomppack,GetMemoryManager());
+						DeletePacket(rtcpcomppack);
 						return status;
 					}
 				}
@@ -260,13 +290,13 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 			
 		if ((status = FillInSDES(rtcpcomppack,&full,&processedall,&itemcount)) < 0)
 		{
-			RTPDelete(rtcpcomppack,GetMemoryManager());
+			DeletePacket(rtcpcomppack);
 			return status;
 		}
 
 		if (itemcount == 0) // Big problem: packet size is too small to let any progress happen
 		{
-			RTPDelete(rtcpcomppack,GetMemoryManager());
+			DeletePacket(rtcpcomppack);
 			return ERR_RTP_RTCPPACKETBUILDER_PACKETFILLEDTOOSOON;
 		}
 
@@ -284,7 +314,7 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 
 				if ((status = FillInReportBlocks(rtcpcomppack,curtime,sources.GetTotalCount(),&full,&added,&skipped,&atendoflist)) < 0)
 				{
-					RTPDelete(rtcpcomppack,GetMemoryManager());
+					DeletePacket(rtcpcomppack);
 					return status;
 				}
 				if (atendoflist) // filled in all possible sources
@@ -295,7 +325,7 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 		
 	if ((status = rtcpcomppack->EndBuild()) < 0)
 	{
-		RTPDelete(rtcpcomppack,GetMemoryManager());
+		DeletePacket(rtcpcomppack);
 		return status;
 	}
 
@@ -307,195 +337,114 @@ int RTCPPacketBuilder::BuildNextPacket(RTCPCompoundPacket **pack)
 
 void RTCPPacketBuilder::ClearAllSourceFlags()
 {
-	if (sources.GotoFirstSource())
-	{
-		do
-		{
-			RTPSourceData *srcdat = sources.GetCurrentSourceInfo();
-			srcdat->SetProcessedInRTCP(false);
-		} while (sources.GotoNextSource());
-	}
+	sources.GetReportTable().ClearProcessedInRTCP();
 }
 
 int RTCPPacketBuilder::FillInReportBlocks(RTCPCompoundPacketBuilder *rtcpcomppack,const RTPTime &curtime,int maxcount,bool *full,int *added,int *skipped,bool *atendoflist)
 {
-	RTPSourceData *srcdat;
+	RTPSourceReportTable &reporttable = sources.GetReportTable();
 	int addedcount = 0;
 	int skippedcount = 0;
 	bool done = false;
 	bool filled = false;
-	bool atend = false;
 	int status;
 
-	if (sources.GotoFirstSource())
+	// The report table only returns the sources that should be processed: not
+	// ourselves, no CSRCs (p 35) and only sources which have sent RTP data. If
+	// this isn't the first packet, RTP packets must have been received since the
+	// previous one (p 35 as well).
+
+	int slot = reporttable.FindReportableSource(0,firstpacket,prevbuildtime);
+
+	while (slot >= 0 && !done)
 	{
-		do
+		if (reporttable.IsReportedInPacket(slot,packetnumber)) // the flags can be cleared while building a packet
+			slot = reporttable.FindReportableSource(slot+1,firstpacket,prevbuildtime);
+		else if (reporttable.IsProcessedInRTCP(slot)) // already covered this one
 		{
-			bool shouldprocess = false;
+			skippedcount++;
+			slot = reporttable.FindReportableSource(slot+1,firstpacket,prevbuildtime);
+		}
+		else
+		{
+			uint32_t rr_ssrc = reporttable.GetSSRC(slot);
+			uint32_t num = reporttable.GetNumPacketsReceivedInInterval(slot);
+			uint32_t prevseq = reporttable.GetSavedExtendedSequenceNumber(slot);
+			uint32_t curseq = reporttable.GetExtendedHighestSequenceNumber(slot);
+			uint32_t expected = curseq-prevseq;
+			uint8_t fraclost;
 			
-			srcdat = sources.GetCurrentSourceInfo();
-			if (!srcdat->IsOwnSSRC()) // don't send to ourselves
+			if (expected < num) // got duplicates
+				fraclost = 0;
+			else
 			{
-				if (!srcdat->IsCSRC()) // p 35: no reports should go to CSRCs
-				{
-					if (srcdat->INF_HasSentData()) // if this isn't true, INF_GetLastRTPPacketTime() won't make any sense
-					{
-						if (firstpacket)
-							shouldprocess = true;
-						else
-						{
-							// p 35: only if rtp packets were received since the last RTP packet, a report block
-							// should be added
-							
-							RTPTime lastrtptime = srcdat->INF_GetLastRTPPacketTime();
-							
-							if (lastrtptime > prevbuildtime)
-								shouldprocess = true;
-						}
-					}
-				}
+				double lost = (double)(expected-num);
+				double frac = lost/((double)expected);
+				fraclost = (uint8_t)(frac*256.0);
 			}
 
-			if (shouldprocess)
-			{
-				if (srcdat->IsProcessedInRTCP()) // already covered this one
-				{
-					skippedcount++;
-				}
-				else
-				{
-					uint32_t rr_ssrc = srcdat->GetSSRC();
-					uint32_t num = srcdat->INF_GetNumPacketsReceivedInInterval();
-					uint32_t prevseq = srcdat->INF_GetSavedExtendedSequenceNumber();
-					uint32_t curseq = srcdat->INF_GetExtendedHighestSequenceNumber();
-					uint32_t expected = curseq-prevseq;
-					uint8_t fraclost;
-					
-					if (expected < num) // got duplicates
-						fraclost = 0;
-					else
-					{
-						double lost = (double)(expected-num);
-						double frac = lost/((double)expected);
-						fraclost = (uint8_t)(frac*256.0);
-					}
-
-					expected = curseq-srcdat->INF_GetBaseSequenceNumber();
-					num = srcdat->INF_GetNumPacketsReceived();
-
-					uint32_t diff = expected-num;
-					int32_t *packlost = (int32_t *)&diff;
-					
-					uint32_t jitter = srcdat->INF_GetJitter();
-					uint32_t lsr;
-					uint32_t dlsr; 	
+			expected = curseq-reporttable.GetBaseSequenceNumber(slot);
+			num = reporttable.GetNumPacketsReceived(slot);
 
-					if (!srcdat->SR_HasInfo())
-					{
-						lsr = 0;
-						dlsr = 0;
-					}
-					else
-					{
-						RTPNTPTime srtime = srcdat->SR_GetNTPTimestamp();
-						uint32_t m = (srtime.GetMSW()&0xFFFF);
-						uint32_t l = ((srtime.GetLSW()>>16)&0xFFFF);
-						lsr = ((m<<16)|l);
-
-						RTPTime diff = curtime;
-						diff -= srcdat->SR_GetReceiveTime();
-						double diff2 = diff.GetDouble();
-						diff2 *= 65536.0;
-						dlsr = (uint32_t)diff2;
-					}
+			uint32_t diff = expected-num;
+			int32_t *packlost = (int32_t *)&diff;
+			
+			uint32_t jitter = reporttable.GetJitter(slot);
+			uint32_t lsr;
+			uint32_t dlsr; 	
+			RTPSourceData *srcdat = reporttable.GetSource(slot);
 
-					status = rtcpcomppack->AddReportBlock(rr_ssrc,fraclost,*packlost,curseq,jitter,lsr,dlsr);
-					if (status < 0)
-					{
-						if (status == ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT)
-						{
-							done = true;
-							filled = true;
-						}
-						else
-							return status;
-					}
-					else
-					{
-						addedcount++;
-						if (addedcount >= maxcount)
-						{
-							done = true;
-							if (!sources.GotoNextSource())
-								atend = true;
-						}
-						srcdat->INF_StartNewInterval();
-						srcdat->SetProcessedInRTCP(true);
-					}
-				}
+			if (!srcdat->SR_HasInfo())
+			{
+				lsr = 0;
+				dlsr = 0;
+			}
+			else
+			{
+				RTPNTPTime srtime = srcdat->SR_GetNTPTimestamp();
+				uint32_t m = (srtime.GetMSW()&0xFFFF);
+				uint32_t l = ((srtime.GetLSW()>>16)&0xFFFF);
+				lsr = ((m<<16)|l);
+
+				RTPTime diff = curtime;
+				diff -= srcdat->SR_GetReceiveTime();
+				double diff2 = diff.GetDouble();
+				diff2 *= 65536.0;
+				dlsr = (uint32_t)diff2;
 			}
 
-			if (!done)
+			status = rtcpcomppack->AddReportBlock(rr_ssrc,fraclost,*packlost,curseq,jitter,lsr,dlsr);
+			if (status < 0)
 			{
-				if (!sources.GotoNextSource())
+				if (status == ERR_RTP_RTCPCOMPPACKBUILDER_NOTENOUGHBYTESLEFT)
 				{
-					atend = true;
 					done = true;
+					filled = true;
 				}
+				else
+					return status;
 			}
-
-		} while (!done);
+			else
+			{
+				addedcount++;
+				reporttable.StartNewInterval(slot);
+				reporttable.SetReported(slot,packetnumber);
+				slot = reporttable.FindReportableSource(slot+1,firstpacket,prevbuildtime);
+				if (addedcount >= maxcount)
+					done = true;
+			}
+		}
 	}
 	
 	*added = addedcount;
 	*skipped = skippedcount;
 	*full = filled;
 	
-	if (!atend) // search for available sources
-	{
-		bool shouldprocess = false;
-		
-		do
-		{	
-			srcdat = sources.GetCurrentSourceInfo();
-			if (!srcdat->IsOwnSSRC()) // don't send to ourselves
-			{
-				if (!srcdat->IsCSRC()) // p 35: no reports should go to CSRCs
-				{
-					if (srcdat->INF_HasSentData()) // if this isn't true, INF_GetLastRTPPacketTime() won't make any sense
-					{
-						if (firstpacket)
-							shouldprocess = true;
-						else
-						{
-							// p 35: only if rtp packets were received since the last RTP packet, a report block
-							// should be added
-							
-							RTPTime lastrtptime = srcdat->INF_GetLastRTPPacketTime();
-							
-							if (lastrtptime > prevbuildtime)
-								shouldprocess = true;
-						}
-					}
-				}
-			}
-			
-			if (shouldprocess)
-			{
-				if (srcdat->IsProcessedInRTCP())
-					shouldprocess = false;
-			}
-
-			if (!shouldprocess)
-			{
-				if (!sources.GotoNextSource())
-					atend = true;
-			}
-	
-		} while (!atend && !shouldprocess);
-	}	
+	// search for available sources
+	while (slot >= 0 && (reporttable.IsProcessedInRTCP(slot) || reporttable.IsReportedInPacket(slot,packetnumber)))
+		slot = reporttable.FindReportableSource(slot+1,firstpacket,prevbuildtime);
 
-	*atendoflist = atend;
+	*atendoflist = (slot < 0);
 	return 0;	
 }
 
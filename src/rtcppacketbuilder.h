@@ -100,9 +100,27 @@ public:
 	 */
 	int SetPreTransmissionDelay(const RTPTime &delay)				{ if (!init) return ERR_RTP_RTCPPACKETBUILDER_NOTINIT; transmissiondelay = delay; return 0; }
 	
+	/** Sets whether the packets returned by BuildNextPacket should be built in place.
+	 *  If \c v is \c true, BuildNextPacket will reuse the same compound packet builder and its buffers 
+	 *  for every packet (see RTCPCompoundPacketBuilder::InitBuildInPlace), so that no memory needs to 
+	 *  be allocated once the buffers are large enough. A packet built this way only contains the 
+	 *  raw compound packet data, not the list of individual packets, and is only valid until the next
+	 *  call to BuildNextPacket. BYE packets are never built in place.
+	 */
+	void SetBuildInPlace(bool v)							{ buildinplace = v; }
+
+	/** Returns \c true if the packets returned by BuildNextPacket are built in place. */
+	bool GetBuildInPlace() const							{ return buildinplace; }
+
 	/** Builds the next RTCP compound packet which should be sent and stores it in \c pack. */
 	int BuildNextPacket(RTCPCompoundPacket **pack);
 
+	/** Releases a packet returned by BuildNextPacket or BuildBYEPacket.
+	 *  Releases a packet returned by BuildNextPacket or BuildBYEPacket. A packet that was built in
+	 *  place is kept for reuse, all other packets are deleted.
+	 */
+	void DeletePacket(RTCPCompoundPacket *pack);
+
 	/** Builds a BYE packet with reason for leaving specified by \c reason and length \c reasonlength.
 	 *  Builds a BYE packet with reason for leaving specified by \c reason and length \c reasonlength. If 
 	 *  \c useSRifpossible is set to \c true, the RTCP compound packet will start with a sender report if
@@ -192,6 +210,8 @@ private:
 	double timestampunit;
 	bool firstpacket;
 	RTPTime prevbuildtime,transmissiondelay;
+	bool buildinplace;
+	RTCPCompoundPacketBuilder *inplacepacket;
 
 	class RTCPSDESInfoInternal : public RTCPSDESInfo
 	{
@@ -221,6 +241,7 @@ private:
 	bool processingsdes;
 
 	int sdesbuildcount;
+	uint32_t packetnumber; // used to recognize the report blocks in the current packet
 };
 
 } // end namespace
@@ -118,16 +118,21 @@ void RTCPScheduler::AnalyseIncoming(RTCPCompoundPacket &rtcpcomppack)
 			isbye = true;
 	}
 	
+	AnalyseIncoming(rtcpcomppack.GetCompoundPacketLength(),isbye);
+}
+
+void RTCPScheduler::AnalyseIncoming(size_t packetlength,bool isbye)
+{
 	if (!isbye)
 	{
-		size_t packsize = headeroverhead+rtcpcomppack.GetCompoundPacketLength();
+		size_t packsize = headeroverhead+packetlength;
 		avgrtcppacksize = (size_t)((1.0/16.0)*((double)packsize)+(15.0/16.0)*((double)avgrtcppacksize));
 	}
 	else
 	{
 		if (byescheduled)
 		{
-			size_t packsize = headeroverhead+rtcpcomppack.GetCompoundPacketLength();
+			size_t packsize = headeroverhead+packetlength;
 			avgbyepacketsize = (size_t)((1.0/16.0)*((double)packsize)+(15.0/16.0)*((double)avgbyepacketsize));
 			byemembers++;
 		}
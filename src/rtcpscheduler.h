@@ -129,6 +129,11 @@ public:
 	/** For each incoming RTCP compound packet, this function has to be called for the scheduler to work correctly. */
 	void AnalyseIncoming(RTCPCompoundPacket &rtcpcomppack);
 
+	/** Does the same as the function above, for an incoming RTCP compound packet of \c packetlength bytes
+	 *  which was not stored in an RTCPCompoundPacket instance; \c isbye indicates if it contains a BYE packet.
+	 */
+	void AnalyseIncoming(size_t packetlength,bool isbye);
+
 	/** For each outgoing RTCP compound packet, this function has to be called for the scheduler to work correctly. */
 	void AnalyseOutgoing(RTCPCompoundPacket &rtcpcomppack);
 
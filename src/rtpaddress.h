@@ -39,6 +39,7 @@
 #define RTPADDRESS_H
 
 #include "rtpconfig.h"
+#include "rtptypes.h"
 #include <string>
 
 namespace jrtplib
@@ -82,6 +83,13 @@ public:
 	 */
 	virtual bool IsFromSameHost(const RTPAddress *addr) const  = 0;
 
+	/** Returns a value that can be used to store the address in a hash table.
+	 *  Returns a value that can be used to store the address in a hash table. Addresses for which
+	 *  IsSameAddress returns \c true must have the same hash value. The default implementation
+	 *  always returns 0, which is correct but makes such a table as slow as a list.
+	 */
+	virtual uint32_t GetHashValue() const						{ return 0; }
+
 #ifdef RTPDEBUG
 	virtual std::string GetAddressString() const = 0;
 #endif // RTPDEBUG
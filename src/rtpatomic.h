@@ -0,0 +1,244 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpatomic.h
+ */
+
+#ifndef RTPATOMIC_H
+
+#define RTPATOMIC_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+
+#if !defined(RTP_HAVE_GCC_ATOMICS) && defined(RTP_SUPPORT_THREAD)
+	#include <jthread/jmutex.h>
+	#define RTPATOMIC_LOCK		mutex.Lock();
+	#define RTPATOMIC_UNLOCK	mutex.Unlock();
+#else
+	#define RTPATOMIC_LOCK
+	#define RTPATOMIC_UNLOCK
+#endif // !RTP_HAVE_GCC_ATOMICS && RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+/** An integer that can be modified atomically by several threads.
+ *  An integer that can be modified atomically by several threads. When the compiler
+ *  supports the GCC style \c __atomic builtins these are used (with sequentially consistent
+ *  ordering), otherwise a mutex is used to protect the value.
+ */
+class RTPAtomicInteger
+{
+	JRTPLIB_NO_COPY(RTPAtomicInteger)
+public:
+	RTPAtomicInteger(int32_t v = 0);
+
+	/** Returns the current value. */
+	int32_t Get() const;
+
+	/** Stores \c v. */
+	void Set(int32_t v);
+
+	/** Adds \c x to the value and returns the value that was stored before. */
+	int32_t FetchAdd(int32_t x);
+
+	/** Stores \c v and returns the value that was stored before. */
+	int32_t Exchange(int32_t v);
+
+	/** Stores \c desired only if the current value is \c expected, and returns \c true if this was the case. */
+	bool CompareExchange(int32_t expected, int32_t desired);
+private:
+	volatile int32_t value;
+#if !defined(RTP_HAVE_GCC_ATOMICS) && defined(RTP_SUPPORT_THREAD)
+	mutable jthread::JMutex mutex;
+#endif // !RTP_HAVE_GCC_ATOMICS && RTP_SUPPORT_THREAD
+};
+
+/** A pointer that can be modified atomically by several threads, see RTPAtomicInteger. */
+template<class T>
+class RTPAtomicPointer
+{
+	JRTPLIB_NO_COPY(RTPAtomicPointer)
+public:
+	RTPAtomicPointer(T *v = 0);
+
+	/** Returns the current value. */
+	T *Get() const;
+
+	/** Stores \c v. */
+	void Set(T *v);
+
+	/** Stores \c v and returns the value that was stored before. */
+	T *Exchange(T *v);
+
+	/** Stores \c desired only if the current value is \c expected, and returns \c true if this was the case. */
+	bool CompareExchange(T *expected, T *desired);
+private:
+	T *volatile value;
+#if !defined(RTP_HAVE_GCC_ATOMICS) && defined(RTP_SUPPORT_THREAD)
+	mutable jthread::JMutex mutex;
+#endif // !RTP_HAVE_GCC_ATOMICS && RTP_SUPPORT_THREAD
+};
+
+inline RTPAtomicInteger::RTPAtomicInteger(int32_t v)
+{
+	value = v;
+#if !defined(RTP_HAVE_GCC_ATOMICS) && defined(RTP_SUPPORT_THREAD)
+	mutex.Init();
+#endif // !RTP_HAVE_GCC_ATOMICS && RTP_SUPPORT_THREAD
+}
+
+#ifdef RTP_HAVE_GCC_ATOMICS
+
+inline int32_t RTPAtomicInteger::Get() const								{ return __atomic_load_n(&value, __ATOMIC_SEQ_CST); }
+inline void RTPAtomicInteger::Set(int32_t v)								{ __atomic_store_n(&value, v, __ATOMIC_SEQ_CST); }
+inline int32_t RTPAtomicInteger::FetchAdd(int32_t x)							{ return __atomic_fetch_add(&value, x, __ATOMIC_SEQ_CST); }
+inline int32_t RTPAtomicInteger::Exchange(int32_t v)							{ return __atomic_exchange_n(&value, v, __ATOMIC_SEQ_CST); }
+inline bool RTPAtomicInteger::CompareExchange(int32_t expected, int32_t desired)			{ return __atomic_compare_exchange_n(&value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+template<class T> inline RTPAtomicPointer<T>::RTPAtomicPointer(T *v)					{ value = v; }
+template<class T> inline T *RTPAtomicPointer<T>::Get() const						{ return __atomic_load_n(&value, __ATOMIC_SEQ_CST); }
+template<class T> inline void RTPAtomicPointer<T>::Set(T *v)						{ __atomic_store_n(&value, v, __ATOMIC_SEQ_CST); }
+template<class T> inline T *RTPAtomicPointer<T>::Exchange(T *v)						{ return __atomic_exchange_n(&value, v, __ATOMIC_SEQ_CST); }
+template<class T> inline bool RTPAtomicPointer<T>::CompareExchange(T *expected, T *desired)		{ return __atomic_compare_exchange_n(&value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+#else
+
+inline int32_t RTPAtomicInteger::Get() const
+{
+	RTPATOMIC_LOCK
+	int32_t v = value;
+	RTPATOMIC_UNLOCK
+	return v;
+}
+
+inline void RTPAtomicInteger::Set(int32_t v)
+{
+	RTPATOMIC_LOCK
+	value = v;
+	RTPATOMIC_UNLOCK
+}
+
+inline int32_t RTPAtomicInteger::FetchAdd(int32_t x)
+{
+	RTPATOMIC_LOCK
+	int32_t v = value;
+	value = v+x;
+	RTPATOMIC_UNLOCK
+	return v;
+}
+
+inline int32_t RTPAtomicInteger::Exchange(int32_t v)
+{
+	RTPATOMIC_LOCK
+	int32_t old = value;
+	value = v;
+	RTPATOMIC_UNLOCK
+	return old;
+}
+
+inline bool RTPAtomicInteger::CompareExchange(int32_t expected, int32_t desired)
+{
+	bool stored = false;
+
+	RTPATOMIC_LOCK
+	if (value == expected)
+	{
+		value = desired;
+		stored = true;
+	}
+	RTPATOMIC_UNLOCK
+	return stored;
+}
+
+template<class T>
+inline RTPAtomicPointer<T>::RTPAtomicPointer(T *v)
+{
+	value = v;
+#ifdef RTP_SUPPORT_THREAD
+	mutex.Init();
+#endif // RTP_SUPPORT_THREAD
+}
+
+template<class T>
+inline T *RTPAtomicPointer<T>::Get() const
+{
+	RTPATOMIC_LOCK
+	T *v = value;
+	RTPATOMIC_UNLOCK
+	return v;
+}
+
+template<class T>
+inline void RTPAtomicPointer<T>::Set(T *v)
+{
+	RTPATOMIC_LOCK
+	value = v;
+	RTPATOMIC_UNLOCK
+}
+
+template<class T>
+inline T *RTPAtomicPointer<T>::Exchange(T *v)
+{
+	RTPATOMIC_LOCK
+	T *old = value;
+	value = v;
+	RTPATOMIC_UNLOCK
+	return old;
+}
+
+template<class T>
+inline bool RTPAtomicPointer<T>::CompareExchange(T *expected, T *desired)
+{
+	bool stored = false;
+
+	RTPATOMIC_LOCK
+	if (value == expected)
+	{
+		value = desired;
+		stored = true;
+	}
+	RTPATOMIC_UNLOCK
+	return stored;
+}
+
+#endif // RTP_HAVE_GCC_ATOMICS
+
+} // end namespace
+
+#undef RTPATOMIC_LOCK
+#undef RTPATOMIC_UNLOCK
+
+#endif // RTPATOMIC_H
+
@@ -75,6 +75,15 @@ bool RTPByteAddress::IsFromSameHost(const RTPAddress *addr) const
 	return false;
 }
 
+uint32_t RTPByteAddress::GetHashValue() const
+{
+	uint32_t h = port;
+
+	for (size_t i = 0 ; i < addresslength ; i++)
+		h = h*31+hostaddress[i];
+	return h;
+}
+
 RTPAddress *RTPByteAddress::CreateCopy(RTPMemoryManager *mgr) const
 {
 	JRTPLIB_UNUSED(mgr); // possibly unused
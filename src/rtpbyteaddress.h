@@ -78,6 +78,7 @@ public:
 	RTPAddress *CreateCopy(RTPMemoryManager *mgr) const;
 	bool IsSameAddress(const RTPAddress *addr) const;
 	bool IsFromSameHost(const RTPAddress *addr) const;
+	uint32_t GetHashValue() const;
 #ifdef RTPDEBUG
 	std::string GetAddressString() const;
 #endif // RTPDEBUG
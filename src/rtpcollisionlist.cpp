@@ -39,21 +39,45 @@
 
 #include "rtpdebug.h"
 
+#define RTPCOLLISIONLIST_INITIALBUCKETS			16
+
 namespace jrtplib
 {
 
 RTPCollisionList::RTPCollisionList(RTPMemoryManager *mgr) : RTPMemoryObject(mgr)
 {
+	buckets = 0;
+	numbuckets = 0;
+	numentries = 0;
+	first = 0;
+	last = 0;
 	timeinit.Dummy();
 }
 
+RTPCollisionList::~RTPCollisionList()
+{
+	Clear();
+	if (buckets)
+		RTPDeleteByteArray((uint8_t *)buckets,GetMemoryManager());
+}
+
 void RTPCollisionList::Clear()
 {
-	std::list<AddressAndTime>::iterator it;
-	
-	for (it = addresslist.begin() ; it != addresslist.end() ; it++)
-		RTPDelete((*it).addr,GetMemoryManager());
-	addresslist.clear();
+	Entry *e = first;
+
+	while (e != 0)
+	{
+		Entry *next = e->next;
+
+		RTPDelete(e->addr,GetMemoryManager());
+		RTPDelete(e,GetMemoryManager());
+		e = next;
+	}
+	for (size_t i = 0 ; i < numbuckets ; i++)
+		buckets[i] = 0;
+	numentries = 0;
+	first = 0;
+	last = 0;
 }
 
 int RTPCollisionList::UpdateAddress(const RTPAddress *addr,const RTPTime &receivetime,bool *created)
@@ -61,66 +85,177 @@ int RTPCollisionList::UpdateAddress(const RTPAddress *addr,const RTPTime &receiv
 	if (addr == 0)
 		return ERR_RTP_COLLISIONLIST_BADADDRESS;
 	
-	std::list<AddressAndTime>::iterator it;
-	
-	for (it = addresslist.begin() ; it != addresslist.end() ; it++)
+	uint32_t hash = CalculateHash(addr);
+	Entry *e = FindEntry(addr,hash);
+
+	if (e != 0)
+	{
+		e->recvtime = receivetime;
+		UnlinkOrdered(e);
+		InsertOrdered(e);
+		*created = false;
+		return 0;
+	}
+
+	if (numentries >= numbuckets) // keep the chains short
 	{
-		if (((*it).addr)->IsSameAddress(addr))
-		{
-			(*it).recvtime = receivetime;
-			*created = false;
-			return 0;
-		}
+		int status;
+
+		if ((status = Resize((numbuckets == 0)?RTPCOLLISIONLIST_INITIALBUCKETS:numbuckets*2)) < 0)
+			return status;
 	}
 
 	RTPAddress *newaddr = addr->CreateCopy(GetMemoryManager());
 	if (newaddr == 0)
 		return ERR_RTP_OUTOFMEM;
-	
-	addresslist.push_back(AddressAndTime(newaddr,receivetime));
+
+	e = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_COLLISIONLISTENTRY) Entry(newaddr,hash,receivetime);
+	if (e == 0)
+	{
+		RTPDelete(newaddr,GetMemoryManager());
+		return ERR_RTP_OUTOFMEM;
+	}
+
+	size_t idx = hash&(numbuckets-1);
+
+	e->hashnext = buckets[idx];
+	buckets[idx] = e;
+	InsertOrdered(e);
+	numentries++;
 	*created = true;
 	return 0;
 }
 
 bool RTPCollisionList::HasAddress(const RTPAddress *addr) const
 {
-	std::list<AddressAndTime>::const_iterator it;
-	
-	for (it = addresslist.begin() ; it != addresslist.end() ; it++)
-	{
-		if (((*it).addr)->IsSameAddress(addr))
-			return true;
-	}
-
-	return false;	
+	if (addr == 0)
+		return false;
+	return (FindEntry(addr,CalculateHash(addr)) != 0);
 }
 
 void RTPCollisionList::Timeout(const RTPTime &currenttime,const RTPTime &timeoutdelay)
 {
-	std::list<AddressAndTime>::iterator it;
 	RTPTime checktime = currenttime;
 	checktime -= timeoutdelay;
 	
-	it = addresslist.begin();
-	while(it != addresslist.end())
+	// Entries are ordered on their receive time, so the ones that have
+	// timed out are at the front of the list
+	
+	while (first != 0 && first->recvtime < checktime) // timeout
+	{
+		Entry *e = first;
+
+		UnlinkOrdered(e);
+		UnlinkFromBucket(e);
+		numentries--;
+		RTPDelete(e->addr,GetMemoryManager());
+		RTPDelete(e,GetMemoryManager());
+	}
+}
+
+uint32_t RTPCollisionList::CalculateHash(const RTPAddress *addr)
+{
+	// Mix the bits, so that the lower ones can be used as the bucket index
+	uint32_t h = addr->GetHashValue();
+
+	h ^= h>>16;
+	h *= 0x45d9f3b;
+	h ^= h>>16;
+	return h;
+}
+
+RTPCollisionList::Entry *RTPCollisionList::FindEntry(const RTPAddress *addr,uint32_t hash) const
+{
+	if (numbuckets == 0)
+		return 0;
+
+	Entry *e = buckets[hash&(numbuckets-1)];
+
+	while (e != 0)
 	{
-		if ((*it).recvtime < checktime) // timeout
-		{
-			RTPDelete((*it).addr,GetMemoryManager());
-			it = addresslist.erase(it);	
-		}
-		else
-			it++;
+		if (e->hash == hash && e->addr->IsSameAddress(addr))
+			return e;
+		e = e->hashnext;
 	}
+	return 0;
+}
+
+void RTPCollisionList::InsertOrdered(Entry *e)
+{
+	// The list is kept ordered on the receive time; since the time will
+	// usually be the most recent one, we start looking at the end
+
+	Entry *prev = last;
+
+	while (prev != 0 && e->recvtime < prev->recvtime)
+		prev = prev->prev;
+
+	e->prev = prev;
+	e->next = (prev)?prev->next:first;
+	if (e->next)
+		e->next->prev = e;
+	else
+		last = e;
+	if (prev)
+		prev->next = e;
+	else
+		first = e;
+}
+
+void RTPCollisionList::UnlinkOrdered(Entry *e)
+{
+	if (e->prev)
+		e->prev->next = e->next;
+	else
+		first = e->next;
+	if (e->next)
+		e->next->prev = e->prev;
+	else
+		last = e->prev;
+	e->prev = 0;
+	e->next = 0;
+}
+
+void RTPCollisionList::UnlinkFromBucket(Entry *e)
+{
+	Entry **ptr = &buckets[e->hash&(numbuckets-1)];
+
+	while (*ptr != e)
+		ptr = &((*ptr)->hashnext);
+	*ptr = e->hashnext;
+	e->hashnext = 0;
+}
+
+int RTPCollisionList::Resize(size_t newnumbuckets)
+{
+	Entry **newbuckets = (Entry **)RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_COLLISIONLISTBUCKETS) uint8_t[sizeof(Entry *)*newnumbuckets];
+
+	if (newbuckets == 0)
+		return ERR_RTP_OUTOFMEM;
+	for (size_t i = 0 ; i < newnumbuckets ; i++)
+		newbuckets[i] = 0;
+
+	// The stored hashes are used to put the entries in their new buckets
+	for (Entry *e = first ; e != 0 ; e = e->next)
+	{
+		size_t idx = e->hash&(newnumbuckets-1);
+
+		e->hashnext = newbuckets[idx];
+		newbuckets[idx] = e;
+	}
+
+	if (buckets)
+		RTPDeleteByteArray((uint8_t *)buckets,GetMemoryManager());
+	buckets = newbuckets;
+	numbuckets = newnumbuckets;
+	return 0;
 }
 
 #ifdef RTPDEBUG
 void RTPCollisionList::Dump()
 {
-	std::list<AddressAndTime>::const_iterator it;
-	
-	for (it = addresslist.begin() ; it != addresslist.end() ; it++)
-		std::cout << "Address: " << ((*it).addr)->GetAddressString() << "\tTime: " << (*it).recvtime.GetSeconds() << std::endl;
+	for (Entry *e = first ; e != 0 ; e = e->next)
+		std::cout << "Address: " << (e->addr)->GetAddressString() << "\tTime: " << e->recvtime.GetSeconds() << std::endl;
 }
 #endif // RTPDEBUG
 
@@ -42,20 +42,25 @@
 #include "rtpaddress.h"
 #include "rtptimeutilities.h"
 #include "rtpmemoryobject.h"
-#include <list>
 
 namespace jrtplib
 {
 
 class RTPAddress;
 
-/** This class represents a list of addresses from which SSRC collisions were detected. */
+/** This class represents a list of addresses from which SSRC collisions were detected.
+ *  This class represents a list of addresses from which SSRC collisions were detected. The
+ *  addresses are stored in a hash table based on RTPAddress::GetHashValue, and are also kept
+ *  in a list ordered on the time of the last collision, so that finding an address and timing
+ *  out the old ones don't depend on the number of addresses in the list.
+ */
 class JRTPLIB_IMPORTEXPORT RTPCollisionList : public RTPMemoryObject
 {
+	JRTPLIB_NO_COPY(RTPCollisionList)
 public:
 	/** Constructs an instance, optionally installing a memory manager. */
 	RTPCollisionList(RTPMemoryManager *mgr = 0);
-	~RTPCollisionList()								{ Clear(); }
+	~RTPCollisionList();
 	
 	/** Clears the list of addresses. */
 	void Clear();
@@ -77,16 +82,28 @@ public:
 	void Dump();
 #endif // RTPDEBUG
 private:
-	class AddressAndTime
+	class Entry
 	{
 	public:
-		AddressAndTime(RTPAddress *a,const RTPTime &t) : addr(a),recvtime(t) { }
+		Entry(RTPAddress *a,uint32_t h,const RTPTime &t) : addr(a),hash(h),recvtime(t),hashnext(0),prev(0),next(0) { }
 
 		RTPAddress *addr;
+		uint32_t hash;
 		RTPTime recvtime;
+		Entry *hashnext; // next entry in the same bucket
+		Entry *prev,*next; // ordered on the receive time
 	};
 
-	std::list<AddressAndTime> addresslist;
+	static uint32_t CalculateHash(const RTPAddress *addr);
+	Entry *FindEntry(const RTPAddress *addr,uint32_t hash) const;
+	void InsertOrdered(Entry *e);
+	void UnlinkOrdered(Entry *e);
+	void UnlinkFromBucket(Entry *e);
+	int Resize(size_t newnumbuckets);
+
+	Entry **buckets;
+	size_t numbuckets,numentries;
+	Entry *first,*last;
 };
 
 } // end namespace
@@ -245,6 +245,52 @@ static RTPErrorInfo ErrorDescriptions[]=
 	{ ERR_RTP_TCPTRANS_SOCKETNOTFOUNDINDESTINATIONS, "The specified destination address (socket) was not found in the list of destinations of the TCP transmitter" },
 	{ ERR_RTP_TCPTRANS_ERRORINSEND, "An error occurred in the TCP transmitter while sending a packet" },
 	{ ERR_RTP_TCPTRANS_ERRORINRECV, "An error occurred in the TCP transmitter while receiving a packet" },
+	{ ERR_RTP_PACKETRINGTRANS_ALREADYCREATED, "The packet ring transmitter was already created" },
+	{ ERR_RTP_PACKETRINGTRANS_ALREADYINIT, "The packet ring transmitter was already initialized" },
+	{ ERR_RTP_PACKETRINGTRANS_ALREADYWAITING, "The packet ring transmitter is already waiting for incoming data" },
+	{ ERR_RTP_PACKETRINGTRANS_BADRECEIVEMODE, "The packet ring transmitter only supports the 'accept all' receive mode" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTATTACHFILTER, "Unable to attach the BPF filter to the packet socket" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTBINDSOCKET, "Unable to bind the packet socket to the specified interface" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTCREATESOCKET, "Unable to create the packet socket (note that this requires the CAP_NET_RAW capability)" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTINITMUTEX, "Unable to initialize a mutex during the initialization of the packet ring transmitter" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTMAPRING, "Unable to map the receive ring of the packet socket into memory" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTSETPROMISCUOUS, "Unable to put the interface in promiscuous mode" },
+	{ ERR_RTP_PACKETRINGTRANS_CANTSETUPRING, "Unable to set up a TPACKET_V3 receive ring for the packet socket" },
+	{ ERR_RTP_PACKETRINGTRANS_ILLEGALPARAMETERS, "Illegal parameters for the packet ring transmitter" },
+	{ ERR_RTP_PACKETRINGTRANS_NOACCEPTLIST, "The packet ring transmitter does not support an accept list" },
+	{ ERR_RTP_PACKETRINGTRANS_NODESTINATIONSSUPPORTED, "The packet ring transmitter is receive-only and does not support destinations" },
+	{ ERR_RTP_PACKETRINGTRANS_NOIGNORELIST, "The packet ring transmitter does not support an ignore list" },
+	{ ERR_RTP_PACKETRINGTRANS_NOMULTICASTSUPPORT, "The packet ring transmitter does not support multicasting" },
+	{ ERR_RTP_PACKETRINGTRANS_NOSUCHINTERFACE, "The interface specified for the packet ring transmitter does not exist" },
+	{ ERR_RTP_PACKETRINGTRANS_NOTCREATED, "The packet ring transmitter has not been created yet" },
+	{ ERR_RTP_PACKETRINGTRANS_NOTINIT, "The packet ring transmitter has not been initialized yet" },
+	{ ERR_RTP_PACKETRINGTRANS_NOTWAITING, "The packet ring transmitter is not waiting for incoming data" },
+	{ ERR_RTP_PACKETRINGTRANS_RECEIVEONLY, "The packet ring transmitter is receive-only and cannot send RTP data" },
+	{ ERR_RTP_LOOPBACKTRANS_ADDRESSINUSE, "The specified address is already in use on the loopback network" },
+	{ ERR_RTP_LOOPBACKTRANS_ALREADYCREATED, "The loopback transmitter was already created" },
+	{ ERR_RTP_LOOPBACKTRANS_ALREADYINIT, "The loopback transmitter was already initialized" },
+	{ ERR_RTP_LOOPBACKTRANS_ALREADYWAITING, "The loopback transmitter is already waiting for incoming data" },
+	{ ERR_RTP_LOOPBACKTRANS_BADRECEIVEMODE, "The loopback transmitter only supports the receive mode 'accept all'" },
+	{ ERR_RTP_LOOPBACKTRANS_CANTINITMUTEX, "Unable to initialize a mutex for the loopback transmitter or network" },
+	{ ERR_RTP_LOOPBACKTRANS_ILLEGALPARAMETERS, "Illegal parameters for the loopback transmitter" },
+	{ ERR_RTP_LOOPBACKTRANS_INVALIDADDRESSTYPE, "The loopback transmitter only accepts IPv4 addresses" },
+	{ ERR_RTP_LOOPBACKTRANS_NOACCEPTLIST, "The loopback transmitter does not support an accept list" },
+	{ ERR_RTP_LOOPBACKTRANS_NOIGNORELIST, "The loopback transmitter does not support an ignore list" },
+	{ ERR_RTP_LOOPBACKTRANS_NOMULTICASTSUPPORT, "The loopback transmitter does not support multicasting" },
+	{ ERR_RTP_LOOPBACKTRANS_NONETWORK, "No loopback network was specified in the transmission parameters" },
+	{ ERR_RTP_LOOPBACKTRANS_NOTCREATED, "The loopback transmitter has not been created yet" },
+	{ ERR_RTP_LOOPBACKTRANS_NOTINIT, "The loopback transmitter has not been initialized yet" },
+	{ ERR_RTP_LOOPBACKTRANS_NOTWAITING, "The loopback transmitter is not waiting for incoming data" },
+	{ ERR_RTP_LOOPBACKTRANS_PORTBASENOTEVEN, "The portbase for the loopback transmitter must be even" },
+	{ ERR_RTP_LOOPBACKTRANS_SPECIFIEDSIZETOOBIG, "The specified packet size exceeds the maximum packet size of the loopback transmitter" },
+	{ ERR_RTP_SPSCQUEUE_INVALIDSIZE, "The requested size of the lock-free queue is zero or too large" },
+	{ ERR_RTP_SOURCESNAPSHOT_ALREADYINIT, "The source snapshot was already initialized" },
+	{ ERR_RTP_TRANSMITTER_GATHERNOTSUPPORTED, "The transmitter cannot send a packet which is stored in several parts" },
+	{ ERR_RTP_TRANSMITTER_TOOMANYGATHERPARTS, "Too many parts were specified for a single packet" },
+	{ ERR_RTP_POOLEDMEMORYMANAGER_INVALIDSIZE, "The requested block size is too large to be pooled" },
+	{ ERR_RTP_POOLEDMEMORYMANAGER_MAXIMUMREACHED, "The maximum amount of pooled memory would be exceeded" },
+	{ ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER, "When building an RTCP compound packet in place, the SDES, APP and BYE information must be added in that order" },
+	{ ERR_RTP_EXTERNALTRANS_NOADDRESS, "No sender address was specified for a packet that was injected in the external transmitter" },
 	{ 0,0 }
 };
 
@@ -246,6 +246,52 @@ std::string JRTPLIB_IMPORTEXPORT RTPGetErrorString(int errcode);
 #define ERR_RTP_TCPTRANS_SOCKETNOTFOUNDINDESTINATIONS             -195
 #define ERR_RTP_TCPTRANS_ERRORINSEND                              -196
 #define ERR_RTP_TCPTRANS_ERRORINRECV                              -197
+#define ERR_RTP_PACKETRINGTRANS_ALREADYCREATED                    -198
+#define ERR_RTP_PACKETRINGTRANS_ALREADYINIT                       -199
+#define ERR_RTP_PACKETRINGTRANS_ALREADYWAITING                    -200
+#define ERR_RTP_PACKETRINGTRANS_BADRECEIVEMODE                    -201
+#define ERR_RTP_PACKETRINGTRANS_CANTATTACHFILTER                  -202
+#define ERR_RTP_PACKETRINGTRANS_CANTBINDSOCKET                    -203
+#define ERR_RTP_PACKETRINGTRANS_CANTCREATESOCKET                  -204
+#define ERR_RTP_PACKETRINGTRANS_CANTINITMUTEX                     -205
+#define ERR_RTP_PACKETRINGTRANS_CANTMAPRING                       -206
+#define ERR_RTP_PACKETRINGTRANS_CANTSETPROMISCUOUS                -207
+#define ERR_RTP_PACKETRINGTRANS_CANTSETUPRING                     -208
+#define ERR_RTP_PACKETRINGTRANS_ILLEGALPARAMETERS                 -209
+#define ERR_RTP_PACKETRINGTRANS_NOACCEPTLIST                      -210
+#define ERR_RTP_PACKETRINGTRANS_NODESTINATIONSSUPPORTED           -211
+#define ERR_RTP_PACKETRINGTRANS_NOIGNORELIST                      -212
+#define ERR_RTP_PACKETRINGTRANS_NOMULTICASTSUPPORT                -213
+#define ERR_RTP_PACKETRINGTRANS_NOSUCHINTERFACE                   -214
+#define ERR_RTP_PACKETRINGTRANS_NOTCREATED                        -215
+#define ERR_RTP_PACKETRINGTRANS_NOTINIT                           -216
+#define ERR_RTP_PACKETRINGTRANS_NOTWAITING                        -217
+#define ERR_RTP_PACKETRINGTRANS_RECEIVEONLY                       -218
+#define ERR_RTP_LOOPBACKTRANS_ADDRESSINUSE                        -219
+#define ERR_RTP_LOOPBACKTRANS_ALREADYCREATED                      -220
+#define ERR_RTP_LOOPBACKTRANS_ALREADYINIT                         -221
+#define ERR_RTP_LOOPBACKTRANS_ALREADYWAITING                      -222
+#define ERR_RTP_LOOPBACKTRANS_BADRECEIVEMODE                      -223
+#define ERR_RTP_LOOPBACKTRANS_CANTINITMUTEX                       -224
+#define ERR_RTP_LOOPBACKTRANS_ILLEGALPARAMETERS                   -225
+#define ERR_RTP_LOOPBACKTRANS_INVALIDADDRESSTYPE                  -226
+#define ERR_RTP_LOOPBACKTRANS_NOACCEPTLIST                        -227
+#define ERR_RTP_LOOPBACKTRANS_NOIGNORELIST                        -228
+#define ERR_RTP_LOOPBACKTRANS_NOMULTICASTSUPPORT                  -229
+#define ERR_RTP_LOOPBACKTRANS_NONETWORK                           -230
+#define ERR_RTP_LOOPBACKTRANS_NOTCREATED                          -231
+#define ERR_RTP_LOOPBACKTRANS_NOTINIT                             -232
+#define ERR_RTP_LOOPBACKTRANS_NOTWAITING                          -233
+#define ERR_RTP_LOOPBACKTRANS_PORTBASENOTEVEN                     -234
+#define ERR_RTP_LOOPBACKTRANS_SPECIFIEDSIZETOOBIG                 -235
+#define ERR_RTP_SPSCQUEUE_INVALIDSIZE                             -236
+#define ERR_RTP_SOURCESNAPSHOT_ALREADYINIT                        -237
+#define ERR_RTP_TRANSMITTER_GATHERNOTSUPPORTED                    -238
+#define ERR_RTP_TRANSMITTER_TOOMANYGATHERPARTS                    -239
+#define ERR_RTP_POOLEDMEMORYMANAGER_INVALIDSIZE                   -240
+#define ERR_RTP_POOLEDMEMORYMANAGER_MAXIMUMREACHED                -241
+#define ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER                  -242
+#define ERR_RTP_EXTERNALTRANS_NOADDRESS                           -243
 
 #endif // RTPERRORS_H
 
@@ -63,7 +63,7 @@
 namespace jrtplib
 {
 
-RTPExternalTransmitter::RTPExternalTransmitter(RTPMemoryManager *mgr) : RTPTransmitter(mgr), packetinjector((RTPExternalTransmitter *)this)
+RTPExternalTransmitter::RTPExternalTransmitter(RTPMemoryManager *mgr) : RTPTransmitter(mgr), packetinjector((RTPExternalTransmitter *)this), rawpacketqueue(mgr)
 {
 	created = false;
 	init = false;
@@ -137,7 +137,7 @@ int RTPExternalTransmitter::Create(size_t maximumpacketsize,const RTPTransmissio
 		MAINMUTEX_UNLOCK
 		return status;
 	}
-	m_abortCount = 0;
+	m_abortSignalled.Set(0);
 	
 	maxpacksize = maximumpacketsize;
 	sender = params->GetSender();
@@ -148,6 +148,7 @@ int RTPExternalTransmitter::Create(size_t maximumpacketsize,const RTPTransmissio
 
 	waitingfordata = false;
 	created = true;
+	m_injectEnabled.Set(1);
 	MAINMUTEX_UNLOCK
 	return 0;
 }
@@ -171,13 +172,18 @@ void RTPExternalTransmitter::Destroy()
 		localhostnamelength = 0;
 	}
 	
+	// Injecting threads don't use the mutex, so wait until the ones that are
+	// still busy have finished before cleaning up
+	m_injectEnabled.Set(0);
+	while (m_injectCount.Get() != 0)
+		RTPTime::Wait(RTPTime(0,100));
+
 	FlushPackets();
 	created = false;
 	
 	if (waitingfordata)
 	{
 		m_abortDesc.SendAbortSignal();
-		m_abortCount++;
 		m_abortDesc.Destroy();
 		MAINMUTEX_UNLOCK
 		WAITMUTEX_LOCK // to make sure that the WaitForIncomingData function ended
@@ -287,7 +293,7 @@ int RTPExternalTransmitter::WaitForIncomingData(const RTPTime &delay,bool *dataa
 	
 	waitingfordata = true;
 
-	if (!rawpacketlist.empty())
+	if (!rawpacketqueue.IsEmpty())
 	{
 		if (dataavailable != 0)
 			*dataavailable = true;
@@ -321,15 +327,17 @@ int RTPExternalTransmitter::WaitForIncomingData(const RTPTime &delay,bool *dataa
 	}
 		
 	// if aborted, read from abort buffer
+	// (the flag is only reset afterwards, so that a signal that's sent in between
+	// is not lost)
 	if (isset)
 	{
 		m_abortDesc.ClearAbortSignal();
-		m_abortCount = 0;
+		m_abortSignalled.Set(0);
 	}
 
 	if (dataavailable != 0)
 	{
-		if (rawpacketlist.empty())
+		if (rawpacketqueue.IsEmpty())
 			*dataavailable = false;
 		else
 			*dataavailable = true;
@@ -357,8 +365,8 @@ int RTPExternalTransmitter::AbortWait()
 		return ERR_RTP_EXTERNALTRANS_NOTWAITING;
 	}
 
-	m_abortDesc.SendAbortSignal();
-	m_abortCount++;
+	if (m_abortSignalled.Exchange(1) == 0)
+		m_abortDesc.SendAbortSignal();
 	
 	MAINMUTEX_UNLOCK
 	return 0;
@@ -427,6 +435,80 @@ int RTPExternalTransmitter::SendRTCPData(const void *data,size_t len)
 	return 0;
 }
 
+int RTPExternalTransmitter::SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	if (!init)
+		return ERR_RTP_EXTERNALTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_EXTERNALTRANS_NOTCREATED;
+	}
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		if (packets[i].length > maxpacksize)
+		{
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_EXTERNALTRANS_SPECIFIEDSIZETOOBIG;
+		}
+	}
+	
+	if (!sender)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_EXTERNALTRANS_NOSENDER;
+	}
+
+	MAINMUTEX_UNLOCK
+
+	if (numpackets == 0)
+		return 0;
+	if (!sender->SendRTPBatch(packets, numpackets))
+		return ERR_RTP_EXTERNALTRANS_SENDERROR;
+
+	return 0;
+}
+
+int RTPExternalTransmitter::SendRTCPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	if (!init)
+		return ERR_RTP_EXTERNALTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_EXTERNALTRANS_NOTCREATED;
+	}
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		if (packets[i].length > maxpacksize)
+		{
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_EXTERNALTRANS_SPECIFIEDSIZETOOBIG;
+		}
+	}
+	
+	if (!sender)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_EXTERNALTRANS_NOSENDER;
+	}
+
+	MAINMUTEX_UNLOCK
+
+	if (numpackets == 0)
+		return 0;
+	if (!sender->SendRTCPBatch(packets, numpackets))
+		return ERR_RTP_EXTERNALTRANS_SENDERROR;
+		
+	return 0;
+}
+
 int RTPExternalTransmitter::AddDestination(const RTPAddress &)
 {
 	return ERR_RTP_EXTERNALTRANS_NODESTINATIONSSUPPORTED;
@@ -526,51 +608,23 @@ int RTPExternalTransmitter::SetMaximumPacketSize(size_t s)
 
 bool RTPExternalTransmitter::NewDataAvailable()
 {
-	if (!init)
+	// No locking is needed here: this is only called from the thread
+	// which processes the incoming packets
+	if (!init || !created)
 		return false;
 	
-	MAINMUTEX_LOCK
-	
-	bool v;
-		
-	if (!created)
-		v = false;
-	else
-	{
-		if (rawpacketlist.empty())
-			v = false;
-		else
-			v = true;
-	}
-	
-	MAINMUTEX_UNLOCK
-	return v;
+	return !rawpacketqueue.IsEmpty();
 }
 
 RTPRawPacket *RTPExternalTransmitter::GetNextPacket()
 {
-	if (!init)
+	if (!init || !created)
 		return 0;
 	
-	MAINMUTEX_LOCK
-	
 	RTPRawPacket *p;
 	
-	if (!created)
-	{
-		MAINMUTEX_UNLOCK
-		return 0;
-	}
-	if (rawpacketlist.empty())
-	{
-		MAINMUTEX_UNLOCK
+	if (!rawpacketqueue.Pop(&p))
 		return 0;
-	}
-
-	p = *(rawpacketlist.begin());
-	rawpacketlist.pop_front();
-
-	MAINMUTEX_UNLOCK
 	return p;
 }
 
@@ -578,161 +632,143 @@ RTPRawPacket *RTPExternalTransmitter::GetNextPacket()
 
 void RTPExternalTransmitter::FlushPackets()
 {
-	std::list<RTPRawPacket*>::const_iterator it;
+	RTPRawPacket *p;
 
-	for (it = rawpacketlist.begin() ; it != rawpacketlist.end() ; ++it)
-		RTPDelete(*it,GetMemoryManager());
-	rawpacketlist.clear();
+	while (rawpacketqueue.Pop(&p))
+		RTPDelete(p,GetMemoryManager());
 }
 
 void RTPExternalTransmitter::InjectRTP(const void *data, size_t len, const RTPAddress &a)
 {
-	if (!init)
-		return;
-
-	MAINMUTEX_LOCK
-	if (!created)
-	{
-		MAINMUTEX_UNLOCK
-		return;
-	}
-
-	RTPAddress *addr = a.CreateCopy(GetMemoryManager());
-	if (addr == 0)
-		return;
-
-	uint8_t *datacopy;
-
-	datacopy = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET) uint8_t[len];
-	if (datacopy == 0)
-	{
-		RTPDelete(addr,GetMemoryManager());
-		return;
-	}
-	memcpy(datacopy, data, len);
-
-	RTPTime curtime = RTPTime::CurrentTime();
-	RTPRawPacket *pack;
-
-	pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(datacopy,len,addr,curtime,true,GetMemoryManager());
-	if (pack == 0)
-	{
-		RTPDelete(addr,GetMemoryManager());
-		RTPDeleteByteArray(localhostname,GetMemoryManager());
-		return;
-	}
-	rawpacketlist.push_back(pack);
+	RTPExternalInjectedPacket packet(data, len, a, RTPExternalInjectedPacket::RTP);
+	InjectPackets(&packet, 1);
+}
 
-	if (m_abortCount == 0)
-	{
-		m_abortDesc.SendAbortSignal();
-		m_abortCount++;
-	}
+void RTPExternalTransmitter::InjectRTCP(const void *data, size_t len, const RTPAddress &a)
+{
+	RTPExternalInjectedPacket packet(data, len, a, RTPExternalInjectedPacket::RTCP);
+	InjectPackets(&packet, 1);
+}
 
-	MAINMUTEX_UNLOCK
+void RTPExternalTransmitter::InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a)
+{
+	RTPExternalInjectedPacket packet(data, len, a, RTPExternalInjectedPacket::RTPorRTCP);
+	InjectPackets(&packet, 1);
 }
 
-void RTPExternalTransmitter::InjectRTCP(const void *data, size_t len, const RTPAddress &a)
+void RTPExternalTransmitter::InjectPackets(const RTPExternalInjectedPacket *packets, size_t numpackets)
 {
 	if (!init)
-		return;
-
-	MAINMUTEX_LOCK
-	if (!created)
 	{
-		MAINMUTEX_UNLOCK
+		ReleaseInjectedData(packets, numpackets);
 		return;
 	}
 
-	RTPAddress *addr = a.CreateCopy(GetMemoryManager());
-	if (addr == 0)
-		return;
-
-	uint8_t *datacopy;
-
-	datacopy = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[len];
-	if (datacopy == 0)
+	// No lock is taken here, several threads can inject packets at the same
+	// time; Destroy waits until the count of busy injectors drops to zero
+	m_injectCount.FetchAdd(1);
+	if (m_injectEnabled.Get() == 0)
 	{
-		RTPDelete(addr,GetMemoryManager());
+		m_injectCount.FetchAdd(-1);
+		ReleaseInjectedData(packets, numpackets);
 		return;
 	}
-	memcpy(datacopy, data, len);
 
 	RTPTime curtime = RTPTime::CurrentTime();
-	RTPRawPacket *pack;
+	bool signal = false;
 
-	pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(datacopy,len,addr,curtime,false,GetMemoryManager());
-	if (pack == 0)
+	for (size_t i = 0 ; i < numpackets ; i++)
 	{
-		RTPDelete(addr,GetMemoryManager());
-		RTPDeleteByteArray(localhostname,GetMemoryManager());
-		return;
+		RTPRawPacket *pack;
+
+		// Like the other inject functions, packets which can't be stored are dropped
+		if (CreateRawPacket(packets[i], curtime, &pack) >= 0)
+		{
+			bool wasempty = false;
+
+			if (rawpacketqueue.Push(pack, &wasempty) < 0)
+				RTPDelete(pack,GetMemoryManager());
+			else if (wasempty)
+				signal = true;
+		}
 	}
-	rawpacketlist.push_back(pack);
 
-	if (m_abortCount == 0)
-	{
+	// Only wake up the session when the queue went from empty to non-empty,
+	// and only if no wake-up is pending yet
+	if (signal && m_abortSignalled.Exchange(1) == 0)
 		m_abortDesc.SendAbortSignal();
-		m_abortCount++;
-	}
 
-	MAINMUTEX_UNLOCK
+	m_injectCount.FetchAdd(-1);
 }
 
-void RTPExternalTransmitter::InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a)
+int RTPExternalTransmitter::CreateRawPacket(const RTPExternalInjectedPacket &packet, RTPTime &curtime, RTPRawPacket **rawpack)
 {
-	if (!init)
-		return;
-
-	MAINMUTEX_LOCK
-	if (!created)
+	if (packet.address == 0)
 	{
-		MAINMUTEX_UNLOCK
-		return;
+		ReleaseInjectedData(&packet, 1);
+		return ERR_RTP_EXTERNALTRANS_NOADDRESS;
 	}
 
-	RTPAddress *addr = a.CreateCopy(GetMemoryManager());
-	if (addr == 0)
-		return;
-
-	uint8_t *datacopy;
+	const uint8_t *data = (const uint8_t *)packet.data;
+	size_t len = packet.length;
 	bool rtp = true;
 
-	if (len >= 2)
+	if (packet.type == RTPExternalInjectedPacket::RTCP)
+		rtp = false;
+	else if (packet.type == RTPExternalInjectedPacket::RTPorRTCP)
 	{
-		const uint8_t *pData = (const uint8_t *)data;
-		if (pData[1] >= 200 && pData[1] <= 204)
+		if (len >= 2 && data[1] >= 200 && data[1] <= 204)
 			rtp = false;
 	}
 
-	datacopy = RTPNew(GetMemoryManager(),(rtp)?RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[len];
-	if (datacopy == 0)
+	RTPAddress *addr = packet.address->CreateCopy(GetMemoryManager());
+	if (addr == 0)
 	{
-		RTPDelete(addr,GetMemoryManager());
-		return;
+		ReleaseInjectedData(&packet, 1);
+		return ERR_RTP_OUTOFMEM;
+	}
+
+	uint8_t *packetdata;
+
+	if (packet.freecallback)
+		packetdata = (uint8_t *)data; // the data is handed over to us
+	else
+	{
+		packetdata = RTPNew(GetMemoryManager(),(rtp)?RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[len];
+		if (packetdata == 0)
+		{
+			RTPDelete(addr,GetMemoryManager());
+			return ERR_RTP_OUTOFMEM;
+		}
+		memcpy(packetdata, data, len);
 	}
-	memcpy(datacopy, data, len);
 
-	RTPTime curtime = RTPTime::CurrentTime();
 	RTPRawPacket *pack;
 
-	pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(datacopy,len,addr,curtime,rtp,GetMemoryManager());
+	pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(packetdata,len,addr,curtime,rtp,GetMemoryManager());
 	if (pack == 0)
 	{
 		RTPDelete(addr,GetMemoryManager());
-		RTPDeleteByteArray(localhostname,GetMemoryManager());
-		return;
+		if (packet.freecallback)
+			packet.freecallback(packetdata, packet.freecallbackparam);
+		else
+			RTPDeleteByteArray(packetdata,GetMemoryManager());
+		return ERR_RTP_OUTOFMEM;
 	}
-	rawpacketlist.push_back(pack);
+	if (packet.freecallback)
+		pack->SetDataFreeCallback(packet.freecallback, packet.freecallbackparam);
+
+	*rawpack = pack;
+	return 0;
+}
 
-	if (m_abortCount == 0)
+void RTPExternalTransmitter::ReleaseInjectedData(const RTPExternalInjectedPacket *packets, size_t numpackets)
+{
+	for (size_t i = 0 ; i < numpackets ; i++)
 	{
-		m_abortDesc.SendAbortSignal();
-		m_abortCount++;
+		if (packets[i].freecallback)
+			packets[i].freecallback((uint8_t *)packets[i].data, packets[i].freecallbackparam);
 	}
-
-	MAINMUTEX_UNLOCK
-
 }
 
 #ifdef RTPDEBUG
@@ -748,7 +784,7 @@ void RTPExternalTransmitter::Dump()
 			std::cout << "Not created" << std::endl;
 		else
 		{
-			std::cout << "Number of raw packets in queue: " << rawpacketlist.size() << std::endl;
+			std::cout << "Number of raw packets in queue: " << rawpacketqueue.GetCount() << std::endl;
 			std::cout << "Maximum allowed packet size:    " << maxpacksize << std::endl;
 		}
 		
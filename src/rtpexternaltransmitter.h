@@ -41,7 +41,9 @@
 #include "rtpconfig.h"
 #include "rtptransmitter.h"
 #include "rtpabortdescriptors.h"
-#include <list>
+#include "rtprawpacket.h"
+#include "rtpmpscqueue.h"
+#include "rtpatomic.h"
 
 #ifdef RTP_SUPPORT_THREAD
 	#include <jthread/jmutex.h>
@@ -74,6 +76,83 @@ public:
 
 	/** Used to identify if an RTPAddress instance originated from this sender (to be able to detect own packets). */
 	virtual bool ComesFromThisSender(const RTPAddress *a) = 0;
+
+	/** This member function will be called when several RTP packets need to be transmitted at once.
+	 *  This member function will be called when several RTP packets need to be transmitted at once,
+	 *  for example when a frame is split over multiple packets using RTPSession::SendFrame. The
+	 *  default implementation calls \c SendRTP for each packet; override it if your mechanism
+	 *  can transmit a batch of packets more efficiently (e.g. using a single system call).
+	 */
+	virtual bool SendRTPBatch(const RTPDataSpan *packets, size_t numpackets);
+
+	/** This member function will be called when several RTCP packets need to be transmitted at once.
+	 *  This member function will be called when several RTCP packets need to be transmitted at once.
+	 *  The default implementation calls \c SendRTCP for each packet.
+	 */
+	virtual bool SendRTCPBatch(const RTPDataSpan *packets, size_t numpackets);
+};
+
+inline bool RTPExternalSender::SendRTPBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		if (!SendRTP(packets[i].data, packets[i].length))
+			return false;
+	}
+	return true;
+}
+
+inline bool RTPExternalSender::SendRTCPBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		if (!SendRTCP(packets[i].data, packets[i].length))
+			return false;
+	}
+	return true;
+}
+
+/** Describes a packet that can be injected using RTPExternalPacketInjecter::InjectPackets.
+ *  Describes a packet that can be injected using RTPExternalPacketInjecter::InjectPackets. If
+ *  no free callback is set, the data will be copied, just like the other inject functions do.
+ *  If a free callback is set, the buffer itself becomes the packet data and the library takes
+ *  ownership of it: the callback will be called with the data and parameter when the library no
+ *  longer needs the data. This is also the case when the packet could not be stored, so a
+ *  buffer which was handed over never has to be released by the caller. A packet without an
+ *  address, e.g. a default constructed one, cannot be stored and is ignored.
+ */
+class JRTPLIB_IMPORTEXPORT RTPExternalInjectedPacket
+{
+public:
+	/** Specifies if the packet contains RTP data, RTCP data or if this should be determined from the packet's header. */
+	enum PacketType { RTP, RTCP, RTPorRTCP };
+
+	RTPExternalInjectedPacket()								{ data = 0; length = 0; address = 0; type = RTPorRTCP; freecallback = 0; freecallbackparam = 0; }
+
+	/** Describes a packet of which the data will be copied. */
+	RTPExternalInjectedPacket(const void *d, size_t len, const RTPAddress &a, PacketType t)	{ data = d; length = len; address = &a; type = t; freecallback = 0; freecallbackparam = 0; }
+
+	/** Describes a packet of which the data will be handed over to the library, to be released by \c f. */
+	RTPExternalInjectedPacket(void *d, size_t len, const RTPAddress &a, PacketType t, RTPRawPacketFreeCallback f, void *param)
+											{ data = d; length = len; address = &a; type = t; freecallback = f; freecallbackparam = param; }
+
+	/** The packet data. */
+	const void *data;
+
+	/** The length of the packet data. */
+	size_t length;
+
+	/** The address the packet came from, which will be copied. */
+	const RTPAddress *address;
+
+	/** The type of the packet. */
+	PacketType type;
+
+	/** If set, the data is handed over and this function will be called to release it. */
+	RTPRawPacketFreeCallback freecallback;
+
+	/** The parameter that will be passed to the free callback. */
+	void *freecallbackparam;
 };
 
 /** Interface to inject incoming RTP and RTCP packets into the library.
@@ -97,6 +176,22 @@ public:
 
 	/** Use this function to inject an RTP or RTCP packet and the transmitter will try to figure out which type of packet it is. */
 	void InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a);
+
+	/** Injects an RTP packet without copying the data; the buffer is handed over and will be released by calling \c f with parameter \c param. */
+	void InjectRTPNoCopy(void *data, size_t len, const RTPAddress &a, RTPRawPacketFreeCallback f, void *param);
+
+	/** Injects an RTCP packet without copying the data; the buffer is handed over and will be released by calling \c f with parameter \c param. */
+	void InjectRTCPNoCopy(void *data, size_t len, const RTPAddress &a, RTPRawPacketFreeCallback f, void *param);
+
+	/** Injects an RTP or RTCP packet without copying the data; the buffer is handed over and will be released by calling \c f with parameter \c param. */
+	void InjectRTPorRTCPNoCopy(void *data, size_t len, const RTPAddress &a, RTPRawPacketFreeCallback f, void *param);
+
+	/** Injects \c numpackets packets at once.
+	 *  Injects \c numpackets packets at once. The transmitter's lock is only taken once for the
+	 *  entire batch, and a session which is waiting for incoming data is only woken up once.
+	 *  See RTPExternalInjectedPacket for the way the data of each packet is handled.
+	 */
+	void InjectPackets(const RTPExternalInjectedPacket *packets, size_t numpackets);
 private:
 	RTPExternalTransmitter *transmitter;
 };
@@ -136,6 +231,9 @@ private:
  *  a class derived from RTPExternalSender to specify the functions which need to be used for
  *  sending the data. Obtain the RTPExternalTransmissionInfo object associated with this
  *  transmitter to obtain the functions needed to pass RTP/RTCP packets on to the transmitter.
+ *  Injected packets are stored in a lock-free queue, so several threads can inject packets
+ *  at the same time without contending for a lock. Note that in that case the memory manager,
+ *  if one is installed, must be able to handle concurrent allocations.
  */
 class JRTPLIB_IMPORTEXPORT RTPExternalTransmitter : public RTPTransmitter
 {
@@ -160,6 +258,8 @@ public:
 	
 	int SendRTPData(const void *data,size_t len);	
 	int SendRTCPData(const void *data,size_t len);
+	int SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets);
+	int SendRTCPDataBatch(const RTPDataSpan *packets, size_t numpackets);
 
 	int AddDestination(const RTPAddress &addr);
 	int DeleteDestination(const RTPAddress &addr);
@@ -188,8 +288,11 @@ public:
 	void InjectRTP(const void *data, size_t len, const RTPAddress &a);
 	void InjectRTCP(const void *data, size_t len, const RTPAddress &a);
 	void InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a);
+	void InjectPackets(const RTPExternalInjectedPacket *packets, size_t numpackets);
 private:
 	void FlushPackets();
+	int CreateRawPacket(const RTPExternalInjectedPacket &packet, RTPTime &curtime, RTPRawPacket **rawpack);
+	void ReleaseInjectedData(const RTPExternalInjectedPacket *packets, size_t numpackets);
 	
 	bool init;
 	bool created;
@@ -197,7 +300,8 @@ private:
 	RTPExternalSender *sender;
 	RTPExternalPacketInjecter packetinjector;
 
-	std::list<RTPRawPacket*> rawpacketlist;
+	RTPMPSCQueue<RTPRawPacket*> rawpacketqueue;
+	RTPAtomicInteger m_injectEnabled, m_injectCount;
 
 	uint8_t *localhostname;
 	size_t localhostnamelength;
@@ -206,7 +310,7 @@ private:
 	int headersize;
 
 	RTPAbortDescriptors m_abortDesc;
-	int m_abortCount;
+	RTPAtomicInteger m_abortSignalled;
 #ifdef RTP_SUPPORT_THREAD
 	jthread::JMutex mainmutex,waitmutex;
 	int threadsafe;
@@ -228,6 +332,29 @@ inline void RTPExternalPacketInjecter::InjectRTPorRTCP(const void *data, size_t
 	transmitter->InjectRTPorRTCP(data, len, a); 
 }
 
+inline void RTPExternalPacketInjecter::InjectRTPNoCopy(void *data, size_t len, const RTPAddress &a, RTPRawPacketFreeCallback f, void *param)
+{
+	RTPExternalInjectedPacket packet(data, len, a, RTPExternalInjectedPacket::RTP, f, param);
+	transmitter->InjectPackets(&packet, 1);
+}
+
+inline void RTPExternalPacketInjecter::InjectRTCPNoCopy(void *data, size_t len, const RTPAddress &a, RTPRawPacketFreeCallback f, void *param)
+{
+	RTPExternalInjectedPacket packet(data, len, a, RTPExternalInjectedPacket::RTCP, f, param);
+	transmitter->InjectPackets(&packet, 1);
+}
+
+inline void RTPExternalPacketInjecter::InjectRTPorRTCPNoCopy(void *data, size_t len, const RTPAddress &a, RTPRawPacketFreeCallback f, void *param)
+{
+	RTPExternalInjectedPacket packet(data, len, a, RTPExternalInjectedPacket::RTPorRTCP, f, param);
+	transmitter->InjectPackets(&packet, 1);
+}
+
+inline void RTPExternalPacketInjecter::InjectPackets(const RTPExternalInjectedPacket *packets, size_t numpackets)
+{
+	transmitter->InjectPackets(packets, numpackets);
+}
+
 } // end namespace
 
 #endif // RTPTCPSOCKETTRANSMITTER_H
@@ -0,0 +1,98 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpflathashtable.h
+ */
+
+#ifndef RTPFLATHASHTABLE_H
+
+#define RTPFLATHASHTABLE_H
+
+#include "rtpconfig.h"
+#include "rtpflatkeyhashtable.h"
+
+#ifdef RTPDEBUG
+#include <iostream>
+#endif // RTPDEBUG
+
+namespace jrtplib
+{
+
+class RTPFlatHashTable_NoValue
+{
+};
+
+#ifdef RTPDEBUG
+inline std::ostream &operator<<(std::ostream &s,const RTPFlatHashTable_NoValue &)
+{
+	return s;
+}
+#endif // RTPDEBUG
+
+// Open addressing variant of RTPHashTable, the element itself is used as 
+// the key of an RTPFlatKeyHashTable.
+
+template<class Element,class GetIndex>
+class RTPFlatHashTable
+{
+	JRTPLIB_NO_COPY(RTPFlatHashTable)
+public:
+	RTPFlatHashTable(RTPMemoryManager *mgr = 0,int memtype = RTPMEM_TYPE_OTHER) : table(mgr,memtype)	{ }
+	~RTPFlatHashTable()					{ }
+
+	void GotoFirstElement()					{ table.GotoFirstElement(); }
+	void GotoLastElement()					{ table.GotoLastElement(); }
+	bool HasCurrentElement()				{ return table.HasCurrentElement(); }
+	int DeleteCurrentElement()				{ return table.DeleteCurrentElement(); }
+	Element &GetCurrentElement()				{ return table.GetCurrentKey(); }
+	int GotoElement(const Element &e)			{ return table.GotoElement(e); }
+	bool HasElement(const Element &e)			{ return table.HasElement(e); }
+	void GotoNextElement()					{ table.GotoNextElement(); }
+	void GotoPreviousElement()				{ table.GotoPreviousElement(); }
+	void Clear()						{ table.Clear(); }
+
+	int AddElement(const Element &elem)			{ return table.AddElement(elem,RTPFlatHashTable_NoValue()); }
+	int DeleteElement(const Element &elem)			{ return table.DeleteElement(elem); }
+
+	int GetNumberOfElements() const				{ return table.GetNumberOfElements(); }
+#ifdef RTPDEBUG
+	void Dump()						{ table.Dump(); }
+#endif // RTPDEBUG
+private:
+	RTPFlatKeyHashTable<Element,RTPFlatHashTable_NoValue,GetIndex> table;
+};
+
+} // end namespace
+
+#endif // RTPFLATHASHTABLE_H
+
@@ -0,0 +1,579 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpflatkeyhashtable.h
+ */
+
+#ifndef RTPFLATKEYHASHTABLE_H
+
+#define RTPFLATKEYHASHTABLE_H
+
+#include "rtpconfig.h"
+#include "rtperrors.h"
+#include "rtpmemoryobject.h"
+#include <new>
+
+#ifdef RTPDEBUG
+#include <iostream>
+#endif // RTPDEBUG
+
+#define RTPFLATKEYHASHTABLE_SLOTSPERELEMENT						16
+
+namespace jrtplib
+{
+
+// The lookup table stores a copy of the key, which needs to be assignable
+template<class T> class RTPFlatKeyHashTable_StoredKey { public: typedef T Type; };
+template<class T> class RTPFlatKeyHashTable_StoredKey<const T> { public: typedef T Type; };
+
+// Open addressing variant of RTPKeyHashTable. The elements are stored in a 
+// single array in the order in which they were added, which is the order in
+// which they're iterated. The lookup table is a sparse, power of two sized
+// array of (key,position) entries using Robin Hood hashing. Since a copy of
+// the key is kept in the lookup table, finding an element usually only 
+// touches one cache line; the element array is only read when the element 
+// itself is used. The key therefore should be a plain value, like an SSRC or
+// an address.
+//
+// The GetIndex class must provide a static 'GetIndex' function returning a 
+// hash value for a key; unlike for RTPKeyHashTable it doesn't need to be 
+// limited to some range.
+//
+// Adding an element can move the stored elements, so references obtained by
+// GetCurrentKey or GetCurrentElement are only valid until the next call to
+// AddElement. Deleting elements does not move anything, so it's safe to 
+// delete the current element while iterating.
+//
+// Besides using the current element, the table can also be iterated using
+// positions, which allows several iterations at the same time. A position
+// remains valid as long as the value returned by GetGeneration is the same.
+
+template<class Key,class Element,class GetIndex>
+class RTPFlatKeyHashTable : public RTPMemoryObject
+{
+	JRTPLIB_NO_COPY(RTPFlatKeyHashTable)
+public:
+	RTPFlatKeyHashTable(RTPMemoryManager *mgr = 0,int memtype = RTPMEM_TYPE_OTHER);
+	~RTPFlatKeyHashTable();
+
+	void GotoFirstElement()					{ curpos = FindUsed(0,1); }
+	void GotoLastElement()					{ curpos = FindUsed(numpositions-1,-1); }
+	bool HasCurrentElement()				{ return (curpos < 0)?false:true; }
+	int DeleteCurrentElement();
+	Element &GetCurrentElement()				{ return GetEntries()[curpos].element; }
+	Key &GetCurrentKey()					{ return GetEntries()[curpos].key; }
+	int GotoElement(const Key &k);
+	bool HasElement(const Key &k);
+	void GotoNextElement()					{ if (curpos >= 0) curpos = FindUsed(curpos+1,1); }
+	void GotoPreviousElement()				{ if (curpos >= 0) curpos = FindUsed(curpos-1,-1); }
+	void Clear();
+
+	int AddElement(const Key &k,const Element &elem);
+	int DeleteElement(const Key &k);
+
+	int GetNumberOfElements() const				{ return numelements; }
+
+	int GetFirstPosition() const				{ return FindUsed(0,1); }
+	int GetLastPosition() const				{ return FindUsed(numpositions-1,-1); }
+	int GetNextPosition(int pos) const			{ return (pos < 0)?-1:FindUsed(pos+1,1); }
+	int GetPreviousPosition(int pos) const			{ return (pos < 0)?-1:FindUsed(pos-1,-1); }
+	int GetPosition(const Key &k)				{ return FindPosition(k); }
+	bool HasElementAt(int pos) const			{ return (pos >= 0 && pos < numpositions && entryused[pos]); }
+	Element &GetElementAt(int pos)				{ return GetEntries()[pos].element; }
+	Key &GetKeyAt(int pos)					{ return GetEntries()[pos].key; }
+	uint32_t GetGeneration() const				{ return generation; }
+#ifdef RTPDEBUG
+	void Dump();
+#endif // RTPDEBUG
+private:
+	class Entry
+	{
+	public:
+		Entry(const Key &k,const Element &e,uint32_t h) : key(k),element(e),hash(h)	{ }
+
+		Key key;
+		Element element;
+		uint32_t hash;
+	};
+
+	class Slot
+	{
+	public:
+		typename RTPFlatKeyHashTable_StoredKey<Key>::Type key;
+		int position; // -1 for an empty slot
+	};
+
+	// Fibonacci hashing: the index functions are often little more than
+	// the identity function, so the key is multiplied by 2^32 divided by 
+	// the golden ratio and the slot is taken from the upper bits
+	static uint32_t CalculateHash(const Key &k)				{ return (uint32_t)GetIndex::GetIndex(k)*0x9e3779b1U; }
+	uint32_t HomeSlot(uint32_t hash) const					{ return hash >> slotshift; }
+
+	Entry *GetEntries()					{ return (Entry *)entrybuffer; }
+	int FindUsed(int pos,int direction) const;
+	int FindSlot(const Key &k,uint32_t hash);
+	int FindPosition(const Key &k) const;
+	void InsertSlot(const Key &k,uint32_t hash,int position);
+	void RemoveSlot(int slot);
+	int Reorganize(int newentrycapacity,int newslotcapacity);
+	void ReleaseBuffers();
+	void UseEmptySlots();
+
+	uint8_t *entrybuffer;
+	bool *entryused;
+	Slot *slots;
+	Slot emptyslots[2];
+	int entrycapacity,numpositions,numelements;
+	int slotcapacity;
+	uint32_t slotmask;
+	int slotshift;
+	int curpos;
+	uint32_t generation;
+#ifdef RTP_SUPPORT_MEMORYMANAGEMENT
+	int memorytype;
+#endif // RTP_SUPPORT_MEMORYMANAGEMENT
+};
+
+template<class Key,class Element,class GetIndex>
+inline RTPFlatKeyHashTable<Key,Element,GetIndex>::RTPFlatKeyHashTable(RTPMemoryManager *mgr,int memtype) : RTPMemoryObject(mgr)
+{
+	JRTPLIB_UNUSED(memtype); // possibly unused
+
+	// Nothing is allocated until the first element is added
+	entrybuffer = 0;
+	entryused = 0;
+	entrycapacity = 0;
+	numpositions = 0;
+	numelements = 0;
+	UseEmptySlots();
+	curpos = -1;
+	generation = 0;
+#ifdef RTP_SUPPORT_MEMORYMANAGEMENT
+	memorytype = memtype;
+#endif // RTP_SUPPORT_MEMORYMANAGEMENT
+}
+
+template<class Key,class Element,class GetIndex>
+inline RTPFlatKeyHashTable<Key,Element,GetIndex>::~RTPFlatKeyHashTable()
+{
+	Clear();
+	ReleaseBuffers();
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::DeleteCurrentElement()
+{
+	if (curpos < 0)
+		return ERR_RTP_HASHTABLE_NOCURRENTELEMENT;
+
+	Entry *e = GetEntries()+curpos;
+	int slot = FindSlot(e->key,e->hash);
+
+	RemoveSlot(slot);
+	e->~Entry();
+	entryused[curpos] = false;
+	numelements--;
+
+	if (numelements == 0) // we can start again at the beginning of the array
+	{
+		numpositions = 0;
+		curpos = -1;
+		generation++;
+	}
+	else
+		curpos = FindUsed(curpos+1,1); // Set to next element in the list
+	return 0;
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::GotoElement(const Key &k)
+{
+	curpos = FindPosition(k);
+	if (curpos < 0)
+		return ERR_RTP_HASHTABLE_ELEMENTNOTFOUND;
+	return 0;
+}
+
+template<class Key,class Element,class GetIndex>
+inline bool RTPFlatKeyHashTable<Key,Element,GetIndex>::HasElement(const Key &k)
+{
+	if (FindPosition(k) < 0)
+		return false;
+	return true;
+}
+
+template<class Key,class Element,class GetIndex>
+inline void RTPFlatKeyHashTable<Key,Element,GetIndex>::Clear()
+{
+	Entry *entries = GetEntries();
+
+	for (int i = 0 ; i < numpositions ; i++)
+	{
+		if (entryused[i])
+		{
+			entries[i].~Entry();
+			entryused[i] = false;
+		}
+	}
+	for (int i = 0 ; i < slotcapacity ; i++)
+		slots[i].position = -1;
+
+	numpositions = 0;
+	numelements = 0;
+	curpos = -1;
+	generation++;
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::AddElement(const Key &k,const Element &elem)
+{
+	uint32_t hash = CalculateHash(k);
+
+	if (FindSlot(k,hash) >= 0)
+		return ERR_RTP_HASHTABLE_ELEMENTALREADYEXISTS;
+
+	// Keep the lookup table at most one sixteenth full, and make room
+	// at the end of the element array. If half of the array consists of
+	// deleted elements, it's compacted instead of enlarged. With a slot
+	// of only a few bytes, a sparse lookup table is cheap and keeps most
+	// elements in their home slot, which avoids branch mispredictions
+	// during a lookup.
+
+	int newslotcapacity = slotcapacity;
+	int newentrycapacity = entrycapacity;
+
+	while ((numelements+1)*RTPFLATKEYHASHTABLE_SLOTSPERELEMENT > newslotcapacity)
+		newslotcapacity = (newslotcapacity == 0)?RTPFLATKEYHASHTABLE_SLOTSPERELEMENT:newslotcapacity*2;
+	if (numpositions == entrycapacity && (numpositions-numelements)*2 < numpositions+1)
+		newentrycapacity = (entrycapacity == 0)?1:entrycapacity*2;
+
+	if (newslotcapacity != slotcapacity || numpositions == entrycapacity)
+	{
+		int status = Reorganize(newentrycapacity,newslotcapacity);
+
+		if (status < 0)
+			return status;
+	}
+
+	new (GetEntries()+numpositions) Entry(k,elem,hash);
+	entryused[numpositions] = true;
+	InsertSlot(k,hash,numpositions);
+	numpositions++;
+	numelements++;
+	return 0;
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::DeleteElement(const Key &k)
+{
+	int status;
+
+	status = GotoElement(k);
+	if (status < 0)
+		return status;
+	return DeleteCurrentElement();
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::FindUsed(int pos,int direction) const
+{
+	while (pos >= 0 && pos < numpositions)
+	{
+		if (entryused[pos])
+			return pos;
+		pos += direction;
+	}
+	return -1;
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::FindSlot(const Key &k,uint32_t hash)
+{
+	if (numelements == 0)
+		return -1;
+
+	uint32_t mask = slotmask;
+	uint32_t idx = HomeSlot(hash);
+	uint32_t dist = 0;
+
+	// With Robin Hood hashing, we can stop as soon as we encounter an
+	// entry which is closer to its ideal position than we would be
+	while (true)
+	{
+		const Slot &s = slots[idx];
+
+		// An empty slot can still contain an old key
+		if (s.key == k && s.position >= 0)
+			return (int)idx;
+		if (s.position < 0 || ((idx-HomeSlot(CalculateHash(s.key)))&mask) < dist)
+			return -1;
+		idx = (idx+1)&mask;
+		dist++;
+	}
+	return -1;
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::FindPosition(const Key &k) const
+{
+	// Same as FindSlot, but returns the position of the element directly.
+	// This is the lookup done for each packet, so the loop is kept small.
+	const Slot *tab = slots;
+	uint32_t mask = slotmask;
+	int shift = slotshift;
+	uint32_t idx = CalculateHash(k) >> shift;
+	uint32_t dist = 0;
+	const Slot *s = tab+idx;
+
+	while (!(s->key == k))
+	{
+		if (s->position < 0 || ((idx-(CalculateHash(s->key) >> shift))&mask) < dist)
+			return -1;
+		idx = (idx+1)&mask;
+		dist++;
+		s = tab+idx;
+	}
+
+	// If this is an empty slot with an old copy of the key, the position
+	// is -1 as well
+	return s->position;
+}
+
+template<class Key,class Element,class GetIndex>
+inline void RTPFlatKeyHashTable<Key,Element,GetIndex>::InsertSlot(const Key &k,uint32_t hash,int position)
+{
+	uint32_t mask = slotmask;
+	uint32_t idx = HomeSlot(hash);
+	uint32_t dist = 0;
+	Slot newslot;
+
+	newslot.key = k;
+	newslot.position = position;
+
+	while (true)
+	{
+		Slot &s = slots[idx];
+
+		if (s.position < 0)
+		{
+			s = newslot;
+			return;
+		}
+
+		uint32_t existingdist = (idx-HomeSlot(CalculateHash(s.key)))&mask;
+
+		if (existingdist < dist) // take the place of the richer entry
+		{
+			Slot tmp = s;
+
+			s = newslot;
+			newslot = tmp;
+			dist = existingdist;
+		}
+		idx = (idx+1)&mask;
+		dist++;
+	}
+}
+
+template<class Key,class Element,class GetIndex>
+inline void RTPFlatKeyHashTable<Key,Element,GetIndex>::RemoveSlot(int slot)
+{
+	// Shift the following entries back, this way no tombstones are needed
+
+	uint32_t mask = slotmask;
+	uint32_t idx = (uint32_t)slot;
+	uint32_t next = (idx+1)&mask;
+
+	while (slots[next].position >= 0 && ((next-HomeSlot(CalculateHash(slots[next].key)))&mask) != 0)
+	{
+		slots[idx] = slots[next];
+		idx = next;
+		next = (next+1)&mask;
+	}
+	slots[idx].position = -1;
+}
+
+template<class Key,class Element,class GetIndex>
+inline int RTPFlatKeyHashTable<Key,Element,GetIndex>::Reorganize(int newentrycapacity,int newslotcapacity)
+{
+	uint8_t *newentrybuffer = entrybuffer;
+	bool *newentryused = entryused;
+	Slot *newslots = slots;
+
+	if (newentrycapacity != entrycapacity)
+	{
+		newentrybuffer = RTPNew(GetMemoryManager(),memorytype) uint8_t[sizeof(Entry)*newentrycapacity];
+		newentryused = (bool *)RTPNew(GetMemoryManager(),memorytype) uint8_t[sizeof(bool)*newentrycapacity];
+		if (newentrybuffer == 0 || newentryused == 0)
+		{
+			if (newentrybuffer)
+				RTPDeleteByteArray(newentrybuffer,GetMemoryManager());
+			if (newentryused)
+				RTPDeleteByteArray((uint8_t *)newentryused,GetMemoryManager());
+			return ERR_RTP_OUTOFMEM;
+		}
+	}
+	if (newslotcapacity != slotcapacity)
+	{
+		newslots = (Slot *)RTPNew(GetMemoryManager(),memorytype) uint8_t[sizeof(Slot)*newslotcapacity];
+		if (newslots == 0)
+		{
+			if (newentrybuffer != entrybuffer)
+			{
+				RTPDeleteByteArray(newentrybuffer,GetMemoryManager());
+				RTPDeleteByteArray((uint8_t *)newentryused,GetMemoryManager());
+			}
+			return ERR_RTP_OUTOFMEM;
+		}
+	}
+
+	// Move the elements to the start of the (new) array, leaving out the
+	// deleted ones, and keep track of where the current element ends up
+
+	Entry *entries = GetEntries();
+	Entry *newentries = (Entry *)newentrybuffer;
+	int newnumpositions = 0;
+	int newcurpos = -1;
+
+	for (int i = 0 ; i < numpositions ; i++)
+	{
+		if (!entryused[i])
+			continue;
+
+		if (i == curpos)
+			newcurpos = newnumpositions;
+		if (newentries != entries || newnumpositions != i)
+		{
+			new (newentries+newnumpositions) Entry(entries[i]);
+			entries[i].~Entry();
+			entryused[i] = false;
+		}
+		newentryused[newnumpositions] = true;
+		newnumpositions++;
+	}
+	for (int i = newnumpositions ; i < newentrycapacity ; i++)
+		newentryused[i] = false;
+
+	if (newentrybuffer != entrybuffer)
+	{
+		if (entrybuffer)
+		{
+			RTPDeleteByteArray(entrybuffer,GetMemoryManager());
+			RTPDeleteByteArray((uint8_t *)entryused,GetMemoryManager());
+		}
+		entrybuffer = newentrybuffer;
+		entryused = newentryused;
+		entrycapacity = newentrycapacity;
+	}
+	if (newslots != slots)
+	{
+		if (slots != emptyslots)
+			RTPDeleteByteArray((uint8_t *)slots,GetMemoryManager());
+		slots = newslots;
+		slotcapacity = newslotcapacity;
+		slotmask = (uint32_t)(newslotcapacity-1);
+		slotshift = 32;
+		while ((1 << (32-slotshift)) < newslotcapacity)
+			slotshift--;
+	}
+	numpositions = newnumpositions;
+	curpos = newcurpos;
+	generation++;
+
+	// The positions have changed, so the lookup table needs to be rebuilt
+
+	for (int i = 0 ; i < slotcapacity ; i++)
+		slots[i].position = -1;
+	for (int i = 0 ; i < numpositions ; i++)
+		InsertSlot(newentries[i].key,newentries[i].hash,i);
+	return 0;
+}
+
+template<class Key,class Element,class GetIndex>
+inline void RTPFlatKeyHashTable<Key,Element,GetIndex>::ReleaseBuffers()
+{
+	if (entrybuffer)
+	{
+		RTPDeleteByteArray(entrybuffer,GetMemoryManager());
+		RTPDeleteByteArray((uint8_t *)entryused,GetMemoryManager());
+	}
+	if (slots != emptyslots)
+		RTPDeleteByteArray((uint8_t *)slots,GetMemoryManager());
+	entrybuffer = 0;
+	entryused = 0;
+	entrycapacity = 0;
+	UseEmptySlots();
+}
+
+template<class Key,class Element,class GetIndex>
+inline void RTPFlatKeyHashTable<Key,Element,GetIndex>::UseEmptySlots()
+{
+	// Without any allocated slots, the lookup table points to two empty
+	// slots, so a lookup doesn't need to check for this case
+	for (int i = 0 ; i < 2 ; i++)
+	{
+		emptyslots[i].key = typename RTPFlatKeyHashTable_StoredKey<Key>::Type();
+		emptyslots[i].position = -1;
+	}
+	slots = emptyslots;
+	slotcapacity = 0;
+	slotmask = 1;
+	slotshift = 31;
+}
+
+#ifdef RTPDEBUG
+template<class Key,class Element,class GetIndex>
+inline void RTPFlatKeyHashTable<Key,Element,GetIndex>::Dump()
+{
+	Entry *entries = GetEntries();
+
+	std::cout << "DUMPING TABLE CONTENTS:" << std::endl;
+	for (int i = 0 ; i < slotcapacity ; i++)
+	{
+		if (slots[i].position >= 0)
+			std::cout << "\tSlot " << i << " | Hash " << CalculateHash(slots[i].key) << " | Position " << slots[i].position << std::endl;
+	}
+
+	std::cout << "DUMPING LIST CONTENTS:" << std::endl;
+	for (int i = 0 ; i < numpositions ; i++)
+	{
+		if (entryused[i])
+			std::cout << "\tKey " << entries[i].key << " | Element " << entries[i].element << std::endl;
+	}
+}
+#endif // RTPDEBUG
+
+} // end namespace
+
+#endif // RTPFLATKEYHASHTABLE_H
+
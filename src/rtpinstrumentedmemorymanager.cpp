@@ -0,0 +1,321 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtpinstrumentedmemorymanager.h"
+#include <new>
+
+#include "rtpdebug.h"
+
+// In front of each block the size and memory type are stored; the size of
+// this header keeps the memory that's returned to the caller suitably aligned
+#define RTPINSTRUMENTEDMEMORYMANAGER_HEADERSIZE					16
+
+#ifdef RTP_SUPPORT_THREAD
+	#define STATS_LOCK(s)		{ if (threadsafe) (s)->mutex.Lock(); }
+	#define STATS_UNLOCK(s)		{ if (threadsafe) (s)->mutex.Unlock(); }
+	#define RATE_LOCK		{ if (threadsafe) ratemutex.Lock(); }
+	#define RATE_UNLOCK		{ if (threadsafe) ratemutex.Unlock(); }
+#else
+	#define STATS_LOCK(s)
+	#define STATS_UNLOCK(s)
+	#define RATE_LOCK
+	#define RATE_UNLOCK
+#endif // RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+RTPMemoryTypeInfo::RTPMemoryTypeInfo()
+{
+	numallocations = 0;
+	numfrees = 0;
+	numfailed = 0;
+	livebytes = 0;
+	peakbytes = 0;
+	totalbytes = 0;
+	rateallocations = 0;
+	rateinterval = 0;
+	for (int i = 0 ; i < RTPINSTRUMENTEDMEMORYMANAGER_NUMHISTOGRAMBINS ; i++)
+		histogram[i] = 0;
+}
+
+double RTPMemoryTypeInfo::GetAllocationRate() const
+{
+	if (rateinterval <= 0)
+		return 0;
+	return ((double)rateallocations)/rateinterval;
+}
+
+uint64_t RTPMemoryTypeInfo::GetHistogramCount(int bin) const
+{
+	if (bin < 0 || bin >= RTPINSTRUMENTEDMEMORYMANAGER_NUMHISTOGRAMBINS)
+		return 0;
+	return histogram[bin];
+}
+
+class RTPInstrumentedMemoryManager::TypeStats
+{
+public:
+	TypeStats()
+	{
+#ifdef RTP_SUPPORT_THREAD
+		mutex.Init();
+#endif // RTP_SUPPORT_THREAD
+	}
+
+	RTPMemoryTypeInfo info;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex mutex;
+#endif // RTP_SUPPORT_THREAD
+};
+
+static inline int GetHistogramBin(size_t numbytes)
+{
+	int bin = 0;
+
+	while (bin < RTPINSTRUMENTEDMEMORYMANAGER_NUMHISTOGRAMBINS-1 && (((size_t)1) << bin) < numbytes)
+		bin++;
+	return bin;
+}
+
+RTPInstrumentedMemoryManager::RTPInstrumentedMemoryManager(RTPMemoryManager *m, bool ts) : mgr(m), threadsafe(ts), ratestart(RTPTime::CurrentTime())
+{
+	stats = new TypeStats[RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES];
+#ifdef RTP_SUPPORT_THREAD
+	ratemutex.Init();
+#endif // RTP_SUPPORT_THREAD
+}
+
+RTPInstrumentedMemoryManager::~RTPInstrumentedMemoryManager()
+{
+	delete [] stats;
+}
+
+void *RTPInstrumentedMemoryManager::AllocateBuffer(size_t numbytes, int memtype)
+{
+	if (memtype < 0 || memtype >= RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES)
+		memtype = RTPMEM_TYPE_OTHER;
+
+	TypeStats *s = &stats[memtype];
+	size_t len = numbytes+RTPINSTRUMENTEDMEMORYMANAGER_HEADERSIZE;
+	uint8_t *header;
+	
+	if (mgr == 0)
+		header = new (std::nothrow) uint8_t[len];
+	else
+		header = (uint8_t *)mgr->AllocateBuffer(len, memtype);
+
+	if (header == 0)
+	{
+		STATS_LOCK(s)
+		s->info.numfailed++;
+		STATS_UNLOCK(s)
+		return 0;
+	}
+
+	*((size_t *)header) = numbytes;
+	*((int32_t *)(header+sizeof(size_t))) = (int32_t)memtype;
+
+	int bin = GetHistogramBin(numbytes);
+
+	STATS_LOCK(s)
+	s->info.numallocations++;
+	s->info.rateallocations++;
+	s->info.totalbytes += numbytes;
+	s->info.livebytes += numbytes;
+	if (s->info.livebytes > s->info.peakbytes)
+		s->info.peakbytes = s->info.livebytes;
+	s->info.histogram[bin]++;
+	STATS_UNLOCK(s)
+
+	return header+RTPINSTRUMENTEDMEMORYMANAGER_HEADERSIZE;
+}
+
+void RTPInstrumentedMemoryManager::FreeBuffer(void *buffer)
+{
+	if (buffer == 0)
+		return;
+
+	uint8_t *header = ((uint8_t *)buffer)-RTPINSTRUMENTEDMEMORYMANAGER_HEADERSIZE;
+	size_t numbytes = *((size_t *)header);
+	int32_t memtype = *((int32_t *)(header+sizeof(size_t)));
+	TypeStats *s = &stats[memtype];
+
+	STATS_LOCK(s)
+	s->info.numfrees++;
+	s->info.livebytes -= numbytes;
+	STATS_UNLOCK(s)
+
+	if (mgr == 0)
+		delete [] header;
+	else
+		mgr->FreeBuffer(header);
+}
+
+void RTPInstrumentedMemoryManager::GetMemoryTypeInfo(int memtype, RTPMemoryTypeInfo &info) const
+{
+	if (memtype < 0 || memtype >= RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES)
+		memtype = RTPMEM_TYPE_OTHER;
+
+	TypeStats *s = &stats[memtype];
+
+	RATE_LOCK
+	STATS_LOCK(s)
+	info = s->info;
+	STATS_UNLOCK(s)
+	RTPTime interval = RTPTime::CurrentTime();
+	interval -= ratestart;
+	RATE_UNLOCK
+
+	info.rateinterval = interval.GetDouble();
+}
+
+void RTPInstrumentedMemoryManager::StartRateInterval()
+{
+	RATE_LOCK
+	for (int i = 0 ; i < RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES ; i++)
+	{
+		STATS_LOCK(&stats[i])
+		stats[i].info.rateallocations = 0;
+		STATS_UNLOCK(&stats[i])
+	}
+	ratestart = RTPTime::CurrentTime();
+	RATE_UNLOCK
+}
+
+const char *RTPInstrumentedMemoryManager::GetMemoryTypeName(int memtype)
+{
+	switch (memtype)
+	{
+	case RTPMEM_TYPE_OTHER:
+		return "RTPMEM_TYPE_OTHER";
+	case RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:
+		return "RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET";
+	case RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET:
+		return "RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET";
+	case RTPMEM_TYPE_BUFFER_RTCPAPPPACKET:
+		return "RTPMEM_TYPE_BUFFER_RTCPAPPPACKET";
+	case RTPMEM_TYPE_BUFFER_RTCPBYEPACKET:
+		return "RTPMEM_TYPE_BUFFER_RTCPBYEPACKET";
+	case RTPMEM_TYPE_BUFFER_RTCPBYEREASON:
+		return "RTPMEM_TYPE_BUFFER_RTCPBYEREASON";
+	case RTPMEM_TYPE_BUFFER_RTCPCOMPOUNDPACKET:
+		return "RTPMEM_TYPE_BUFFER_RTCPCOMPOUNDPACKET";
+	case RTPMEM_TYPE_BUFFER_RTCPSDESBLOCK:
+		return "RTPMEM_TYPE_BUFFER_RTCPSDESBLOCK";
+	case RTPMEM_TYPE_BUFFER_RTPPACKET:
+		return "RTPMEM_TYPE_BUFFER_RTPPACKET";
+	case RTPMEM_TYPE_BUFFER_RTPPACKETBUILDERBUFFER:
+		return "RTPMEM_TYPE_BUFFER_RTPPACKETBUILDERBUFFER";
+	case RTPMEM_TYPE_BUFFER_SDESITEM:
+		return "RTPMEM_TYPE_BUFFER_SDESITEM";
+	case RTPMEM_TYPE_CLASS_ACCEPTIGNOREHASHELEMENT:
+		return "RTPMEM_TYPE_CLASS_ACCEPTIGNOREHASHELEMENT";
+	case RTPMEM_TYPE_CLASS_ACCEPTIGNOREPORTINFO:
+		return "RTPMEM_TYPE_CLASS_ACCEPTIGNOREPORTINFO";
+	case RTPMEM_TYPE_CLASS_DESTINATIONLISTHASHELEMENT:
+		return "RTPMEM_TYPE_CLASS_DESTINATIONLISTHASHELEMENT";
+	case RTPMEM_TYPE_CLASS_MULTICASTHASHELEMENT:
+		return "RTPMEM_TYPE_CLASS_MULTICASTHASHELEMENT";
+	case RTPMEM_TYPE_CLASS_RTCPAPPPACKET:
+		return "RTPMEM_TYPE_CLASS_RTCPAPPPACKET";
+	case RTPMEM_TYPE_CLASS_RTCPBYEPACKET:
+		return "RTPMEM_TYPE_CLASS_RTCPBYEPACKET";
+	case RTPMEM_TYPE_CLASS_RTCPCOMPOUNDPACKETBUILDER:
+		return "RTPMEM_TYPE_CLASS_RTCPCOMPOUNDPACKETBUILDER";
+	case RTPMEM_TYPE_CLASS_RTCPRECEIVERREPORT:
+		return "RTPMEM_TYPE_CLASS_RTCPRECEIVERREPORT";
+	case RTPMEM_TYPE_CLASS_RTCPRRPACKET:
+		return "RTPMEM_TYPE_CLASS_RTCPRRPACKET";
+	case RTPMEM_TYPE_CLASS_RTCPSDESPACKET:
+		return "RTPMEM_TYPE_CLASS_RTCPSDESPACKET";
+	case RTPMEM_TYPE_CLASS_RTCPSRPACKET:
+		return "RTPMEM_TYPE_CLASS_RTCPSRPACKET";
+	case RTPMEM_TYPE_CLASS_RTCPUNKNOWNPACKET:
+		return "RTPMEM_TYPE_CLASS_RTCPUNKNOWNPACKET";
+	case RTPMEM_TYPE_CLASS_RTPADDRESS:
+		return "RTPMEM_TYPE_CLASS_RTPADDRESS";
+	case RTPMEM_TYPE_CLASS_RTPINTERNALSOURCEDATA:
+		return "RTPMEM_TYPE_CLASS_RTPINTERNALSOURCEDATA";
+	case RTPMEM_TYPE_CLASS_RTPPACKET:
+		return "RTPMEM_TYPE_CLASS_RTPPACKET";
+	case RTPMEM_TYPE_CLASS_RTPPOLLTHREAD:
+		return "RTPMEM_TYPE_CLASS_RTPPOLLTHREAD";
+	case RTPMEM_TYPE_CLASS_RTPRAWPACKET:
+		return "RTPMEM_TYPE_CLASS_RTPRAWPACKET";
+	case RTPMEM_TYPE_CLASS_RTPTRANSMISSIONINFO:
+		return "RTPMEM_TYPE_CLASS_RTPTRANSMISSIONINFO";
+	case RTPMEM_TYPE_CLASS_RTPTRANSMITTER:
+		return "RTPMEM_TYPE_CLASS_RTPTRANSMITTER";
+	case RTPMEM_TYPE_CLASS_SDESPRIVATEITEM:
+		return "RTPMEM_TYPE_CLASS_SDESPRIVATEITEM";
+	case RTPMEM_TYPE_CLASS_SDESSOURCE:
+		return "RTPMEM_TYPE_CLASS_SDESSOURCE";
+	case RTPMEM_TYPE_CLASS_SOURCETABLEHASHELEMENT:
+		return "RTPMEM_TYPE_CLASS_SOURCETABLEHASHELEMENT";
+	case RTPMEM_TYPE_BUFFER_SRTPDATA:
+		return "RTPMEM_TYPE_BUFFER_SRTPDATA";
+	case RTPMEM_TYPE_CLASS_PACKETQUEUENODE:
+		return "RTPMEM_TYPE_CLASS_PACKETQUEUENODE";
+	case RTPMEM_TYPE_BUFFER_SOURCETABLE:
+		return "RTPMEM_TYPE_BUFFER_SOURCETABLE";
+	case RTPMEM_TYPE_BUFFER_DESTINATIONTABLE:
+		return "RTPMEM_TYPE_BUFFER_DESTINATIONTABLE";
+	case RTPMEM_TYPE_BUFFER_MULTICASTTABLE:
+		return "RTPMEM_TYPE_BUFFER_MULTICASTTABLE";
+	case RTPMEM_TYPE_BUFFER_ACCEPTIGNORETABLE:
+		return "RTPMEM_TYPE_BUFFER_ACCEPTIGNORETABLE";
+	case RTPMEM_TYPE_BUFFER_SOURCEPACKETQUEUE:
+		return "RTPMEM_TYPE_BUFFER_SOURCEPACKETQUEUE";
+	case RTPMEM_TYPE_BUFFER_SPSCQUEUE:
+		return "RTPMEM_TYPE_BUFFER_SPSCQUEUE";
+	case RTPMEM_TYPE_BUFFER_SOURCESNAPSHOT:
+		return "RTPMEM_TYPE_BUFFER_SOURCESNAPSHOT";
+	case RTPMEM_TYPE_CLASS_SOURCESNAPSHOT:
+		return "RTPMEM_TYPE_CLASS_SOURCESNAPSHOT";
+	case RTPMEM_TYPE_BUFFER_SOURCEREPORTTABLE:
+		return "RTPMEM_TYPE_BUFFER_SOURCEREPORTTABLE";
+	case RTPMEM_TYPE_BUFFER_COLLISIONLISTBUCKETS:
+		return "RTPMEM_TYPE_BUFFER_COLLISIONLISTBUCKETS";
+	case RTPMEM_TYPE_CLASS_COLLISIONLISTENTRY:
+		return "RTPMEM_TYPE_CLASS_COLLISIONLISTENTRY";
+	case RTPMEM_TYPE_CLASS_SHAREDBUFFER:
+		return "RTPMEM_TYPE_CLASS_SHAREDBUFFER";
+	case RTPMEM_TYPE_BUFFER_SHAREDBUFFERDATA:
+		return "RTPMEM_TYPE_BUFFER_SHAREDBUFFERDATA";
+	default:
+		return "UNKNOWN";
+	}
+}
+
+} // end namespace
+
@@ -0,0 +1,152 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpinstrumentedmemorymanager.h
+ */
+
+#ifndef RTPINSTRUMENTEDMEMORYMANAGER_H
+
+#define RTPINSTRUMENTEDMEMORYMANAGER_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtptimeutilities.h"
+#include "rtpmemorymanager.h"
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jmutex.h>
+#endif // RTP_SUPPORT_THREAD
+
+#define RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES				64
+#define RTPINSTRUMENTEDMEMORYMANAGER_NUMHISTOGRAMBINS				24
+
+namespace jrtplib
+{
+
+/** Describes the allocations of one memory type, as tracked by an RTPInstrumentedMemoryManager. */
+class JRTPLIB_IMPORTEXPORT RTPMemoryTypeInfo
+{
+public:
+	RTPMemoryTypeInfo();
+
+	/** Returns the number of allocations that were done. */
+	uint64_t GetNumberOfAllocations() const							{ return numallocations; }
+
+	/** Returns the number of blocks that were freed. */
+	uint64_t GetNumberOfFrees() const							{ return numfrees; }
+
+	/** Returns the number of allocations that failed. */
+	uint64_t GetNumberOfFailedAllocations() const						{ return numfailed; }
+
+	/** Returns the number of blocks that are currently allocated. */
+	uint64_t GetLiveBlocks() const								{ return numallocations-numfrees; }
+
+	/** Returns the number of bytes that are currently allocated. */
+	uint64_t GetLiveBytes() const								{ return livebytes; }
+
+	/** Returns the largest number of bytes that were allocated at the same time. */
+	uint64_t GetPeakBytes() const								{ return peakbytes; }
+
+	/** Returns the total number of bytes of all allocations that were done. */
+	uint64_t GetTotalBytes() const								{ return totalbytes; }
+
+	/** Returns the number of allocations per second since RTPInstrumentedMemoryManager::StartRateInterval was last called. */
+	double GetAllocationRate() const;
+
+	/** Returns the number of allocations with a size in histogram bin \c bin.
+	 *  Returns the number of allocations with a size in histogram bin \c bin. Bin 0
+	 *  counts allocations of at most one byte, bin \c i the ones of more than 
+	 *  2^(i-1) and at most 2^i bytes, and the last bin all larger allocations.
+	 */
+	uint64_t GetHistogramCount(int bin) const;
+private:
+	friend class RTPInstrumentedMemoryManager;
+
+	uint64_t numallocations, numfrees, numfailed;
+	uint64_t livebytes, peakbytes, totalbytes;
+	uint64_t rateallocations;
+	double rateinterval;
+	uint64_t histogram[RTPINSTRUMENTEDMEMORYMANAGER_NUMHISTOGRAMBINS];
+};
+
+/** A memory manager which keeps statistics about the allocations of each memory type.
+ *  A memory manager which keeps statistics about the allocations of each memory type. The 
+ *  allocations themselves are passed on to another memory manager, or to \c new and \c delete 
+ *  if no memory manager was specified, so it can be put in front of any memory manager. For each
+ *  \c RTPMEM_TYPE_* value, the number of allocations and frees, the number of bytes that are 
+ *  currently in use and the largest amount that was in use at the same time, the allocation
+ *  rate and a histogram of the allocation sizes can be retrieved at any time. Types which are 
+ *  not smaller than RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES are counted as \c RTPMEM_TYPE_OTHER.
+ *
+ *  To be able to account for a freed block, each allocation is made sixteen bytes larger and 
+ *  the size and type are stored in front of the block. Each memory type has its own lock, so 
+ *  allocations of different types don't wait for each other.
+ */
+class JRTPLIB_IMPORTEXPORT RTPInstrumentedMemoryManager : public RTPMemoryManager
+{
+	JRTPLIB_NO_COPY(RTPInstrumentedMemoryManager)
+public:
+	/** Creates an instance which passes the allocations on to \c mgr; if \c threadsafe is false, no locks are used. */
+	RTPInstrumentedMemoryManager(RTPMemoryManager *mgr = 0, bool threadsafe = true);
+	~RTPInstrumentedMemoryManager();
+
+	void *AllocateBuffer(size_t numbytes, int memtype);
+	void FreeBuffer(void *buffer);
+
+	/** Passes the notification on to the memory manager that does the allocations. */
+	void OnThreadStop()										{ if (mgr) mgr->OnThreadStop(); }
+
+	/** Stores the current statistics of memory type \c memtype in \c info. */
+	void GetMemoryTypeInfo(int memtype, RTPMemoryTypeInfo &info) const;
+
+	/** Starts a new interval for the allocation rates reported by RTPMemoryTypeInfo::GetAllocationRate. */
+	void StartRateInterval();
+
+	/** Returns the name of memory type \c memtype, e.g. "RTPMEM_TYPE_CLASS_RTPPACKET", or "UNKNOWN". */
+	static const char *GetMemoryTypeName(int memtype);
+private:
+	class TypeStats;
+
+	RTPMemoryManager *mgr;
+	bool threadsafe;
+	TypeStats *stats;
+	RTPTime ratestart;
+#ifdef RTP_SUPPORT_THREAD
+	mutable jthread::JMutex ratemutex;
+#endif // RTP_SUPPORT_THREAD
+};
+
+} // end namespace
+
+#endif // RTPINSTRUMENTEDMEMORYMANAGER_H
+
@@ -47,14 +47,21 @@ RTPInternalSourceData::RTPInternalSourceData(uint32_t ssrc,RTPSources::Probation
 #ifdef RTP_SUPPORT_PROBATION
 	probationtype = probtype;
 #endif // RTP_SUPPORT_PROBATION
+	for (int i = 0 ; i < RTPSOURCES_NUMTIMEOUTLISTS ; i++)
+		timeoutlinks[i].source = this;
+	reportslot = -1;
+	datalistprev = 0;
+	datalistnext = 0;
+	indatalist = false;
 }
 
 RTPInternalSourceData::~RTPInternalSourceData()
 {
 }
 
-// The following function should delete rtppack if necessary
-int RTPInternalSourceData::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &receivetime,bool *stored,RTPSources *sources)
+// If the packet isn't stored, the caller should delete the RTPPacket instance
+// that may have been created for the view
+int RTPInternalSourceData::ProcessRTPPacket(RTPPacketView *view,const RTPTime &receivetime,bool *stored,RTPSources *sources)
 {
 	bool accept,onprobation,applyprobation;
 	double tsunit;
@@ -80,7 +87,7 @@ int RTPInternalSourceData::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &re
 	applyprobation = false;
 #endif // RTP_SUPPORT_PROBATION
 
-	stats.ProcessPacket(rtppack,receivetime,tsunit,ownssrc,&accept,applyprobation,&onprobation);
+	stats.ProcessPacket(view,receivetime,tsunit,ownssrc,&accept,applyprobation,&onprobation);
 
 #ifdef RTP_SUPPORT_PROBATION
 	switch (probationtype)
@@ -112,6 +119,15 @@ int RTPInternalSourceData::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &re
 	bool isonprobation = !validated;
 	bool ispackethandled = false;
 
+	sources->OnValidatedRTPPacketView(this, *view, isonprobation, &ispackethandled);
+	if (ispackethandled) // Only the view was needed, the packet can be discarded
+		return 0;
+
+	// From here on, we need an actual RTPPacket instance
+	RTPPacket *rtppack = sources->MaterializePacket(view);
+	if (rtppack == 0)
+		return ERR_RTP_OUTOFMEM;
+
 	sources->OnValidatedRTPPacket(this, rtppack, isonprobation, &ispackethandled);
 	if (ispackethandled) // Packet is already handled in the callback, no need to store it in the list
 	{
@@ -122,68 +138,18 @@ int RTPInternalSourceData::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &re
 
 	// Now, we can place the packet in the queue
 	
-	if (packetlist.empty())
-	{
-		*stored = true;
-		packetlist.push_back(rtppack);
-		return 0;
-	}
-	
 	if (!validated) // still on probation
 	{
 		// Make sure that we don't buffer too much packets to avoid wasting memory
 		// on a bad source. Delete the packet in the queue with the lowest sequence
 		// number.
-		if (packetlist.size() == RTPINTERNALSOURCEDATA_MAXPROBATIONPACKETS)
-		{
-			RTPPacket *p = *(packetlist.begin());
-			packetlist.pop_front();
-			RTPDelete(p,GetMemoryManager());
-		}
-	}
-
-	// find the right position to insert the packet
-	
-	std::list<RTPPacket*>::iterator it,start;
-	bool done = false;
-	uint32_t newseqnr = rtppack->GetExtendedSequenceNumber();
-	
-	it = packetlist.end();
-	--it;
-	start = packetlist.begin();
-	
-	while (!done)
-	{
-		RTPPacket *p;
-		uint32_t seqnr;
-		
-		p = *it;
-		seqnr = p->GetExtendedSequenceNumber();
-		if (seqnr > newseqnr)
-		{
-			if (it != start)
-				--it;
-			else // we're at the start of the list
-			{
-				*stored = true;
-				done = true;
-				packetlist.push_front(rtppack);
-			}
-		}
-		else if (seqnr < newseqnr) // insert after this packet
-		{
-			++it;
-			packetlist.insert(it,rtppack);
-			done = true;
-			*stored = true;
-		}
-		else // they're equal !! Drop packet
-		{
-			done = true;
-		}
+		if (packetqueue.GetNumberOfPackets() == RTPINTERNALSOURCEDATA_MAXPROBATIONPACKETS)
+			RTPDelete(packetqueue.GetNextPacket(),GetMemoryManager());
 	}
 
-	return 0;
+	// If a packet with the same sequence number is already present, it 
+	// won't be stored and the caller will delete it
+	return packetqueue.StorePacket(rtppack,stored);
 }
 
 int RTPInternalSourceData::ProcessSDESItem(uint8_t sdesid,const uint8_t *data,size_t itemlen,const RTPTime &receivetime,bool *cnamecollis)
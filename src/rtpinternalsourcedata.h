@@ -53,7 +53,7 @@ public:
 	RTPInternalSourceData(uint32_t ssrc, RTPSources::ProbationType probtype, RTPMemoryManager *mgr = 0);
 	~RTPInternalSourceData();
 
-	int ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &receivetime,bool *stored, RTPSources *sources);
+	int ProcessRTPPacket(RTPPacketView *view,const RTPTime &receivetime,bool *stored, RTPSources *sources);
 	void ProcessSenderInfo(const RTPNTPTime &ntptime,uint32_t rtptime,uint32_t packetcount,
 	                       uint32_t octetcount,const RTPTime &receivetime)				{ SRprevinf = SRinf; SRinf.Set(ntptime,rtptime,packetcount,octetcount,receivetime); stats.SetLastMessageTime(receivetime); }
 	void ProcessReportBlock(uint8_t fractionlost,int32_t lostpackets,uint32_t exthighseqnr,
@@ -74,9 +74,19 @@ public:
 	void SetOwnSSRC()										{ ownssrc = true; validated = true; }
 	void SetCSRC()											{ validated = true; iscsrc = true; }
 	void ClearNote()										{ SDESinf.SetNote(0,0); }
-	
-#ifdef RTP_SUPPORT_PROBATION
 private:
+	friend class RTPSources;
+
+	// Used by RTPSources to find the sources which time out
+	RTPSourceTimeoutLink timeoutlinks[RTPSOURCES_NUMTIMEOUTLISTS];
+
+	// Index of the source in the report table of RTPSources
+	int reportslot;
+
+	// Used by RTPSources to keep track of the sources which have packets
+	RTPInternalSourceData *datalistprev,*datalistnext;
+	bool indatalist;
+#ifdef RTP_SUPPORT_PROBATION
 	RTPSources::ProbationType probationtype;
 #endif // RTP_SUPPORT_PROBATION
 };
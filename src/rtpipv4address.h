@@ -137,6 +137,7 @@ public:
 	// the rtcpsendport variable is not important and should be ignored.
 	bool IsSameAddress(const RTPAddress *addr) const;
 	bool IsFromSameHost(const RTPAddress *addr) const;
+	uint32_t GetHashValue() const																	{ return ip^(((uint32_t)port)<<16)^((uint32_t)port); }
 #ifdef RTPDEBUG
 	std::string GetAddressString() const;
 #endif // RTPDEBUG
@@ -45,6 +45,15 @@
 namespace jrtplib
 {
 
+uint32_t RTPIPv6Address::GetHashValue() const
+{
+	uint32_t h = port;
+
+	for (int i = 0 ; i < 16 ; i++)
+		h = h*31+ip.s6_addr[i];
+	return h;
+}
+
 RTPAddress *RTPIPv6Address::CreateCopy(RTPMemoryManager *mgr) const
 {
 	JRTPLIB_UNUSED(mgr); // possibly unused
@@ -57,6 +57,12 @@ namespace jrtplib
 class JRTPLIB_IMPORTEXPORT RTPIPv6Destination
 {
 public:
+	RTPIPv6Destination()
+	{
+		memset(&rtpaddr,0,sizeof(struct sockaddr_in6));
+		memset(&rtcpaddr,0,sizeof(struct sockaddr_in6));
+	}
+
 	RTPIPv6Destination(in6_addr ip,uint16_t portbase)
 	{ 
 		memset(&rtpaddr,0,sizeof(struct sockaddr_in6));
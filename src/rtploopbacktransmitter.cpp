@@ -0,0 +1,862 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtploopbacktransmitter.h"
+#include "rtprawpacket.h"
+#include "rtpipv4address.h"
+#include "rtptimeutilities.h"
+#include "rtpdefines.h"
+#include "rtperrors.h"
+#include "rtpselect.h"
+#include "rtpinternalutils.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef RTPDEBUG
+	#include <iostream>
+#endif // RTPDEBUG
+
+#include "rtpdebug.h"
+
+#ifdef RTP_SUPPORT_THREAD
+	#define MAINMUTEX_LOCK 		{ if (threadsafe) mainmutex.Lock(); }
+	#define MAINMUTEX_UNLOCK	{ if (threadsafe) mainmutex.Unlock(); }
+	#define WAITMUTEX_LOCK		{ if (threadsafe) waitmutex.Lock(); }
+	#define WAITMUTEX_UNLOCK	{ if (threadsafe) waitmutex.Unlock(); }
+	// Other transmitters can add packets from any thread, so the queue is
+	// always protected
+	#define QUEUEMUTEX_LOCK		{ queuemutex.Lock(); }
+	#define QUEUEMUTEX_UNLOCK	{ queuemutex.Unlock(); }
+	#define NETWORKMUTEX_LOCK	{ mutex.Lock(); }
+	#define NETWORKMUTEX_UNLOCK	{ mutex.Unlock(); }
+#else
+	#define MAINMUTEX_LOCK
+	#define MAINMUTEX_UNLOCK
+	#define WAITMUTEX_LOCK
+	#define WAITMUTEX_UNLOCK
+	#define QUEUEMUTEX_LOCK
+	#define QUEUEMUTEX_UNLOCK
+	#define NETWORKMUTEX_LOCK
+	#define NETWORKMUTEX_UNLOCK
+#endif // RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+RTPLoopbackNetwork::RTPLoopbackNetwork()
+{
+#ifdef RTP_SUPPORT_THREAD
+	mutexinit = (mutex.Init() >= 0);
+#endif // RTP_SUPPORT_THREAD
+}
+
+RTPLoopbackNetwork::~RTPLoopbackNetwork()
+{
+}
+
+size_t RTPLoopbackNetwork::GetNumberOfTransmitters()
+{
+	NETWORKMUTEX_LOCK
+	size_t num = endpoints.size()/2; // an RTP and RTCP endpoint for each transmitter
+	NETWORKMUTEX_UNLOCK
+	return num;
+}
+
+int RTPLoopbackNetwork::Attach(RTPLoopbackTransmitter *trans, uint32_t ip, uint16_t portbase)
+{
+#ifdef RTP_SUPPORT_THREAD
+	if (!mutexinit)
+		return ERR_RTP_LOOPBACKTRANS_CANTINITMUTEX;
+#endif // RTP_SUPPORT_THREAD
+
+	uint64_t rtpkey = GetKey(ip, portbase);
+	uint64_t rtcpkey = GetKey(ip, portbase+1);
+
+	NETWORKMUTEX_LOCK
+	if (endpoints.find(rtpkey) != endpoints.end() || endpoints.find(rtcpkey) != endpoints.end())
+	{
+		NETWORKMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_ADDRESSINUSE;
+	}
+	endpoints[rtpkey] = Endpoint(trans, true);
+	endpoints[rtcpkey] = Endpoint(trans, false);
+	NETWORKMUTEX_UNLOCK
+	return 0;
+}
+
+void RTPLoopbackNetwork::Detach(uint32_t ip, uint16_t portbase)
+{
+	NETWORKMUTEX_LOCK
+	endpoints.erase(GetKey(ip, portbase));
+	endpoints.erase(GetKey(ip, portbase+1));
+	NETWORKMUTEX_UNLOCK
+}
+
+void RTPLoopbackNetwork::Deliver(uint32_t destip, uint16_t destport, const RTPDataSpan *parts, size_t numparts,
+                                 uint32_t srcip, uint16_t srcport, const RTPTime &arrivaltime)
+{
+	// The lock is kept while the packet is stored, so that the destination
+	// cannot detach (and be destroyed) in the mean time
+	NETWORKMUTEX_LOCK
+	std::map<uint64_t, Endpoint>::const_iterator it = endpoints.find(GetKey(destip, destport));
+	if (it != endpoints.end())
+		it->second.transmitter->EnqueuePacket(parts, numparts, srcip, srcport, it->second.isrtp, arrivaltime);
+	NETWORKMUTEX_UNLOCK
+}
+
+RTPLoopbackTransmitter::RTPLoopbackTransmitter(RTPMemoryManager *mgr) : RTPTransmitter(mgr), delay(0, 0), destinations(mgr,RTPMEM_TYPE_BUFFER_DESTINATIONTABLE)
+{
+	created = false;
+	init = false;
+}
+
+RTPLoopbackTransmitter::~RTPLoopbackTransmitter()
+{
+	Destroy();
+}
+
+int RTPLoopbackTransmitter::Init(bool tsafe)
+{
+	if (init)
+		return ERR_RTP_LOOPBACKTRANS_ALREADYINIT;
+	
+#ifdef RTP_SUPPORT_THREAD
+	int status;
+
+	threadsafe = tsafe;
+	if (threadsafe)
+	{
+		status = mainmutex.Init();
+		if (status < 0)
+			return ERR_RTP_LOOPBACKTRANS_CANTINITMUTEX;
+		status = waitmutex.Init();
+		if (status < 0)
+			return ERR_RTP_LOOPBACKTRANS_CANTINITMUTEX;
+	}
+	status = queuemutex.Init();
+	if (status < 0)
+		return ERR_RTP_LOOPBACKTRANS_CANTINITMUTEX;
+#else
+	if (tsafe)
+		return ERR_RTP_NOTHREADSUPPORT;
+#endif // RTP_SUPPORT_THREAD
+
+	init = true;
+	return 0;
+}
+
+int RTPLoopbackTransmitter::Create(size_t maximumpacketsize,const RTPTransmissionParams *transparams)
+{
+	const RTPLoopbackTransmissionParams *params;
+	int status;
+
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+
+	if (created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_ALREADYCREATED;
+	}
+	
+	// Obtain transmission parameters
+	
+	if (transparams == 0 || transparams->GetTransmissionProtocol() != RTPTransmitter::LoopbackProto)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_ILLEGALPARAMETERS;
+	}
+	params = (const RTPLoopbackTransmissionParams *)transparams;
+
+	if (params->GetNetwork() == 0)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NONETWORK;
+	}
+	if (params->GetPortbase()%2 != 0)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_PORTBASENOTEVEN;
+	}
+
+	if ((status = m_abortDesc.Init()) < 0)
+	{
+		MAINMUTEX_UNLOCK
+		return status;
+	}
+
+	network = params->GetNetwork();
+	bindIP = params->GetBindIP();
+	portbase = params->GetPortbase();
+	delay = params->GetDelay();
+	maxpacksize = maximumpacketsize;
+	waitingfordata = false;
+	wakeuprequested = false;
+	abortsignalled = false;
+
+	// From this point on, other transmitters can deliver packets to us
+	if ((status = network->Attach(this, bindIP, portbase)) < 0)
+	{
+		m_abortDesc.Destroy();
+		MAINMUTEX_UNLOCK
+		return status;
+	}
+
+	created = true;
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+void RTPLoopbackTransmitter::Destroy()
+{
+	if (!init)
+		return;
+
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK;
+		return;
+	}
+
+	// After this, no other transmitter can add packets anymore
+	network->Detach(bindIP, portbase);
+
+	destinations.Clear();
+	FlushPackets();
+	created = false;
+	
+	if (waitingfordata)
+	{
+		m_abortDesc.SendAbortSignal();
+		m_abortDesc.Destroy();
+		MAINMUTEX_UNLOCK
+		WAITMUTEX_LOCK // to make sure that the WaitForIncomingData function ended
+		WAITMUTEX_UNLOCK
+	}
+	else
+		m_abortDesc.Destroy();
+
+	MAINMUTEX_UNLOCK
+}
+
+RTPTransmissionInfo *RTPLoopbackTransmitter::GetTransmissionInfo()
+{
+	if (!init)
+		return 0;
+
+	MAINMUTEX_LOCK
+	RTPTransmissionInfo *tinf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPTRANSMISSIONINFO) RTPLoopbackTransmissionInfo(bindIP, portbase);
+	MAINMUTEX_UNLOCK
+	return tinf;
+}
+
+void RTPLoopbackTransmitter::DeleteTransmissionInfo(RTPTransmissionInfo *i)
+{
+	if (!init)
+		return;
+
+	RTPDelete(i, GetMemoryManager());
+}
+
+int RTPLoopbackTransmitter::GetLocalHostName(uint8_t *buffer,size_t *bufferlength)
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+
+	// There is no real host, so we'll just use the address on the network
+	char name[32];
+
+	RTP_SNPRINTF(name,32,"%d.%d.%d.%d",(int)((bindIP>>24)&0xFF),(int)((bindIP>>16)&0xFF),(int)((bindIP>>8)&0xFF),(int)(bindIP&0xFF));
+
+	size_t namelength = strlen(name);
+
+	if ((*bufferlength) < namelength)
+	{
+		*bufferlength = namelength; // tell the application the required size of the buffer
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_TRANS_BUFFERLENGTHTOOSMALL;
+	}
+
+	memcpy(buffer,name,namelength);
+	*bufferlength = namelength;
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+bool RTPLoopbackTransmitter::ComesFromThisTransmitter(const RTPAddress *addr)
+{
+	if (!init)
+		return false;
+
+	if (addr == 0 || addr->GetAddressType() != RTPAddress::IPv4Address)
+		return false;
+
+	const RTPIPv4Address *addr2 = (const RTPIPv4Address *)addr;
+	bool value = false;
+
+	MAINMUTEX_LOCK
+	if (created && addr2->GetIP() == bindIP && (addr2->GetPort() == portbase || addr2->GetPort() == portbase+1))
+		value = true;
+	MAINMUTEX_UNLOCK
+	return value;
+}
+
+int RTPLoopbackTransmitter::Poll()
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+	MoveArrivedPackets(RTPTime::CurrentTime());
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPLoopbackTransmitter::WaitForIncomingData(const RTPTime &delay,bool *dataavailable)
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+	if (waitingfordata)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_ALREADYWAITING;
+	}
+	
+	if (!rawpacketlist.empty())
+	{
+		if (dataavailable != 0)
+			*dataavailable = true;
+		MAINMUTEX_UNLOCK
+		return 0;
+	}
+
+	// If a packet is still underway, we don't need to wait longer than its
+	// arrival time
+	
+	RTPTime waittime = delay;
+	bool arrived = false;
+
+	QUEUEMUTEX_LOCK
+	if (!pendingpackets.empty())
+	{
+		RTPTime curtime = RTPTime::CurrentTime();
+		RTPTime arrivaltime = pendingpackets.front()->GetReceiveTime();
+
+		if (arrivaltime <= curtime)
+			arrived = true;
+		else
+		{
+			arrivaltime -= curtime;
+			if (arrivaltime < waittime)
+				waittime = arrivaltime;
+		}
+	}
+	if (!arrived)
+		wakeuprequested = true;
+	QUEUEMUTEX_UNLOCK
+
+	if (arrived)
+	{
+		if (dataavailable != 0)
+			*dataavailable = true;
+		MAINMUTEX_UNLOCK
+		return 0;
+	}
+
+	waitingfordata = true;
+	
+	WAITMUTEX_LOCK
+	MAINMUTEX_UNLOCK
+
+	int8_t isset = 0;
+	SocketType abortSock = m_abortDesc.GetAbortSocket();
+	int status = RTPSelect(&abortSock, &isset, 1, waittime);
+	
+	MAINMUTEX_LOCK
+	waitingfordata = false;
+	if (!created) // destroy called
+	{
+		MAINMUTEX_UNLOCK;
+		WAITMUTEX_UNLOCK
+		return (status < 0)?status:0;
+	}
+
+	QUEUEMUTEX_LOCK
+	wakeuprequested = false;
+	if (isset)
+	{
+		m_abortDesc.ClearAbortSignal();
+		abortsignalled = false;
+	}
+	bool available = false;
+	if (!pendingpackets.empty() && pendingpackets.front()->GetReceiveTime() <= RTPTime::CurrentTime())
+		available = true;
+	QUEUEMUTEX_UNLOCK
+	
+	MAINMUTEX_UNLOCK
+	WAITMUTEX_UNLOCK
+
+	if (status < 0)
+		return status;
+	if (dataavailable != 0)
+		*dataavailable = available;
+	return 0;
+}
+
+int RTPLoopbackTransmitter::AbortWait()
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+	if (!waitingfordata)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTWAITING;
+	}
+
+	QUEUEMUTEX_LOCK
+	if (!abortsignalled)
+	{
+		m_abortDesc.SendAbortSignal();
+		abortsignalled = true;
+	}
+	QUEUEMUTEX_UNLOCK
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPLoopbackTransmitter::SendRTPData(const void *data,size_t len)	
+{
+	RTPDataSpan packet(data, len);
+
+	return SendData(&packet, 1, true, false);
+}
+
+int RTPLoopbackTransmitter::SendRTCPData(const void *data,size_t len)
+{
+	RTPDataSpan packet(data, len);
+
+	return SendData(&packet, 1, false, false);
+}
+
+int RTPLoopbackTransmitter::SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	return SendData(packets, numpackets, true, false);
+}
+
+int RTPLoopbackTransmitter::SendRTCPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	return SendData(packets, numpackets, false, false);
+}
+
+int RTPLoopbackTransmitter::SendRTPDataGather(const RTPDataSpan *parts, size_t numparts)
+{
+	if (numparts > RTPTRANSMITTER_MAXGATHERPARTS)
+		return ERR_RTP_TRANSMITTER_TOOMANYGATHERPARTS;
+	return SendData(parts, numparts, true, true);
+}
+
+int RTPLoopbackTransmitter::AddDestination(const RTPAddress &addr)
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+
+	RTPIPv4Destination dest;
+	if (!RTPIPv4Destination::AddressToDestination(addr, dest))
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_INVALIDADDRESSTYPE;
+	}
+	
+	int status = destinations.AddElement(dest);
+
+	MAINMUTEX_UNLOCK
+	return status;
+}
+
+int RTPLoopbackTransmitter::DeleteDestination(const RTPAddress &addr)
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+
+	RTPIPv4Destination dest;
+	if (!RTPIPv4Destination::AddressToDestination(addr, dest))
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_INVALIDADDRESSTYPE;
+	}
+	
+	int status = destinations.DeleteElement(dest);
+
+	MAINMUTEX_UNLOCK
+	return status;
+}
+
+void RTPLoopbackTransmitter::ClearDestinations()
+{
+	if (!init)
+		return;
+	
+	MAINMUTEX_LOCK
+	if (created)
+		destinations.Clear();
+	MAINMUTEX_UNLOCK
+}
+
+bool RTPLoopbackTransmitter::SupportsMulticasting()
+{
+	return false;
+}
+
+int RTPLoopbackTransmitter::JoinMulticastGroup(const RTPAddress &)
+{
+	return ERR_RTP_LOOPBACKTRANS_NOMULTICASTSUPPORT;
+}
+
+int RTPLoopbackTransmitter::LeaveMulticastGroup(const RTPAddress &)
+{
+	return ERR_RTP_LOOPBACKTRANS_NOMULTICASTSUPPORT;
+}
+
+void RTPLoopbackTransmitter::LeaveAllMulticastGroups()
+{
+}
+
+int RTPLoopbackTransmitter::SetReceiveMode(RTPTransmitter::ReceiveMode m)
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+	if (m != RTPTransmitter::AcceptAll)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_BADRECEIVEMODE;
+	}
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPLoopbackTransmitter::AddToIgnoreList(const RTPAddress &)
+{
+	return ERR_RTP_LOOPBACKTRANS_NOIGNORELIST;
+}
+
+int RTPLoopbackTransmitter::DeleteFromIgnoreList(const RTPAddress &)
+{
+	return ERR_RTP_LOOPBACKTRANS_NOIGNORELIST;
+}
+
+void RTPLoopbackTransmitter::ClearIgnoreList()
+{
+}
+
+int RTPLoopbackTransmitter::AddToAcceptList(const RTPAddress &)
+{
+	return ERR_RTP_LOOPBACKTRANS_NOACCEPTLIST;
+}
+
+int RTPLoopbackTransmitter::DeleteFromAcceptList(const RTPAddress &)
+{
+	return ERR_RTP_LOOPBACKTRANS_NOACCEPTLIST;
+}
+
+void RTPLoopbackTransmitter::ClearAcceptList()
+{
+}
+
+int RTPLoopbackTransmitter::SetMaximumPacketSize(size_t s)	
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+	maxpacksize = s;
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+bool RTPLoopbackTransmitter::NewDataAvailable()
+{
+	if (!init)
+		return false;
+	
+	MAINMUTEX_LOCK
+	
+	bool v;
+		
+	if (!created)
+		v = false;
+	else
+		v = !rawpacketlist.empty();
+	
+	MAINMUTEX_UNLOCK
+	return v;
+}
+
+RTPRawPacket *RTPLoopbackTransmitter::GetNextPacket()
+{
+	if (!init)
+		return 0;
+	
+	MAINMUTEX_LOCK
+	
+	RTPRawPacket *p;
+	
+	if (!created || rawpacketlist.empty())
+	{
+		MAINMUTEX_UNLOCK
+		return 0;
+	}
+
+	p = *(rawpacketlist.begin());
+	rawpacketlist.pop_front();
+
+	MAINMUTEX_UNLOCK
+	return p;
+}
+
+// Here the private functions start...
+
+// When 'gather' is set, the spans are the parts of a single packet
+int RTPLoopbackTransmitter::SendData(const RTPDataSpan *packets, size_t numpackets, bool rtp, bool gather)
+{
+	if (!init)
+		return ERR_RTP_LOOPBACKTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_LOOPBACKTRANS_NOTCREATED;
+	}
+	size_t totallength = 0;
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		totallength += packets[i].length;
+		if (packets[i].length > maxpacksize || (gather && totallength > maxpacksize))
+		{
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_LOOPBACKTRANS_SPECIFIEDSIZETOOBIG;
+		}
+	}
+
+	// All packets in this call get the same arrival time
+	RTPTime arrivaltime = RTPTime::CurrentTime();
+	arrivaltime += delay;
+
+	uint16_t srcport = (rtp)?portbase:(uint16_t)(portbase+1);
+	
+	destinations.GotoFirstElement();
+	while (destinations.HasCurrentElement())
+	{
+		const RTPIPv4Destination &dest = destinations.GetCurrentElement();
+		uint16_t destport = ntohs((rtp)?dest.GetRTPPort_NBO():dest.GetRTCPPort_NBO());
+
+		if (gather)
+			network->Deliver(dest.GetIP(), destport, packets, numpackets, bindIP, srcport, arrivaltime);
+		else
+		{
+			for (size_t i = 0 ; i < numpackets ; i++)
+				network->Deliver(dest.GetIP(), destport, &packets[i], 1, bindIP, srcport, arrivaltime);
+		}
+		destinations.GotoNextElement();
+	}
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+void RTPLoopbackTransmitter::EnqueuePacket(const RTPDataSpan *parts, size_t numparts, uint32_t srcip, uint16_t srcport, bool rtp, const RTPTime &arrivaltime)
+{
+	// Called by the network while another transmitter is sending; we're only
+	// allowed to touch the pending packets here
+
+	size_t len = 0;
+	for (size_t i = 0 ; i < numparts ; i++)
+		len += parts[i].length;
+
+	uint8_t *buf = RTPNew(GetMemoryManager(),(rtp)?RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[len];
+	if (buf == 0)
+		return;
+
+	RTPIPv4Address *addr = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPADDRESS) RTPIPv4Address(srcip, srcport);
+	if (addr == 0)
+	{
+		RTPDeleteByteArray(buf,GetMemoryManager());
+		return;
+	}
+
+	size_t offset = 0;
+	for (size_t i = 0 ; i < numparts ; i++)
+	{
+		memcpy(buf+offset, parts[i].data, parts[i].length);
+		offset += parts[i].length;
+	}
+	
+	RTPTime recvtime = arrivaltime;
+	RTPRawPacket *pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(buf,len,addr,recvtime,rtp,GetMemoryManager());
+	if (pack == 0)
+	{
+		RTPDelete(addr,GetMemoryManager());
+		RTPDeleteByteArray(buf,GetMemoryManager());
+		return;
+	}
+
+	QUEUEMUTEX_LOCK
+
+	// Keep the list sorted on arrival time; usually the packet just goes to the end
+	std::list<RTPRawPacket*>::iterator it = pendingpackets.end();
+	while (it != pendingpackets.begin())
+	{
+		std::list<RTPRawPacket*>::iterator prev = it;
+		--prev;
+		if ((*prev)->GetReceiveTime() <= recvtime)
+			break;
+		it = prev;
+	}
+	pendingpackets.insert(it, pack);
+
+	if (wakeuprequested && !abortsignalled)
+	{
+		m_abortDesc.SendAbortSignal();
+		abortsignalled = true;
+	}
+	QUEUEMUTEX_UNLOCK
+}
+
+void RTPLoopbackTransmitter::MoveArrivedPackets(const RTPTime &curtime)
+{
+	QUEUEMUTEX_LOCK
+	while (!pendingpackets.empty() && pendingpackets.front()->GetReceiveTime() <= curtime)
+		rawpacketlist.splice(rawpacketlist.end(), pendingpackets, pendingpackets.begin());
+	QUEUEMUTEX_UNLOCK
+}
+
+void RTPLoopbackTransmitter::FlushPackets()
+{
+	std::list<RTPRawPacket*>::const_iterator it;
+
+	QUEUEMUTEX_LOCK
+	for (it = pendingpackets.begin() ; it != pendingpackets.end() ; ++it)
+		RTPDelete(*it,GetMemoryManager());
+	pendingpackets.clear();
+	QUEUEMUTEX_UNLOCK
+
+	for (it = rawpacketlist.begin() ; it != rawpacketlist.end() ; ++it)
+		RTPDelete(*it,GetMemoryManager());
+	rawpacketlist.clear();
+}
+
+#ifdef RTPDEBUG
+void RTPLoopbackTransmitter::Dump()
+{
+	if (!init)
+		std::cout << "Not initialized" << std::endl;
+	else
+	{
+		MAINMUTEX_LOCK
+	
+		if (!created)
+			std::cout << "Not created" << std::endl;
+		else
+		{
+			std::cout << "Bind IP:                        " << RTPIPv4Address(bindIP, portbase).GetAddressString() << std::endl;
+			std::cout << "Number of raw packets in queue: " << rawpacketlist.size() << std::endl;
+			std::cout << "Maximum allowed packet size:    " << maxpacksize << std::endl;
+		}
+		
+		MAINMUTEX_UNLOCK
+	}
+}
+#endif // RTPDEBUG
+
+} // end namespace
+
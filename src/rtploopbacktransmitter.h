@@ -0,0 +1,276 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtploopbacktransmitter.h
+ */
+
+#ifndef RTPLOOPBACKTRANSMITTER_H
+
+#define RTPLOOPBACKTRANSMITTER_H
+
+#include "rtpconfig.h"
+#include "rtptransmitter.h"
+#include "rtpipv4destination.h"
+#include "rtpflathashtable.h"
+#include "rtpabortdescriptors.h"
+#include <list>
+#include <map>
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jmutex.h>
+#endif // RTP_SUPPORT_THREAD
+
+#define RTPLOOPBACKTRANS_DEFAULTPORTBASE							5000
+#define RTPLOOPBACKTRANS_DEFAULTBINDIP								0x7F000001
+
+#define RTPLOOPBACKTRANS_HEADERSIZE								(20+8)
+
+namespace jrtplib
+{
+
+class RTPLoopbackTransmitter;
+
+/** An in-memory network which connects RTPLoopbackTransmitter instances.
+ *  An in-memory network which connects RTPLoopbackTransmitter instances. Each loopback
+ *  transmitter which is attached to the same network is reachable at an IPv4 address and
+ *  port pair, just as if it were a UDP transmitter, but packets are passed along using
+ *  memory queues instead of sockets. This way, several RTPSession instances in the same 
+ *  process can exchange packets, which is useful for tests and for benchmarking the library 
+ *  itself without the cost of the kernel's network stack. The network must stay alive as
+ *  long as transmitters are attached to it.
+ */
+class JRTPLIB_IMPORTEXPORT RTPLoopbackNetwork
+{
+	JRTPLIB_NO_COPY(RTPLoopbackNetwork)
+public:
+	RTPLoopbackNetwork();
+	~RTPLoopbackNetwork();
+
+	/** Returns the number of transmitters which are currently attached to this network. */
+	size_t GetNumberOfTransmitters();
+private:
+	friend class RTPLoopbackTransmitter;
+
+	class Endpoint
+	{
+	public:
+		Endpoint() : transmitter(0), isrtp(true)						{ }
+		Endpoint(RTPLoopbackTransmitter *t, bool rtp) : transmitter(t), isrtp(rtp)		{ }
+
+		RTPLoopbackTransmitter *transmitter;
+		bool isrtp;
+	};
+
+	static uint64_t GetKey(uint32_t ip, uint16_t port)					{ return (((uint64_t)ip) << 16) | (uint64_t)port; }
+
+	int Attach(RTPLoopbackTransmitter *trans, uint32_t ip, uint16_t portbase);
+	void Detach(uint32_t ip, uint16_t portbase);
+	void Deliver(uint32_t destip, uint16_t destport, const RTPDataSpan *parts, size_t numparts,
+	             uint32_t srcip, uint16_t srcport, const RTPTime &arrivaltime);
+
+	std::map<uint64_t, Endpoint> endpoints;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex mutex;
+	bool mutexinit;
+#endif // RTP_SUPPORT_THREAD
+};
+
+/** Parameters for the loopback transmitter. */
+class JRTPLIB_IMPORTEXPORT RTPLoopbackTransmissionParams : public RTPTransmissionParams
+{
+public:
+	RTPLoopbackTransmissionParams(RTPLoopbackNetwork *net = 0);
+
+	/** Sets the in-memory network to which the transmitter should be attached. */
+	void SetNetwork(RTPLoopbackNetwork *net)						{ network = net; }
+
+	/** Sets the IP address at which the transmitter can be reached on the network (host byte order, defaults to 127.0.0.1). */
+	void SetBindIP(uint32_t ip)								{ bindIP = ip; }
+
+	/** Sets the RTP portbase for this transmitter; the RTCP port is one higher (defaults to 5000). */
+	void SetPortbase(uint16_t pbase)							{ portbase = pbase; }
+
+	/** Sets the simulated one-way delay for packets sent by this transmitter (defaults to no delay). */
+	void SetDelay(const RTPTime &d)								{ delay = d; }
+
+	/** Returns the network to which the transmitter will be attached. */
+	RTPLoopbackNetwork *GetNetwork() const							{ return network; }
+
+	/** Returns the IP address of the transmitter (host byte order). */
+	uint32_t GetBindIP() const								{ return bindIP; }
+
+	/** Returns the RTP portbase of the transmitter. */
+	uint16_t GetPortbase() const								{ return portbase; }
+
+	/** Returns the simulated one-way delay. */
+	RTPTime GetDelay() const								{ return delay; }
+private:
+	RTPLoopbackNetwork *network;
+	uint32_t bindIP;
+	uint16_t portbase;
+	RTPTime delay;
+};
+
+inline RTPLoopbackTransmissionParams::RTPLoopbackTransmissionParams(RTPLoopbackNetwork *net) 
+	: RTPTransmissionParams(RTPTransmitter::LoopbackProto), delay(0, 0)
+{
+	network = net;
+	bindIP = RTPLOOPBACKTRANS_DEFAULTBINDIP;
+	portbase = RTPLOOPBACKTRANS_DEFAULTPORTBASE;
+}
+
+/** Additional information about the loopback transmitter. */
+class JRTPLIB_IMPORTEXPORT RTPLoopbackTransmissionInfo : public RTPTransmissionInfo
+{
+public:
+	RTPLoopbackTransmissionInfo(uint32_t ip, uint16_t pbase) : RTPTransmissionInfo(RTPTransmitter::LoopbackProto)	{ bindIP = ip; portbase = pbase; }
+	~RTPLoopbackTransmissionInfo()								{ }
+
+	/** Returns the IP address at which the transmitter can be reached (host byte order). */
+	uint32_t GetBindIP() const								{ return bindIP; }
+
+	/** Returns the RTP portbase of the transmitter. */
+	uint16_t GetPortbase() const								{ return portbase; }
+private:
+	uint32_t bindIP;
+	uint16_t portbase;
+};
+
+class JRTPLIB_IMPORTEXPORT RTPLoopbackTrans_GetHashIndex_IPv4Dest
+{
+public:
+	static int GetIndex(const RTPIPv4Destination &d)					{ return d.GetIP()^(((uint32_t)d.GetRTPPort_NBO())<<16); }
+};
+
+/** A transmitter which exchanges packets with other transmitters through memory.
+ *  A transmitter which exchanges packets with other transmitters through memory. All
+ *  transmitters which are attached to the same RTPLoopbackNetwork can send packets to
+ *  each other: destinations are specified as RTPIPv4Address instances, and a packet sent
+ *  to such an address is copied into the receive queue of the transmitter which is attached
+ *  at that address. If a delay was specified in the transmission parameters, the packet
+ *  only becomes available to the receiver once that delay has passed. Packets sent to an
+ *  address at which no transmitter is attached are silently dropped. Only the 
+ *  RTPTransmitter::AcceptAll receive mode is supported, and multicasting is not available.
+ *  Since sending transmitters allocate the receiver's packets, a memory manager which is
+ *  shared by sessions in different threads must be able to handle concurrent allocations.
+ */
+class JRTPLIB_IMPORTEXPORT RTPLoopbackTransmitter : public RTPTransmitter
+{
+	JRTPLIB_NO_COPY(RTPLoopbackTransmitter)
+public:
+	RTPLoopbackTransmitter(RTPMemoryManager *mgr);
+	~RTPLoopbackTransmitter();
+
+	int Init(bool treadsafe);
+	int Create(size_t maxpacksize,const RTPTransmissionParams *transparams);
+	void Destroy();
+	RTPTransmissionInfo *GetTransmissionInfo();
+	void DeleteTransmissionInfo(RTPTransmissionInfo *inf);
+
+	int GetLocalHostName(uint8_t *buffer,size_t *bufferlength);
+	bool ComesFromThisTransmitter(const RTPAddress *addr);
+	size_t GetHeaderOverhead()								{ return RTPLOOPBACKTRANS_HEADERSIZE; }
+	
+	int Poll();
+	int WaitForIncomingData(const RTPTime &delay,bool *dataavailable = 0);
+	int AbortWait();
+	
+	int SendRTPData(const void *data,size_t len);	
+	int SendRTCPData(const void *data,size_t len);
+	int SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets);
+	int SendRTCPDataBatch(const RTPDataSpan *packets, size_t numpackets);
+	bool SupportsGatherSend()								{ return true; }
+	int SendRTPDataGather(const RTPDataSpan *parts, size_t numparts);
+
+	int AddDestination(const RTPAddress &addr);
+	int DeleteDestination(const RTPAddress &addr);
+	void ClearDestinations();
+
+	bool SupportsMulticasting();
+	int JoinMulticastGroup(const RTPAddress &addr);
+	int LeaveMulticastGroup(const RTPAddress &addr);
+	void LeaveAllMulticastGroups();
+
+	int SetReceiveMode(RTPTransmitter::ReceiveMode m);
+	int AddToIgnoreList(const RTPAddress &addr);
+	int DeleteFromIgnoreList(const RTPAddress &addr);
+	void ClearIgnoreList();
+	int AddToAcceptList(const RTPAddress &addr);
+	int DeleteFromAcceptList(const RTPAddress &addr);
+	void ClearAcceptList();
+	int SetMaximumPacketSize(size_t s);	
+	
+	bool NewDataAvailable();
+	RTPRawPacket *GetNextPacket();
+#ifdef RTPDEBUG
+	void Dump();
+#endif // RTPDEBUG
+private:
+	friend class RTPLoopbackNetwork;
+
+	int SendData(const RTPDataSpan *packets, size_t numpackets, bool rtp, bool gather);
+	void EnqueuePacket(const RTPDataSpan *parts, size_t numparts, uint32_t srcip, uint16_t srcport, bool rtp, const RTPTime &arrivaltime);
+	void MoveArrivedPackets(const RTPTime &curtime);
+	void FlushPackets();
+
+	bool init;
+	bool created;
+	bool waitingfordata;
+	RTPLoopbackNetwork *network;
+	uint32_t bindIP;
+	uint16_t portbase;
+	RTPTime delay;
+	size_t maxpacksize;
+
+	RTPFlatHashTable<const RTPIPv4Destination,RTPLoopbackTrans_GetHashIndex_IPv4Dest> destinations;
+
+	// Packets which have been delivered by the network, ordered by arrival
+	// time; these are protected by queuemutex since other transmitters
+	// add to this list
+	std::list<RTPRawPacket*> pendingpackets;
+	bool wakeuprequested, abortsignalled;
+
+	// Packets which have arrived and can be processed by the session
+	std::list<RTPRawPacket*> rawpacketlist;
+
+	RTPAbortDescriptors m_abortDesc;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex mainmutex,waitmutex,queuemutex;
+	int threadsafe;
+#endif // RTP_SUPPORT_THREAD
+};
+
+} // end namespace
+
+#endif // RTPLOOPBACKTRANSMITTER_H
+
@@ -143,6 +143,48 @@
 /** Buffer that's used when encrypting a packet. */
 #define RTPMEM_TYPE_BUFFER_SRTPDATA								33
 
+/** Buffer to store a node of a lock-free packet queue. */
+#define RTPMEM_TYPE_CLASS_PACKETQUEUENODE						34
+
+/** Buffer to store the elements or the lookup table of the source table. */
+#define RTPMEM_TYPE_BUFFER_SOURCETABLE							35
+
+/** Buffer to store the elements or the lookup table of a destination table. */
+#define RTPMEM_TYPE_BUFFER_DESTINATIONTABLE						36
+
+/** Buffer to store the elements or the lookup table of a multicast group table. */
+#define RTPMEM_TYPE_BUFFER_MULTICASTTABLE						37
+
+/** Buffer to store the elements or the lookup table of an accept/ignore table. */
+#define RTPMEM_TYPE_BUFFER_ACCEPTIGNORETABLE						38
+
+/** Buffer to store the ring of an RTPSourcePacketQueue instance. */
+#define RTPMEM_TYPE_BUFFER_SOURCEPACKETQUEUE						39
+
+/** Buffer to store the ring of a single producer, single consumer queue. */
+#define RTPMEM_TYPE_BUFFER_SPSCQUEUE							40
+
+/** Buffer to store the statistics of RTPSourceSnapshot instances, which are shared in chunks. */
+#define RTPMEM_TYPE_BUFFER_SOURCESNAPSHOT						41
+
+/** Buffer to store an RTPSourceSnapshot instance. */
+#define RTPMEM_TYPE_CLASS_SOURCESNAPSHOT						42
+
+/** Buffer to store the arrays of an RTPSourceReportTable instance. */
+#define RTPMEM_TYPE_BUFFER_SOURCEREPORTTABLE						43
+
+/** Buffer to store the hash table of an RTPCollisionList instance. */
+#define RTPMEM_TYPE_BUFFER_COLLISIONLISTBUCKETS						44
+
+/** Buffer to store an entry of an RTPCollisionList instance. */
+#define RTPMEM_TYPE_CLASS_COLLISIONLISTENTRY						45
+
+/** Buffer to store an RTPSharedBuffer instance. */
+#define RTPMEM_TYPE_CLASS_SHAREDBUFFER							46
+
+/** Buffer to store the data of an RTPSharedBuffer instance. */
+#define RTPMEM_TYPE_BUFFER_SHAREDBUFFERDATA						47
+
 namespace jrtplib
 {
 
@@ -164,6 +206,13 @@ public:
 
 	/** Frees the previously allocated memory block \c buffer */
 	virtual void FreeBuffer(void *buffer) = 0;
+
+	/** Is called by a thread of the library, like the poll thread, right before it stops.
+	 *  Is called by a thread of the library, like the poll thread, right before it stops. A memory
+	 *  manager which keeps information for each thread can release it here. By default, nothing
+	 *  is done.
+	 */
+	virtual void OnThreadStop()								{ }
 };
 
 } // end namespace
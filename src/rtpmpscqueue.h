@@ -0,0 +1,170 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpmpscqueue.h
+ */
+
+#ifndef RTPMPSCQUEUE_H
+
+#define RTPMPSCQUEUE_H
+
+#include "rtpconfig.h"
+#include "rtperrors.h"
+#include "rtpmemorymanager.h"
+#include "rtpatomic.h"
+
+namespace jrtplib
+{
+
+/** A lock-free queue with multiple producers and a single consumer.
+ *  A lock-free queue with multiple producers and a single consumer. Any number of threads
+ *  can call RTPMPSCQueue::Push concurrently; this only takes a single atomic exchange on the
+ *  head of the queue, so producers never wait for each other or for the consumer. Only one
+ *  thread at a time may call RTPMPSCQueue::Pop. The nodes are allocated using the memory manager
+ *  with memory type \c RTPMEM_TYPE_CLASS_PACKETQUEUENODE. The queue itself does not take ownership
+ *  of the elements: remaining elements should be popped before the queue is destroyed.
+ */
+template<class Element>
+class RTPMPSCQueue
+{
+	JRTPLIB_NO_COPY(RTPMPSCQueue)
+public:
+	RTPMPSCQueue(RTPMemoryManager *mgr);
+	~RTPMPSCQueue();
+
+	/** Adds \c e to the queue; \c wasempty is set to \c true if the queue was empty before. */
+	int Push(const Element &e, bool *wasempty = 0);
+
+	/** Stores the oldest element in \c e and removes it from the queue, returns \c false if the
+	 *  queue was empty (or if the element that's being added by a producer is not complete yet). */
+	bool Pop(Element *e);
+
+	/** Returns \c true if the queue contains no elements. */
+	bool IsEmpty() const											{ return (count.Get() <= 0); }
+
+	/** Returns the number of elements in the queue. */
+	int32_t GetCount() const										{ int32_t n = count.Get(); return (n < 0)?0:n; }
+private:
+	class Node
+	{
+	public:
+		Node()												{ }
+		RTPAtomicPointer<Node> next;
+		Element value;
+	};
+
+	RTPMemoryManager *mgr;
+	RTPAtomicPointer<Node> head;
+	Node *tail;
+	Node stub;
+	RTPAtomicInteger count;
+};
+
+template<class Element>
+inline RTPMPSCQueue<Element>::RTPMPSCQueue(RTPMemoryManager *m) : mgr(m), head(&stub)
+{
+	tail = &stub;
+}
+
+template<class Element>
+inline RTPMPSCQueue<Element>::~RTPMPSCQueue()
+{
+	Element e;
+
+	while (Pop(&e))
+		;
+}
+
+template<class Element>
+inline int RTPMPSCQueue<Element>::Push(const Element &e, bool *wasempty)
+{
+	Node *n = RTPNew(mgr,RTPMEM_TYPE_CLASS_PACKETQUEUENODE) Node;
+	if (n == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	n->value = e;
+
+	// Once the exchange is done, the node is part of the queue, but the consumer
+	// can only reach it after the previous node has been linked to it
+	Node *prev = head.Exchange(n);
+	prev->next.Set(n);
+
+	int32_t oldcount = count.FetchAdd(1);
+	if (wasempty)
+		*wasempty = (oldcount == 0);
+	return 0;
+}
+
+template<class Element>
+inline bool RTPMPSCQueue<Element>::Pop(Element *e)
+{
+	Node *t = tail;
+	Node *next = t->next.Get();
+
+	if (t == &stub)
+	{
+		if (next == 0)
+			return false;
+		tail = next;
+		t = next;
+		next = next->next.Get();
+	}
+
+	if (next == 0)
+	{
+		// 't' is the last node; if a producer is busy adding a node after it,
+		// we have to wait for the link to be completed
+		if (t != head.Get())
+			return false;
+
+		// Put the stub node back at the end, so that 't' can be removed
+		stub.next.Set(0);
+		Node *prev = head.Exchange(&stub);
+		prev->next.Set(&stub);
+
+		next = t->next.Get();
+		if (next == 0)
+			return false;
+	}
+
+	tail = next;
+	*e = t->value;
+	RTPDelete(t,mgr);
+	count.FetchAdd(-1);
+	return true;
+}
+
+} // end namespace
+
+#endif // RTPMPSCQUEUE_H
+
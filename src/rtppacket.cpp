@@ -35,6 +35,7 @@
 #include "rtpdefines.h"
 #include "rtperrors.h"
 #include "rtprawpacket.h"
+#include "rtpsharedbuffer.h"
 #ifdef RTP_SUPPORT_NETINET_IN
 	#include <netinet/in.h>
 #endif // RTP_SUPPORT_NETINET_IN
@@ -67,6 +68,19 @@ void RTPPacket::Clear()
 	extensionlength = 0;
 	error = 0;
 	externalbuffer = false;
+	freecallback = 0;
+	freecallbackparam = 0;
+}
+
+RTPPacket::~RTPPacket()
+{
+	if (packet && !externalbuffer)
+	{
+		if (freecallback)
+			freecallback(packet,freecallbackparam);
+		else
+			RTPDeleteByteArray(packet,GetMemoryManager());
+	}
 }
 
 RTPPacket::RTPPacket(RTPRawPacket &rawpack,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),receivetime(rawpack.GetReceiveTime())
@@ -75,6 +89,39 @@ RTPPacket::RTPPacket(RTPRawPacket &rawpack,RTPMemoryManager *mgr) : RTPMemoryObj
 	error = ParseRawPacket(rawpack);
 }
 
+RTPPacket::RTPPacket(RTPRawPacket &rawpack,const RTPPacketView &view,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),receivetime(view.GetReceiveTime())
+{
+	Clear();
+	if (view.GetPacketData() == 0 || view.GetPacketData() != rawpack.GetData())
+	{
+		error = ERR_RTP_PACKET_INVALIDPACKET;
+		return;
+	}
+
+	hasextension = view.HasExtension();
+	if (hasextension)
+	{
+		extid = view.GetExtensionID();
+		extensionlength = view.GetExtensionLength();
+		extension = (uint8_t *)view.GetExtensionData();
+	}
+	hasmarker = view.HasMarker();
+	numcsrcs = view.GetCSRCCount();
+	payloadtype = view.GetPayloadType();
+	extseqnr = view.GetExtendedSequenceNumber();
+	timestamp = view.GetTimestamp();
+	ssrc = view.GetSSRC();
+	packet = rawpack.GetData();
+	payload = (uint8_t *)view.GetPayloadData();
+	packetlength = view.GetPacketLength();
+	payloadlength = view.GetPayloadLength();
+	freecallback = rawpack.GetDataFreeCallback();
+	freecallbackparam = rawpack.GetDataFreeCallbackParameter();
+
+	// The data now belongs to this packet
+	rawpack.ZeroData();
+}
+
 RTPPacket::RTPPacket(uint8_t payloadtype,const void *payloaddata,size_t payloadlen,uint16_t seqnr,
 		  uint32_t timestamp,uint32_t ssrc,bool gotmarker,uint8_t numcsrcs,const uint32_t *csrcs,
 		  bool gotextension,uint16_t extensionid,uint16_t extensionlen_numwords,const void *extensiondata,
@@ -197,6 +244,8 @@ int RTPPacket::ParseRawPacket(RTPRawPacket &rawpack)
 	RTPPacket::payload = packetbytes+payloadoffset;
 	RTPPacket::packetlength = packetlen;
 	RTPPacket::payloadlength = payloadlength;
+	RTPPacket::freecallback = rawpack.GetDataFreeCallback();
+	RTPPacket::freecallbackparam = rawpack.GetDataFreeCallbackParameter();
 
 	// We'll zero the data of the raw packet, since we're using it here now!
 	rawpack.ZeroData();
@@ -204,6 +253,43 @@ int RTPPacket::ParseRawPacket(RTPRawPacket &rawpack)
 	return 0;
 }
 
+RTPPacket::RTPPacket(const RTPPacket &src,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),receivetime(src.receivetime)
+{
+	error = src.error;
+	hasextension = src.hasextension;
+	hasmarker = src.hasmarker;
+	numcsrcs = src.numcsrcs;
+	payloadtype = src.payloadtype;
+	extseqnr = src.extseqnr;
+	timestamp = src.timestamp;
+	ssrc = src.ssrc;
+	packet = src.packet;
+	payload = src.payload;
+	packetlength = src.packetlength;
+	payloadlength = src.payloadlength;
+	extid = src.extid;
+	extension = src.extension;
+	extensionlength = src.extensionlength;
+	externalbuffer = false;
+	freecallback = src.freecallback;
+	freecallbackparam = src.freecallbackparam;
+
+	// This instance releases its own reference when it's deleted
+	((RTPSharedBuffer *)freecallbackparam)->AddReference();
+}
+
+bool RTPPacket::IsShared() const
+{
+	return (packet != 0 && !externalbuffer && freecallback == RTPSharedBuffer::ReleaseData);
+}
+
+RTPPacket *RTPPacket::CreateReference(RTPMemoryManager *mgr) const
+{
+	if (!IsShared())
+		return 0;
+	return RTPNew(mgr,RTPMEM_TYPE_CLASS_RTPPACKET) RTPPacket(*this,mgr);
+}
+
 uint32_t RTPPacket::GetCSRC(int num) const
 {
 	if (num >= numcsrcs)
@@ -315,7 +401,8 @@ int RTPPacket::BuildPacket(uint8_t payloadtype,const void *payloaddata,size_t pa
 		
 		payload += RTPPacket::extensionlength;
 	}
-	memcpy(payload,payloaddata,payloadlen);
+	if (payloadlen > 0)
+		memcpy(payload,payloaddata,payloadlen);
 	return 0;
 }
 
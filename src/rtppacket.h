@@ -42,12 +42,12 @@
 #include "rtptypes.h"
 #include "rtptimeutilities.h"
 #include "rtpmemoryobject.h"
+#include "rtprawpacket.h"
+#include "rtppacketview.h"
 
 namespace jrtplib
 {
 
-class RTPRawPacket;
-
 /** Represents an RTP Packet.
  *  The RTPPacket class can be used to parse a RTPRawPacket instance if it represents RTP data. 
  *  The class can also be used to create a new RTP packet according to the parameters specified by
@@ -63,6 +63,14 @@ public:
 	 */
 	RTPPacket(RTPRawPacket &rawpack,RTPMemoryManager *mgr = 0);
 
+	/** Creates an RTPPacket instance for the data in \c rawpack which was already parsed in \c view.
+	 *  Creates an RTPPacket instance for the data in \c rawpack which was already parsed in \c view. 
+	 *  The packet is not checked again, the header information is taken from the view, including the 
+	 *  extended sequence number. As with the other constructor, the data is moved from the raw packet 
+	 *  to the RTPPacket instance. The view must refer to the data of \c rawpack.
+	 */
+	RTPPacket(RTPRawPacket &rawpack,const RTPPacketView &view,RTPMemoryManager *mgr = 0);
+
 	/** Creates a new buffer for an RTP packet and fills in the fields according to the specified parameters. 
 	 *  Creates a new buffer for an RTP packet and fills in the fields according to the specified parameters.
 	 *  If \c maxpacksize is not equal to zero, an error is generated if the total packet size would exceed 
@@ -81,7 +89,20 @@ public:
 		  bool gotextension,uint16_t extensionid,uint16_t extensionlen_numwords,const void *extensiondata,
 		  void *buffer,size_t buffersize,RTPMemoryManager *mgr = 0);
 
-	virtual ~RTPPacket()																{ if (packet && !externalbuffer) RTPDeleteByteArray(packet,GetMemoryManager());  }
+	virtual ~RTPPacket();
+
+	/** Returns \c true if the packet data is stored in an RTPSharedBuffer, so that CreateReference can be used. */
+	bool IsShared() const;
+
+	/** Creates another RTPPacket instance for the same data, without copying it.
+	 *  Creates another RTPPacket instance for the same data, without copying it. This is only possible
+	 *  if the data is stored in an RTPSharedBuffer (see IsShared), otherwise null is returned. The new
+	 *  instance adds a reference to that buffer and can be handed to another consumer, possibly in another
+	 *  thread; each instance must be deleted separately, and the buffer is only returned to its pool when
+	 *  the last one is deleted. Since the data is shared, it should not be modified. The extended sequence
+	 *  number is copied as well. The instance is allocated using memory manager \c mgr.
+	 */
+	RTPPacket *CreateReference(RTPMemoryManager *mgr = 0) const;
 
 	/** If an error occurred in one of the constructors, this function returns the error code. */
 	int GetCreationError() const														{ return error; }
@@ -152,6 +173,7 @@ public:
 	 */
 	RTPTime GetReceiveTime() const														{ return receivetime; }
 private:
+	RTPPacket(const RTPPacket &src,RTPMemoryManager *mgr);
 	void Clear();
 	int ParseRawPacket(RTPRawPacket &rawpack);
 	int BuildPacket(uint8_t payloadtype,const void *payloaddata,size_t payloadlen,uint16_t seqnr,
@@ -174,6 +196,8 @@ private:
 	size_t extensionlength;
 
 	bool externalbuffer;
+	RTPRawPacketFreeCallback freecallback;
+	void *freecallbackparam;
 
 	RTPTime receivetime;
 };
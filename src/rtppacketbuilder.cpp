@@ -36,6 +36,7 @@
 #include "rtpsources.h"
 #include <time.h>
 #include <stdlib.h>
+#include <string.h>
 #ifdef RTPDEBUG
 	#include <iostream>
 #endif // RTPDEBUG
@@ -45,7 +46,7 @@
 namespace jrtplib
 {
 
-RTPPacketBuilder::RTPPacketBuilder(RTPRandom &r,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),rtprnd(r),lastwallclocktime(0,0)
+RTPPacketBuilder::RTPPacketBuilder(RTPRandom &r,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),rtprnd(r),lastwallclocktime(0,0),savedlastwallclocktime(0,0)
 {
 	init = false;
 	timeinit.Dummy();
@@ -65,10 +66,10 @@ int RTPPacketBuilder::Init(size_t max)
 	if (max <= 0)
 		return ERR_RTP_PACKBUILD_INVALIDMAXPACKETSIZE;
 	
+	// The buffer is only allocated when the first packet is built, a
+	// session which doesn't send any data doesn't need it
 	maxpacksize = max;
-	buffer = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTPPACKETBUILDERBUFFER) uint8_t [max];
-	if (buffer == 0)
-		return ERR_RTP_OUTOFMEM;
+	buffer = 0;
 	packetlength = 0;
 	
 	CreateNewSSRC();
@@ -78,6 +79,7 @@ int RTPPacketBuilder::Init(size_t max)
 	defmarkset = false;
 		
 	numcsrcs = 0;
+	headertemplatevalid = false;
 	
 	init = true;
 	return 0;
@@ -87,7 +89,8 @@ void RTPPacketBuilder::Destroy()
 {
 	if (!init)
 		return;
-	RTPDeleteByteArray(buffer,GetMemoryManager());
+	if (buffer)
+		RTPDeleteByteArray(buffer,GetMemoryManager());
 	init = false;
 }
 
@@ -97,6 +100,11 @@ int RTPPacketBuilder::SetMaximumPacketSize(size_t max)
 
 	if (max <= 0)
 		return ERR_RTP_PACKBUILD_INVALIDMAXPACKETSIZE;
+	if (buffer == 0) // not allocated yet
+	{
+		maxpacksize = max;
+		return 0;
+	}
 	newbuf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTPPACKETBUILDERBUFFER) uint8_t[max];
 	if (newbuf == 0)
 		return ERR_RTP_OUTOFMEM;
@@ -123,6 +131,7 @@ int RTPPacketBuilder::AddCSRC(uint32_t csrc)
 	}
 	csrcs[numcsrcs] = csrc;
 	numcsrcs++;
+	headertemplatevalid = false;
 	return 0;
 }
 
@@ -149,6 +158,7 @@ int RTPPacketBuilder::DeleteCSRC(uint32_t csrc)
 	numcsrcs--;
 	if (numcsrcs > 0 && numcsrcs != i)
 		csrcs[i] = csrcs[numcsrcs];
+	headertemplatevalid = false;
 	return 0;
 }
 
@@ -157,6 +167,7 @@ void RTPPacketBuilder::ClearCSRCList()
 	if (!init)
 		return;
 	numcsrcs = 0;
+	headertemplatevalid = false;
 }
 
 uint32_t RTPPacketBuilder::CreateNewSSRC()
@@ -168,6 +179,7 @@ uint32_t RTPPacketBuilder::CreateNewSSRC()
 	// p 38: the count SHOULD be reset if the sender changes its SSRC identifier
 	numpayloadbytes = 0;
 	numpackets = 0;
+	headertemplatevalid = false;
 	return ssrc;
 }
 
@@ -187,6 +199,7 @@ uint32_t RTPPacketBuilder::CreateNewSSRC(RTPSources &sources)
 	// p 38: the count SHOULD be reset if the sender changes its SSRC identifier
 	numpayloadbytes = 0;
 	numpackets = 0;
+	headertemplatevalid = false;
 	return ssrc;
 }
 
@@ -235,17 +248,102 @@ int RTPPacketBuilder::BuildPacketEx(const void *data,size_t len,
 
 }
 
+int RTPPacketBuilder::BuildPacketHeader(size_t len)
+{
+	if (!init)
+		return ERR_RTP_PACKBUILD_NOTINIT;
+	if (!defptset)
+		return ERR_RTP_PACKBUILD_DEFAULTPAYLOADTYPENOTSET;
+	if (!defmarkset)
+		return ERR_RTP_PACKBUILD_DEFAULTMARKNOTSET;
+	if (!deftsset)
+		return ERR_RTP_PACKBUILD_DEFAULTTSINCNOTSET;
+	return PrivateBuildPacket(0,len,defaultpayloadtype,defaultmark,defaulttimestampinc,false,0,0,0,true);
+}
+
+int RTPPacketBuilder::BuildPacketHeader(size_t len,uint8_t pt,bool mark,uint32_t timestampinc)
+{
+	if (!init)
+		return ERR_RTP_PACKBUILD_NOTINIT;
+	return PrivateBuildPacket(0,len,pt,mark,timestampinc,false,0,0,0,true);
+}
+
+int RTPPacketBuilder::BuildPacketHeaderEx(size_t len,uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords)
+{
+	if (!init)
+		return ERR_RTP_PACKBUILD_NOTINIT;
+	if (!defptset)
+		return ERR_RTP_PACKBUILD_DEFAULTPAYLOADTYPENOTSET;
+	if (!defmarkset)
+		return ERR_RTP_PACKBUILD_DEFAULTMARKNOTSET;
+	if (!deftsset)
+		return ERR_RTP_PACKBUILD_DEFAULTTSINCNOTSET;
+	return PrivateBuildPacket(0,len,defaultpayloadtype,defaultmark,defaulttimestampinc,true,hdrextID,hdrextdata,numhdrextwords,true);
+}
+
+int RTPPacketBuilder::BuildPacketHeaderEx(size_t len,uint8_t pt,bool mark,uint32_t timestampinc,
+                                          uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords)
+{
+	if (!init)
+		return ERR_RTP_PACKBUILD_NOTINIT;
+	return PrivateBuildPacket(0,len,pt,mark,timestampinc,true,hdrextID,hdrextdata,numhdrextwords,true);
+}
+
 int RTPPacketBuilder::PrivateBuildPacket(const void *data,size_t len,
 	                  uint8_t pt,bool mark,uint32_t timestampinc,bool gotextension,
-	                  uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords)
+	                  uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords,
+	                  bool headeronly)
 {
-	RTPPacket p(pt,data,len,seqnr,timestamp,ssrc,mark,numcsrcs,csrcs,gotextension,hdrextID,
-	            (uint16_t)numhdrextwords,hdrextdata,buffer,maxpacksize,GetMemoryManager());
-	int status = p.GetCreationError();
+	if (buffer == 0)
+	{
+		buffer = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTPPACKETBUILDERBUFFER) uint8_t [maxpacksize];
+		if (buffer == 0)
+			return ERR_RTP_OUTOFMEM;
+	}
 
-	if (status < 0)
-		return status;
-	packetlength = p.GetPacketLength();
+	if (!gotextension)
+	{
+		// Only the marker, sequence number and timestamp need to be filled in
+		// in the header template, unless the payload type changed
+
+		if (!headertemplatevalid || pt != headertemplatept)
+		{
+			int status = BuildHeaderTemplate(pt);
+			if (status < 0)
+				return status;
+		}
+		if (headertemplatelength+len > maxpacksize)
+			return ERR_RTP_PACKET_DATAEXCEEDSMAXSIZE;
+
+		memcpy(buffer,headertemplate,headertemplatelength);
+		buffer[1] = (mark)?(pt|0x80):pt;
+		buffer[2] = (uint8_t)(seqnr>>8);
+		buffer[3] = (uint8_t)(seqnr&0xff);
+		buffer[4] = (uint8_t)(timestamp>>24);
+		buffer[5] = (uint8_t)((timestamp>>16)&0xff);
+		buffer[6] = (uint8_t)((timestamp>>8)&0xff);
+		buffer[7] = (uint8_t)(timestamp&0xff);
+		packetlength = headertemplatelength;
+		if (!headeronly && len > 0)
+		{
+			memcpy(buffer+headertemplatelength,data,len);
+			packetlength += len;
+		}
+	}
+	else
+	{
+		// The RTP header doesn't contain the payload length, so a packet without
+		// payload gives us the header that's needed
+		RTPPacket p(pt,data,(headeronly)?0:len,seqnr,timestamp,ssrc,mark,numcsrcs,csrcs,gotextension,hdrextID,
+			    (uint16_t)numhdrextwords,hdrextdata,buffer,maxpacksize,GetMemoryManager());
+		int status = p.GetCreationError();
+
+		if (status < 0)
+			return status;
+		packetlength = p.GetPacketLength();
+		if (headeronly && packetlength+len > maxpacksize)
+			return ERR_RTP_PACKET_DATAEXCEEDSMAXSIZE;
+	}
 
 	if (numpackets == 0) // first packet
 	{
@@ -260,7 +358,7 @@ int RTPPacketBuilder::PrivateBuildPacket(const void *data,size_t len,
 		prevrtptimestamp = timestamp;
 	}
 	
-	numpayloadbytes += (uint32_t)p.GetPayloadLength();
+	numpayloadbytes += (uint32_t)len;
 	numpackets++;
 	timestamp += timestampinc;
 	seqnr++;
@@ -268,5 +366,23 @@ int RTPPacketBuilder::PrivateBuildPacket(const void *data,size_t len,
 	return 0;
 }
 
+int RTPPacketBuilder::BuildHeaderTemplate(uint8_t pt)
+{
+	// This also checks the payload type; the fields that change for every
+	// packet are filled in later
+	RTPPacket p(pt,0,0,0,0,ssrc,false,numcsrcs,csrcs,false,0,0,0,headertemplate,sizeof(headertemplate),GetMemoryManager());
+	int status = p.GetCreationError();
+
+	if (status < 0)
+	{
+		headertemplatevalid = false;
+		return status;
+	}
+	headertemplatelength = p.GetPacketLength();
+	headertemplatept = pt;
+	headertemplatevalid = true;
+	return 0;
+}
+
 } // end namespace
 
@@ -44,6 +44,7 @@
 #include "rtprandom.h"
 #include "rtptimeutilities.h"
 #include "rtptypes.h"
+#include "rtpstructs.h"
 #include "rtpmemoryobject.h"
 
 namespace jrtplib
@@ -124,6 +125,36 @@ public:
 	                  uint8_t pt,bool mark,uint32_t timestampinc,
 	                  uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords);
 
+	/** Builds only the header of a packet with payload length \c len.
+	 *  Builds only the header of a packet with payload length \c len, using the default payload type, 
+	 *  marker and timestamp increment. The payload itself is not copied: after this call, GetPacket 
+	 *  and GetPacketLength describe the header only, and the payload can be sent after it, for example 
+	 *  using RTPTransmitter::SendRTPDataGather. The internal buffer still has room to store the payload
+	 *  directly behind the header. The sequence number, timestamp and statistics are updated as if the 
+	 *  complete packet was built.
+	 */
+	int BuildPacketHeader(size_t len);
+
+	/** Builds only the header of a packet with payload length \c len.
+	 *  Builds only the header of a packet with payload length \c len, like the BuildPacket function 
+	 *  with the same arguments does for the complete packet. See the previous function for more 
+	 *  information.
+	 */
+	int BuildPacketHeader(size_t len,uint8_t pt,bool mark,uint32_t timestampinc);
+
+	/** Builds only the header of a packet with payload length \c len, including a header extension.
+	 *  Builds only the header of a packet with payload length \c len, including a header extension, 
+	 *  like the BuildPacketEx function with the same arguments does for the complete packet.
+	 */
+	int BuildPacketHeaderEx(size_t len,uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords);
+
+	/** Builds only the header of a packet with payload length \c len, including a header extension.
+	 *  Builds only the header of a packet with payload length \c len, including a header extension, 
+	 *  like the BuildPacketEx function with the same arguments does for the complete packet.
+	 */
+	int BuildPacketHeaderEx(size_t len,uint8_t pt,bool mark,uint32_t timestampinc,
+	                        uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords);
+
 	/** Returns a pointer to the last built RTP packet data. */
 	uint8_t *GetPacket()						{ if (!init) return 0; return buffer; }
 
@@ -191,11 +222,23 @@ public:
 	 *  Sets a specific SSRC to be used. Does not create a new timestamp offset or sequence number
 	 *  offset. Does not reset the packet count or byte count. Think twice before using this!
 	 */
-	void AdjustSSRC(uint32_t s)					{ ssrc = s; }
+	void AdjustSSRC(uint32_t s)					{ ssrc = s; headertemplatevalid = false; }
+
+	/** Remembers the sequence number, timestamp and packet and octet counts.
+	 *  Remembers the sequence number, timestamp and packet and octet counts, so that they can
+	 *  be reset using RTPPacketBuilder::RestoreState when packets that have been built will not
+	 *  be sent after all.
+	 */
+	void SaveState();
+
+	/** Resets the sequence number, timestamp and counts to the values stored by RTPPacketBuilder::SaveState. */
+	void RestoreState();
 private:
 	int PrivateBuildPacket(const void *data,size_t len,
 	                  uint8_t pt,bool mark,uint32_t timestampinc,bool gotextension,
-	                  uint16_t hdrextID = 0,const void *hdrextdata = 0,size_t numhdrextwords = 0);
+	                  uint16_t hdrextID = 0,const void *hdrextdata = 0,size_t numhdrextwords = 0,
+	                  bool headeronly = false);
+	int BuildHeaderTemplate(uint8_t pt);
 
 	RTPRandom &rtprnd;	
 	size_t maxpacksize;
@@ -219,11 +262,46 @@ private:
 	uint32_t csrcs[RTP_MAXCSRCS];
 	int numcsrcs;
 
+	// Packets without a header extension only differ in marker, payload type, 
+	// sequence number and timestamp, so their header is copied from here
+	uint8_t headertemplate[sizeof(RTPHeader)+sizeof(uint32_t)*RTP_MAXCSRCS];
+	size_t headertemplatelength;
+	uint8_t headertemplatept;
+	bool headertemplatevalid;
+
 	RTPTime lastwallclocktime;
 	uint32_t lastrtptimestamp;
 	uint32_t prevrtptimestamp;
+
+	uint32_t savednumpayloadbytes,savednumpackets;
+	uint32_t savedtimestamp;
+	uint16_t savedseqnr;
+	RTPTime savedlastwallclocktime;
+	uint32_t savedlastrtptimestamp,savedprevrtptimestamp;
 };
 
+inline void RTPPacketBuilder::SaveState()
+{
+	savednumpayloadbytes = numpayloadbytes;
+	savednumpackets = numpackets;
+	savedtimestamp = timestamp;
+	savedseqnr = seqnr;
+	savedlastwallclocktime = lastwallclocktime;
+	savedlastrtptimestamp = lastrtptimestamp;
+	savedprevrtptimestamp = prevrtptimestamp;
+}
+
+inline void RTPPacketBuilder::RestoreState()
+{
+	numpayloadbytes = savednumpayloadbytes;
+	numpackets = savednumpackets;
+	timestamp = savedtimestamp;
+	seqnr = savedseqnr;
+	lastwallclocktime = savedlastwallclocktime;
+	lastrtptimestamp = savedlastrtptimestamp;
+	prevrtptimestamp = savedprevrtptimestamp;
+}
+
 inline int RTPPacketBuilder::SetDefaultPayloadType(uint8_t pt)
 {
 	if (!init)
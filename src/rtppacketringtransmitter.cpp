@@ -0,0 +1,1057 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtppacketringtransmitter.h"
+
+#ifdef RTP_SUPPORT_PACKETRING
+
+#include "rtprawpacket.h"
+#include "rtpipv4address.h"
+#include "rtpipv6address.h"
+#include "rtptimeutilities.h"
+#include "rtpdefines.h"
+#include "rtpstructs.h"
+#include "rtperrors.h"
+#include "rtpselect.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <unistd.h>
+#include <string.h>
+#include <vector>
+
+#ifdef RTPDEBUG
+	#include <iostream>
+#endif // RTPDEBUG
+
+#include "rtpdebug.h"
+
+#define RTPPACKETRINGTRANS_ETHERTYPE_IPV4						0x0800
+#define RTPPACKETRINGTRANS_ETHERTYPE_IPV6						0x86DD
+#define RTPPACKETRINGTRANS_IPPROTO_UDP							17
+
+#ifdef RTP_SUPPORT_THREAD
+	#define MAINMUTEX_LOCK 		{ if (threadsafe) mainmutex.Lock(); }
+	#define MAINMUTEX_UNLOCK	{ if (threadsafe) mainmutex.Unlock(); }
+	#define WAITMUTEX_LOCK		{ if (threadsafe) waitmutex.Lock(); }
+	#define WAITMUTEX_UNLOCK	{ if (threadsafe) waitmutex.Unlock(); }
+	#define RINGMUTEX_LOCK(r)	{ if ((r)->threadsafe) (r)->mutex.Lock(); }
+	#define RINGMUTEX_UNLOCK(r)	{ if ((r)->threadsafe) (r)->mutex.Unlock(); }
+#else
+	#define MAINMUTEX_LOCK
+	#define MAINMUTEX_UNLOCK
+	#define WAITMUTEX_LOCK
+	#define WAITMUTEX_UNLOCK
+	#define RINGMUTEX_LOCK(r)
+	#define RINGMUTEX_UNLOCK(r)
+#endif // RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+// Bookkeeping for a single block of the receive ring. A block can only be
+// handed back to the kernel when it has been processed and no packets
+// refer to its memory anymore.
+class RTPPacketRingTransmitter::RingBlock
+{
+public:
+	RingBlock()											{ ring = 0; desc = 0; refcount = 0; walked = false; }
+
+	Ring *ring;
+	struct tpacket_block_desc *desc;
+	int refcount;
+	bool walked;
+};
+
+// The memory mapped ring is kept in a separate object, so that the mapping
+// stays valid for packets which are still referring to it after the transmitter
+// has been destroyed. The reference count includes one reference for the
+// transmitter itself and one for each outstanding packet.
+class RTPPacketRingTransmitter::Ring
+{
+public:
+	Ring(RTPMemoryManager *m)									{ mgr = m; sock = -1; map = 0; mapsize = 0; numblocks = 0; refcount = 1; threadsafe = false; }
+
+	RTPMemoryManager *mgr;
+	int sock;
+	uint8_t *map;
+	size_t mapsize;
+	std::vector<RingBlock> blocks;
+	uint32_t numblocks;
+	int refcount;
+	bool threadsafe;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex mutex;
+#endif // RTP_SUPPORT_THREAD
+};
+
+static inline bool RTPPacketRingTrans_IsUserBlock(struct tpacket_block_desc *desc)
+{
+	volatile uint32_t *status = &(desc->hdr.bh1.block_status);
+
+	if (((*status)&TP_STATUS_USER) == 0)
+		return false;
+	__sync_synchronize(); // make sure the contents are read after the status
+	return true;
+}
+
+static inline void RTPPacketRingTrans_ReturnBlock(struct tpacket_block_desc *desc)
+{
+	volatile uint32_t *status = &(desc->hdr.bh1.block_status);
+
+	__sync_synchronize(); // we're done with the contents
+	*status = TP_STATUS_KERNEL;
+}
+
+RTPPacketRingTransmitter::RTPPacketRingTransmitter(RTPMemoryManager *mgr) : RTPTransmitter(mgr)
+{
+	created = false;
+	init = false;
+	ring = 0;
+}
+
+RTPPacketRingTransmitter::~RTPPacketRingTransmitter()
+{
+	Destroy();
+}
+
+int RTPPacketRingTransmitter::Init(bool tsafe)
+{
+	if (init)
+		return ERR_RTP_PACKETRINGTRANS_ALREADYINIT;
+	
+#ifdef RTP_SUPPORT_THREAD
+	threadsafe = tsafe;
+	if (threadsafe)
+	{
+		int status;
+		
+		status = mainmutex.Init();
+		if (status < 0)
+			return ERR_RTP_PACKETRINGTRANS_CANTINITMUTEX;
+		status = waitmutex.Init();
+		if (status < 0)
+			return ERR_RTP_PACKETRINGTRANS_CANTINITMUTEX;
+	}
+#else
+	if (tsafe)
+		return ERR_RTP_NOTHREADSUPPORT;
+#endif // RTP_SUPPORT_THREAD
+
+	init = true;
+	return 0;
+}
+
+int RTPPacketRingTransmitter::Create(size_t maximumpacketsize,const RTPTransmissionParams *transparams)
+{
+	const RTPPacketRingTransmissionParams *params;
+	int status;
+
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+
+	if (created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_ALREADYCREATED;
+	}
+	
+	// Obtain transmission parameters
+	
+	if (transparams == 0)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_ILLEGALPARAMETERS;
+	}
+	if (transparams->GetTransmissionProtocol() != RTPTransmitter::PacketRingProto)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_ILLEGALPARAMETERS;
+	}
+		
+	params = (const RTPPacketRingTransmissionParams *)transparams;
+
+	long pagesize = sysconf(_SC_PAGESIZE);
+	if (pagesize <= 0 || params->GetBlockSize() == 0 || (params->GetBlockSize()%(uint32_t)pagesize) != 0 ||
+	    params->GetNumberOfBlocks() == 0 || params->GetFrameSize() < TPACKET_ALIGNMENT ||
+	    (params->GetFrameSize()%TPACKET_ALIGNMENT) != 0 || params->GetFrameSize() > params->GetBlockSize() ||
+	    params->GetMinimumPort() > params->GetMaximumPort())
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_ILLEGALPARAMETERS;
+	}
+
+	ring = RTPNew(GetMemoryManager(),RTPMEM_TYPE_OTHER) Ring(GetMemoryManager());
+	if (ring == 0)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_OUTOFMEM;
+	}
+#ifdef RTP_SUPPORT_THREAD
+	if (threadsafe)
+	{
+		if (ring->mutex.Init() < 0)
+		{
+			RTPDelete(ring,GetMemoryManager());
+			ring = 0;
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_PACKETRINGTRANS_CANTINITMUTEX;
+		}
+		ring->threadsafe = true;
+	}
+#endif // RTP_SUPPORT_THREAD
+
+	ring->numblocks = params->GetNumberOfBlocks();
+	ring->blocks.resize(ring->numblocks);
+
+	if ((status = SetupSocket(params, &ring->sock, &ifindex)) < 0)
+	{
+		ReleaseRing(ring);
+		ring = 0;
+		MAINMUTEX_UNLOCK
+		return status;
+	}
+
+	ring->mapsize = (size_t)params->GetBlockSize()*(size_t)params->GetNumberOfBlocks();
+	void *map = mmap(0, ring->mapsize, PROT_READ|PROT_WRITE, MAP_SHARED, ring->sock, 0);
+	if (map == MAP_FAILED)
+	{
+		ReleaseRing(ring);
+		ring = 0;
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_CANTMAPRING;
+	}
+	ring->map = (uint8_t *)map;
+
+	for (uint32_t i = 0 ; i < ring->numblocks ; i++)
+	{
+		ring->blocks[i].ring = ring;
+		ring->blocks[i].desc = (struct tpacket_block_desc *)(ring->map + (size_t)i*(size_t)params->GetBlockSize());
+	}
+
+	// Only bind to the interface now that the filter and ring are in place,
+	// otherwise unfiltered packets could end up in the ring
+	
+	struct sockaddr_ll addr;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ALL);
+	addr.sll_ifindex = ifindex;
+	if (bind(ring->sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	{
+		ReleaseRing(ring);
+		ring = 0;
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_CANTBINDSOCKET;
+	}
+
+	if (params->GetPromiscuous())
+	{
+		struct packet_mreq mreq;
+
+		memset(&mreq, 0, sizeof(mreq));
+		mreq.mr_ifindex = ifindex;
+		mreq.mr_type = PACKET_MR_PROMISC;
+		if (setsockopt(ring->sock, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+		{
+			ReleaseRing(ring);
+			ring = 0;
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_PACKETRINGTRANS_CANTSETPROMISCUOUS;
+		}
+	}
+
+	if ((status = m_abortDesc.Init()) < 0)
+	{
+		ReleaseRing(ring);
+		ring = 0;
+		MAINMUTEX_UNLOCK
+		return status;
+	}
+
+	curblock = 0;
+	zerocopy = params->GetZeroCopy();
+	portmin = params->GetMinimumPort();
+	portmax = params->GetMaximumPort();
+	maxpacksize = maximumpacketsize;
+
+	localhostname = 0;
+	localhostnamelength = 0;
+
+	waitingfordata = false;
+	created = true;
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+void RTPPacketRingTransmitter::Destroy()
+{
+	if (!init)
+		return;
+
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK;
+		return;
+	}
+
+	if (localhostname)
+	{
+		RTPDeleteByteArray(localhostname,GetMemoryManager());
+		localhostname = 0;
+		localhostnamelength = 0;
+	}
+	
+	FlushPackets();
+	
+	// Packets which are still referring to the ring keep it alive
+	ReleaseRing(ring);
+	ring = 0;
+	created = false;
+	
+	if (waitingfordata)
+	{
+		m_abortDesc.SendAbortSignal();
+		m_abortDesc.Destroy();
+		MAINMUTEX_UNLOCK
+		WAITMUTEX_LOCK // to make sure that the WaitForIncomingData function ended
+		WAITMUTEX_UNLOCK
+	}
+	else
+		m_abortDesc.Destroy();
+
+	MAINMUTEX_UNLOCK
+}
+
+RTPTransmissionInfo *RTPPacketRingTransmitter::GetTransmissionInfo()
+{
+	if (!init)
+		return 0;
+
+	MAINMUTEX_LOCK
+	RTPTransmissionInfo *tinf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPTRANSMISSIONINFO) RTPPacketRingTransmissionInfo((created)?ring->sock:-1, (created)?ifindex:0);
+	MAINMUTEX_UNLOCK
+	return tinf;
+}
+
+void RTPPacketRingTransmitter::DeleteTransmissionInfo(RTPTransmissionInfo *i)
+{
+	if (!init)
+		return;
+
+	RTPDelete(i, GetMemoryManager());
+}
+
+int RTPPacketRingTransmitter::GetLocalHostName(uint8_t *buffer,size_t *bufferlength)
+{
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTCREATED;
+	}
+
+	if (localhostname == 0)
+	{
+		char name[1024];
+
+		if (gethostname(name,1023) != 0)
+			strcpy(name, "localhost"); // failsafe
+		else
+			name[1023] = 0; // ensure null-termination
+
+		localhostnamelength = strlen(name);
+		localhostname = RTPNew(GetMemoryManager(),RTPMEM_TYPE_OTHER) uint8_t [localhostnamelength+1];
+		if (localhostname == 0)
+		{
+			localhostnamelength = 0;
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_OUTOFMEM;
+		}
+
+		memcpy(localhostname, name, localhostnamelength);
+		localhostname[localhostnamelength] = 0;
+	}
+	
+	if ((*bufferlength) < localhostnamelength)
+	{
+		*bufferlength = localhostnamelength; // tell the application the required size of the buffer
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_TRANS_BUFFERLENGTHTOOSMALL;
+	}
+
+	memcpy(buffer,localhostname,localhostnamelength);
+	*bufferlength = localhostnamelength;
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+bool RTPPacketRingTransmitter::ComesFromThisTransmitter(const RTPAddress *)
+{
+	// we never send anything ourselves
+	return false;
+}
+
+int RTPPacketRingTransmitter::Poll()
+{
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTCREATED;
+	}
+
+	int status = 0;
+	uint32_t count = 0;
+
+	// Walk the blocks in ring order, stopping at the first one that still
+	// belongs to the kernel or that was processed before but is still in use
+	while (count < ring->numblocks)
+	{
+		RingBlock *block = &(ring->blocks[curblock]);
+		bool walked;
+
+		RINGMUTEX_LOCK(ring)
+		walked = block->walked;
+		RINGMUTEX_UNLOCK(ring)
+
+		if (walked || !RTPPacketRingTrans_IsUserBlock(block->desc))
+			break;
+
+		status = ProcessBlock(block);
+		curblock = (curblock+1)%ring->numblocks;
+		count++;
+
+		if (status < 0)
+			break;
+	}
+
+	MAINMUTEX_UNLOCK
+	return status;
+}
+
+int RTPPacketRingTransmitter::WaitForIncomingData(const RTPTime &delay,bool *dataavailable)
+{
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTCREATED;
+	}
+	if (waitingfordata)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_ALREADYWAITING;
+	}
+
+	RingBlock *block = &(ring->blocks[curblock]);
+	bool walked;
+
+	RINGMUTEX_LOCK(ring)
+	walked = block->walked;
+	RINGMUTEX_UNLOCK(ring)
+
+	if (!rawpacketlist.empty() || (!walked && RTPPacketRingTrans_IsUserBlock(block->desc)))
+	{
+		if (dataavailable != 0)
+			*dataavailable = true;
+		MAINMUTEX_UNLOCK
+		return 0;
+	}
+	
+	SocketType socks[2] = { ring->sock, m_abortDesc.GetAbortSocket() };
+	int8_t readflags[2] = { 0, 0 };
+	const int idxRing = 0;
+	const int idxAbort = 1;
+
+	waitingfordata = true;
+	
+	WAITMUTEX_LOCK
+	MAINMUTEX_UNLOCK
+
+	int status = RTPSelect(socks, readflags, 2, delay);
+	if (status < 0)
+	{
+		MAINMUTEX_LOCK
+		waitingfordata = false;
+		MAINMUTEX_UNLOCK
+		WAITMUTEX_UNLOCK
+		return status;
+	}
+	
+	MAINMUTEX_LOCK
+	waitingfordata = false;
+	if (!created) // destroy called
+	{
+		MAINMUTEX_UNLOCK;
+		WAITMUTEX_UNLOCK
+		return 0;
+	}
+		
+	// if aborted, read from abort buffer
+	if (readflags[idxAbort])
+		m_abortDesc.ReadSignallingByte();
+
+	if (dataavailable != 0)
+	{
+		if (readflags[idxRing])
+			*dataavailable = true;
+		else
+			*dataavailable = false;
+	}	
+	
+	MAINMUTEX_UNLOCK
+	WAITMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPPacketRingTransmitter::AbortWait()
+{
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTCREATED;
+	}
+	if (!waitingfordata)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTWAITING;
+	}
+
+	m_abortDesc.SendAbortSignal();
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPPacketRingTransmitter::SendRTPData(const void *,size_t)	
+{
+	return ERR_RTP_PACKETRINGTRANS_RECEIVEONLY;
+}
+
+int RTPPacketRingTransmitter::SendRTCPData(const void *,size_t)
+{
+	// A passive probe should never transmit anything, but the session will
+	// still generate RTCP packets; these are silently discarded
+	return 0;
+}
+
+int RTPPacketRingTransmitter::AddDestination(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NODESTINATIONSSUPPORTED;
+}
+
+int RTPPacketRingTransmitter::DeleteDestination(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NODESTINATIONSSUPPORTED;
+}
+
+void RTPPacketRingTransmitter::ClearDestinations()
+{
+}
+
+bool RTPPacketRingTransmitter::SupportsMulticasting()
+{
+	return false;
+}
+
+int RTPPacketRingTransmitter::JoinMulticastGroup(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NOMULTICASTSUPPORT;
+}
+
+int RTPPacketRingTransmitter::LeaveMulticastGroup(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NOMULTICASTSUPPORT;
+}
+
+void RTPPacketRingTransmitter::LeaveAllMulticastGroups()
+{
+}
+
+int RTPPacketRingTransmitter::SetReceiveMode(RTPTransmitter::ReceiveMode m)
+{
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTCREATED;
+	}
+	if (m != RTPTransmitter::AcceptAll)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_BADRECEIVEMODE;
+	}
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPPacketRingTransmitter::AddToIgnoreList(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NOIGNORELIST;
+}
+
+int RTPPacketRingTransmitter::DeleteFromIgnoreList(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NOIGNORELIST;
+}
+
+void RTPPacketRingTransmitter::ClearIgnoreList()
+{
+}
+
+int RTPPacketRingTransmitter::AddToAcceptList(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NOACCEPTLIST;
+}
+
+int RTPPacketRingTransmitter::DeleteFromAcceptList(const RTPAddress &)
+{
+	return ERR_RTP_PACKETRINGTRANS_NOACCEPTLIST;
+}
+
+void RTPPacketRingTransmitter::ClearAcceptList()
+{
+}
+
+int RTPPacketRingTransmitter::SetMaximumPacketSize(size_t s)	
+{
+	if (!init)
+		return ERR_RTP_PACKETRINGTRANS_NOTINIT;
+	
+	MAINMUTEX_LOCK
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_PACKETRINGTRANS_NOTCREATED;
+	}
+	maxpacksize = s;
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+bool RTPPacketRingTransmitter::NewDataAvailable()
+{
+	if (!init)
+		return false;
+	
+	MAINMUTEX_LOCK
+	
+	bool v;
+		
+	if (!created)
+		v = false;
+	else
+	{
+		if (rawpacketlist.empty())
+			v = false;
+		else
+			v = true;
+	}
+	
+	MAINMUTEX_UNLOCK
+	return v;
+}
+
+RTPRawPacket *RTPPacketRingTransmitter::GetNextPacket()
+{
+	if (!init)
+		return 0;
+	
+	MAINMUTEX_LOCK
+	
+	RTPRawPacket *p;
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return 0;
+	}
+	if (rawpacketlist.empty())
+	{
+		MAINMUTEX_UNLOCK
+		return 0;
+	}
+
+	p = *(rawpacketlist.begin());
+	rawpacketlist.pop_front();
+
+	MAINMUTEX_UNLOCK
+	return p;
+}
+
+// Here the private functions start...
+
+int RTPPacketRingTransmitter::SetupSocket(const RTPPacketRingTransmissionParams *params, int *sockptr, int *ifindexptr)
+{
+	int idx = (int)if_nametoindex(params->GetInterfaceName().c_str());
+	if (idx == 0)
+		return ERR_RTP_PACKETRINGTRANS_NOSUCHINTERFACE;
+
+	int sock = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	if (sock < 0)
+		return ERR_RTP_PACKETRINGTRANS_CANTCREATESOCKET;
+
+	// from here on, the socket will be closed when the ring is released
+	*sockptr = sock;
+	*ifindexptr = idx;
+
+	int version = TPACKET_V3;
+	if (setsockopt(sock, SOL_PACKET, PACKET_VERSION, &version, sizeof(int)) != 0)
+		return ERR_RTP_PACKETRINGTRANS_CANTSETUPRING;
+
+	// Only accept non-fragmented UDP over IPv4 or IPv6 for which the
+	// destination port lies in the configured range; the offsets are
+	// relative to the start of the Ethernet header
+	
+	uint32_t minport = params->GetMinimumPort();
+	uint32_t maxport = params->GetMaximumPort();
+	struct sock_filter code[] = {
+		/*  0 */ BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 12),
+		/*  1 */ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, RTPPACKETRINGTRANS_ETHERTYPE_IPV4, 0, 8),
+		/*  2 */ BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 23),
+		/*  3 */ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, RTPPACKETRINGTRANS_IPPROTO_UDP, 0, 13),
+		/*  4 */ BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 20),
+		/*  5 */ BPF_JUMP(BPF_JMP|BPF_JSET|BPF_K, 0x3FFF, 11, 0),
+		/*  6 */ BPF_STMT(BPF_LDX|BPF_B|BPF_MSH, 14),
+		/*  7 */ BPF_STMT(BPF_LD|BPF_H|BPF_IND, 16),
+		/*  8 */ BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, minport, 0, 8),
+		/*  9 */ BPF_JUMP(BPF_JMP|BPF_JGT|BPF_K, maxport, 7, 6),
+		/* 10 */ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, RTPPACKETRINGTRANS_ETHERTYPE_IPV6, 0, 6),
+		/* 11 */ BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 20),
+		/* 12 */ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, RTPPACKETRINGTRANS_IPPROTO_UDP, 0, 4),
+		/* 13 */ BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 56),
+		/* 14 */ BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, minport, 0, 2),
+		/* 15 */ BPF_JUMP(BPF_JMP|BPF_JGT|BPF_K, maxport, 1, 0),
+		/* 16 */ BPF_STMT(BPF_RET|BPF_K, 0xFFFFFFFF),
+		/* 17 */ BPF_STMT(BPF_RET|BPF_K, 0)
+	};
+	struct sock_fprog prog;
+
+	prog.len = sizeof(code)/sizeof(struct sock_filter);
+	prog.filter = code;
+	if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0)
+		return ERR_RTP_PACKETRINGTRANS_CANTATTACHFILTER;
+
+	struct tpacket_req3 req;
+
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = params->GetBlockSize();
+	req.tp_block_nr = params->GetNumberOfBlocks();
+	req.tp_frame_size = params->GetFrameSize();
+	req.tp_frame_nr = (params->GetBlockSize()/params->GetFrameSize())*params->GetNumberOfBlocks();
+	req.tp_retire_blk_tov = params->GetBlockTimeout();
+	if (setsockopt(sock, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+		return ERR_RTP_PACKETRINGTRANS_CANTSETUPRING;
+
+	return 0;
+}
+
+int RTPPacketRingTransmitter::ProcessBlock(RingBlock *block)
+{
+	struct tpacket_block_desc *desc = block->desc;
+	uint32_t numpackets = desc->hdr.bh1.num_pkts;
+	uint8_t *ptr = ((uint8_t *)desc) + desc->hdr.bh1.offset_to_first_pkt;
+	int numrefs = 0;
+	int status = 0;
+
+	for (uint32_t i = 0 ; status >= 0 && i < numpackets ; i++)
+	{
+		struct tpacket3_hdr *hdr = (struct tpacket3_hdr *)ptr;
+		struct sockaddr_ll *ll = (struct sockaddr_ll *)(ptr + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+		// skip truncated packets and packets that are being sent from this host
+		if (hdr->tp_snaplen == hdr->tp_len && ll->sll_pkttype != PACKET_OUTGOING)
+		{
+			RTPTime recvtime((int64_t)hdr->tp_sec, hdr->tp_nsec/1000);
+
+			status = ProcessFrame(block, ptr + hdr->tp_mac, hdr->tp_snaplen, recvtime, &numrefs);
+		}
+		ptr += hdr->tp_next_offset;
+	}
+
+	// Account for the packets that refer to this block; as long as we still
+	// hold the main mutex, none of these packets can be deleted elsewhere
+
+	bool release;
+
+	RINGMUTEX_LOCK(ring)
+	block->refcount += numrefs;
+	ring->refcount += numrefs;
+	block->walked = true;
+	release = (block->refcount == 0);
+	if (release)
+		block->walked = false;
+	RINGMUTEX_UNLOCK(ring)
+
+	if (release)
+		RTPPacketRingTrans_ReturnBlock(desc);
+
+	return status;
+}
+
+int RTPPacketRingTransmitter::ProcessFrame(RingBlock *block, uint8_t *frame, size_t framelen, const RTPTime &recvtime, int *numrefs)
+{
+	size_t offset = 14;
+	uint16_t ethertype;
+
+	if (framelen < offset)
+		return 0;
+	// The socket filter only lets untagged frames through; the kernel normally
+	// strips VLAN tags before a frame is put in the ring anyway
+	ethertype = (((uint16_t)frame[12])<<8)|((uint16_t)frame[13]);
+
+	uint8_t *ip = frame+offset;
+	uint8_t *udp;
+	size_t udplen;
+	RTPAddress *addr = 0;
+
+	if (ethertype == RTPPACKETRINGTRANS_ETHERTYPE_IPV4)
+	{
+		if (framelen < offset+20 || (ip[0]>>4) != 4 || ip[9] != RTPPACKETRINGTRANS_IPPROTO_UDP)
+			return 0;
+
+		size_t headerlen = ((size_t)(ip[0]&0x0F))*4;
+		size_t totallen = (((size_t)ip[2])<<8)|((size_t)ip[3]);
+		uint16_t fragment = (((uint16_t)ip[6])<<8)|((uint16_t)ip[7]);
+
+		if (headerlen < 20 || totallen < headerlen+8 || offset+totallen > framelen || (fragment&0x3FFF) != 0)
+			return 0;
+
+		udp = ip+headerlen;
+		udplen = totallen-headerlen;
+	}
+#ifdef RTP_SUPPORT_IPV6
+	else if (ethertype == RTPPACKETRINGTRANS_ETHERTYPE_IPV6)
+	{
+		// extension headers are not supported, the UDP header must follow immediately
+		if (framelen < offset+40 || (ip[0]>>4) != 6 || ip[6] != RTPPACKETRINGTRANS_IPPROTO_UDP)
+			return 0;
+
+		size_t payloadlen = (((size_t)ip[4])<<8)|((size_t)ip[5]);
+
+		if (payloadlen < 8 || offset+40+payloadlen > framelen)
+			return 0;
+
+		udp = ip+40;
+		udplen = payloadlen;
+	}
+#endif // RTP_SUPPORT_IPV6
+	else
+		return 0;
+
+	uint16_t srcport = (((uint16_t)udp[0])<<8)|((uint16_t)udp[1]);
+	uint16_t dstport = (((uint16_t)udp[2])<<8)|((uint16_t)udp[3]);
+	size_t len = (((size_t)udp[4])<<8)|((size_t)udp[5]);
+
+	if (len <= 8 || len > udplen || dstport < portmin || dstport > portmax)
+		return 0;
+	if (len-8 > maxpacksize) // larger packets are not accepted, just like when sending
+		return 0;
+
+	uint8_t *data = udp+8;
+	size_t datalen = len-8;
+
+	if (ethertype == RTPPACKETRINGTRANS_ETHERTYPE_IPV4)
+	{
+		uint32_t srcip = (((uint32_t)ip[12])<<24)|(((uint32_t)ip[13])<<16)|(((uint32_t)ip[14])<<8)|((uint32_t)ip[15]);
+
+		addr = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPADDRESS) RTPIPv4Address(srcip,srcport);
+	}
+#ifdef RTP_SUPPORT_IPV6
+	else
+	{
+		in6_addr srcip;
+
+		memcpy(srcip.s6_addr, ip+8, 16);
+		addr = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPADDRESS) RTPIPv6Address(srcip,srcport);
+	}
+#endif // RTP_SUPPORT_IPV6
+	if (addr == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	bool isrtp = true;
+
+	if (datalen >= sizeof(RTCPCommonHeader))
+	{
+		RTCPCommonHeader *rtcpheader = (RTCPCommonHeader *)data;
+		uint8_t packettype = rtcpheader->packettype;
+
+		if (packettype >= 200 && packettype <= 204)
+			isrtp = false;
+	}
+
+	// The header structures are accessed directly, so on the rare occasion that
+	// the payload isn't properly aligned (e.g. because of IP options), a copy is
+	// made anyway
+	bool copydata = (!zerocopy || (((size_t)data)&(sizeof(uint32_t)-1)) != 0);
+	uint8_t *packetdata = data;
+
+	if (copydata)
+	{
+		packetdata = RTPNew(GetMemoryManager(),(isrtp)?RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[datalen];
+		if (packetdata == 0)
+		{
+			RTPDelete(addr,GetMemoryManager());
+			return ERR_RTP_OUTOFMEM;
+		}
+		memcpy(packetdata, data, datalen);
+	}
+
+	RTPTime t = recvtime;
+	RTPRawPacket *pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(packetdata,datalen,addr,t,isrtp,GetMemoryManager());
+	if (pack == 0)
+	{
+		RTPDelete(addr,GetMemoryManager());
+		if (copydata)
+			RTPDeleteByteArray(packetdata,GetMemoryManager());
+		return ERR_RTP_OUTOFMEM;
+	}
+	if (!copydata)
+	{
+		pack->SetDataFreeCallback(ReleaseRingData, block);
+		(*numrefs)++;
+	}
+
+	rawpacketlist.push_back(pack);
+	return 0;
+}
+
+void RTPPacketRingTransmitter::FlushPackets()
+{
+	std::list<RTPRawPacket*>::const_iterator it;
+
+	for (it = rawpacketlist.begin() ; it != rawpacketlist.end() ; ++it)
+		RTPDelete(*it,GetMemoryManager());
+	rawpacketlist.clear();
+}
+
+void RTPPacketRingTransmitter::ReleaseRingData(uint8_t *, void *param)
+{
+	RingBlock *block = (RingBlock *)param;
+	Ring *r = block->ring;
+	bool returnblock = false;
+
+	RINGMUTEX_LOCK(r)
+	block->refcount--;
+	if (block->refcount == 0 && block->walked)
+	{
+		block->walked = false;
+		returnblock = true;
+	}
+	RINGMUTEX_UNLOCK(r)
+
+	if (returnblock)
+		RTPPacketRingTrans_ReturnBlock(block->desc);
+
+	ReleaseRing(r);
+}
+
+void RTPPacketRingTransmitter::ReleaseRing(Ring *r)
+{
+	bool last;
+
+	RINGMUTEX_LOCK(r)
+	r->refcount--;
+	last = (r->refcount == 0);
+	RINGMUTEX_UNLOCK(r)
+
+	if (!last)
+		return;
+
+	if (r->map)
+		munmap(r->map, r->mapsize);
+	if (r->sock >= 0)
+		close(r->sock);
+	RTPDelete(r, r->mgr);
+}
+
+#ifdef RTPDEBUG
+void RTPPacketRingTransmitter::Dump()
+{
+	if (!init)
+		std::cout << "Not initialized" << std::endl;
+	else
+	{
+		MAINMUTEX_LOCK
+	
+		if (!created)
+			std::cout << "Not created" << std::endl;
+		else
+		{
+			std::cout << "Packet socket descriptor:       " << ring->sock << std::endl;
+			std::cout << "Interface index:                " << ifindex << std::endl;
+			std::cout << "Port range:                     " << portmin << "-" << portmax << std::endl;
+			std::cout << "Number of ring blocks:          " << ring->numblocks << std::endl;
+			std::cout << "Current ring block:             " << curblock << std::endl;
+			std::cout << "Zero-copy:                      " << ((zerocopy)?"yes":"no") << std::endl;
+			std::cout << "Number of raw packets in queue: " << rawpacketlist.size() << std::endl;
+			std::cout << "Maximum allowed packet size:    " << maxpacksize << std::endl;
+		}
+		
+		MAINMUTEX_UNLOCK
+	}
+}
+#endif // RTPDEBUG
+
+} // end namespace
+
+#endif // RTP_SUPPORT_PACKETRING
+
@@ -0,0 +1,259 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtppacketringtransmitter.h
+ */
+
+#ifndef RTPPACKETRINGTRANSMITTER_H
+
+#define RTPPACKETRINGTRANSMITTER_H
+
+#include "rtpconfig.h"
+
+#ifdef RTP_SUPPORT_PACKETRING
+
+#include "rtptransmitter.h"
+#include "rtpabortdescriptors.h"
+#include <string>
+#include <list>
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jmutex.h>
+#endif // RTP_SUPPORT_THREAD
+
+#define RTPPACKETRINGTRANS_HEADERSIZE						(20+8)
+#define RTPPACKETRINGTRANS_DEFAULTBLOCKSIZE					262144
+#define RTPPACKETRINGTRANS_DEFAULTNUMBLOCKS					64
+#define RTPPACKETRINGTRANS_DEFAULTFRAMESIZE					2048
+#define RTPPACKETRINGTRANS_DEFAULTBLOCKTIMEOUT					10
+	
+namespace jrtplib
+{
+
+/** Parameters for the receive-only AF_PACKET ring transmitter. */
+class JRTPLIB_IMPORTEXPORT RTPPacketRingTransmissionParams : public RTPTransmissionParams
+{
+public:
+	RTPPacketRingTransmissionParams();
+
+	/** Sets the name of the network interface (e.g. the mirror port) on which traffic should be captured. */
+	void SetInterfaceName(const std::string &name)						{ ifname = name; }
+
+	/** Only UDP packets with a destination port in the range [\c minport, \c maxport] will be
+	 *  passed to the session; the filtering is done in the kernel using a BPF filter (default is
+	 *  the full range of ports). */
+	void SetPortRange(uint16_t minport, uint16_t maxport)					{ portmin = minport; portmax = maxport; }
+
+	/** Sets the size of a single block of the receive ring, must be a multiple of the page size (default is 256 KiB). */
+	void SetBlockSize(uint32_t s)								{ blocksize = s; }
+
+	/** Sets the number of blocks in the receive ring (default is 64). */
+	void SetNumberOfBlocks(uint32_t n)							{ numblocks = n; }
+
+	/** Sets the frame size that's requested for the ring; for TPACKET_V3 this only limits the maximum packet size (default is 2048). */
+	void SetFrameSize(uint32_t s)								{ framesize = s; }
+
+	/** Sets the time in milliseconds after which the kernel hands over a block which is only partially filled (default is 10). */
+	void SetBlockTimeout(uint32_t ms)							{ blocktimeout = ms; }
+
+	/** If set to \c true (the default), the received packets refer directly to the memory of the
+	 *  receive ring, otherwise the data is copied.
+	 *  If set to \c true (the default), the received packets refer directly to the memory of the
+	 *  receive ring, otherwise the data is copied. Note that in the zero-copy case a block of the ring
+	 *  can only be handed back to the kernel when all packets that refer to it have been deleted, so
+	 *  packets which are kept for a long time will make the ring fill up.
+	 */
+	void SetZeroCopy(bool f)								{ zerocopy = f; }
+
+	/** If set to \c true (the default), the interface will be put in promiscuous mode. */
+	void SetPromiscuous(bool f)								{ promisc = f; }
+
+	/** Returns the name of the interface on which traffic will be captured. */
+	std::string GetInterfaceName() const							{ return ifname; }
+
+	/** Returns the lowest destination port that will be accepted. */
+	uint16_t GetMinimumPort() const								{ return portmin; }
+
+	/** Returns the highest destination port that will be accepted. */
+	uint16_t GetMaximumPort() const								{ return portmax; }
+
+	/** Returns the size of a block of the receive ring. */
+	uint32_t GetBlockSize() const								{ return blocksize; }
+
+	/** Returns the number of blocks in the receive ring. */
+	uint32_t GetNumberOfBlocks() const							{ return numblocks; }
+
+	/** Returns the frame size that's requested for the receive ring. */
+	uint32_t GetFrameSize() const								{ return framesize; }
+
+	/** Returns the block retirement timeout in milliseconds. */
+	uint32_t GetBlockTimeout() const							{ return blocktimeout; }
+
+	/** Returns \c true if the received packets will refer directly to the ring memory. */
+	bool GetZeroCopy() const								{ return zerocopy; }
+
+	/** Returns \c true if the interface will be put in promiscuous mode. */
+	bool GetPromiscuous() const								{ return promisc; }
+private:
+	std::string ifname;
+	uint16_t portmin, portmax;
+	uint32_t blocksize, numblocks, framesize, blocktimeout;
+	bool zerocopy, promisc;
+};
+
+inline RTPPacketRingTransmissionParams::RTPPacketRingTransmissionParams() : RTPTransmissionParams(RTPTransmitter::PacketRingProto)
+{
+	portmin = 0;
+	portmax = 65535;
+	blocksize = RTPPACKETRINGTRANS_DEFAULTBLOCKSIZE;
+	numblocks = RTPPACKETRINGTRANS_DEFAULTNUMBLOCKS;
+	framesize = RTPPACKETRINGTRANS_DEFAULTFRAMESIZE;
+	blocktimeout = RTPPACKETRINGTRANS_DEFAULTBLOCKTIMEOUT;
+	zerocopy = true;
+	promisc = true;
+}
+
+/** Additional information about the AF_PACKET ring transmitter. */
+class JRTPLIB_IMPORTEXPORT RTPPacketRingTransmissionInfo : public RTPTransmissionInfo
+{
+public:
+	RTPPacketRingTransmissionInfo(int s, int idx) : RTPTransmissionInfo(RTPTransmitter::PacketRingProto)	{ sock = s; ifindex = idx; }
+	~RTPPacketRingTransmissionInfo()							{ }
+
+	/** Returns the packet socket that's used to capture the traffic. */
+	int GetSocket() const									{ return sock; }
+
+	/** Returns the index of the interface on which the traffic is captured. */
+	int GetInterfaceIndex() const								{ return ifindex; }
+private:
+	int sock, ifindex;
+};
+
+/** A receive-only transmission component which captures RTP and RTCP traffic using a memory mapped AF_PACKET ring.
+ *  A receive-only transmission component which captures RTP and RTCP traffic using a memory mapped
+ *  AF_PACKET ring. The packet socket uses a TPACKET_V3 \c PACKET_RX_RING and a BPF filter which only
+ *  lets through UDP packets for the configured destination port range. The Ethernet, IP and UDP headers
+ *  are parsed in place, and unless disabled in the parameters, the resulting RTPRawPacket instances
+ *  refer directly to the ring memory. Because no socket per port is needed, a single session can be
+ *  used to passively follow a large number of streams, e.g. on a mirror port. Since this component
+ *  never transmits anything, RTCP packets generated by the session are silently discarded, and
+ *  trying to send RTP data will result in an error. Creating the packet socket requires the
+ *  \c CAP_NET_RAW capability. This transmitter is only available on Linux.
+ */
+class JRTPLIB_IMPORTEXPORT RTPPacketRingTransmitter : public RTPTransmitter
+{
+	JRTPLIB_NO_COPY(RTPPacketRingTransmitter)
+public:
+	RTPPacketRingTransmitter(RTPMemoryManager *mgr);
+	~RTPPacketRingTransmitter();
+
+	int Init(bool treadsafe);
+	int Create(size_t maxpacksize,const RTPTransmissionParams *transparams);
+	void Destroy();
+	RTPTransmissionInfo *GetTransmissionInfo();
+	void DeleteTransmissionInfo(RTPTransmissionInfo *inf);
+
+	int GetLocalHostName(uint8_t *buffer,size_t *bufferlength);
+	bool ComesFromThisTransmitter(const RTPAddress *addr);
+	size_t GetHeaderOverhead()								{ return RTPPACKETRINGTRANS_HEADERSIZE; }
+	
+	int Poll();
+	int WaitForIncomingData(const RTPTime &delay,bool *dataavailable = 0);
+	int AbortWait();
+	
+	int SendRTPData(const void *data,size_t len);	
+	int SendRTCPData(const void *data,size_t len);
+
+	int AddDestination(const RTPAddress &addr);
+	int DeleteDestination(const RTPAddress &addr);
+	void ClearDestinations();
+
+	bool SupportsMulticasting();
+	int JoinMulticastGroup(const RTPAddress &addr);
+	int LeaveMulticastGroup(const RTPAddress &addr);
+	void LeaveAllMulticastGroups();
+
+	int SetReceiveMode(RTPTransmitter::ReceiveMode m);
+	int AddToIgnoreList(const RTPAddress &addr);
+	int DeleteFromIgnoreList(const RTPAddress &addr);
+	void ClearIgnoreList();
+	int AddToAcceptList(const RTPAddress &addr);
+	int DeleteFromAcceptList(const RTPAddress &addr);
+	void ClearAcceptList();
+	int SetMaximumPacketSize(size_t s);	
+	
+	bool NewDataAvailable();
+	RTPRawPacket *GetNextPacket();
+#ifdef RTPDEBUG
+	void Dump();
+#endif // RTPDEBUG
+private:
+	class Ring;
+	class RingBlock;
+
+	int SetupSocket(const RTPPacketRingTransmissionParams *params, int *sockptr, int *ifindexptr);
+	int ProcessBlock(RingBlock *block);
+	int ProcessFrame(RingBlock *block, uint8_t *frame, size_t framelen, const RTPTime &recvtime, int *numrefs);
+	void FlushPackets();
+	static void ReleaseRingData(uint8_t *data, void *param);
+	static void ReleaseRing(Ring *ring);
+
+	bool init;
+	bool created;
+	bool waitingfordata;
+	bool zerocopy;
+	Ring *ring;
+	uint32_t curblock;
+	int ifindex;
+	uint16_t portmin, portmax;
+
+	std::list<RTPRawPacket*> rawpacketlist;
+
+	uint8_t *localhostname;
+	size_t localhostnamelength;
+
+	size_t maxpacksize;
+
+	RTPAbortDescriptors m_abortDesc;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex mainmutex,waitmutex;
+	int threadsafe;
+#endif // RTP_SUPPORT_THREAD
+};
+
+} // end namespace
+
+#endif // RTP_SUPPORT_PACKETRING
+
+#endif // RTPPACKETRINGTRANSMITTER_H
+
@@ -0,0 +1,130 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtppacketview.h"
+#include "rtppacket.h"
+#include "rtprawpacket.h"
+#include "rtpstructs.h"
+#include "rtpdefines.h"
+#include "rtperrors.h"
+
+#include "rtpdebug.h"
+
+namespace jrtplib
+{
+
+RTPPacketView::RTPPacketView() : receivetime(0,0)
+{
+	packet = 0;
+	packetlength = 0;
+	payloadoffset = 0;
+	payloadlength = 0;
+	extseqnr = 0;
+	rawpack = 0;
+	rtppack = 0;
+}
+
+int RTPPacketView::Parse(RTPRawPacket &rawpack)
+{
+	int status;
+
+	// If we didn't receive it on the RTP port, we'll ignore it
+	if (!rawpack.IsRTP())
+		return ERR_RTP_PACKET_INVALIDPACKET;
+	if ((status = Parse(rawpack.GetData(),rawpack.GetDataLength(),rawpack.GetReceiveTime())) < 0)
+		return status;
+	RTPPacketView::rawpack = &rawpack;
+	return 0;
+}
+
+int RTPPacketView::Parse(const uint8_t *data,size_t length,const RTPTime &receivetime)
+{
+	// These are the same checks as in RTPPacket::ParseRawPacket, but nothing
+	// is stored except for the location of the payload
+
+	packet = 0;
+	packetlength = 0;
+	rawpack = 0;
+	rtppack = 0;
+
+	if (data == 0 || length < sizeof(RTPHeader))
+		return ERR_RTP_PACKET_INVALIDPACKET;
+
+	// The version number should be correct
+	if ((data[0]>>6) != RTP_VERSION)
+		return ERR_RTP_PACKET_INVALIDPACKET;
+
+	// The marker bit and payload type combined should not be an SR or RR
+	// identifier, otherwise this is possibly an RTCP packet
+	if (data[1] == RTP_RTCPTYPE_SR || data[1] == RTP_RTCPTYPE_RR)
+		return ERR_RTP_PACKET_INVALIDPACKET;
+
+	size_t offset = sizeof(RTPHeader)+(size_t)(data[0]&0x0F)*sizeof(uint32_t);
+	size_t numpadbytes = 0;
+
+	if (data[0]&0x20) // padding
+	{
+		numpadbytes = (size_t)data[length-1]; // last byte contains number of padding bytes
+		if (numpadbytes == 0)
+			return ERR_RTP_PACKET_INVALIDPACKET;
+	}
+
+	if (data[0]&0x10) // header extension
+	{
+		if (offset+sizeof(RTPExtensionHeader) > length)
+			return ERR_RTP_PACKET_INVALIDPACKET;
+		
+		size_t exthdrlen = ((size_t)data[offset+2]<<8)|(size_t)data[offset+3];
+		offset += sizeof(RTPExtensionHeader)+exthdrlen*sizeof(uint32_t);
+	}
+
+	if (offset+numpadbytes > length)
+		return ERR_RTP_PACKET_INVALIDPACKET;
+
+	packet = data;
+	packetlength = length;
+	payloadoffset = offset;
+	payloadlength = length-numpadbytes-offset;
+	extseqnr = (uint32_t)GetSequenceNumber();
+	RTPPacketView::receivetime = receivetime;
+	return 0;
+}
+
+void RTPPacketView::SetExtendedSequenceNumber(uint32_t seq)
+{
+	extseqnr = seq;
+	if (rtppack) // keep a packet that was already created in sync
+		rtppack->SetExtendedSequenceNumber(seq);
+}
+
+} // end namespace
+
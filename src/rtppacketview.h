@@ -0,0 +1,154 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtppacketview.h
+ */
+
+#ifndef RTPPACKETVIEW_H
+
+#define RTPPACKETVIEW_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtptimeutilities.h"
+
+namespace jrtplib
+{
+
+class RTPRawPacket;
+class RTPPacket;
+
+/** Describes an RTP packet in a buffer it does not own.
+ *  Describes an RTP packet in a buffer it does not own. Unlike RTPPacket, no memory is allocated
+ *  and no data is copied: the Parse functions only check if the data contains a valid RTP packet,
+ *  and the header fields are read from the buffer when the corresponding member function is called.
+ *  A view is therefore only usable as long as the buffer it refers to exists. When a packet needs
+ *  to be kept, an RTPPacket instance can be created from the view instead.
+ */
+class JRTPLIB_IMPORTEXPORT RTPPacketView
+{
+public:
+	/** Creates an empty view, one of the Parse functions must be called before it can be used. */
+	RTPPacketView();
+
+	/** Checks if the \c length bytes in \c data form a valid RTP packet and if so, lets this view refer to it.
+	 *  Checks if the \c length bytes in \c data form a valid RTP packet and if so, lets this view refer to it.
+	 *  The same checks as in the RTPPacket constructor are performed; if the packet is not valid,
+	 *  ERR_RTP_PACKET_INVALIDPACKET is returned. The time \c receivetime is stored as the packet's
+	 *  receive time.
+	 */
+	int Parse(const uint8_t *data,size_t length,const RTPTime &receivetime);
+
+	/** Lets this view refer to the data of the raw packet \c rawpack, if it contains a valid RTP packet. */
+	int Parse(RTPRawPacket &rawpack);
+
+	/** Returns \c true if the RTP packet has a header extension and \c false otherwise. */
+	bool HasExtension() const										{ return (packet[0]&0x10)?true:false; }
+
+	/** Returns \c true if the marker bit was set and \c false otherwise. */
+	bool HasMarker() const											{ return (packet[1]&0x80)?true:false; }
+
+	/** Returns the number of CSRCs contained in this packet. */
+	int GetCSRCCount() const										{ return (int)(packet[0]&0x0F); }
+
+	/** Returns a specific CSRC identifier.
+	 *  Returns a specific CSRC identifier. The parameter \c num can go from 0 to GetCSRCCount()-1.
+	 */
+	uint32_t GetCSRC(int num) const									{ if (num < 0 || num >= GetCSRCCount()) return 0; return ReadUInt32(12+num*4); }
+
+	/** Returns the payload type of the packet. */
+	uint8_t GetPayloadType() const									{ return packet[1]&0x7F; }
+
+	/** Returns the extended sequence number of the packet.
+	 *  Returns the extended sequence number of the packet. Right after parsing, only the low 16
+	 *  bits are set; the high 16 bits are filled in when the packet is processed by RTPSources.
+	 */
+	uint32_t GetExtendedSequenceNumber() const						{ return extseqnr; }
+
+	/** Returns the sequence number of this packet. */
+	uint16_t GetSequenceNumber() const								{ return (uint16_t)(((uint16_t)packet[2]<<8)|(uint16_t)packet[3]); }
+
+	/** Sets the extended sequence number of this packet to \c seq. */
+	void SetExtendedSequenceNumber(uint32_t seq);
+
+	/** Returns the timestamp of this packet. */
+	uint32_t GetTimestamp() const									{ return ReadUInt32(4); }
+
+	/** Returns the SSRC identifier stored in this packet. */
+	uint32_t GetSSRC() const										{ return ReadUInt32(8); }
+
+	/** Returns a pointer to the data of the entire packet. */
+	const uint8_t *GetPacketData() const							{ return packet; }
+
+	/** Returns the length of the entire packet. */
+	size_t GetPacketLength() const									{ return packetlength; }
+
+	/** Returns a pointer to the actual payload data. */
+	const uint8_t *GetPayloadData() const							{ return packet+payloadoffset; }
+
+	/** Returns the payload length. */
+	size_t GetPayloadLength() const									{ return payloadlength; }
+
+	/** If a header extension is present, this function returns the extension identifier. */
+	uint16_t GetExtensionID() const									{ if (!HasExtension()) return 0; size_t off = ExtensionOffset(); return (uint16_t)(((uint16_t)packet[off]<<8)|(uint16_t)packet[off+1]); }
+
+	/** Returns the header extension data, or null if no header extension is present. */
+	const uint8_t *GetExtensionData() const							{ if (!HasExtension()) return 0; return packet+ExtensionOffset()+4; }
+
+	/** Returns the length of the header extension data. */
+	size_t GetExtensionLength() const								{ if (!HasExtension()) return 0; size_t off = ExtensionOffset(); return (((size_t)packet[off+2]<<8)|(size_t)packet[off+3])*sizeof(uint32_t); }
+
+	/** Returns the time at which this packet was received. */
+	RTPTime GetReceiveTime() const									{ return receivetime; }
+private:
+	friend class RTPSources;
+
+	uint32_t ReadUInt32(size_t offset) const						{ return ((uint32_t)packet[offset]<<24)|((uint32_t)packet[offset+1]<<16)|((uint32_t)packet[offset+2]<<8)|(uint32_t)packet[offset+3]; }
+	size_t ExtensionOffset() const									{ return 12+GetCSRCCount()*sizeof(uint32_t); }
+
+	const uint8_t *packet;
+	size_t packetlength;
+	size_t payloadoffset,payloadlength;
+	uint32_t extseqnr;
+	RTPTime receivetime;
+
+	// Used by RTPSources to create an RTPPacket instance from the view
+	// only when it's actually needed
+	RTPRawPacket *rawpack;
+	RTPPacket *rtppack;
+};
+
+} // end namespace
+
+#endif // RTPPACKETVIEW_H
+
@@ -164,6 +164,11 @@ void *RTPPollThread::Thread()
 
 	rtpsession.OnPollThreadStop();
 
+	// Lets the memory manager release what it keeps for this thread
+	RTPMemoryManager *mgr = rtpsession.GetMemoryManager();
+	if (mgr)
+		mgr->OnThreadStop();
+
 	return 0;
 }
 
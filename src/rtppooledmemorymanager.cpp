@@ -0,0 +1,737 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtppooledmemorymanager.h"
+#include "rtperrors.h"
+#include <new>
+#include <string.h>
+
+#include "rtpdebug.h"
+
+// Every block starts with a pointer to the cache it belongs to, or a null
+// pointer if it was allocated from the system directly. The size keeps the
+// memory that's returned to the caller suitably aligned.
+#define RTPPOOLEDMEMORYMANAGER_HEADERSIZE					16
+
+#if defined(RTP_SUPPORT_THREAD) && defined(RTP_HAVE_THREADLOCAL)
+	#define RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+	#ifdef RTP_HAVE_PTHREAD_KEY
+		#define RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+		#include <pthread.h>
+	#endif // RTP_HAVE_PTHREAD_KEY
+#endif // RTP_SUPPORT_THREAD && RTP_HAVE_THREADLOCAL
+
+#ifdef RTP_SUPPORT_THREAD
+	#define CACHE_LOCK(c)		{ if (threadsafe) (c)->mutex.Lock(); }
+	#define CACHE_UNLOCK(c)		{ if (threadsafe) (c)->mutex.Unlock(); }
+	#define POOL_LOCK		{ if (threadsafe) poolmutex.Lock(); }
+	#define POOL_UNLOCK		{ if (threadsafe) poolmutex.Unlock(); }
+#else
+	#define CACHE_LOCK(c)
+	#define CACHE_UNLOCK(c)
+	#define POOL_LOCK
+	#define POOL_UNLOCK
+#endif // RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+class RTPPooledMemoryManager::Cache
+{
+public:
+	Cache()
+	{
+		index = 0;
+		blocksize = 0;
+		numfree = 0;
+		freelist = 0;
+		slabs = 0;
+#ifdef RTP_SUPPORT_THREAD
+		mutex.Init();
+#endif // RTP_SUPPORT_THREAD
+	}
+
+	~Cache()
+	{
+		while (slabs != 0)
+		{
+			uint8_t *next = *((uint8_t **)slabs);
+
+			delete [] slabs;
+			slabs = next;
+		}
+	}
+
+	// Position of the magazine for this cache in a thread cache
+	int index;
+
+	// The number of bytes that can be used in a block, a multiple of the header size
+	size_t blocksize;
+	size_t numfree;
+	
+	// A free block stores the pointer to the next free block in its first bytes
+	uint8_t *freelist;
+
+	// Each slab starts with a pointer to the next one, followed by its blocks
+	uint8_t *slabs;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex mutex;
+#endif // RTP_SUPPORT_THREAD
+};
+
+class RTPPooledMemoryManager::ThreadCache
+{
+public:
+	class Magazine
+	{
+	public:
+		Magazine() : blocksize(0), count(0)					{ }
+
+		// Copy of the block size of the cache, so it can be checked without a lock
+		size_t blocksize;
+		int count;
+		uint8_t *blocks[RTPPOOLEDMEMORYMANAGER_MAGAZINESIZE];
+	};
+
+	ThreadCache() : magazines(0), next(0)						{ }
+	~ThreadCache()									{ delete [] magazines; }
+
+	Magazine *magazines;
+	ThreadCache *next;
+};
+
+#ifdef RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+
+struct RTPPooledMemoryManagerThreadSlot
+{
+	int32_t managerid;
+	void *threadcache;
+};
+
+static __thread RTPPooledMemoryManagerThreadSlot threadslots[RTPPOOLEDMEMORYMANAGER_MAXTHREADCACHEMANAGERS];
+
+// These are only used when a manager is created or destroyed, and are not
+// global objects so that managers can be created during static initialization
+
+static RTPAtomicInteger &GetUsedThreadSlots()
+{
+	static RTPAtomicInteger usedslots(0); // one bit for each position in 'threadslots'
+	return usedslots;
+}
+
+static RTPAtomicInteger &GetLastManagerID()
+{
+	static RTPAtomicInteger lastid(0);
+	return lastid;
+}
+
+#ifdef RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+
+// When a thread which has used a manager exits, the destructor of a thread 
+// specific key returns its magazines. The managers are registered at their 
+// position in 'threadslots' so they can be found from there; the mutex makes
+// sure that a manager isn't destroyed while this happens. These are all 
+// initialized statically, so they can be used during static initialization.
+
+static pthread_mutex_t exitmutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t exitkeyonce = PTHREAD_ONCE_INIT;
+static pthread_key_t exitkey;
+static bool exitkeycreated = false;
+static RTPPooledMemoryManager *exitmanagers[RTPPOOLEDMEMORYMANAGER_MAXTHREADCACHEMANAGERS];
+
+#endif // RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+
+#endif // RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+
+static inline size_t RoundBlockSize(size_t numbytes)
+{
+	if (numbytes == 0)
+		return RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+	return ((numbytes+RTPPOOLEDMEMORYMANAGER_HEADERSIZE-1)/RTPPOOLEDMEMORYMANAGER_HEADERSIZE)*RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+}
+
+RTPPooledMemoryManager::RTPPooledMemoryManager(bool ts) : threadsafe(ts), numsystemallocations(0)
+{
+	numcaches = 0;
+	for (int i = 0 ; i < RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES ; i++)
+	{
+		classcaches[i] = 0;
+		if (IsClassMemoryType(i))
+		{
+			classcaches[i] = new Cache();
+			classcaches[i]->index = numcaches++;
+		}
+	}
+
+	// Sizes of the buckets: MINBUCKETSIZE, 1.5*MINBUCKETSIZE, 2*MINBUCKETSIZE, ... , MAXBUCKETSIZE
+	numbuckets = 0;
+	for (size_t s = RTPPOOLEDMEMORYMANAGER_MINBUCKETSIZE ; s <= RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE ; s *= 2)
+		numbuckets += (s+s/2 <= RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE)?2:1;
+
+	buckets = new Cache[numbuckets];
+	
+	int idx = 0;
+	for (size_t s = RTPPOOLEDMEMORYMANAGER_MINBUCKETSIZE ; s <= RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE ; s *= 2)
+	{
+		buckets[idx++].blocksize = RoundBlockSize(s);
+		if (s+s/2 <= RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE)
+			buckets[idx++].blocksize = RoundBlockSize(s+s/2);
+	}
+	for (int i = 0 ; i < numbuckets ; i++)
+		buckets[i].index = numcaches++;
+
+	maxpooledmemory = RTPPOOLEDMEMORYMANAGER_DEFAULTMAXPOOLEDMEMORY;
+	pooledmemory = 0;
+#ifdef RTP_SUPPORT_THREAD
+	poolmutex.Init();
+#endif // RTP_SUPPORT_THREAD
+
+	managerid = 0;
+	threadcacheindex = -1;
+	threadcaches = 0;
+#ifdef RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+	if (threadsafe)
+	{
+		// Reserve a position in the thread local table; there are at most 32 of 
+		// them, one for each bit
+		RTPAtomicInteger &usedslots = GetUsedThreadSlots();
+		int32_t mask = usedslots.Get();
+		int i = 0;
+
+		while (i < RTPPOOLEDMEMORYMANAGER_MAXTHREADCACHEMANAGERS && threadcacheindex < 0)
+		{
+			int32_t bit = (int32_t)(((uint32_t)1) << i);
+
+			if (mask&bit)
+				i++;
+			else if (usedslots.CompareExchange(mask, mask|bit))
+				threadcacheindex = i;
+			else
+				mask = usedslots.Get();
+		}
+		if (threadcacheindex >= 0)
+			managerid = GetLastManagerID().FetchAdd(1)+1;
+	}
+#ifdef RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+	if (threadcacheindex >= 0)
+	{
+		pthread_once(&exitkeyonce, CreateExitKey);
+		pthread_mutex_lock(&exitmutex);
+		exitmanagers[threadcacheindex] = this;
+		pthread_mutex_unlock(&exitmutex);
+	}
+#endif // RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+#endif // RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+}
+
+RTPPooledMemoryManager::~RTPPooledMemoryManager()
+{
+#ifdef RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+	// Threads which exit from now on must leave this manager alone
+	if (threadcacheindex >= 0)
+	{
+		pthread_mutex_lock(&exitmutex);
+		exitmanagers[threadcacheindex] = 0;
+		pthread_mutex_unlock(&exitmutex);
+	}
+#endif // RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+
+	// The blocks in the magazines are part of the slabs, which are deleted
+	// together with the caches
+	while (threadcaches != 0)
+	{
+		ThreadCache *next = threadcaches->next;
+
+		delete threadcaches;
+		threadcaches = next;
+	}
+
+#ifdef RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+	if (threadcacheindex >= 0)
+	{
+		RTPPooledMemoryManagerThreadSlot &slot = threadslots[threadcacheindex];
+
+		if (slot.managerid == managerid)
+		{
+			slot.managerid = 0;
+			slot.threadcache = 0;
+		}
+
+		// Entries in the tables of other threads are left behind, but since the
+		// identifier of a manager is never reused, they won't be used again
+
+		RTPAtomicInteger &usedslots = GetUsedThreadSlots();
+		int32_t bit = (int32_t)(((uint32_t)1) << threadcacheindex);
+		int32_t mask;
+
+		do
+		{
+			mask = usedslots.Get();
+		} while (!usedslots.CompareExchange(mask, mask&~bit));
+	}
+#endif // RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+
+	for (int i = 0 ; i < RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES ; i++)
+		delete classcaches[i];
+	delete [] buckets;
+}
+
+void *RTPPooledMemoryManager::AllocateBuffer(size_t numbytes, int memtype)
+{
+	ThreadCache *tc = GetThreadCache();
+	Cache *cache = 0;
+	void *buf;
+
+	if (memtype >= 0 && memtype < RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES && classcaches[memtype] != 0 && 
+	    UseClassCache(classcaches[memtype], numbytes, tc))
+		cache = classcaches[memtype];
+	else
+	{
+		// Variable size buffer, or a class instance of a different size than the 
+		// first one for this type (e.g. RTPAddress implementations)
+
+		cache = GetBucket(numbytes);
+		if (cache == 0)
+			return AllocateFromSystem(numbytes);
+	}
+
+	if (tc != 0)
+		buf = AllocateFromMagazine(cache, tc);
+	else
+	{
+		CACHE_LOCK(cache)
+		buf = AllocateFromCache(cache);
+		CACHE_UNLOCK(cache)
+	}
+	return (buf != 0)?buf:AllocateFromSystem(numbytes);
+}
+
+void RTPPooledMemoryManager::FreeBuffer(void *buffer)
+{
+	if (buffer == 0)
+		return;
+
+	uint8_t *block = (uint8_t *)buffer;
+	uint8_t *header = block-RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+	Cache *cache = *((Cache **)header);
+
+	if (cache == 0)
+	{
+		delete [] header;
+		return;
+	}
+
+	ThreadCache *tc = GetThreadCache();
+
+	if (tc != 0)
+		FreeToMagazine(cache, tc, block);
+	else
+		ReturnBlocks(cache, &block, 1);
+}
+
+int RTPPooledMemoryManager::Preallocate(int memtype, size_t numbytes, size_t numblocks)
+{
+	Cache *cache = 0;
+
+	if (memtype >= 0 && memtype < RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES && classcaches[memtype] != 0 &&
+	    UseClassCache(classcaches[memtype], numbytes, 0))
+		cache = classcaches[memtype];
+	else
+	{
+		cache = GetBucket(numbytes);
+		if (cache == 0)
+			return ERR_RTP_POOLEDMEMORYMANAGER_INVALIDSIZE;
+	}
+
+	int status = 0;
+
+	CACHE_LOCK(cache)
+	while (cache->numfree < numblocks)
+	{
+		if ((status = GrowCache(cache)) < 0)
+			break;
+	}
+	CACHE_UNLOCK(cache)
+	return status;
+}
+
+void RTPPooledMemoryManager::SetMaximumPooledMemory(size_t maxbytes)
+{
+	POOL_LOCK
+	maxpooledmemory = maxbytes;
+	POOL_UNLOCK
+}
+
+size_t RTPPooledMemoryManager::GetMaximumPooledMemory() const
+{
+	size_t m;
+
+	POOL_LOCK
+	m = maxpooledmemory;
+	POOL_UNLOCK
+	return m;
+}
+
+size_t RTPPooledMemoryManager::GetPooledMemory() const
+{
+	size_t m;
+
+	POOL_LOCK
+	m = pooledmemory;
+	POOL_UNLOCK
+	return m;
+}
+
+void RTPPooledMemoryManager::FlushThreadCache()
+{
+#ifdef RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+	if (threadcacheindex < 0)
+		return;
+
+	RTPPooledMemoryManagerThreadSlot &slot = threadslots[threadcacheindex];
+
+	if (slot.managerid != managerid)
+		return;
+
+	ThreadCache *tc = (ThreadCache *)slot.threadcache;
+
+	slot.managerid = 0;
+	slot.threadcache = 0;
+	ReleaseThreadCache(tc);
+#endif // RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+}
+
+void RTPPooledMemoryManager::ReleaseThreadCache(ThreadCache *tc)
+{
+	for (int i = 0 ; i < RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES ; i++)
+	{
+		if (classcaches[i] != 0)
+			ReturnBlocks(classcaches[i], tc->magazines[classcaches[i]->index].blocks, tc->magazines[classcaches[i]->index].count);
+	}
+	for (int i = 0 ; i < numbuckets ; i++)
+		ReturnBlocks(&buckets[i], tc->magazines[buckets[i].index].blocks, tc->magazines[buckets[i].index].count);
+
+	POOL_LOCK
+	ThreadCache **prev = &threadcaches;
+
+	while (*prev != tc)
+		prev = &((*prev)->next);
+	*prev = tc->next;
+	POOL_UNLOCK
+
+	delete tc;
+}
+
+void RTPPooledMemoryManager::CreateExitKey()
+{
+#ifdef RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+	if (pthread_key_create(&exitkey, ThreadExit) == 0)
+		exitkeycreated = true;
+#endif // RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+}
+
+void RTPPooledMemoryManager::ThreadExit(void *slots)
+{
+#ifdef RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+	// Called with the 'threadslots' table of the thread that exits
+
+	RTPPooledMemoryManagerThreadSlot *threadslots = (RTPPooledMemoryManagerThreadSlot *)slots;
+
+	pthread_mutex_lock(&exitmutex);
+	for (int i = 0 ; i < RTPPOOLEDMEMORYMANAGER_MAXTHREADCACHEMANAGERS ; i++)
+	{
+		RTPPooledMemoryManagerThreadSlot &slot = threadslots[i];
+		RTPPooledMemoryManager *mgr = exitmanagers[i];
+
+		// The entry can belong to a manager that was already destroyed, of 
+		// which the position was reused
+		if (slot.managerid != 0 && mgr != 0 && mgr->managerid == slot.managerid)
+			mgr->ReleaseThreadCache((ThreadCache *)slot.threadcache);
+		slot.managerid = 0;
+		slot.threadcache = 0;
+	}
+	pthread_mutex_unlock(&exitmutex);
+#else
+	JRTPLIB_UNUSED(slots);
+#endif // RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+}
+
+bool RTPPooledMemoryManager::IsClassMemoryType(int memtype)
+{
+	switch (memtype)
+	{
+	case RTPMEM_TYPE_CLASS_ACCEPTIGNOREHASHELEMENT:
+	case RTPMEM_TYPE_CLASS_ACCEPTIGNOREPORTINFO:
+	case RTPMEM_TYPE_CLASS_DESTINATIONLISTHASHELEMENT:
+	case RTPMEM_TYPE_CLASS_MULTICASTHASHELEMENT:
+	case RTPMEM_TYPE_CLASS_RTCPAPPPACKET:
+	case RTPMEM_TYPE_CLASS_RTCPBYEPACKET:
+	case RTPMEM_TYPE_CLASS_RTCPCOMPOUNDPACKETBUILDER:
+	case RTPMEM_TYPE_CLASS_RTCPRECEIVERREPORT:
+	case RTPMEM_TYPE_CLASS_RTCPRRPACKET:
+	case RTPMEM_TYPE_CLASS_RTCPSDESPACKET:
+	case RTPMEM_TYPE_CLASS_RTCPSRPACKET:
+	case RTPMEM_TYPE_CLASS_RTCPUNKNOWNPACKET:
+	case RTPMEM_TYPE_CLASS_RTPADDRESS:
+	case RTPMEM_TYPE_CLASS_RTPINTERNALSOURCEDATA:
+	case RTPMEM_TYPE_CLASS_RTPPACKET:
+	case RTPMEM_TYPE_CLASS_RTPPOLLTHREAD:
+	case RTPMEM_TYPE_CLASS_RTPRAWPACKET:
+	case RTPMEM_TYPE_CLASS_RTPTRANSMISSIONINFO:
+	case RTPMEM_TYPE_CLASS_RTPTRANSMITTER:
+	case RTPMEM_TYPE_CLASS_SDESPRIVATEITEM:
+	case RTPMEM_TYPE_CLASS_SDESSOURCE:
+	case RTPMEM_TYPE_CLASS_SOURCETABLEHASHELEMENT:
+	case RTPMEM_TYPE_CLASS_PACKETQUEUENODE:
+	case RTPMEM_TYPE_CLASS_SOURCESNAPSHOT:
+	case RTPMEM_TYPE_CLASS_COLLISIONLISTENTRY:
+	case RTPMEM_TYPE_CLASS_SHAREDBUFFER:
+		return true;
+	default:
+		return false;
+	}
+}
+
+RTPPooledMemoryManager::Cache *RTPPooledMemoryManager::GetBucket(size_t numbytes)
+{
+	size_t s = RTPPOOLEDMEMORYMANAGER_MINBUCKETSIZE;
+	int idx = 0;
+
+	while (idx < numbuckets)
+	{
+		if (numbytes <= s)
+			return &buckets[idx];
+		if (idx+1 < numbuckets && numbytes <= s+s/2)
+			return &buckets[idx+1];
+		s *= 2;
+		idx += 2;
+	}
+	return 0;
+}
+
+bool RTPPooledMemoryManager::UseClassCache(Cache *cache, size_t numbytes, ThreadCache *tc)
+{
+	// The block size of a class cache is set once, so after the first time
+	// a thread can use its own copy instead of taking the lock
+	size_t blocksize = (tc != 0)?tc->magazines[cache->index].blocksize:0;
+
+	if (blocksize == 0)
+	{
+		CACHE_LOCK(cache)
+		if (cache->blocksize == 0)
+			cache->blocksize = RoundBlockSize(numbytes);
+		blocksize = cache->blocksize;
+		CACHE_UNLOCK(cache)
+
+		if (tc != 0)
+			tc->magazines[cache->index].blocksize = blocksize;
+	}
+	return (numbytes <= blocksize);
+}
+
+void *RTPPooledMemoryManager::AllocateFromCache(Cache *cache)
+{
+	// The lock of the cache is held by the caller
+
+	if (cache->freelist == 0)
+	{
+		if (GrowCache(cache) < 0)
+			return 0;
+	}
+
+	uint8_t *block = cache->freelist;
+
+	cache->freelist = *((uint8_t **)block);
+	cache->numfree--;
+	return block;
+}
+
+void *RTPPooledMemoryManager::AllocateFromMagazine(Cache *cache, ThreadCache *tc)
+{
+	ThreadCache::Magazine &mag = tc->magazines[cache->index];
+
+	if (mag.count == 0)
+	{
+		// Take half a magazine at once, so the next allocations don't need the lock
+		CACHE_LOCK(cache)
+		while (mag.count < RTPPOOLEDMEMORYMANAGER_MAGAZINESIZE/2)
+		{
+			uint8_t *block = (uint8_t *)AllocateFromCache(cache);
+
+			if (block == 0)
+				break;
+			mag.blocks[mag.count++] = block;
+		}
+		CACHE_UNLOCK(cache)
+
+		if (mag.count == 0)
+			return 0;
+	}
+	return mag.blocks[--mag.count];
+}
+
+void *RTPPooledMemoryManager::AllocateFromSystem(size_t numbytes)
+{
+	uint8_t *header = new (std::nothrow) uint8_t[numbytes+RTPPOOLEDMEMORYMANAGER_HEADERSIZE];
+
+	if (header == 0)
+		return 0;
+	numsystemallocations.FetchAdd(1);
+	*((Cache **)header) = 0;
+	return header+RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+}
+
+void RTPPooledMemoryManager::FreeToMagazine(Cache *cache, ThreadCache *tc, uint8_t *block)
+{
+	ThreadCache::Magazine &mag = tc->magazines[cache->index];
+
+	if (mag.count == RTPPOOLEDMEMORYMANAGER_MAGAZINESIZE)
+	{
+		// Return the oldest half in one go; this is where blocks that were 
+		// allocated by another thread flow back to the shared pool
+		const int num = RTPPOOLEDMEMORYMANAGER_MAGAZINESIZE/2;
+
+		ReturnBlocks(cache, mag.blocks, num);
+		memmove(mag.blocks, mag.blocks+num, (mag.count-num)*sizeof(uint8_t *));
+		mag.count -= num;
+	}
+	mag.blocks[mag.count++] = block;
+}
+
+void RTPPooledMemoryManager::ReturnBlocks(Cache *cache, uint8_t **blocks, int num)
+{
+	if (num == 0)
+		return;
+
+	CACHE_LOCK(cache)
+	for (int i = 0 ; i < num ; i++)
+	{
+		*((uint8_t **)blocks[i]) = cache->freelist;
+		cache->freelist = blocks[i];
+	}
+	cache->numfree += num;
+	CACHE_UNLOCK(cache)
+}
+
+int RTPPooledMemoryManager::GrowCache(Cache *cache)
+{
+	// The lock of the cache is held by the caller
+
+	size_t stride = cache->blocksize+RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+	size_t numblocks = RTPPOOLEDMEMORYMANAGER_SLABSIZE/stride;
+	
+	if (numblocks == 0)
+		numblocks = 1;
+
+	size_t slabsize = RTPPOOLEDMEMORYMANAGER_HEADERSIZE+numblocks*stride;
+	
+	POOL_LOCK
+	if (maxpooledmemory != 0 && pooledmemory+slabsize > maxpooledmemory)
+	{
+		POOL_UNLOCK
+		return ERR_RTP_POOLEDMEMORYMANAGER_MAXIMUMREACHED;
+	}
+	pooledmemory += slabsize;
+	POOL_UNLOCK
+
+	uint8_t *slab = new (std::nothrow) uint8_t[slabsize];
+
+	if (slab == 0)
+	{
+		POOL_LOCK
+		pooledmemory -= slabsize;
+		POOL_UNLOCK
+		return ERR_RTP_OUTOFMEM;
+	}
+	numsystemallocations.FetchAdd(1);
+
+	*((uint8_t **)slab) = cache->slabs;
+	cache->slabs = slab;
+
+	uint8_t *header = slab+RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+
+	for (size_t i = 0 ; i < numblocks ; i++, header += stride)
+	{
+		uint8_t *block = header+RTPPOOLEDMEMORYMANAGER_HEADERSIZE;
+
+		*((Cache **)header) = cache;
+		*((uint8_t **)block) = cache->freelist;
+		cache->freelist = block;
+	}
+	cache->numfree += numblocks;
+	return 0;
+}
+
+RTPPooledMemoryManager::ThreadCache *RTPPooledMemoryManager::GetThreadCache()
+{
+#ifdef RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+	if (threadcacheindex < 0)
+		return 0;
+
+	RTPPooledMemoryManagerThreadSlot &slot = threadslots[threadcacheindex];
+
+	if (slot.managerid == managerid)
+		return (ThreadCache *)slot.threadcache;
+
+	// First use of this manager in the calling thread
+
+	ThreadCache *tc = new (std::nothrow) ThreadCache();
+
+	if (tc == 0)
+		return 0;
+	if ((tc->magazines = new (std::nothrow) ThreadCache::Magazine[numcaches]) == 0)
+	{
+		delete tc;
+		return 0;
+	}
+	for (int i = 0 ; i < numbuckets ; i++)
+		tc->magazines[buckets[i].index].blocksize = buckets[i].blocksize;
+
+	POOL_LOCK
+	tc->next = threadcaches;
+	threadcaches = tc;
+	POOL_UNLOCK
+
+	slot.managerid = managerid;
+	slot.threadcache = tc;
+#ifdef RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+	if (exitkeycreated)
+		pthread_setspecific(exitkey, threadslots);
+#endif // RTPPOOLEDMEMORYMANAGER_FLUSHONTHREADEXIT
+	return tc;
+#else
+	return 0;
+#endif // RTPPOOLEDMEMORYMANAGER_USETHREADCACHES
+}
+
+} // end namespace
+
@@ -0,0 +1,178 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtppooledmemorymanager.h
+ */
+
+#ifndef RTPPOOLEDMEMORYMANAGER_H
+
+#define RTPPOOLEDMEMORYMANAGER_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtpatomic.h"
+#include "rtpmemorymanager.h"
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jmutex.h>
+#endif // RTP_SUPPORT_THREAD
+
+#define RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES					64
+#define RTPPOOLEDMEMORYMANAGER_MINBUCKETSIZE					32
+#define RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE					65536
+#define RTPPOOLEDMEMORYMANAGER_SLABSIZE						65536
+#define RTPPOOLEDMEMORYMANAGER_DEFAULTMAXPOOLEDMEMORY				(32*1024*1024)
+#define RTPPOOLEDMEMORYMANAGER_MAGAZINESIZE					32
+#define RTPPOOLEDMEMORYMANAGER_MAXTHREADCACHEMANAGERS				32
+
+namespace jrtplib
+{
+
+/** A memory manager which keeps freed memory blocks in pools for reuse.
+ *  A memory manager which keeps freed memory blocks in pools for reuse. Memory is obtained
+ *  from the system in slabs which are divided into blocks of the same size; a freed block is
+ *  put on the free list of its pool and is handed out again by the next allocation of that pool,
+ *  so that once the pools have grown large enough no more system allocations are needed.
+ *
+ *  Each memory type starting with \c RTPMEM_TYPE_CLASS gets a pool of its own, of which the block 
+ *  size is set by the first allocation or preallocation for that type. Allocations for other 
+ *  memory types, and class allocations which are larger than the block size of their pool, are 
+ *  served from pools of which the block sizes are powers of two and one and a half times powers 
+ *  of two, ranging from RTPPOOLEDMEMORYMANAGER_MINBUCKETSIZE to RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE 
+ *  bytes. Larger allocations are passed to the system directly.
+ *
+ *  The memory in the slabs is only returned to the system when the memory manager is destroyed,
+ *  so it must outlive all objects which use it. To limit the amount of memory that is kept, a 
+ *  maximum can be set using RTPPooledMemoryManager::SetMaximumPooledMemory; when a pool needs to 
+ *  grow beyond this maximum, the block is allocated directly from the system instead and is also 
+ *  released to the system when it is freed.
+ *
+ *  When the manager is thread safe and the compiler supports thread local storage, each thread 
+ *  which uses the manager gets a magazine of at most RTPPOOLEDMEMORYMANAGER_MAGAZINESIZE blocks 
+ *  for every pool. Allocations are taken from, and freed blocks are put in, the magazine of the 
+ *  calling thread without taking a lock; only when a magazine is empty or full is the lock of the 
+ *  pool taken, to move half a magazine of blocks at once. Blocks which are allocated in one thread 
+ *  and freed in another, like packets which are received in the poll thread and deleted by the 
+ *  application, are therefore returned to the shared pool in batches. At most 
+ *  RTPPOOLEDMEMORYMANAGER_MAXTHREADCACHEMANAGERS managers can use magazines at the same time, 
+ *  others always use the locks. The magazines of a thread are emptied when the thread exits,
+ *  when the thread calls RTPPooledMemoryManager::FlushThreadCache, or when the manager is 
+ *  destroyed. Emptying them on exit requires \c pthread_key_create (\c RTP_HAVE_PTHREAD_KEY); 
+ *  without it, threads that stop while the manager is still being used should call 
+ *  RTPPooledMemoryManager::FlushThreadCache themselves. The poll thread of a session always does
+ *  this when it stops, through RTPMemoryManager::OnThreadStop.
+ */
+class JRTPLIB_IMPORTEXPORT RTPPooledMemoryManager : public RTPMemoryManager
+{
+	JRTPLIB_NO_COPY(RTPPooledMemoryManager)
+public:
+	/** Creates a memory manager; if \c threadsafe is false, no locks are used and the manager may only be used from one thread at a time. */
+	RTPPooledMemoryManager(bool threadsafe = true);
+	~RTPPooledMemoryManager();
+
+	void *AllocateBuffer(size_t numbytes, int memtype);
+	void FreeBuffer(void *buffer);
+
+	/** Calls RTPPooledMemoryManager::FlushThreadCache, so the magazines of a poll thread are emptied when it stops. */
+	void OnThreadStop()										{ FlushThreadCache(); }
+
+	/** Makes sure that \c numblocks blocks of \c numbytes bytes are available for memory type \c memtype.
+	 *  Makes sure that \c numblocks blocks of \c numbytes bytes are available for memory type \c memtype,
+	 *  allocating the necessary slabs. For a type starting with \c RTPMEM_TYPE_CLASS this also sets the 
+	 *  block size of its pool if no allocation was done for that type yet. Blocks which are currently 
+	 *  allocated are not taken into account.
+	 */
+	int Preallocate(int memtype, size_t numbytes, size_t numblocks);
+
+	/** Sets the maximum amount of memory that can be kept in slabs to \c maxbytes; zero means no limit.
+	 *  Sets the maximum amount of memory that can be kept in slabs to \c maxbytes; zero means no limit.
+	 *  Memory that's already part of a slab is not released when the maximum is lowered. By default, 
+	 *  RTPPOOLEDMEMORYMANAGER_DEFAULTMAXPOOLEDMEMORY is used.
+	 */
+	void SetMaximumPooledMemory(size_t maxbytes);
+
+	/** Returns the maximum amount of memory that can be kept in slabs. */
+	size_t GetMaximumPooledMemory() const;
+
+	/** Returns the amount of memory that's currently kept in slabs. */
+	size_t GetPooledMemory() const;
+
+	/** Returns the number of times memory was allocated from the system, either for a slab or for a single block. */
+	int32_t GetNumberOfSystemAllocations() const							{ return numsystemallocations.Get(); }
+
+	/** Returns the blocks in the magazines of the calling thread to the pools, and releases the magazines; this also happens automatically when the thread exits, if \c RTP_HAVE_PTHREAD_KEY is defined. */
+	void FlushThreadCache();
+
+	/** Returns true if \c memtype is one of the fixed size types, starting with \c RTPMEM_TYPE_CLASS. */
+	static bool IsClassMemoryType(int memtype);
+private:
+	class Cache;
+	class ThreadCache;
+
+	Cache *GetBucket(size_t numbytes);
+	bool UseClassCache(Cache *cache, size_t numbytes, ThreadCache *tc);
+	void *AllocateFromCache(Cache *cache);
+	void *AllocateFromMagazine(Cache *cache, ThreadCache *tc);
+	void *AllocateFromSystem(size_t numbytes);
+	void FreeToMagazine(Cache *cache, ThreadCache *tc, uint8_t *block);
+	void ReturnBlocks(Cache *cache, uint8_t **blocks, int num);
+	int GrowCache(Cache *cache);
+	ThreadCache *GetThreadCache();
+	void ReleaseThreadCache(ThreadCache *tc);
+	static void CreateExitKey();
+	static void ThreadExit(void *threadslots);
+
+	bool threadsafe;
+	Cache *classcaches[RTPPOOLEDMEMORYMANAGER_NUMMEMTYPES];
+	Cache *buckets;
+	int numbuckets, numcaches;
+
+	// Thread caches are looked up in a thread local table, at the position that's
+	// reserved for this manager; the identifier tells if the entry is really ours,
+	// or was left behind by a destroyed manager which used the same position
+	int32_t managerid;
+	int threadcacheindex;
+	ThreadCache *threadcaches;
+
+	size_t maxpooledmemory;
+	size_t pooledmemory;
+	RTPAtomicInteger numsystemallocations;
+#ifdef RTP_SUPPORT_THREAD
+	mutable jthread::JMutex poolmutex;
+#endif // RTP_SUPPORT_THREAD
+};
+
+} // end namespace
+
+#endif // RTPPOOLEDMEMORYMANAGER_H
+
@@ -58,6 +58,11 @@ int RTPRandomURandom::Init()
 	if (device == 0)
 		return ERR_RTP_RTPRANDOMURANDOM_CANTOPEN;
 
+	// Each session has its own generator, so the default stdio buffer
+	// would cost several kilobytes per session while only a few random
+	// numbers are needed every RTCP interval
+	setvbuf(device,devicebuffer,_IOFBF,RTPRANDOMURANDOM_BUFFERSIZE);
+
 	return 0;
 }
 
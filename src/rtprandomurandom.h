@@ -42,6 +42,8 @@
 #include "rtprandom.h"
 #include <stdio.h>
 
+#define RTPRANDOMURANDOM_BUFFERSIZE					64
+
 namespace jrtplib
 {
 
@@ -61,6 +63,7 @@ public:
 	double GetRandomDouble();
 private:
 	FILE *device;
+	char devicebuffer[RTPRANDOMURANDOM_BUFFERSIZE];
 };
 
 } // end namespace
@@ -48,6 +48,13 @@
 namespace jrtplib
 {
 
+/** Type of a function which can be installed in an RTPRawPacket instance to release the packet data.
+ *  Type of a function which can be installed in an RTPRawPacket instance to release the packet data.
+ *  The first argument is the pointer to the data, the second one is the parameter that was
+ *  specified in RTPRawPacket::SetDataFreeCallback.
+ */
+typedef void (*RTPRawPacketFreeCallback)(uint8_t *data, void *param);
+
 /** This class is used by the transmission component to store the incoming RTP and RTCP data in. */
 class JRTPLIB_IMPORTEXPORT RTPRawPacket : public RTPMemoryObject
 {
@@ -96,7 +103,21 @@ public:
 	 *  the packet data (without having to copy it)	and to make sure the data isn't deleted 
 	 *  when the destructor of RTPRawPacket is called.
 	 */
-	void ZeroData()															{ packetdata = 0; packetdatalength = 0; }
+	void ZeroData()															{ packetdata = 0; packetdatalength = 0; freecallback = 0; freecallbackparam = 0; }
+
+	/** Installs a function which will be used to release the packet data instead of the memory manager.
+	 *  Installs a function which will be used to release the packet data instead of the memory manager.
+	 *  This allows a transmitter to hand out data which resides in a buffer it does not own (e.g. a
+	 *  memory mapped receive ring) without copying it. When the data is moved to an RTPPacket or
+	 *  RTCPCompoundPacket instance, the callback is moved along with it.
+	 */
+	void SetDataFreeCallback(RTPRawPacketFreeCallback f, void *param)		{ freecallback = f; freecallbackparam = param; }
+
+	/** Returns the function which will be used to release the packet data, or null if the memory manager is used. */
+	RTPRawPacketFreeCallback GetDataFreeCallback() const					{ return freecallback; }
+
+	/** Returns the parameter that will be passed to the function which releases the packet data. */
+	void *GetDataFreeCallbackParameter() const								{ return freecallbackparam; }
 
 	/** Allocates a number of bytes for RTP or RTCP data using the memory manager that
 	 *  was used for this raw packet instance, can be useful if the RTPRawPacket::SetData
@@ -104,7 +125,9 @@ public:
 	uint8_t *AllocateBytes(bool isrtp, int recvlen) const;
 
 	/** Deallocates the previously stored data and replaces it with the data that's
-	 *  specified, can be useful when e.g. decrypting data in RTPSession::OnChangeIncomingData */
+	 *  specified, can be useful when e.g. decrypting data in RTPSession::OnChangeIncomingData.
+	 *  The new data is assumed to be allocated by the memory manager, so a previously installed
+	 *  free callback is removed. */
 	void SetData(uint8_t *data, size_t datalen);
 
 	/** Deallocates the currently stored RTPAddress instance and replaces it
@@ -118,6 +141,8 @@ private:
 	RTPTime receivetime;
 	RTPAddress *senderaddress;
 	bool isrtp;
+	RTPRawPacketFreeCallback freecallback;
+	void *freecallbackparam;
 };
 
 inline RTPRawPacket::RTPRawPacket(uint8_t *data,size_t datalen,RTPAddress *address,RTPTime &recvtime,bool rtp,RTPMemoryManager *mgr):RTPMemoryObject(mgr),receivetime(recvtime)
@@ -126,6 +151,8 @@ inline RTPRawPacket::RTPRawPacket(uint8_t *data,size_t datalen,RTPAddress *addre
 	packetdatalength = datalen;
 	senderaddress = address;
 	isrtp = rtp;
+	freecallback = 0;
+	freecallbackparam = 0;
 }
 
 inline RTPRawPacket::RTPRawPacket(uint8_t *data,size_t datalen,RTPAddress *address,RTPTime &recvtime,RTPMemoryManager *mgr):RTPMemoryObject(mgr),receivetime(recvtime)
@@ -133,6 +160,8 @@ inline RTPRawPacket::RTPRawPacket(uint8_t *data,size_t datalen,RTPAddress *addre
 	packetdata = data;
 	packetdatalength = datalen;
 	senderaddress = address;
+	freecallback = 0;
+	freecallbackparam = 0;
 
 	isrtp = true;
 	if (datalen >= sizeof(RTCPCommonHeader))
@@ -153,12 +182,19 @@ inline RTPRawPacket::~RTPRawPacket()
 inline void RTPRawPacket::DeleteData()
 {
 	if (packetdata)
-		RTPDeleteByteArray(packetdata,GetMemoryManager());
+	{
+		if (freecallback)
+			freecallback(packetdata,freecallbackparam);
+		else
+			RTPDeleteByteArray(packetdata,GetMemoryManager());
+	}
 	if (senderaddress)
 		RTPDelete(senderaddress,GetMemoryManager());
 
 	packetdata = 0;
 	senderaddress = 0;
+	freecallback = 0;
+	freecallbackparam = 0;
 }
 
 inline uint8_t *RTPRawPacket::AllocateBytes(bool isrtp, int recvlen) const
@@ -170,7 +206,14 @@ inline uint8_t *RTPRawPacket::AllocateBytes(bool isrtp, int recvlen) const
 inline void RTPRawPacket::SetData(uint8_t *data, size_t datalen)
 {
 	if (packetdata)
-		RTPDeleteByteArray(packetdata,GetMemoryManager());
+	{
+		if (freecallback)
+			freecallback(packetdata,freecallbackparam);
+		else
+			RTPDeleteByteArray(packetdata,GetMemoryManager());
+	}
+	freecallback = 0;
+	freecallbackparam = 0;
 
 	packetdata = data;
 	packetdatalength = datalen;
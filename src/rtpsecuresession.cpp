@@ -250,8 +250,12 @@ int RTPSecureSession::decryptRawPacket(RTPRawPacket *rawpack, int *srtpError)
 		}
 	}
 
+	RTPRawPacketFreeCallback freeCallback = rawpack->GetDataFreeCallback();
+	void *freeCallbackParam = rawpack->GetDataFreeCallbackParameter();
+
 	rawpack->ZeroData(); // make sure we don't delete the data we're going to store
 	rawpack->SetData(pData, (size_t)dataLength);
+	rawpack->SetDataFreeCallback(freeCallback, freeCallbackParam);
 
 	return 0;
 }
@@ -37,10 +37,13 @@
 #include "rtpudpv6transmitter.h"
 #include "rtptcptransmitter.h"
 #include "rtpexternaltransmitter.h"
+#include "rtppacketringtransmitter.h"
+#include "rtploopbacktransmitter.h"
 #include "rtpsessionparams.h"
 #include "rtpdefines.h"
 #include "rtprawpacket.h"
 #include "rtppacket.h"
+#include "rtpsourcesnapshot.h"
 #include "rtptimeutilities.h"
 #include "rtpmemorymanager.h"
 #include "rtprandomrand48.h"
@@ -50,6 +53,8 @@
 	#include "rtcpcompoundpacket.h"
 #endif // RTP_SUPPORT_SENDAPP
 #include "rtpinternalutils.h"
+#include "rtpstructs.h"
+#include <string.h>
 #ifndef WIN32
 	#include <unistd.h>
 	#include <stdlib.h>
@@ -72,6 +77,8 @@
 	#define SCHED_UNLOCK					{ if (needthreadsafety) schedmutex.Unlock(); }
 	#define PACKSENT_LOCK					{ if (needthreadsafety) packsentmutex.Lock(); }
 	#define PACKSENT_UNLOCK					{ if (needthreadsafety) packsentmutex.Unlock(); } 
+	#define SNAPSHOT_LOCK					{ if (needthreadsafety) snapshotmutex.Lock(); }
+	#define SNAPSHOT_UNLOCK					{ if (needthreadsafety) snapshotmutex.Unlock(); }
 #else
 	#define SOURCES_LOCK
 	#define SOURCES_UNLOCK
@@ -81,6 +88,8 @@
 	#define SCHED_UNLOCK
 	#define PACKSENT_LOCK
 	#define PACKSENT_UNLOCK
+	#define SNAPSHOT_LOCK
+	#define SNAPSHOT_UNLOCK
 #endif // RTP_SUPPORT_THREAD
 
 namespace jrtplib
@@ -88,7 +97,7 @@ namespace jrtplib
 
 RTPSession::RTPSession(RTPRandom *r,RTPMemoryManager *mgr) 
 	: RTPMemoryObject(mgr),rtprnd(GetRandomNumberGenerator(r)),sources(*this,mgr),packetbuilder(*rtprnd,mgr),rtcpsched(sources,*rtprnd),
-	  rtcpbuilder(sources,packetbuilder,mgr),collisionlist(mgr)
+	  rtcpbuilder(sources,packetbuilder,mgr),collisionlist(mgr),deliveryqueue(mgr)
 {
 	// We're not going to set these flags in Create, so that the constructor of a derived class
 	// can already change them
@@ -96,6 +105,9 @@ RTPSession::RTPSession(RTPRandom *r,RTPMemoryManager *mgr)
 	m_changeOutgoingData = false;
 
 	created = false;
+	framebuffer = 0;
+	framebufferlength = 0;
+	cursnapshot = 0;
 	timeinit.Dummy();
 
 	//std::cout << (void *)(rtprnd) << std::endl;
@@ -154,6 +166,14 @@ int RTPSession::Create(const RTPSessionParams &sessparams,const RTPTransmissionP
 	case RTPTransmitter::TCPProto:
 		rtptrans = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPTRANSMITTER) RTPTCPTransmitter(GetMemoryManager());
 		break;
+#ifdef RTP_SUPPORT_PACKETRING
+	case RTPTransmitter::PacketRingProto:
+		rtptrans = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPTRANSMITTER) RTPPacketRingTransmitter(GetMemoryManager());
+		break;
+#endif // RTP_SUPPORT_PACKETRING
+	case RTPTransmitter::LoopbackProto:
+		rtptrans = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPTRANSMITTER) RTPLoopbackTransmitter(GetMemoryManager());
+		break;
 	default:
 		return ERR_RTP_SESSION_UNSUPPORTEDTRANSMISSIONPROTOCOL;
 	}
@@ -220,6 +240,9 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 	if (sessparams.GetUsePredefinedSSRC())
 		packetbuilder.AdjustSSRC(sessparams.GetPredefinedSSRC());
 
+	sources.SetUsePacketViews(sessparams.GetUsePacketViews());
+	sources.SetParseRTCPInPlace(sessparams.GetParseRTCPInPlace());
+
 #ifdef RTP_SUPPORT_PROBATION
 
 	// Set probation type
@@ -281,6 +304,7 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 			RTPDelete(rtptrans,GetMemoryManager());
 		return status;
 	}
+	rtcpbuilder.SetBuildInPlace(sessparams.GetBuildRTCPInPlace());
 
 	// Set scheduler parameters
 	
@@ -324,6 +348,23 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 	
 	rtcpsched.SetParameters(schedparams);
 
+	// Allocate the packet delivery queue if requested
+
+	deliverydropcount.Set(0);
+	snapshotsused.Set(0);
+	if (sessparams.GetPacketDeliveryQueueSize() > 0)
+	{
+		if ((status = deliveryqueue.Init(sessparams.GetPacketDeliveryQueueSize())) < 0)
+		{
+			if (deletetransmitter)
+				RTPDelete(rtptrans,GetMemoryManager());
+			packetbuilder.Destroy();
+			sources.Clear();
+			rtcpbuilder.Destroy();
+			return status;
+		}
+	}
+
 	// copy other parameters
 	
 	acceptownpackets = sessparams.AcceptOwnPackets();
@@ -348,6 +389,7 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 				packetbuilder.Destroy();
 				sources.Clear();
 				rtcpbuilder.Destroy();
+				deliveryqueue.Destroy();
 				return ERR_RTP_SESSION_CANTINITMUTEX;
 			}
 		}
@@ -360,6 +402,7 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 				packetbuilder.Destroy();
 				sources.Clear();
 				rtcpbuilder.Destroy();
+				deliveryqueue.Destroy();
 				return ERR_RTP_SESSION_CANTINITMUTEX;
 			}
 		}
@@ -372,6 +415,7 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 				packetbuilder.Destroy();
 				sources.Clear();
 				rtcpbuilder.Destroy();
+				deliveryqueue.Destroy();
 				return ERR_RTP_SESSION_CANTINITMUTEX;
 			}
 		}
@@ -384,6 +428,20 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 				packetbuilder.Destroy();
 				sources.Clear();
 				rtcpbuilder.Destroy();
+				deliveryqueue.Destroy();
+				return ERR_RTP_SESSION_CANTINITMUTEX;
+			}
+		}
+		if (!snapshotmutex.IsInitialized())
+		{
+			if (snapshotmutex.Init() < 0)
+			{
+				if (deletetransmitter)
+					RTPDelete(rtptrans,GetMemoryManager());
+				packetbuilder.Destroy();
+				sources.Clear();
+				rtcpbuilder.Destroy();
+				deliveryqueue.Destroy();
 				return ERR_RTP_SESSION_CANTINITMUTEX;
 			}
 		}
@@ -396,6 +454,7 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 			packetbuilder.Destroy();
 			sources.Clear();
 			rtcpbuilder.Destroy();
+			deliveryqueue.Destroy();
 			return ERR_RTP_OUTOFMEM;
 		}
 		if ((status = pollthread->Start(rtptrans)) < 0)
@@ -406,6 +465,7 @@ int RTPSession::InternalCreate(const RTPSessionParams &sessparams)
 			packetbuilder.Destroy();
 			sources.Clear();
 			rtcpbuilder.Destroy();
+			deliveryqueue.Destroy();
 			return status;
 		}
 	}
@@ -433,12 +493,21 @@ void RTPSession::Destroy()
 	rtcpsched.Reset();
 	collisionlist.Clear();
 	sources.Clear();
+	ClearDeliveryQueue();
+	PublishSourceSnapshot(0);
 
 	std::list<RTCPCompoundPacket *>::const_iterator it;
 
 	for (it = byepackets.begin() ; it != byepackets.end() ; it++)
 		RTPDelete(*it,GetMemoryManager());
 	byepackets.clear();
+
+	if (framebuffer)
+		RTPDeleteByteArray(framebuffer,GetMemoryManager());
+	framebuffer = 0;
+	framebufferlength = 0;
+	framepackets.clear();
+	framepayloads.clear();
 	
 	created = false;
 }
@@ -515,6 +584,8 @@ void RTPSession::BYEDestroy(const RTPTime &maxwaittime,const void *reason,size_t
 	rtcpsched.Reset();
 	collisionlist.Clear();
 	sources.Clear();
+	ClearDeliveryQueue();
+	PublishSourceSnapshot(0);
 
 	// clear rest of bye packets
 	std::list<RTCPCompoundPacket *>::const_iterator it;
@@ -522,6 +593,13 @@ void RTPSession::BYEDestroy(const RTPTime &maxwaittime,const void *reason,size_t
 	for (it = byepackets.begin() ; it != byepackets.end() ; it++)
 		RTPDelete(*it,GetMemoryManager());
 	byepackets.clear();
+
+	if (framebuffer)
+		RTPDeleteByteArray(framebuffer,GetMemoryManager());
+	framebuffer = 0;
+	framebufferlength = 0;
+	framepackets.clear();
+	framepayloads.clear();
 	
 	created = false;
 }
@@ -601,12 +679,13 @@ int RTPSession::SendPacket(const void *data,size_t len)
 		return ERR_RTP_SESSION_NOTCREATED;
 
 	BUILDER_LOCK
-	if ((status = packetbuilder.BuildPacket(data,len)) < 0)
+	bool gather = UseGatherSend();
+	if ((status = (gather)?packetbuilder.BuildPacketHeader(len):packetbuilder.BuildPacket(data,len)) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
 	}
-	if ((status = SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
+	if ((status = (gather)?SendRTPHeaderAndPayload(data,len):SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
@@ -631,12 +710,13 @@ int RTPSession::SendPacket(const void *data,size_t len,
 		return ERR_RTP_SESSION_NOTCREATED;
 	
 	BUILDER_LOCK
-	if ((status = packetbuilder.BuildPacket(data,len,pt,mark,timestampinc)) < 0)
+	bool gather = UseGatherSend();
+	if ((status = (gather)?packetbuilder.BuildPacketHeader(len,pt,mark,timestampinc):packetbuilder.BuildPacket(data,len,pt,mark,timestampinc)) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
 	}
-	if ((status = SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
+	if ((status = (gather)?SendRTPHeaderAndPayload(data,len):SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
@@ -661,12 +741,13 @@ int RTPSession::SendPacketEx(const void *data,size_t len,
 		return ERR_RTP_SESSION_NOTCREATED;
 
 	BUILDER_LOCK
-	if ((status = packetbuilder.BuildPacketEx(data,len,hdrextID,hdrextdata,numhdrextwords)) < 0)
+	bool gather = UseGatherSend();
+	if ((status = (gather)?packetbuilder.BuildPacketHeaderEx(len,hdrextID,hdrextdata,numhdrextwords):packetbuilder.BuildPacketEx(data,len,hdrextID,hdrextdata,numhdrextwords)) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
 	}
-	if ((status = SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
+	if ((status = (gather)?SendRTPHeaderAndPayload(data,len):SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
@@ -692,12 +773,13 @@ int RTPSession::SendPacketEx(const void *data,size_t len,
 		return ERR_RTP_SESSION_NOTCREATED;
 	
 	BUILDER_LOCK
-	if ((status = packetbuilder.BuildPacketEx(data,len,pt,mark,timestampinc,hdrextID,hdrextdata,numhdrextwords)) < 0)
+	bool gather = UseGatherSend();
+	if ((status = (gather)?packetbuilder.BuildPacketHeaderEx(len,pt,mark,timestampinc,hdrextID,hdrextdata,numhdrextwords):packetbuilder.BuildPacketEx(data,len,pt,mark,timestampinc,hdrextID,hdrextdata,numhdrextwords)) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
 	}
-	if ((status = SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
+	if ((status = (gather)?SendRTPHeaderAndPayload(data,len):SendRTPData(packetbuilder.GetPacket(),packetbuilder.GetPacketLength())) < 0)
 	{
 		BUILDER_UNLOCK
 		return status;
@@ -713,6 +795,130 @@ int RTPSession::SendPacketEx(const void *data,size_t len,
 	return 0;
 }
 
+int RTPSession::SendFrame(const RTPDataSpan *payloads,size_t numpayloads,
+                          uint8_t pt,uint32_t timestampinc)
+{
+	if (!created)
+		return ERR_RTP_SESSION_NOTCREATED;
+	if (numpayloads == 0)
+		return 0;
+
+	// Only the last packet of the frame gets the marker and increments the timestamp
+
+	BUILDER_LOCK
+	framepayloads.resize(numpayloads);
+	for (size_t i = 0 ; i < numpayloads ; i++)
+	{
+		bool last = (i == numpayloads-1);
+
+		framepayloads[i] = RTPPayloadInfo(payloads[i].data,payloads[i].length,pt,last,(last)?timestampinc:0);
+	}
+	int status = InternalSendPackets(&framepayloads[0],numpayloads);
+	BUILDER_UNLOCK
+
+	if (status < 0)
+		return status;
+
+	SOURCES_LOCK
+	for (size_t i = 0 ; i < numpayloads ; i++)
+		sources.SentRTPPacket();
+	SOURCES_UNLOCK
+	PACKSENT_LOCK
+	sentpackets = true;
+	PACKSENT_UNLOCK
+	return 0;
+}
+
+int RTPSession::SendPackets(const RTPPayloadInfo *payloads,size_t numpayloads)
+{
+	if (!created)
+		return ERR_RTP_SESSION_NOTCREATED;
+	if (numpayloads == 0)
+		return 0;
+
+	BUILDER_LOCK
+	int status = InternalSendPackets(payloads,numpayloads);
+	BUILDER_UNLOCK
+
+	if (status < 0)
+		return status;
+
+	SOURCES_LOCK
+	for (size_t i = 0 ; i < numpayloads ; i++)
+		sources.SentRTPPacket();
+	SOURCES_UNLOCK
+	PACKSENT_LOCK
+	sentpackets = true;
+	PACKSENT_UNLOCK
+	return 0;
+}
+
+// Should be called with the builder lock held
+int RTPSession::InternalSendPackets(const RTPPayloadInfo *payloads,size_t numpayloads)
+{
+	// If possible, only the headers are stored in the frame buffer and the
+	// payloads are sent from where they are; otherwise the complete packets
+	// are stored there
+
+	bool gather = UseGatherSend();
+	size_t maxframelength = 0;
+	int status;
+
+	for (size_t i = 0 ; i < numpayloads ; i++)
+	{
+		maxframelength += sizeof(RTPHeader) + sizeof(uint32_t)*RTP_MAXCSRCS;
+		if (!gather)
+			maxframelength += payloads[i].length;
+	}
+	
+	if (maxframelength > framebufferlength)
+	{
+		uint8_t *newbuf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_RTPPACKETBUILDERBUFFER) uint8_t[maxframelength];
+		if (newbuf == 0)
+			return ERR_RTP_OUTOFMEM;
+		if (framebuffer)
+			RTPDeleteByteArray(framebuffer,GetMemoryManager());
+		framebuffer = newbuf;
+		framebufferlength = maxframelength;
+	}
+	framepackets.resize((gather)?numpayloads*2:numpayloads);
+	
+	// If one of the packets can't be built, the ones before it aren't sent
+	// either, so they mustn't use up sequence numbers or be counted
+	packetbuilder.SaveState();
+
+	size_t offset = 0;
+	for (size_t i = 0 ; i < numpayloads ; i++)
+	{
+		const RTPPayloadInfo &p = payloads[i];
+
+		if (gather)
+			status = packetbuilder.BuildPacketHeader(p.length,p.payloadtype,p.mark,p.timestampinc);
+		else
+			status = packetbuilder.BuildPacket(p.data,p.length,p.payloadtype,p.mark,p.timestampinc);
+		if (status < 0)
+		{
+			packetbuilder.RestoreState();
+			return status;
+		}
+
+		size_t packlen = packetbuilder.GetPacketLength();
+
+		memcpy(framebuffer+offset,packetbuilder.GetPacket(),packlen);
+		if (gather)
+		{
+			framepackets[i*2] = RTPDataSpan(framebuffer+offset,packlen);
+			framepackets[i*2+1] = RTPDataSpan(p.data,p.length);
+		}
+		else
+			framepackets[i] = RTPDataSpan(framebuffer+offset,packlen);
+		offset += packlen;
+	}
+	if (gather)
+		return rtptrans->SendRTPDataGatherBatch(&framepackets[0],2,numpayloads);
+	return SendRTPDataBatch(&framepackets[0],numpayloads);
+}
+
 #ifdef RTP_SUPPORT_SENDAPP
 
 int RTPSession::SendRTCPAPPPacket(uint8_t subtype, const uint8_t name[4], const void *appdata, size_t appdatalen)
@@ -1123,6 +1329,104 @@ void RTPSession::DeletePacket(RTPPacket *p)
 	RTPDelete(p,GetMemoryManager());
 }
 
+RTPPacket *RTPSession::GetNextDeliveredPacket()
+{
+	RTPPacket *p;
+
+	if (!created || !deliveryqueue.Pop(&p))
+		return 0;
+	return p;
+}
+
+bool RTPSession::GotoFirstSource(RTPSources::Iterator &it)
+{
+	if (!created)
+		return false;
+	return sources.GotoFirstSource(it);
+}
+
+bool RTPSession::GotoNextSource(RTPSources::Iterator &it)
+{
+	if (!created)
+		return false;
+	return sources.GotoNextSource(it);
+}
+
+bool RTPSession::GotoPreviousSource(RTPSources::Iterator &it)
+{
+	if (!created)
+		return false;
+	return sources.GotoPreviousSource(it);
+}
+
+RTPSourceData *RTPSession::GetSourceInfo(const RTPSources::Iterator &it)
+{
+	if (!created)
+		return 0;
+	return sources.GetSourceInfo(it);
+}
+
+RTPSourceSnapshot *RTPSession::GetSourceSnapshot()
+{
+	if (!created)
+		return 0;
+
+	RTPSourceSnapshot *snapshot;
+
+	// Snapshots are only kept up to date once they're used, so the first
+	// one is made here
+	if (snapshotsused.Get() == 0)
+	{
+		if (UpdateSourceSnapshot() < 0)
+			return 0;
+	}
+
+	SNAPSHOT_LOCK
+	snapshot = cursnapshot;
+	if (snapshot)
+		snapshot->refcount++;
+	SNAPSHOT_UNLOCK
+	return snapshot;
+}
+
+void RTPSession::ReleaseSourceSnapshot(RTPSourceSnapshot *snapshot)
+{
+	if (snapshot == 0)
+		return;
+
+	bool del;
+
+	SNAPSHOT_LOCK
+	snapshot->refcount--;
+	del = (snapshot->refcount == 0);
+	SNAPSHOT_UNLOCK
+
+	if (del)
+		RTPDelete(snapshot,GetMemoryManager());
+}
+
+int RTPSession::UpdateSourceSnapshot()
+{
+	if (!created)
+		return ERR_RTP_SESSION_NOTCREATED;
+
+	RTPSourceSnapshot *snapshot;
+	int status;
+
+	// Publishing while the sources are still locked makes sure that a
+	// snapshot can't be replaced by an older one
+	SOURCES_LOCK
+	if ((status = sources.CreateSnapshot(&snapshot,RTPTime::CurrentTime())) < 0)
+	{
+		SOURCES_UNLOCK
+		return status;
+	}
+	PublishSourceSnapshot(snapshot);
+	snapshotsused.Set(1);
+	SOURCES_UNLOCK
+	return 0;
+}
+
 int RTPSession::EndDataAccess()
 {
 	if (!created)
@@ -1375,8 +1679,12 @@ int RTPSession::ProcessPolledData()
 {
 	RTPRawPacket *rawpack;
 	int status;
+
+	// The sources lock is only held while the source table is used: incoming
+	// data is fetched from the transmitter (and possibly changed, e.g. decrypted)
+	// before taking it, and an RTCP packet is sent after releasing it. This way, 
+	// other threads don't have to wait for a system call to access the sources.
 	
-	SOURCES_LOCK
 	while ((rawpack = rtptrans->GetNextPacket()) != 0)
 	{
 		if (m_changeIncomingData)
@@ -1389,92 +1697,17 @@ int RTPSession::ProcessPolledData()
 			}
 		}
 
-		sources.ClearOwnCollisionFlag();
+		SOURCES_LOCK
+		status = ProcessRawPacket(rawpack);
+		SOURCES_UNLOCK
 
-		// since our sources instance also uses the scheduler (analysis of incoming packets)
-		// we'll lock it
-		SCHED_LOCK
-		if ((status = sources.ProcessRawPacket(rawpack,rtptrans,acceptownpackets)) < 0)
-		{
-			SCHED_UNLOCK
-			SOURCES_UNLOCK
-			RTPDelete(rawpack,GetMemoryManager());
-			return status;
-		}
-		SCHED_UNLOCK
-				
-		if (sources.DetectedOwnCollision()) // collision handling!
-		{
-			bool created;
-			
-			if ((status = collisionlist.UpdateAddress(rawpack->GetSenderAddress(),rawpack->GetReceiveTime(),&created)) < 0)
-			{
-				SOURCES_UNLOCK
-				RTPDelete(rawpack,GetMemoryManager());
-				return status;
-			}
-
-			if (created) // first time we've encountered this address, send bye packet and
-			{            // change our own SSRC
-				PACKSENT_LOCK
-				bool hassentpackets = sentpackets;
-				PACKSENT_UNLOCK
-
-				if (hassentpackets)
-				{
-					// Only send BYE packet if we've actually sent data using this
-					// SSRC
-					
-					RTCPCompoundPacket *rtcpcomppack;
-
-					BUILDER_LOCK
-					if ((status = rtcpbuilder.BuildBYEPacket(&rtcpcomppack,0,0,useSR_BYEifpossible)) < 0)
-					{
-						BUILDER_UNLOCK
-						SOURCES_UNLOCK
-						RTPDelete(rawpack,GetMemoryManager());
-						return status;
-					}
-					BUILDER_UNLOCK
-
-					byepackets.push_back(rtcpcomppack);
-					if (byepackets.size() == 1) // was the first packet, schedule a BYE packet (otherwise there's already one scheduled)
-					{
-						SCHED_LOCK
-						rtcpsched.ScheduleBYEPacket(rtcpcomppack->GetCompoundPacketLength());
-						SCHED_UNLOCK
-					}
-				}
-				// bye packet is built and scheduled, now change our SSRC
-				// and reset the packet count in the transmitter
-				
-				BUILDER_LOCK
-				uint32_t newssrc = packetbuilder.CreateNewSSRC(sources);
-				BUILDER_UNLOCK
-					
-				PACKSENT_LOCK
-				sentpackets = false;
-				PACKSENT_UNLOCK
-	
-				// remove old entry in source table and add new one
-
-				if ((status = sources.DeleteOwnSSRC()) < 0)
-				{
-					SOURCES_UNLOCK
-					RTPDelete(rawpack,GetMemoryManager());
-					return status;
-				}
-				if ((status = sources.CreateOwnSSRC(newssrc)) < 0)
-				{
-					SOURCES_UNLOCK
-					RTPDelete(rawpack,GetMemoryManager());
-					return status;
-				}
-			}
-		}
 		RTPDelete(rawpack,GetMemoryManager());
+		if (status < 0)
+			return status;
 	}
 
+	SOURCES_LOCK
+
 	SCHED_LOCK
 	RTPTime d = rtcpsched.CalculateDeterministicInterval(false);
 	SCHED_UNLOCK
@@ -1489,75 +1722,161 @@ int RTPSession::ProcessPolledData()
 	
 	sources.MultipleTimeouts(t,sendertimeout,byetimeout,generaltimeout,notetimeout);
 	collisionlist.Timeout(t,colltimeout);
+
+	// Only the statistics that changed since the previous snapshot are copied
+	if (snapshotsused.Get() != 0 && sources.HasSnapshotChanges())
+	{
+		RTPSourceSnapshot *snapshot;
+
+		if ((status = sources.CreateSnapshot(&snapshot,t)) < 0)
+		{
+			SOURCES_UNLOCK
+			return status;
+		}
+		PublishSourceSnapshot(snapshot);
+	}
 	
 	// We'll check if it's time for RTCP stuff
 
 	SCHED_LOCK
 	bool istime = rtcpsched.IsTime();
 	SCHED_UNLOCK
-	
-	if (istime)
+
+	if (!istime)
 	{
-		RTCPCompoundPacket *pack;
+		SOURCES_UNLOCK
+		return 0;
+	}
 	
-		// we'll check if there's a bye packet to send, or just a normal packet
+	// we'll check if there's a bye packet to send, or just a normal packet;
+	// only the latter needs the source table
+
+	RTCPCompoundPacket *pack;
+	bool isbye = !byepackets.empty();
 
-		if (byepackets.empty())
+	if (!isbye)
+	{
+		BUILDER_LOCK
+		if ((status = rtcpbuilder.BuildNextPacket(&pack)) < 0)
 		{
-			BUILDER_LOCK
-			if ((status = rtcpbuilder.BuildNextPacket(&pack)) < 0)
-			{
-				BUILDER_UNLOCK
-				SOURCES_UNLOCK
-				return status;
-			}
 			BUILDER_UNLOCK
-			if ((status = SendRTCPData(pack->GetCompoundPacketData(),pack->GetCompoundPacketLength())) < 0)
-			{
-				SOURCES_UNLOCK
-				RTPDelete(pack,GetMemoryManager());
-				return status;
-			}
+			SOURCES_UNLOCK
+			return status;
+		}
+		BUILDER_UNLOCK
+	}
+	SOURCES_UNLOCK
+
+	if (isbye)
+	{
+		pack = *(byepackets.begin());
+		byepackets.pop_front();
+	}
+	
+	if ((status = SendRTCPData(pack->GetCompoundPacketData(),pack->GetCompoundPacketLength())) < 0)
+	{
+		rtcpbuilder.DeletePacket(pack);
+		return status;
+	}
+
+	PACKSENT_LOCK
+	sentpackets = true;
+	PACKSENT_UNLOCK
+
+	OnSendRTCPCompoundPacket(pack); // we'll place this after the actual send to avoid tampering
+
+	if (isbye && !byepackets.empty()) // more bye packets to send, schedule them
+	{
+		SOURCES_LOCK
+		SCHED_LOCK
+		rtcpsched.ScheduleBYEPacket((*(byepackets.begin()))->GetCompoundPacketLength());
+		SCHED_UNLOCK
+		SOURCES_UNLOCK
+	}
+	
+	SCHED_LOCK
+	rtcpsched.AnalyseOutgoing(*pack);
+	SCHED_UNLOCK
+
+	rtcpbuilder.DeletePacket(pack);
+	return 0;
+}
+
+// Processes a single incoming packet, the sources lock must be held by the caller
+int RTPSession::ProcessRawPacket(RTPRawPacket *rawpack)
+{
+	int status;
+
+	sources.ClearOwnCollisionFlag();
+
+	// since our sources instance also uses the scheduler (analysis of incoming packets)
+	// we'll lock it
+	SCHED_LOCK
+	status = sources.ProcessRawPacket(rawpack,rtptrans,acceptownpackets);
+	SCHED_UNLOCK
+	if (status < 0)
+		return status;
+				
+	if (!sources.DetectedOwnCollision()) 
+		return 0;
+
+	// collision handling!
+
+	bool created;
+	
+	if ((status = collisionlist.UpdateAddress(rawpack->GetSenderAddress(),rawpack->GetReceiveTime(),&created)) < 0)
+		return status;
+
+	if (!created) 
+		return 0;
+
+	// first time we've encountered this address, send bye packet and
+	// change our own SSRC
+
+	PACKSENT_LOCK
+	bool hassentpackets = sentpackets;
+	PACKSENT_UNLOCK
+
+	if (hassentpackets)
+	{
+		// Only send BYE packet if we've actually sent data using this
+		// SSRC
 		
-			PACKSENT_LOCK
-			sentpackets = true;
-			PACKSENT_UNLOCK
+		RTCPCompoundPacket *rtcpcomppack;
 
-			OnSendRTCPCompoundPacket(pack); // we'll place this after the actual send to avoid tampering
-		}
-		else
+		BUILDER_LOCK
+		if ((status = rtcpbuilder.BuildBYEPacket(&rtcpcomppack,0,0,useSR_BYEifpossible)) < 0)
 		{
-			pack = *(byepackets.begin());
-			byepackets.pop_front();
-			
-			if ((status = SendRTCPData(pack->GetCompoundPacketData(),pack->GetCompoundPacketLength())) < 0)
-			{
-				SOURCES_UNLOCK
-				RTPDelete(pack,GetMemoryManager());
-				return status;
-			}
-			
-			PACKSENT_LOCK
-			sentpackets = true;
-			PACKSENT_UNLOCK
+			BUILDER_UNLOCK
+			return status;
+		}
+		BUILDER_UNLOCK
 
-			OnSendRTCPCompoundPacket(pack); // we'll place this after the actual send to avoid tampering
-			
-			if (!byepackets.empty()) // more bye packets to send, schedule them
-			{
-				SCHED_LOCK
-				rtcpsched.ScheduleBYEPacket((*(byepackets.begin()))->GetCompoundPacketLength());
-				SCHED_UNLOCK
-			}
+		byepackets.push_back(rtcpcomppack);
+		if (byepackets.size() == 1) // was the first packet, schedule a BYE packet (otherwise there's already one scheduled)
+		{
+			SCHED_LOCK
+			rtcpsched.ScheduleBYEPacket(rtcpcomppack->GetCompoundPacketLength());
+			SCHED_UNLOCK
 		}
+	}
+	// bye packet is built and scheduled, now change our SSRC
+	// and reset the packet count in the transmitter
+	
+	BUILDER_LOCK
+	uint32_t newssrc = packetbuilder.CreateNewSSRC(sources);
+	BUILDER_UNLOCK
 		
-		SCHED_LOCK
-		rtcpsched.AnalyseOutgoing(*pack);
-		SCHED_UNLOCK
+	PACKSENT_LOCK
+	sentpackets = false;
+	PACKSENT_UNLOCK
 
-		RTPDelete(pack,GetMemoryManager());
-	}
-	SOURCES_UNLOCK
+	// remove old entry in source table and add new one
+
+	if ((status = sources.DeleteOwnSSRC()) < 0)
+		return status;
+	if ((status = sources.CreateOwnSSRC(newssrc)) < 0)
+		return status;
 	return 0;
 }
 
@@ -1680,6 +1999,38 @@ int RTPSession::SendRTPData(const void *data, size_t len)
 	return status;
 }
 
+bool RTPSession::UseGatherSend()
+{
+	// When the outgoing data may be changed (e.g. encrypted), the callback
+	// needs the complete packet in a single buffer
+	return (!m_changeOutgoingData && rtptrans->SupportsGatherSend());
+}
+
+int RTPSession::SendRTPHeaderAndPayload(const void *data, size_t len)
+{
+	RTPDataSpan parts[2];
+
+	parts[0] = RTPDataSpan(packetbuilder.GetPacket(), packetbuilder.GetPacketLength());
+	parts[1] = RTPDataSpan(data, len);
+	return rtptrans->SendRTPDataGather(parts, 2);
+}
+
+int RTPSession::SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	if (!m_changeOutgoingData)
+		return rtptrans->SendRTPDataBatch(packets, numpackets);
+
+	// The outgoing data may be changed (e.g. encrypted) per packet, so
+	// we'll just send them one by one
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		int status = SendRTPData(packets[i].data, packets[i].length);
+		if (status < 0)
+			return status;
+	}
+	return 0;
+}
+
 int RTPSession::SendRTCPData(const void *data, size_t len)
 {
 	if (!m_changeOutgoingData)
@@ -1702,6 +2053,40 @@ int RTPSession::SendRTCPData(const void *data, size_t len)
 	return status;
 }
 
+void RTPSession::DeliverPacket(RTPPacket *rtppack)
+{
+	// This is called by the thread that processes the incoming data; if the
+	// application doesn't keep up, the newest packets are dropped
+	if (!deliveryqueue.Push(rtppack))
+	{
+		RTPDelete(rtppack,GetMemoryManager());
+		deliverydropcount.FetchAdd(1);
+	}
+}
+
+void RTPSession::ClearDeliveryQueue()
+{
+	RTPPacket *p;
+
+	while (deliveryqueue.Pop(&p))
+		RTPDelete(p,GetMemoryManager());
+	deliveryqueue.Destroy();
+}
+
+// Replaces the snapshot returned by GetSourceSnapshot, the old one is deleted
+// once every thread that is still using it has released it
+void RTPSession::PublishSourceSnapshot(RTPSourceSnapshot *snapshot)
+{
+	RTPSourceSnapshot *oldsnapshot;
+
+	SNAPSHOT_LOCK
+	oldsnapshot = cursnapshot;
+	cursnapshot = snapshot;
+	SNAPSHOT_UNLOCK
+
+	ReleaseSourceSnapshot(oldsnapshot);
+}
+
 #ifdef RTPDEBUG
 void RTPSession::DumpSources()
 {
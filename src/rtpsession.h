@@ -49,7 +49,9 @@
 #include "rtptimeutilities.h"
 #include "rtcpcompoundpacketbuilder.h"
 #include "rtpmemoryobject.h"
+#include "rtpspscqueue.h"
 #include <list>
+#include <vector>
 
 #ifdef RTP_SUPPORT_THREAD
 	#include <jthread/jmutex.h>	
@@ -64,11 +66,41 @@ class RTPTransmissionParams;
 class RTPAddress;
 class RTPSourceData;
 class RTPPacket;
+class RTPPacketView;
 class RTPPollThread;
 class RTPTransmissionInfo;
 class RTCPCompoundPacket;
 class RTCPPacket;
 class RTCPAPPPacket;
+class RTPSourceSnapshot;
+
+/** Describes the payload of one of the packets passed to RTPSession::SendPackets.
+ *  Describes the payload of one of the packets passed to RTPSession::SendPackets. Like for the 
+ *  RTPSession::SendPacket function, the packet will use payload type \c payloadtype and marker 
+ *  \c mark, and after building it the timestamp will be incremented by \c timestampinc.
+ */
+class JRTPLIB_IMPORTEXPORT RTPPayloadInfo
+{
+public:
+	RTPPayloadInfo() : data(0), length(0), payloadtype(0), mark(false), timestampinc(0)			{ }
+	RTPPayloadInfo(const void *d, size_t len, uint8_t pt, bool m, uint32_t tsinc)
+		: data(d), length(len), payloadtype(pt), mark(m), timestampinc(tsinc)				{ }
+
+	/** Points to the payload data. */
+	const void *data;
+
+	/** The length of the payload. */
+	size_t length;
+
+	/** The payload type of the packet. */
+	uint8_t payloadtype;
+
+	/** The marker bit of the packet. */
+	bool mark;
+
+	/** The timestamp increment after the packet has been built. */
+	uint32_t timestampinc;
+};
 
 /** High level class for using RTP.
  *  For most RTP based applications, the RTPSession class will probably be the one to use. It handles 
@@ -150,7 +182,11 @@ public:
 	/** Sends the RTP packet with payload \c data which has length \c len.
 	 *  Sends the RTP packet with payload \c data which has length \c len.
 	 *  The used payload type, marker and timestamp increment will be those that have been set 
-	 *  using the \c SetDefault member functions.
+	 *  using the \c SetDefault member functions. If the transmitter supports it (see
+	 *  RTPTransmitter::SupportsGatherSend), only the RTP header is built and the payload is sent 
+	 *  from \c data directly, without copying it first. This is also the case for the other 
+	 *  \c SendPacket and \c SendPacketEx functions, unless RTPSession::SetChangeOutgoingData was
+	 *  used to enable changing the outgoing data (as is done for SRTP).
 	 */
 	int SendPacket(const void *data,size_t len);
 
@@ -179,6 +215,30 @@ public:
 	int SendPacketEx(const void *data,size_t len,
 	                  uint8_t pt,bool mark,uint32_t timestampinc,
 	                  uint16_t hdrextID,const void *hdrextdata,size_t numhdrextwords);
+
+	/** Sends a frame which is split over the \c numpayloads payloads described by \c payloads.
+	 *  Sends a frame which is split over the \c numpayloads payloads described by \c payloads. An
+	 *  RTP packet is built for each payload, using payload type \c pt and the same timestamp for
+	 *  all of them. Only the last packet will have its marker bit set, and after it has been built,
+	 *  the timestamp will be incremented by \c timestampinc. The packets are sent like in
+	 *  RTPSession::SendPackets, so if one of them can't be built, none of them are sent and the
+	 *  sequence number and timestamp are not changed.
+	 */
+	int SendFrame(const RTPDataSpan *payloads,size_t numpayloads,
+	              uint8_t pt,uint32_t timestampinc);
+
+	/** Sends an RTP packet for each of the \c numpayloads payloads described by \c payloads.
+	 *  Sends an RTP packet for each of the \c numpayloads payloads described by \c payloads, each
+	 *  one with its own payload type, marker and timestamp increment. This has the same effect as 
+	 *  calling RTPSession::SendPacket for each payload, but the packets are built while locking the
+	 *  packet builder only once, and are all passed to the transmitter at once, using 
+	 *  RTPTransmitter::SendRTPDataGatherBatch (or RTPTransmitter::SendRTPDataBatch if the payloads
+	 *  need to be copied, see RTPSession::SendPacket). The UDP transmitters can then send them using
+	 *  a single system call for each destination, if \c sendmmsg is available. If building one of
+	 *  the packets fails, none of them are sent, and the sequence number, timestamp and packet
+	 *  and octet counts are left as they were before the call.
+	 */
+	int SendPackets(const RTPPayloadInfo *payloads,size_t numpayloads);
 #ifdef RTP_SUPPORT_SENDAPP
 	/** If sending of RTCP APP packets was enabled at compile time, this function creates a compound packet 
 	 *  containing an RTCP APP packet and sends it immediately. 
@@ -330,6 +390,47 @@ public:
 	 */
 	RTPSourceData *GetSourceInfo(uint32_t ssrc);
 
+	/** Lets the iterator \c it point to the first member in the table.
+	 *  Lets the iterator \c it point to the first member in the table. Unlike the current source,
+	 *  several iterators can be used at the same time, for example in nested loops or in a callback.
+	 *  If a member was found, the function returns \c true, otherwise it returns \c false. Like the
+	 *  other source functions, this should be called between BeginDataAccess and EndDataAccess.
+	 */
+	bool GotoFirstSource(RTPSources::Iterator &it);
+
+	/** Lets the iterator \c it point to the next member in the table, returns \c false if there are no more members. */
+	bool GotoNextSource(RTPSources::Iterator &it);
+
+	/** Lets the iterator \c it point to the previous member in the table, returns \c false if there are no more members. */
+	bool GotoPreviousSource(RTPSources::Iterator &it);
+
+	/** Returns the \c RTPSourceData instance for the participant the iterator \c it points to,
+	 *  or NULL if there is none.
+	 */
+	RTPSourceData *GetSourceInfo(const RTPSources::Iterator &it);
+
+	/** Returns the most recent copy of the statistics of all participants, or NULL on error.
+	 *  Returns the most recent copy of the statistics of all participants, or NULL on error. The first
+	 *  call makes a snapshot right away, which locks the source table once. From then on, a new snapshot
+	 *  is published each time the poll thread (or Poll, when no poll thread is used) has processed
+	 *  incoming data or timeouts, in which only the statistics of the participants that changed are
+	 *  copied. The result therefore includes everything up to the last processing step, and later calls
+	 *  don't need BeginDataAccess nor have to wait for the poll thread, which makes this suited for
+	 *  monitoring threads. The returned instance is never changed and must be released using
+	 *  ReleaseSourceSnapshot when it's no longer needed.
+	 */
+	RTPSourceSnapshot *GetSourceSnapshot();
+
+	/** Releases a snapshot that was obtained using GetSourceSnapshot. */
+	void ReleaseSourceSnapshot(RTPSourceSnapshot *snapshot);
+
+	/** Publishes a new snapshot of the statistics of all participants right away.
+	 *  Publishes a new snapshot of the statistics of all participants right away, e.g. to include
+	 *  packets that were sent since the last processing step; this locks the source table, so it must
+	 *  not be called between BeginDataAccess and EndDataAccess.
+	 */
+	int UpdateSourceSnapshot();
+
 	/** Extracts the next packet from the received packets queue of the current participant,
 	 *  or NULL if no more packets are available.
 	 *  Extracts the next packet from the received packets queue of the current participant,
@@ -344,6 +445,21 @@ public:
 	/** Frees the memory used by \c p. */
 	void DeletePacket(RTPPacket *p);
 
+	/** Extracts the next packet from the packet delivery queue, or NULL if no packets are available.
+	 *  Extracts the next packet from the packet delivery queue, or NULL if no packets are available.
+	 *  The queue is only used if a size was set using RTPSessionParams::SetPacketDeliveryQueueSize.
+	 *  In that case, validated packets of all sources end up in this queue in the order in which they
+	 *  arrived, instead of being stored (and sorted) in the source table; packets from a source that is
+	 *  still on probation are stored in the source table like before. This function does not use the
+	 *  lock of BeginDataAccess, so it never has to wait for the poll thread, but it may only be called
+	 *  from one thread at a time. When the packet is no longer needed, its memory should be freed using
+	 *  the DeletePacket member function.
+	 */
+	RTPPacket *GetNextDeliveredPacket();
+
+	/** Returns the number of packets that were discarded because the packet delivery queue was full. */
+	uint32_t GetNumberOfDroppedDeliveredPackets() const				{ return (uint32_t)deliverydropcount.Get(); }
+
 	/** See BeginDataAccess. */
 	int EndDataAccess();
 	
@@ -473,10 +589,25 @@ protected:
 	 */
 	virtual void OnRTPPacket(RTPPacket *pack,const RTPTime &receivetime, const RTPAddress *senderaddress);
 
+	/** Is called instead of RTPSession::OnRTPPacket if RTPSessionParams::SetUsePacketViews was enabled.
+	 *  Is called instead of RTPSession::OnRTPPacket if RTPSessionParams::SetUsePacketViews was enabled. 
+	 *  No RTPPacket instance needs to be created for this call; the view \c pack refers to the received 
+	 *  data and can only be used until the function returns.
+	 */
+	virtual void OnRTPPacketView(const RTPPacketView &pack,const RTPTime &receivetime, const RTPAddress *senderaddress);
+
 	/** Is called when an incoming RTCP packet is about to be processed. */
 	virtual void OnRTCPCompoundPacket(RTCPCompoundPacket *pack,const RTPTime &receivetime,
 	                                  const RTPAddress *senderaddress);
 
+	/** Is called instead of OnRTCPCompoundPacket when RTPSessionParams::SetParseRTCPInPlace was enabled.
+	 *  Is called instead of OnRTCPCompoundPacket when RTPSessionParams::SetParseRTCPInPlace was enabled. The
+	 *  \c datalen bytes in \c data contain the incoming compound packet, which can be inspected using an 
+	 *  RTCPCompoundPacketParser, and can only be used until the function returns.
+	 */
+	virtual void OnRTCPCompoundPacketData(const uint8_t *data,size_t datalen,const RTPTime &receivetime,
+	                                      const RTPAddress *senderaddress);
+
 	/** Is called when an SSRC collision was detected. 
 	 *  Is called when an SSRC collision was detected. The instance \c srcdat is the one present in 
 	 *  the table, the address \c senderaddress is the one that collided with one of the addresses 
@@ -535,7 +666,11 @@ protected:
 	/** Is called when a BYE packet has been processed for source \c srcdat. */
 	virtual void OnBYEPacket(RTPSourceData *srcdat);
 
-	/** Is called when an RTCP compound packet has just been sent (useful to inspect outgoing RTCP data). */
+	/** Is called when an RTCP compound packet has just been sent (useful to inspect outgoing RTCP data).
+	 *  Is called when an RTCP compound packet has just been sent (useful to inspect outgoing RTCP data).
+	 *  Unlike most other callbacks, this one is called without the source table being locked: if
+	 *  information about the sources is needed, use BeginDataAccess and EndDataAccess.
+	 */
 	virtual void OnSendRTCPCompoundPacket(RTCPCompoundPacket *pack);
 #ifdef RTP_SUPPORT_THREAD
 	/** Is called when error \c errcode was detected in the poll thread. */
@@ -603,14 +738,31 @@ protected:
 	 *  really suited to actually do something with the data.
 	 */
 	virtual void OnValidatedRTPPacket(RTPSourceData *srcdat, RTPPacket *rtppack, bool isonprobation, bool *ispackethandled);
+
+	/** Allows you to use an RTP packet from the specified source directly, without an RTPPacket instance.
+	 *  Allows you to use an RTP packet from the specified source directly, without an RTPPacket instance.
+	 *  This function is called before RTPSession::OnValidatedRTPPacket. If `ispackethandled` is set to 
+	 *  `true`, the packet is discarded when the function returns: no RTPPacket instance is created for it, 
+	 *  it's not stored and RTPSession::OnValidatedRTPPacket isn't called. The view \c pack can only be used
+	 *  until the function returns; if you need to keep the packet, leave `ispackethandled` set to `false`.
+	 */
+	virtual void OnValidatedRTPPacketView(RTPSourceData *srcdat, const RTPPacketView &pack, bool isonprobation, bool *ispackethandled);
 private:
 	int InternalCreate(const RTPSessionParams &sessparams);
 	int CreateCNAME(uint8_t *buffer,size_t *bufferlength,bool resolve);
 	int ProcessPolledData();
+	int ProcessRawPacket(RTPRawPacket *rawpack);
 	int ProcessRTCPCompoundPacket(RTCPCompoundPacket &rtcpcomppack,RTPRawPacket *pack);
 	RTPRandom *GetRandomNumberGenerator(RTPRandom *r);
 	int SendRTPData(const void *data, size_t len);
 	int SendRTCPData(const void *data, size_t len);
+	int SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets);
+	bool UseGatherSend();
+	int InternalSendPackets(const RTPPayloadInfo *payloads,size_t numpayloads);
+	int SendRTPHeaderAndPayload(const void *data, size_t len);
+	void DeliverPacket(RTPPacket *rtppack);
+	void ClearDeliveryQueue();
+	void PublishSourceSnapshot(RTPSourceSnapshot *snapshot);
 
 	RTPRandom *rtprnd;
 	bool deletertprnd;
@@ -640,10 +792,21 @@ private:
 	RTPCollisionList collisionlist;
 
 	std::list<RTCPCompoundPacket *> byepackets;
+
+	uint8_t *framebuffer;
+	size_t framebufferlength;
+	std::vector<RTPDataSpan> framepackets;
+	std::vector<RTPPayloadInfo> framepayloads;
+
+	RTPSPSCQueue<RTPPacket *> deliveryqueue;
+	RTPAtomicInteger deliverydropcount;
+
+	RTPSourceSnapshot *cursnapshot;
+	RTPAtomicInteger snapshotsused;
 	
 #ifdef RTP_SUPPORT_THREAD
 	RTPPollThread *pollthread;
-	jthread::JMutex sourcesmutex,buildermutex,schedmutex,packsentmutex;
+	jthread::JMutex sourcesmutex,buildermutex,schedmutex,packsentmutex,snapshotmutex;
 
 	friend class RTPPollThread;
 #endif // RTP_SUPPORT_THREAD
@@ -653,7 +816,9 @@ private:
 
 inline RTPTransmitter *RTPSession::NewUserDefinedTransmitter()                                          { return 0; }
 inline void RTPSession::OnRTPPacket(RTPPacket *, const RTPTime &, const RTPAddress *)                   { }
+inline void RTPSession::OnRTPPacketView(const RTPPacketView &, const RTPTime &, const RTPAddress *)     { }
 inline void RTPSession::OnRTCPCompoundPacket(RTCPCompoundPacket *, const RTPTime &, const RTPAddress *) { }
+inline void RTPSession::OnRTCPCompoundPacketData(const uint8_t *, size_t, const RTPTime &, const RTPAddress *) { }
 inline void RTPSession::OnSSRCCollision(RTPSourceData *, const RTPAddress *, bool )                     { }
 inline void RTPSession::OnCNAMECollision(RTPSourceData *, const RTPAddress *, const uint8_t *, size_t ) { }
 inline void RTPSession::OnNewSource(RTPSourceData *)                                                    { }
@@ -688,6 +853,7 @@ inline int RTPSession::OnChangeRTPOrRTCPData(const void *, size_t, bool, void **
 inline void RTPSession::OnSentRTPOrRTCPData(void *, size_t, bool)                                       { }
 inline bool RTPSession::OnChangeIncomingData(RTPRawPacket *)                                            { return true; }
 inline void RTPSession::OnValidatedRTPPacket(RTPSourceData *, RTPPacket *, bool, bool *)                { }
+inline void RTPSession::OnValidatedRTPPacketView(RTPSourceData *, const RTPPacketView &, bool, bool *)  { }
 
 } // end namespace
 
@@ -50,6 +50,10 @@ RTPSessionParams::RTPSessionParams() : mininterval(0,0)
 	m_needThreadSafety = false;
 #endif // RTP_SUPPORT_THREAD
 	maxpacksize = RTP_DEFAULTPACKETSIZE;
+	deliveryqueuesize = 0;
+	usepacketviews = false;
+	buildrtcpinplace = false;
+	parsertcpinplace = false;
 	receivemode = RTPTransmitter::AcceptAll;
 	acceptown = false;
 	owntsunit = -1; // The user will have to set it to the correct value himself
@@ -218,10 +218,59 @@ public:
 
 	/** Returns `true` if thread safety was requested using RTPSessionParams::SetNeedThreadSafety. */
 	bool NeedThreadSafety() const								{ return m_needThreadSafety; }
+
+	/** Sets the size of the packet delivery queue, a size of zero disables it.
+	 *  Sets the size of the packet delivery queue, a size of zero disables it. When enabled,
+	 *  validated RTP packets are not stored in the source table but placed in a bounded lock-free
+	 *  queue, from which they can be retrieved using RTPSession::GetNextDeliveredPacket without
+	 *  taking the lock that protects the source table. The size is rounded up to a power of two.
+	 */
+	void SetPacketDeliveryQueueSize(size_t s)					{ deliveryqueuesize = s; }
+
+	/** Returns the size of the packet delivery queue (default is 0, which means that packets are stored
+	 *  in the source table). */
+	size_t GetPacketDeliveryQueueSize() const					{ return deliveryqueuesize; }
+
+	/** If \c v is \c true, RTPSession::OnRTPPacketView will be called for incoming RTP packets instead of RTPSession::OnRTPPacket.
+	 *  If \c v is \c true, RTPSession::OnRTPPacketView will be called for incoming RTP packets instead of 
+	 *  RTPSession::OnRTPPacket. Since the latter needs an RTPPacket instance, this avoids that such an instance
+	 *  is allocated for packets that are not stored, for example because they are handled in 
+	 *  RTPSession::OnValidatedRTPPacketView. See RTPSources::SetUsePacketViews.
+	 */
+	void SetUsePacketViews(bool v)								{ usepacketviews = v; }
+
+	/** Returns \c true if incoming RTP packets are only passed as an RTPPacketView to RTPSession::OnRTPPacketView (default is \c false). */
+	bool GetUsePacketViews() const								{ return usepacketviews; }
+
+	/** If \c v is \c true, the periodic RTCP compound packets are built in place in reused buffers.
+	 *  If \c v is \c true, the periodic RTCP compound packets are built in place in buffers which are 
+	 *  reused for every packet, so that no memory needs to be allocated for them. The packet passed to
+	 *  RTPSession::OnSendRTCPCompoundPacket then only contains the raw compound packet data, not the list
+	 *  of individual RTCP packets. See RTCPPacketBuilder::SetBuildInPlace.
+	 */
+	void SetBuildRTCPInPlace(bool v)							{ buildrtcpinplace = v; }
+
+	/** Returns \c true if the periodic RTCP compound packets are built in place (default is \c false). */
+	bool GetBuildRTCPInPlace() const							{ return buildrtcpinplace; }
+
+	/** If \c v is \c true, incoming RTCP compound packets are processed without creating RTCPPacket instances.
+	 *  If \c v is \c true, incoming RTCP compound packets are processed directly in the received data,
+	 *  so that no RTCPCompoundPacket and RTCPPacket instances need to be allocated for them. 
+	 *  RTPSession::OnRTCPCompoundPacketData is then called instead of RTPSession::OnRTCPCompoundPacket.
+	 *  See RTPSources::SetParseRTCPInPlace.
+	 */
+	void SetParseRTCPInPlace(bool v)							{ parsertcpinplace = v; }
+
+	/** Returns \c true if incoming RTCP compound packets are processed in place (default is \c false). */
+	bool GetParseRTCPInPlace() const							{ return parsertcpinplace; }
 private:
 	bool acceptown;
 	bool usepollthread;
 	size_t maxpacksize;
+	size_t deliveryqueuesize;
+	bool usepacketviews;
+	bool buildrtcpinplace;
+	bool parsertcpinplace;
 	double owntsunit;
 	RTPTransmitter::ReceiveMode receivemode;
 	bool resolvehostname;
@@ -33,6 +33,7 @@
 #include "rtpsessionsources.h"
 #include "rtpsession.h"
 #include "rtpsourcedata.h"
+#include "rtcpcompoundpacketparser.h"
 
 #include "rtpdebug.h"
 
@@ -44,6 +45,11 @@ void RTPSessionSources::OnRTPPacket(RTPPacket *pack,const RTPTime &receivetime,c
 	rtpsession.OnRTPPacket(pack,receivetime,senderaddress);
 }
 
+void RTPSessionSources::OnRTPPacketView(const RTPPacketView &pack,const RTPTime &receivetime,const RTPAddress *senderaddress)
+{
+	rtpsession.OnRTPPacketView(pack,receivetime,senderaddress);
+}
+
 void RTPSessionSources::OnRTCPCompoundPacket(RTCPCompoundPacket *pack,const RTPTime &receivetime,const RTPAddress *senderaddress)
 {
 	if (senderaddress != 0) // don't analyse own RTCP packets again (they're already analysed on their way out)
@@ -51,6 +57,13 @@ void RTPSessionSources::OnRTCPCompoundPacket(RTCPCompoundPacket *pack,const RTPT
 	rtpsession.OnRTCPCompoundPacket(pack,receivetime,senderaddress);
 }
 
+void RTPSessionSources::OnRTCPCompoundPacketData(const uint8_t *data,size_t datalen,const RTPTime &receivetime,const RTPAddress *senderaddress)
+{
+	if (senderaddress != 0) // don't analyse own RTCP packets again (they're already analysed on their way out)
+		rtpsession.rtcpsched.AnalyseIncoming(datalen,RTCPCompoundPacketParser::ContainsBYE(data,datalen));
+	rtpsession.OnRTCPCompoundPacketData(data,datalen,receivetime,senderaddress);
+}
+
 void RTPSessionSources::OnSSRCCollision(RTPSourceData *srcdat,const RTPAddress *senderaddress,bool isrtp)
 {
 	if (srcdat->IsOwnSSRC())
@@ -113,6 +126,16 @@ void RTPSessionSources::OnNoteTimeout(RTPSourceData *srcdat)
 void RTPSessionSources::OnValidatedRTPPacket(RTPSourceData *srcdat, RTPPacket *rtppack, bool isonprobation, bool *ispackethandled)
 {
 	rtpsession.OnValidatedRTPPacket(srcdat, rtppack, isonprobation, ispackethandled);
+	if (!(*ispackethandled) && !isonprobation && rtpsession.deliveryqueue.IsInitialized())
+	{
+		rtpsession.DeliverPacket(rtppack);
+		*ispackethandled = true;
+	}
+}
+
+void RTPSessionSources::OnValidatedRTPPacketView(RTPSourceData *srcdat, const RTPPacketView &pack, bool isonprobation, bool *ispackethandled)
+{
+	rtpsession.OnValidatedRTPPacketView(srcdat, pack, isonprobation, ispackethandled);
 }
 
 void RTPSessionSources::OnRTCPSenderReport(RTPSourceData *srcdat)
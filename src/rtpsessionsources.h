@@ -57,8 +57,12 @@ public:
 private:
 	void OnRTPPacket(RTPPacket *pack,const RTPTime &receivetime,
 	                 const RTPAddress *senderaddress);
+	void OnRTPPacketView(const RTPPacketView &pack,const RTPTime &receivetime,
+	                     const RTPAddress *senderaddress);
 	void OnRTCPCompoundPacket(RTCPCompoundPacket *pack,const RTPTime &receivetime,
 	                          const RTPAddress *senderaddress);
+	void OnRTCPCompoundPacketData(const uint8_t *data,size_t datalen,const RTPTime &receivetime,
+	                              const RTPAddress *senderaddress);
 	void OnSSRCCollision(RTPSourceData *srcdat,const RTPAddress *senderaddress,bool isrtp);
 	void OnCNAMECollision(RTPSourceData *srcdat,const RTPAddress *senderaddress,
 	                              const uint8_t *cname,size_t cnamelength);
@@ -75,6 +79,7 @@ private:
 	                           const RTPAddress *senderaddress);
 	void OnNoteTimeout(RTPSourceData *srcdat);
 	void OnValidatedRTPPacket(RTPSourceData *srcdat, RTPPacket *rtppack, bool isonprobation, bool *ispackethandled);
+	void OnValidatedRTPPacketView(RTPSourceData *srcdat, const RTPPacketView &pack, bool isonprobation, bool *ispackethandled);
 	void OnRTCPSenderReport(RTPSourceData *srcdat);
 	void OnRTCPReceiverReport(RTPSourceData *srcdat);
 	void OnRTCPSDESItem(RTPSourceData *srcdat, RTCPSDESPacket::ItemType t,
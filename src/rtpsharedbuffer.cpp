@@ -0,0 +1,121 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtpsharedbuffer.h"
+#include "rtpmemorymanager.h"
+
+#include "rtpdebug.h"
+
+#ifdef RTP_SUPPORT_THREAD
+	#define AVAILABLE_LOCK		availablemutex.Lock();
+	#define AVAILABLE_UNLOCK	availablemutex.Unlock();
+#else
+	#define AVAILABLE_LOCK
+	#define AVAILABLE_UNLOCK
+#endif // RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+RTPSharedBufferPool::RTPSharedBufferPool(size_t size, RTPMemoryManager *mgr) : RTPMemoryObject(mgr), buffersize(size), numbuffers(0), returned(0)
+{
+	available = 0;
+#ifdef RTP_SUPPORT_THREAD
+	availablemutex.Init();
+#endif // RTP_SUPPORT_THREAD
+}
+
+RTPSharedBufferPool::~RTPSharedBufferPool()
+{
+	DeleteBuffers(available);
+	DeleteBuffers(returned.Exchange(0));
+}
+
+RTPSharedBuffer *RTPSharedBufferPool::GetBuffer()
+{
+	RTPSharedBuffer *buf;
+
+	AVAILABLE_LOCK
+	if (available == 0)
+		available = returned.Exchange(0);
+	buf = available;
+	if (buf != 0)
+		available = buf->nextfree;
+	AVAILABLE_UNLOCK
+
+	if (buf == 0)
+	{
+		uint8_t *data = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_SHAREDBUFFERDATA) uint8_t[(buffersize == 0)?1:buffersize];
+		if (data == 0)
+			return 0;
+		buf = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_SHAREDBUFFER) RTPSharedBuffer(this,data,buffersize);
+		if (buf == 0)
+		{
+			RTPDeleteByteArray(data,GetMemoryManager());
+			return 0;
+		}
+		numbuffers.FetchAdd(1);
+	}
+
+	buf->nextfree = 0;
+	buf->refcount.Set(1);
+	return buf;
+}
+
+void RTPSharedBufferPool::ReturnBuffer(RTPSharedBuffer *buf)
+{
+	// Only the thread releasing the last reference gets here, and the buffer
+	// is only taken from the list as a whole, so a simple push suffices
+	RTPSharedBuffer *head;
+
+	do
+	{
+		head = returned.Get();
+		buf->nextfree = head;
+	} while (!returned.CompareExchange(head,buf));
+}
+
+void RTPSharedBufferPool::DeleteBuffers(RTPSharedBuffer *list)
+{
+	while (list != 0)
+	{
+		RTPSharedBuffer *next = list->nextfree;
+
+		RTPDeleteByteArray(list->data,GetMemoryManager());
+		RTPDelete(list,GetMemoryManager());
+		numbuffers.FetchAdd(-1);
+		list = next;
+	}
+}
+
+} // end namespace
+
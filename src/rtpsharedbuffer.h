@@ -0,0 +1,149 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpsharedbuffer.h
+ */
+
+#ifndef RTPSHAREDBUFFER_H
+
+#define RTPSHAREDBUFFER_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtpatomic.h"
+#include "rtpmemoryobject.h"
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jmutex.h>
+#endif // RTP_SUPPORT_THREAD
+
+namespace jrtplib
+{
+
+class RTPSharedBufferPool;
+
+/** A reference counted buffer for packet data.
+ *  A reference counted buffer for packet data. Several RTPPacket instances, possibly used in
+ *  different threads, can refer to the same buffer; the reference count is modified atomically
+ *  and when the last reference is released, the buffer is returned to the RTPSharedBufferPool
+ *  it was obtained from. Such a buffer can be stored in an RTPRawPacket by installing 
+ *  RTPSharedBuffer::ReleaseData as its free callback, with the buffer as the parameter.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSharedBuffer
+{
+	JRTPLIB_NO_COPY(RTPSharedBuffer)
+public:
+	/** Returns a pointer to the data. */
+	uint8_t *GetData() const										{ return data; }
+
+	/** Returns the number of bytes that can be stored in the buffer. */
+	size_t GetCapacity() const										{ return capacity; }
+
+	/** Returns the number of references to this buffer. */
+	int32_t GetReferenceCount() const								{ return refcount.Get(); }
+
+	/** Adds a reference to this buffer. */
+	void AddReference()												{ refcount.FetchAdd(1); }
+
+	/** Releases a reference; the buffer is returned to its pool when this was the last one. */
+	void Release();
+
+	/** Can be installed as the free callback of an RTPRawPacket, with the buffer as parameter, to release a reference. */
+	static void ReleaseData(uint8_t *data, void *param);
+private:
+	friend class RTPSharedBufferPool;
+
+	RTPSharedBuffer(RTPSharedBufferPool *p, uint8_t *d, size_t c) : pool(p), data(d), capacity(c), refcount(0), nextfree(0) { }
+
+	RTPSharedBufferPool *pool;
+	uint8_t *data;
+	size_t capacity;
+	RTPAtomicInteger refcount;
+	RTPSharedBuffer *nextfree;
+};
+
+/** A pool of RTPSharedBuffer instances of the same size.
+ *  A pool of RTPSharedBuffer instances of the same size. New buffers are only allocated 
+ *  when no released buffer is available. Releasing a buffer can be done from any thread and
+ *  doesn't take a lock: the buffer is added to a list of returned buffers using an atomic
+ *  compare-and-swap. The pool must not be destroyed before all of its buffers have been released.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSharedBufferPool : public RTPMemoryObject
+{
+	JRTPLIB_NO_COPY(RTPSharedBufferPool)
+public:
+	/** Creates a pool for buffers which can store \c buffersize bytes, optionally installing a memory manager. */
+	RTPSharedBufferPool(size_t buffersize, RTPMemoryManager *mgr = 0);
+	~RTPSharedBufferPool();
+
+	/** Returns the number of bytes that can be stored in each buffer of this pool. */
+	size_t GetBufferSize() const									{ return buffersize; }
+
+	/** Returns a buffer with a reference count of one, or null if no memory could be allocated. */
+	RTPSharedBuffer *GetBuffer();
+
+	/** Returns the number of buffers that were allocated by this pool. */
+	int32_t GetNumberOfBuffers() const								{ return numbuffers.Get(); }
+private:
+	friend class RTPSharedBuffer;
+
+	void ReturnBuffer(RTPSharedBuffer *buf);
+	void DeleteBuffers(RTPSharedBuffer *list);
+
+	size_t buffersize;
+	RTPAtomicInteger numbuffers;
+
+	// Released buffers are pushed onto this list by any thread; GetBuffer takes
+	// the entire list at once and then uses it without needing atomic operations
+	RTPAtomicPointer<RTPSharedBuffer> returned;
+	RTPSharedBuffer *available;
+#ifdef RTP_SUPPORT_THREAD
+	jthread::JMutex availablemutex;
+#endif // RTP_SUPPORT_THREAD
+};
+
+inline void RTPSharedBuffer::Release()
+{
+	if (refcount.FetchAdd(-1) == 1)
+		pool->ReturnBuffer(this);
+}
+
+inline void RTPSharedBuffer::ReleaseData(uint8_t *, void *param)
+{
+	((RTPSharedBuffer *)param)->Release();
+}
+
+} // end namespace
+
+#endif // RTPSHAREDBUFFER_H
+
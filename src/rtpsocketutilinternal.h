@@ -45,6 +45,7 @@
 	#define RTPIOCTL								ioctlsocket
 #else // not Win32
 	#include <sys/socket.h>
+	#include <sys/uio.h>
 	#include <netinet/in.h>
 	#include <arpa/inet.h>
 	#include <sys/ioctl.h>
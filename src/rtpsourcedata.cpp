@@ -77,6 +77,22 @@ namespace jrtplib
 
 void RTPSourceStats::ProcessPacket(RTPPacket *pack,const RTPTime &receivetime,double tsunit,
                                    bool ownpacket,bool *accept,bool applyprobation,bool *onprobation)
+{
+	RTPPacketView view;
+
+	*onprobation = false;
+	if (view.Parse(pack->GetPacketData(),pack->GetPacketLength(),pack->GetReceiveTime()) < 0)
+	{
+		*accept = false;
+		return;
+	}
+	view.SetExtendedSequenceNumber(pack->GetExtendedSequenceNumber());
+	ProcessPacket(&view,receivetime,tsunit,ownpacket,accept,applyprobation,onprobation);
+	pack->SetExtendedSequenceNumber(view.GetExtendedSequenceNumber());
+}
+
+void RTPSourceStats::ProcessPacket(RTPPacketView *pack,const RTPTime &receivetime,double tsunit,
+                                   bool ownpacket,bool *accept,bool applyprobation,bool *onprobation)
 {
 	JRTPLIB_UNUSED(applyprobation); // possibly unused
 
@@ -260,7 +276,7 @@ jitter = (uint32_t)djitter;
 	}
 }
 
-RTPSourceData::RTPSourceData(uint32_t s, RTPMemoryManager *mgr) : RTPMemoryObject(mgr),SDESinf(mgr),byetime(0,0)
+RTPSourceData::RTPSourceData(uint32_t s, RTPMemoryManager *mgr) : RTPMemoryObject(mgr),packetqueue(mgr),SDESinf(mgr),byetime(0,0)
 {
 	ssrc = s;
 	issender = false;
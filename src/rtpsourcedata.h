@@ -41,11 +41,12 @@
 #include "rtpconfig.h"
 #include "rtptimeutilities.h"
 #include "rtppacket.h"
+#include "rtppacketview.h"
 #include "rtcpsdesinfo.h"
 #include "rtptypes.h"
 #include "rtpsources.h"
 #include "rtpmemoryobject.h"
-#include <list>
+#include "rtpsourcepacketqueue.h"
 
 namespace jrtplib
 {
@@ -105,6 +106,7 @@ class JRTPLIB_IMPORTEXPORT RTPSourceStats
 public:
 	RTPSourceStats();
 	void ProcessPacket(RTPPacket *pack,const RTPTime &receivetime,double tsunit,bool ownpacket,bool *accept,bool applyprobation,bool *onprobation);
+	void ProcessPacket(RTPPacketView *pack,const RTPTime &receivetime,double tsunit,bool ownpacket,bool *accept,bool applyprobation,bool *onprobation);
 
 	bool HasSentData() const						{ return sentdata; }
 	uint32_t GetNumPacketsReceived() const					{ return packetsreceived; }
@@ -177,7 +179,7 @@ public:
 	void FlushPackets();
 
 	/** Returns \c true if there are RTP packets which can be extracted. */
-	bool HasData() const							{ if (!validated) return false; return packetlist.empty()?false:true; }
+	bool HasData() const							{ if (!validated) return false; return packetqueue.IsEmpty()?false:true; }
 
 	/** Returns the SSRC identifier for this member. */
 	uint32_t GetSSRC() const						{ return ssrc; }
@@ -427,7 +429,7 @@ public:
 	virtual void Dump();
 #endif // RTPDEBUG
 protected:
-	std::list<RTPPacket *> packetlist;
+	RTPSourcePacketQueue packetqueue;
 
 	uint32_t ssrc;
 	bool ownssrc;
@@ -456,22 +458,12 @@ inline RTPPacket *RTPSourceData::GetNextPacket()
 	if (!validated)
 		return 0;
 
-	RTPPacket *p;
-
-	if (packetlist.empty())
-		return 0;
-	p = *(packetlist.begin());
-	packetlist.pop_front();
-	return p;
+	return packetqueue.GetNextPacket();
 }
 
 inline void RTPSourceData::FlushPackets()
 {
-	std::list<RTPPacket *>::const_iterator it;
-
-	for (it = packetlist.begin() ; it != packetlist.end() ; ++it)
-		RTPDelete(*it,GetMemoryManager());
-	packetlist.clear();
+	packetqueue.Clear();
 }
 
 } // end namespace
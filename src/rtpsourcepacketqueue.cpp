@@ -0,0 +1,190 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtpsourcepacketqueue.h"
+#include "rtppacket.h"
+#include "rtperrors.h"
+#include "rtpmemorymanager.h"
+
+#include "rtpdebug.h"
+
+namespace jrtplib
+{
+
+RTPSourcePacketQueue::RTPSourcePacketQueue(RTPMemoryManager *mgr) : RTPMemoryObject(mgr)
+{
+	ring = 0;
+	ringsize = 0;
+	numpackets = 0;
+	firstseqnr = 0;
+	endseqnr = 0;
+}
+
+RTPSourcePacketQueue::~RTPSourcePacketQueue()
+{
+	Clear();
+	ReleaseRing();
+}
+
+int RTPSourcePacketQueue::StorePacket(RTPPacket *pack,bool *stored)
+{
+	uint32_t seqnr = pack->GetExtendedSequenceNumber();
+	int status;
+
+	*stored = false;
+
+	if (numpackets == 0)
+	{
+		if (ring == 0)
+		{
+			if ((status = Resize(RTPSOURCEPACKETQUEUE_INITIALSIZE)) < 0)
+				return status;
+		}
+
+		firstseqnr = seqnr;
+		endseqnr = seqnr+1;
+		ring[seqnr&(uint32_t)(ringsize-1)] = pack;
+		numpackets = 1;
+		*stored = true;
+		return 0;
+	}
+
+	uint32_t newfirstseqnr = firstseqnr;
+	uint32_t newendseqnr = endseqnr;
+
+	if ((int32_t)(seqnr-firstseqnr) < 0) // comes before the first packet in the queue
+		newfirstseqnr = seqnr;
+	else if ((int32_t)(seqnr-endseqnr) >= 0) // comes after the last packet in the queue
+		newendseqnr = seqnr+1;
+	else // it's in the range that's covered by the ring
+	{
+		RTPPacket **p = ring+(seqnr&(uint32_t)(ringsize-1));
+
+		if (*p != 0) // a packet with the same sequence number is already stored
+			return 0;
+
+		*p = pack;
+		numpackets++;
+		*stored = true;
+		return 0;
+	}
+
+	size_t span = (size_t)(newendseqnr-newfirstseqnr);
+
+	if (span > RTPSOURCEPACKETQUEUE_MAXSIZE)
+	{
+		if (newfirstseqnr == seqnr) // the new packet is the oldest one, don't store it
+			return 0;
+
+		// Make room by discarding the oldest packets
+
+		while (numpackets > 0 && (size_t)(newendseqnr-firstseqnr) > RTPSOURCEPACKETQUEUE_MAXSIZE)
+			RTPDelete(GetNextPacket(),GetMemoryManager());
+
+		if (numpackets == 0)
+			return StorePacket(pack,stored);
+
+		newfirstseqnr = firstseqnr;
+		span = (size_t)(newendseqnr-newfirstseqnr);
+	}
+
+	if (span > ringsize)
+	{
+		size_t newsize = ringsize;
+
+		while (newsize < span)
+			newsize <<= 1;
+		if ((status = Resize(newsize)) < 0)
+			return status;
+	}
+
+	firstseqnr = newfirstseqnr;
+	endseqnr = newendseqnr;
+	ring[seqnr&(uint32_t)(ringsize-1)] = pack;
+	numpackets++;
+	*stored = true;
+	return 0;
+}
+
+void RTPSourcePacketQueue::Clear()
+{
+	if (numpackets == 0)
+		return;
+
+	uint32_t mask = (uint32_t)(ringsize-1);
+
+	for (uint32_t s = firstseqnr ; s != endseqnr ; s++)
+	{
+		if (ring[s&mask] != 0)
+		{
+			RTPDelete(ring[s&mask],GetMemoryManager());
+			ring[s&mask] = 0;
+		}
+	}
+	numpackets = 0;
+}
+
+int RTPSourcePacketQueue::Resize(size_t newsize)
+{
+	RTPPacket **newring = (RTPPacket **)RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_SOURCEPACKETQUEUE) uint8_t[sizeof(RTPPacket *)*newsize];
+	if (newring == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	for (size_t i = 0 ; i < newsize ; i++)
+		newring[i] = 0;
+
+	if (numpackets > 0)
+	{
+		uint32_t oldmask = (uint32_t)(ringsize-1);
+		uint32_t newmask = (uint32_t)(newsize-1);
+
+		for (uint32_t s = firstseqnr ; s != endseqnr ; s++)
+			newring[s&newmask] = ring[s&oldmask];
+	}
+
+	if (ring)
+		RTPDeleteByteArray((uint8_t *)ring,GetMemoryManager());
+	ring = newring;
+	ringsize = newsize;
+	return 0;
+}
+
+void RTPSourcePacketQueue::ReleaseRing()
+{
+	if (ring)
+		RTPDeleteByteArray((uint8_t *)ring,GetMemoryManager());
+	ring = 0;
+	ringsize = 0;
+}
+
+} // end namespace
+
@@ -0,0 +1,128 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpsourcepacketqueue.h
+ */
+
+#ifndef RTPSOURCEPACKETQUEUE_H
+
+#define RTPSOURCEPACKETQUEUE_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtpmemoryobject.h"
+
+#define RTPSOURCEPACKETQUEUE_INITIALSIZE					16
+#define RTPSOURCEPACKETQUEUE_KEEPSIZE						256
+#define RTPSOURCEPACKETQUEUE_MAXSIZE						65536
+
+namespace jrtplib
+{
+
+class RTPPacket;
+
+/** Queue of RTP packets of a participant, ordered by their extended sequence number.
+ *  Queue of RTP packets of a participant, ordered by their extended sequence number. The
+ *  packets are stored in a power of two sized ring which is indexed by the extended sequence
+ *  number, so storing a packet which arrives in order or out of order, detecting a duplicate 
+ *  packet and taking the first packet from the queue don't require a search or an allocation.
+ *  The ring grows when the range of sequence numbers in the queue no longer fits. If that range
+ *  would exceed RTPSOURCEPACKETQUEUE_MAXSIZE, the packets with the lowest sequence numbers
+ *  are discarded.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSourcePacketQueue : public RTPMemoryObject
+{
+	JRTPLIB_NO_COPY(RTPSourcePacketQueue)
+public:
+	/** Creates an empty queue, optionally installing a memory manager. */
+	RTPSourcePacketQueue(RTPMemoryManager *mgr = 0);
+	~RTPSourcePacketQueue();
+
+	/** Returns \c true if there are no packets in the queue. */
+	bool IsEmpty() const								{ return (numpackets == 0)?true:false; }
+
+	/** Returns the number of packets in the queue. */
+	size_t GetNumberOfPackets() const						{ return numpackets; }
+
+	/** Stores \c pack at the position indicated by its extended sequence number.
+	 *  Stores \c pack at the position indicated by its extended sequence number. If a packet
+	 *  with the same extended sequence number is already present, the packet is not stored
+	 *  and \c stored is set to \c false, in which case the caller is still responsible for
+	 *  deleting it.
+	 */
+	int StorePacket(RTPPacket *pack,bool *stored);
+
+	/** Removes the packet with the lowest extended sequence number from the queue and 
+	 *  returns it, or returns null if the queue is empty. */
+	RTPPacket *GetNextPacket();
+
+	/** Deletes all packets in the queue. */
+	void Clear();
+private:
+	int Resize(size_t newsize);
+	void ReleaseRing();
+
+	RTPPacket **ring;
+	size_t ringsize;
+	size_t numpackets;
+	uint32_t firstseqnr; // extended sequence number of the first packet
+	uint32_t endseqnr; // one more than the highest extended sequence number
+};
+
+inline RTPPacket *RTPSourcePacketQueue::GetNextPacket()
+{
+	if (numpackets == 0)
+		return 0;
+
+	uint32_t mask = (uint32_t)(ringsize-1);
+	RTPPacket *p = ring[firstseqnr&mask];
+
+	ring[firstseqnr&mask] = 0;
+	numpackets--;
+	firstseqnr++;
+
+	// Skip the missing packets, if any
+	if (numpackets > 0)
+	{
+		while (ring[firstseqnr&mask] == 0)
+			firstseqnr++;
+	}
+	else if (ringsize > RTPSOURCEPACKETQUEUE_KEEPSIZE) // don't hold on to a large ring
+		ReleaseRing();
+	return p;
+}
+
+} // end namespace
+
+#endif // RTPSOURCEPACKETQUEUE_H
+
@@ -0,0 +1,233 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtpsourcereporttable.h"
+#include "rtpsourcedata.h"
+#include "rtperrors.h"
+#include <string.h>
+
+#include "rtpdebug.h"
+
+#define RTPSOURCEREPORTTABLE_INITIALCAPACITY		16
+
+namespace jrtplib
+{
+
+RTPSourceReportTable::RTPSourceReportTable(RTPMemoryManager *mgr) : RTPMemoryObject(mgr)
+{
+	block = 0;
+	numslots = 0;
+	capacity = 0;
+	sources = 0;
+	lastrtptimes = 0;
+	ssrcs = 0;
+	exthighseqnrs = 0;
+	baseseqnrs = 0;
+	savedseqnrs = 0;
+	numpackets = 0;
+	numnewpackets = 0;
+	jitters = 0;
+	reportpackets = 0;
+	flags = 0;
+}
+
+RTPSourceReportTable::~RTPSourceReportTable()
+{
+	if (block)
+		RTPDeleteByteArray(block,GetMemoryManager());
+}
+
+int RTPSourceReportTable::AddSource(RTPSourceData *srcdat, int *slot)
+{
+	if (numslots == capacity)
+	{
+		int status;
+
+		if ((status = Resize((capacity == 0)?RTPSOURCEREPORTTABLE_INITIALCAPACITY:capacity*2)) < 0)
+			return status;
+	}
+
+	int idx = numslots++;
+
+	sources[idx] = srcdat;
+	flags[idx] = (srcdat->IsProcessedInRTCP())?RTPSOURCEREPORTTABLE_FLAG_PROCESSED:0;
+	reportpackets[idx] = 0;
+	UpdateSource(idx,srcdat);
+	*slot = idx;
+	return 0;
+}
+
+RTPSourceData *RTPSourceReportTable::RemoveSource(int slot)
+{
+	int last = --numslots;
+
+	if (slot == last)
+		return 0;
+
+	sources[slot] = sources[last];
+	lastrtptimes[slot] = lastrtptimes[last];
+	ssrcs[slot] = ssrcs[last];
+	exthighseqnrs[slot] = exthighseqnrs[last];
+	baseseqnrs[slot] = baseseqnrs[last];
+	savedseqnrs[slot] = savedseqnrs[last];
+	numpackets[slot] = numpackets[last];
+	numnewpackets[slot] = numnewpackets[last];
+	jitters[slot] = jitters[last];
+	reportpackets[slot] = reportpackets[last];
+	flags[slot] = flags[last];
+	return sources[slot];
+}
+
+void RTPSourceReportTable::UpdateSource(int slot, const RTPSourceData *srcdat)
+{
+	// The processed flag is only changed by SetProcessedInRTCP
+	uint8_t f = flags[slot]&RTPSOURCEREPORTTABLE_FLAG_PROCESSED;
+
+	if (srcdat->IsOwnSSRC())
+		f |= RTPSOURCEREPORTTABLE_FLAG_OWNSSRC;
+	if (srcdat->IsCSRC())
+		f |= RTPSOURCEREPORTTABLE_FLAG_CSRC;
+	if (srcdat->INF_HasSentData())
+		f |= RTPSOURCEREPORTTABLE_FLAG_SENTDATA;
+
+	flags[slot] = f;
+	lastrtptimes[slot] = srcdat->INF_GetLastRTPPacketTime().GetDouble();
+	ssrcs[slot] = srcdat->GetSSRC();
+	exthighseqnrs[slot] = srcdat->INF_GetExtendedHighestSequenceNumber();
+	baseseqnrs[slot] = srcdat->INF_GetBaseSequenceNumber();
+	savedseqnrs[slot] = srcdat->INF_GetSavedExtendedSequenceNumber();
+	numpackets[slot] = (uint32_t)srcdat->INF_GetNumPacketsReceived();
+	numnewpackets[slot] = srcdat->INF_GetNumPacketsReceivedInInterval();
+	jitters[slot] = srcdat->INF_GetJitter();
+}
+
+int RTPSourceReportTable::FindReportableSource(int slot, bool all, const RTPTime &t) const
+{
+	const uint8_t mask = RTPSOURCEREPORTTABLE_FLAG_OWNSSRC|RTPSOURCEREPORTTABLE_FLAG_CSRC|RTPSOURCEREPORTTABLE_FLAG_SENTDATA;
+	double tval = t.GetDouble();
+
+	// Only the flags and the time of the last RTP packet need to be checked,
+	// which are stored next to the ones of the neighbouring slots
+	for ( ; slot < numslots ; slot++)
+	{
+		if ((flags[slot]&mask) == RTPSOURCEREPORTTABLE_FLAG_SENTDATA && (all || lastrtptimes[slot] > tval))
+			return slot;
+	}
+	return -1;
+}
+
+void RTPSourceReportTable::SetProcessedInRTCP(int slot, bool v)
+{
+	if (v)
+		flags[slot] |= RTPSOURCEREPORTTABLE_FLAG_PROCESSED;
+	else
+		flags[slot] &= ~RTPSOURCEREPORTTABLE_FLAG_PROCESSED;
+	sources[slot]->SetProcessedInRTCP(v);
+}
+
+void RTPSourceReportTable::ClearProcessedInRTCP()
+{
+	// Only the participants which have the flag set need to be changed
+	for (int slot = 0 ; slot < numslots ; slot++)
+	{
+		if (flags[slot]&RTPSOURCEREPORTTABLE_FLAG_PROCESSED)
+			SetProcessedInRTCP(slot,false);
+	}
+}
+
+void RTPSourceReportTable::StartNewInterval(int slot)
+{
+	sources[slot]->INF_StartNewInterval();
+	savedseqnrs[slot] = exthighseqnrs[slot];
+	numnewpackets[slot] = 0;
+}
+
+int RTPSourceReportTable::Resize(int newcapacity)
+{
+	// The arrays are stored from the largest to the smallest element size,
+	// so that each one is properly aligned if the capacity is a multiple of 8
+	size_t n = (size_t)newcapacity;
+	size_t blocksize = n*(sizeof(RTPSourceData *)+sizeof(double)+8*sizeof(uint32_t)+sizeof(uint8_t));
+	uint8_t *newblock = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_SOURCEREPORTTABLE) uint8_t[blocksize];
+
+	if (newblock == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	RTPSourceData **newsources = (RTPSourceData **)newblock;
+	double *newlastrtptimes = (double *)(newsources+n);
+	uint32_t *newssrcs = (uint32_t *)(newlastrtptimes+n);
+	uint32_t *newexthighseqnrs = newssrcs+n;
+	uint32_t *newbaseseqnrs = newexthighseqnrs+n;
+	uint32_t *newsavedseqnrs = newbaseseqnrs+n;
+	uint32_t *newnumpackets = newsavedseqnrs+n;
+	uint32_t *newnumnewpackets = newnumpackets+n;
+	uint32_t *newjitters = newnumnewpackets+n;
+	uint32_t *newreportpackets = newjitters+n;
+	uint8_t *newflags = (uint8_t *)(newreportpackets+n);
+
+	if (numslots > 0)
+	{
+		size_t num = (size_t)numslots;
+
+		memcpy(newsources,sources,num*sizeof(RTPSourceData *));
+		memcpy(newlastrtptimes,lastrtptimes,num*sizeof(double));
+		memcpy(newssrcs,ssrcs,num*sizeof(uint32_t));
+		memcpy(newexthighseqnrs,exthighseqnrs,num*sizeof(uint32_t));
+		memcpy(newbaseseqnrs,baseseqnrs,num*sizeof(uint32_t));
+		memcpy(newsavedseqnrs,savedseqnrs,num*sizeof(uint32_t));
+		memcpy(newnumpackets,numpackets,num*sizeof(uint32_t));
+		memcpy(newnumnewpackets,numnewpackets,num*sizeof(uint32_t));
+		memcpy(newjitters,jitters,num*sizeof(uint32_t));
+		memcpy(newreportpackets,reportpackets,num*sizeof(uint32_t));
+		memcpy(newflags,flags,num*sizeof(uint8_t));
+	}
+	if (block)
+		RTPDeleteByteArray(block,GetMemoryManager());
+
+	block = newblock;
+	capacity = newcapacity;
+	sources = newsources;
+	lastrtptimes = newlastrtptimes;
+	ssrcs = newssrcs;
+	exthighseqnrs = newexthighseqnrs;
+	baseseqnrs = newbaseseqnrs;
+	savedseqnrs = newsavedseqnrs;
+	numpackets = newnumpackets;
+	numnewpackets = newnumnewpackets;
+	jitters = newjitters;
+	reportpackets = newreportpackets;
+	flags = newflags;
+	return 0;
+}
+
+} // end namespace
+
@@ -0,0 +1,162 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpsourcereporttable.h
+ */
+
+#ifndef RTPSOURCEREPORTTABLE_H
+
+#define RTPSOURCEREPORTTABLE_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtptimeutilities.h"
+#include "rtpmemoryobject.h"
+
+namespace jrtplib
+{
+
+class RTPSourceData;
+
+/** Keeps the statistics that are needed to build RTCP report blocks in a compact table.
+ *  Keeps the statistics that are needed to build RTCP report blocks in a compact table, with
+ *  one array per field and one slot per participant. This way, finding the participants that
+ *  need a report block only reads a few small arrays, instead of every RTPSourceData instance.
+ *  The table is kept up to date by RTPSources and is used by RTCPPacketBuilder.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSourceReportTable : public RTPMemoryObject
+{
+	JRTPLIB_NO_COPY(RTPSourceReportTable)
+public:
+	RTPSourceReportTable(RTPMemoryManager *mgr = 0);
+	~RTPSourceReportTable();
+
+	/** Adds a slot for \c srcdat, of which the index is stored in \c slot. */
+	int AddSource(RTPSourceData *srcdat, int *slot);
+
+	/** Removes the slot with index \c slot.
+	 *  Removes the slot with index \c slot. To keep the table compact, the last slot is moved to
+	 *  this position; the function returns the participant of that slot, or NULL if no slot was moved.
+	 */
+	RTPSourceData *RemoveSource(int slot);
+
+	/** Copies the current statistics of \c srcdat to the slot with index \c slot. */
+	void UpdateSource(int slot, const RTPSourceData *srcdat);
+
+	/** Removes all slots. */
+	void Clear()											{ numslots = 0; }
+
+	/** Returns the number of slots in use. */
+	int GetNumberOfSlots() const									{ return numslots; }
+
+	/** Returns the participant of slot \c slot. */
+	RTPSourceData *GetSource(int slot) const							{ return sources[slot]; }
+
+	/** Returns the first slot starting from \c slot of a participant that should get a report block.
+	 *  Returns the first slot starting from \c slot of a participant that should get a report block,
+	 *  or -1 if there is none. These are the participants other than the local one and the ones only
+	 *  known from a CSRC list, that have sent RTP data; unless \c all is \c true, the last RTP packet
+	 *  must also have been received after time \c t.
+	 */
+	int FindReportableSource(int slot, bool all, const RTPTime &t) const;
+
+	/** Returns \c true if a report block for the participant in \c slot was already added in the current round. */
+	bool IsProcessedInRTCP(int slot) const								{ return (flags[slot]&RTPSOURCEREPORTTABLE_FLAG_PROCESSED)?true:false; }
+
+	/** Marks the participant in \c slot as processed (or not), in the table as well as in its RTPSourceData instance. */
+	void SetProcessedInRTCP(int slot, bool v);
+
+	/** Marks the participant in \c slot as processed, because a report block was added to RTCP packet \c packetnumber. */
+	void SetReported(int slot, uint32_t packetnumber)						{ SetProcessedInRTCP(slot,true); reportpackets[slot] = packetnumber; }
+
+	/** Returns \c true if a report block for the participant in \c slot was added to RTCP packet \c packetnumber. */
+	bool IsReportedInPacket(int slot, uint32_t packetnumber) const					{ return (reportpackets[slot] == packetnumber); }
+
+	/** Clears the processed flag of all participants. */
+	void ClearProcessedInRTCP();
+
+	/** Starts a new reporting interval for the participant in \c slot, see RTPSourceData::INF_StartNewInterval. */
+	void StartNewInterval(int slot);
+
+	/** Returns the SSRC of the participant in \c slot. */
+	uint32_t GetSSRC(int slot) const								{ return ssrcs[slot]; }
+
+	/** Returns the extended highest sequence number received from the participant in \c slot. */
+	uint32_t GetExtendedHighestSequenceNumber(int slot) const					{ return exthighseqnrs[slot]; }
+
+	/** Returns the base sequence number of the participant in \c slot. */
+	uint32_t GetBaseSequenceNumber(int slot) const							{ return baseseqnrs[slot]; }
+
+	/** Returns the extended sequence number saved at the start of the interval for the participant in \c slot. */
+	uint32_t GetSavedExtendedSequenceNumber(int slot) const						{ return savedseqnrs[slot]; }
+
+	/** Returns the number of packets received from the participant in \c slot. */
+	uint32_t GetNumPacketsReceived(int slot) const							{ return numpackets[slot]; }
+
+	/** Returns the number of packets received from the participant in \c slot in the current interval. */
+	uint32_t GetNumPacketsReceivedInInterval(int slot) const					{ return numnewpackets[slot]; }
+
+	/** Returns the jitter of the participant in \c slot. */
+	uint32_t GetJitter(int slot) const								{ return jitters[slot]; }
+private:
+	enum
+	{
+		RTPSOURCEREPORTTABLE_FLAG_OWNSSRC = 0x01,
+		RTPSOURCEREPORTTABLE_FLAG_CSRC = 0x02,
+		RTPSOURCEREPORTTABLE_FLAG_SENTDATA = 0x04,
+		RTPSOURCEREPORTTABLE_FLAG_PROCESSED = 0x08
+	};
+
+	int Resize(int newcapacity);
+
+	uint8_t *block;
+	int numslots, capacity;
+
+	// Each field is stored in its own array, all of them in the same block
+	RTPSourceData **sources;
+	double *lastrtptimes;
+	uint32_t *ssrcs;
+	uint32_t *exthighseqnrs;
+	uint32_t *baseseqnrs;
+	uint32_t *savedseqnrs;
+	uint32_t *numpackets;
+	uint32_t *numnewpackets;
+	uint32_t *jitters;
+	uint32_t *reportpackets;
+	uint8_t *flags;
+};
+
+} // end namespace
+
+#endif // RTPSOURCEREPORTTABLE_H
+
@@ -33,16 +33,19 @@
 #include "rtpsources.h"
 #include "rtperrors.h"
 #include "rtprawpacket.h"
+#include "rtppacketview.h"
 #include "rtpinternalsourcedata.h"
 #include "rtptimeutilities.h"
 #include "rtpdefines.h"
 #include "rtcpcompoundpacket.h"
+#include "rtcpcompoundpacketparser.h"
 #include "rtcppacket.h"
 #include "rtcpapppacket.h"
 #include "rtcpbyepacket.h"
 #include "rtcpsdespacket.h"
 #include "rtcpsrpacket.h"
 #include "rtcprrpacket.h"
+#include "rtcpunknownpacket.h"
 #include "rtptransmitter.h"
 
 #ifdef RTPDEBUG
@@ -54,7 +57,7 @@
 namespace jrtplib
 {
 
-RTPSources::RTPSources(ProbationType probtype,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),sourcelist(mgr,RTPMEM_TYPE_CLASS_SOURCETABLEHASHELEMENT)
+RTPSources::RTPSources(ProbationType probtype,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),sourcelist(mgr,RTPMEM_TYPE_BUFFER_SOURCETABLE),reporttable(mgr),snapshottable(mgr)
 {
 	JRTPLIB_UNUSED(probtype); // possibly unused
 
@@ -62,9 +65,14 @@ RTPSources::RTPSources(ProbationType probtype,RTPMemoryManager *mgr) : RTPMemory
 	sendercount = 0;
 	activecount = 0;
 	owndata = 0;
+	firstsourcewithdata = 0;
+	lastsourcewithdata = 0;
+	currentsourcewithdata = 0;
 #ifdef RTP_SUPPORT_PROBATION
 	probationtype = probtype;
 #endif // RTP_SUPPORT_PROBATION
+	usepacketviews = false;
+	parsertcpinplace = false;
 }
 
 RTPSources::~RTPSources()
@@ -89,6 +97,13 @@ void RTPSources::ClearSourceList()
 		sourcelist.GotoNextElement();
 	}
 	sourcelist.Clear();
+	for (int i = 0 ; i < RTPSOURCES_NUMTIMEOUTLISTS ; i++)
+		timeoutlists[i].Clear();
+	reporttable.Clear();
+	snapshottable.Clear();
+	firstsourcewithdata = 0;
+	lastsourcewithdata = 0;
+	currentsourcewithdata = 0;
 	owndata = 0;
 	totalcount = 0;
 	sendercount = 0;
@@ -114,6 +129,7 @@ int RTPSources::CreateOwnSSRC(uint32_t ssrc)
 	owndata->SetOwnSSRC();	
 	owndata->SetRTPDataAddress(0);
 	owndata->SetRTCPDataAddress(0);
+	UpdateSourceIndexes(owndata);
 
 	// we've created a validated ssrc, so we should increase activecount
 	activecount++;
@@ -131,6 +147,8 @@ int RTPSources::DeleteOwnSSRC()
 
 	sourcelist.GotoElement(ssrc);
 	sourcelist.DeleteCurrentElement();
+	RemoveFromSourceIndexes(owndata);
+	RemoveFromDataList(owndata);
 
 	totalcount--;
 	if (owndata->IsSender())
@@ -155,6 +173,7 @@ void RTPSources::SentRTPPacket()
 	owndata->SentRTPPacket();
 	if (!prevsender && owndata->IsSender())
 		sendercount++;
+	UpdateSourceIndexes(owndata);
 }
 
 int RTPSources::ProcessRawPacket(RTPRawPacket *rawpack,RTPTransmitter *rtptrans,bool acceptownpackets)
@@ -176,28 +195,11 @@ int RTPSources::ProcessRawPacket(RTPRawPacket *rawpack,RTPTransmitter *rtptrans[
 	
 	if (rawpack->IsRTP()) // RTP packet
 	{
-		RTPPacket *rtppack;
+		RTPPacketView view;
 		
-		// First, we'll see if the packet can be parsed
-		rtppack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPPACKET) RTPPacket(*rawpack,GetMemoryManager());
-		if (rtppack == 0)
-			return ERR_RTP_OUTOFMEM;
-		if ((status = rtppack->GetCreationError()) < 0)
-		{
-			if (status == ERR_RTP_PACKET_INVALIDPACKET)
-			{
-				RTPDelete(rtppack,GetMemoryManager());
-				rtppack = 0;
-			}
-			else
-			{
-				RTPDelete(rtppack,GetMemoryManager());
-				return status;
-			}
-		}
-				
-		// Check if the packet was valid
-		if (rtppack != 0)
+		// First, we'll see if the packet can be parsed; this doesn't allocate
+		// anything, an RTPPacket instance is only created when it's needed
+		if (view.Parse(*rawpack) == 0)
 		{
 			bool stored = false;
 			bool ownpacket = false;
@@ -210,6 +212,8 @@ int RTPSources::ProcessRawPacket(RTPRawPacket *rawpack,RTPTransmitter *rtptrans[
 					ownpacket = true;
 			}
 			
+			status = 0;
+
 			// Check if the packet is our own.
 			if (ownpacket)
 			{
@@ -218,25 +222,39 @@ int RTPSources::ProcessRawPacket(RTPRawPacket *rawpack,RTPTransmitter *rtptrans[
 				if (acceptownpackets)
 				{
 					// sender addres for own packets has to be NULL!
-					if ((status = ProcessRTPPacket(rtppack,rawpack->GetReceiveTime(),0,&stored)) < 0)
-					{
-						if (!stored)
-							RTPDelete(rtppack,GetMemoryManager());
-						return status;
-					}
+					status = ProcessRTPPacketView(&view,rawpack->GetReceiveTime(),0,&stored);
 				}
 			}
 			else 
-			{
-				if ((status = ProcessRTPPacket(rtppack,rawpack->GetReceiveTime(),senderaddress,&stored)) < 0)
-				{
-					if (!stored)
-						RTPDelete(rtppack,GetMemoryManager());
-					return status;
-				}
-			}
-			if (!stored)
-				RTPDelete(rtppack,GetMemoryManager());
+				status = ProcessRTPPacketView(&view,rawpack->GetReceiveTime(),senderaddress,&stored);
+
+			if (view.rtppack != 0 && !stored)
+				RTPDelete(view.rtppack,GetMemoryManager());
+			if (status < 0)
+				return status;
+		}
+	}
+	else if (parsertcpinplace) // RTCP packet, processed in the received data
+	{
+		bool ownpacket = false;
+		int i;
+		const RTPAddress *senderaddress = rawpack->GetSenderAddress();
+
+		for (i = 0 ; !ownpacket && i < numtrans ; i++)
+		{
+			if (rtptrans[i]->ComesFromThisTransmitter(senderaddress))
+				ownpacket = true;
+		}
+
+		// sender address for own packets has to be NULL
+		if (!ownpacket || acceptownpackets)
+		{
+			status = ProcessRTCPCompoundPacketData(rawpack->GetData(),rawpack->GetDataLength(),rawpack->GetReceiveTime(),
+			                                       (ownpacket)?0:senderaddress);
+
+			// invalid compound packets are ignored, just like below
+			if (status < 0 && status != ERR_RTP_RTCPCOMPOUND_INVALIDPACKET)
+				return status;
 		}
 	}
 	else // RTCP packet
@@ -289,17 +307,64 @@ int RTPSources::ProcessRawPacket(RTPRawPacket *rawpack,RTPTransmitter *rtptrans[
 }
 
 int RTPSources::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &receivetime,const RTPAddress *senderaddress,bool *stored)
+{
+	RTPPacketView view;
+	int status;
+
+	*stored = false;
+	if ((status = view.Parse(rtppack->GetPacketData(),rtppack->GetPacketLength(),receivetime)) < 0)
+		return status;
+	view.SetExtendedSequenceNumber(rtppack->GetExtendedSequenceNumber());
+
+	// This is the instance that will be used for the callbacks which need one,
+	// and it's the caller who deletes it if it's not stored
+	view.rtppack = rtppack;
+	return ProcessRTPPacketView(&view,receivetime,senderaddress,stored);
+}
+
+RTPPacket *RTPSources::MaterializePacket(RTPPacketView *view)
+{
+	if (view->rtppack != 0)
+		return view->rtppack;
+	if (view->rawpack == 0) // shouldn't happen
+		return 0;
+
+	RTPPacket *rtppack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPPACKET) RTPPacket(*(view->rawpack),*view,GetMemoryManager());
+	if (rtppack == 0)
+		return 0;
+	if (rtppack->GetCreationError() < 0)
+	{
+		RTPDelete(rtppack,GetMemoryManager());
+		return 0;
+	}
+
+	// The data now belongs to the packet, the view still refers to it
+	view->rawpack = 0;
+	view->rtppack = rtppack;
+	return rtppack;
+}
+
+int RTPSources::ProcessRTPPacketView(RTPPacketView *view,const RTPTime &receivetime,const RTPAddress *senderaddress,bool *stored)
 {
 	uint32_t ssrc;
 	RTPInternalSourceData *srcdat;
 	int status;
 	bool created;
 
-	OnRTPPacket(rtppack,receivetime,senderaddress);
-
 	*stored = false;
+
+	if (usepacketviews)
+		OnRTPPacketView(*view,receivetime,senderaddress);
+	else
+	{
+		RTPPacket *rtppack = MaterializePacket(view);
+
+		if (rtppack == 0)
+			return ERR_RTP_OUTOFMEM;
+		OnRTPPacket(rtppack,receivetime,senderaddress);
+	}
 	
-	ssrc = rtppack->GetSSRC();
+	ssrc = view->GetSSRC();
 	if ((status = ObtainSourceDataInstance(ssrc,&srcdat,&created)) < 0)
 		return status;
 
@@ -318,21 +383,21 @@ int RTPSources::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &receivetime,c
 	bool prevactive = srcdat->IsActive();
 	
 	uint32_t CSRCs[RTP_MAXCSRCS];
-	int numCSRCs = rtppack->GetCSRCCount();
+	int numCSRCs = view->GetCSRCCount();
 	if (numCSRCs > RTP_MAXCSRCS) // shouldn't happen, but better to check than go out of bounds
 		numCSRCs = RTP_MAXCSRCS;
 
 	for (int i = 0 ; i < numCSRCs ; i++)
-		CSRCs[i] = rtppack->GetCSRC(i);
+		CSRCs[i] = view->GetCSRC(i);
 
 	// The packet comes from a valid source, we can process it further now
-	// The following function should delete rtppack itself if something goes
-	// wrong
-	if ((status = srcdat->ProcessRTPPacket(rtppack,receivetime,stored,this)) < 0)
+	status = srcdat->ProcessRTPPacket(view,receivetime,stored,this);
+	UpdateSourceIndexes(srcdat);
+	if (status < 0)
 		return status;
 
-	// NOTE: we cannot use 'rtppack' anymore since it may have been deleted in
-	//       OnValidatedRTPPacket
+	// NOTE: we cannot use 'view' anymore since the packet it refers to may 
+	//       have been deleted in OnValidatedRTPPacket
 
 	if (!prevsender && srcdat->IsSender())
 		sendercount++;
@@ -357,6 +422,7 @@ int RTPSources::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &receivetime,c
 			if (createdcsrc)
 			{
 				csrcdat->SetCSRC();
+				UpdateSourceIndexes(csrcdat);
 				if (csrcdat->IsActive())
 					activecount++;
 				OnNewSource(csrcdat);
@@ -364,7 +430,10 @@ int RTPSources::ProcessRTPPacket(RTPPacket *rtppack,const RTPTime &receivetime,c
 			else // already found an entry, possibly because of RTCP data
 			{
 				if (!CheckCollision(csrcdat,senderaddress,true))
+				{
 					csrcdat->SetCSRC();
+					UpdateSourceIndexes(csrcdat);
+				}
 			}
 		}
 	}
@@ -541,6 +610,154 @@ int RTPSources::ProcessRTCPCompoundPacket(RTCPCompoundPacket *rtcpcomppack,const
 	return 0;
 }
 
+// Passes the information in an RTCP compound packet to the RTPSources::Process...
+// functions in the same way as RTPSources::ProcessRTCPCompoundPacket does
+class RTPSourcesRTCPParser : public RTCPCompoundPacketParser
+{
+public:
+	RTPSourcesRTCPParser(RTPSources &s,const RTPTime &t,const RTPAddress *addr)
+		: sources(s),receivetime(t),senderaddress(addr)
+	{
+		gotownssrc = (sources.owndata != 0);
+		ownssrc = (gotownssrc)?sources.owndata->GetSSRC():0;
+		gotinfo = false;
+		updated = false;
+	}
+protected:
+	int OnSenderInfo(uint32_t senderssrc,const RTPNTPTime &ntptime,uint32_t rtptime,uint32_t packetcount,uint32_t octetcount)
+	{
+		return sources.ProcessRTCPSenderInfo(senderssrc,ntptime,rtptime,packetcount,octetcount,receivetime,senderaddress);
+	}
+
+	int OnReportBlock(uint32_t senderssrc,uint32_t ssrc,uint8_t fractionlost,int32_t lostpackets,
+	                  uint32_t exthighseqnr,uint32_t jitter,uint32_t lsr,uint32_t dlsr)
+	{
+		if (!gotownssrc || ssrc != ownssrc) // only the data that's meant for us is used
+			return 0;
+		gotinfo = true;
+		return sources.ProcessRTCPReportBlock(senderssrc,fractionlost,lostpackets,exthighseqnr,jitter,lsr,dlsr,receivetime,senderaddress);
+	}
+
+	int OnEndOfReport(uint32_t senderssrc)
+	{
+		int status = 0;
+
+		if (!gotinfo)
+			status = sources.UpdateReceiveTime(senderssrc,receivetime,senderaddress);
+		gotinfo = false;
+		return status;
+	}
+
+	int OnSDESItem(uint32_t ssrc,RTCPSDESPacket::ItemType t,const uint8_t *itemdata,size_t itemlength)
+	{
+		updated = true;
+		return sources.ProcessSDESNormalItem(ssrc,t,itemlength,itemdata,receivetime,senderaddress);
+	}
+
+#ifdef RTP_SUPPORT_SDESPRIV
+	int OnSDESPrivateItem(uint32_t ssrc,const uint8_t *prefixdata,size_t prefixlength,const uint8_t *valuedata,size_t valuelength)
+	{
+		updated = true;
+		return sources.ProcessSDESPrivateItem(ssrc,prefixlength,prefixdata,valuelength,valuedata,receivetime,senderaddress);
+	}
+#endif // RTP_SUPPORT_SDESPRIV
+
+	int OnEndOfSDESChunk(uint32_t ssrc)
+	{
+		int status = 0;
+
+		if (!updated)
+			status = sources.UpdateReceiveTime(ssrc,receivetime,senderaddress);
+		updated = false;
+		return status;
+	}
+
+	int OnBYE(uint32_t ssrc,const uint8_t *reasondata,size_t reasonlength)
+	{
+		return sources.ProcessBYE(ssrc,reasonlength,reasondata,receivetime,senderaddress);
+	}
+
+	// The callbacks below still need packet instances, but these don't allocate
+	// any memory and only have to exist during the call
+	
+	int OnAPPPacket(uint8_t,uint32_t,const uint8_t *,const uint8_t *,size_t)
+	{
+		RTCPAPPPacket p(GetCurrentPacketData(),GetCurrentPacketLength());
+
+		sources.OnAPPPacket(&p,receivetime,senderaddress);
+		return 0;
+	}
+
+	int OnUnknownPacketType(uint8_t)
+	{
+		RTCPUnknownPacket p(GetCurrentPacketData(),GetCurrentPacketLength());
+
+		sources.OnUnknownPacketType(&p,receivetime,senderaddress);
+		return 0;
+	}
+
+	int OnUnknownPacketFormat(uint8_t packettype)
+	{
+		uint8_t *data = GetCurrentPacketData();
+		size_t len = GetCurrentPacketLength();
+
+		switch (packettype)
+		{
+		case RTP_RTCPTYPE_SR:
+			{
+				RTCPSRPacket p(data,len);
+				sources.OnUnknownPacketFormat(&p,receivetime,senderaddress);
+			}
+			break;
+		case RTP_RTCPTYPE_RR:
+			{
+				RTCPRRPacket p(data,len);
+				sources.OnUnknownPacketFormat(&p,receivetime,senderaddress);
+			}
+			break;
+		case RTP_RTCPTYPE_SDES:
+			{
+				RTCPSDESPacket p(data,len);
+				sources.OnUnknownPacketFormat(&p,receivetime,senderaddress);
+			}
+			break;
+		case RTP_RTCPTYPE_BYE:
+			{
+				RTCPBYEPacket p(data,len);
+				sources.OnUnknownPacketFormat(&p,receivetime,senderaddress);
+			}
+			break;
+		default:
+			{
+				RTCPAPPPacket p(data,len);
+				sources.OnUnknownPacketFormat(&p,receivetime,senderaddress);
+			}
+		}
+		return 0;
+	}
+private:
+	RTPSources &sources;
+	const RTPTime &receivetime;
+	const RTPAddress *senderaddress;
+	bool gotownssrc;
+	uint32_t ownssrc;
+	bool gotinfo,updated;
+};
+
+int RTPSources::ProcessRTCPCompoundPacketData(uint8_t *data,size_t datalen,const RTPTime &receivetime,const RTPAddress *senderaddress)
+{
+	int status;
+
+	if ((status = RTCPCompoundPacketParser::Validate(data,datalen)) < 0)
+		return status;
+
+	OnRTCPCompoundPacketData(data,datalen,receivetime,senderaddress);
+
+	RTPSourcesRTCPParser parser(*this,receivetime,senderaddress);
+
+	return parser.Parse(data,datalen);
+}
+
 bool RTPSources::GotoFirstSource()
 {
 	sourcelist.GotoFirstElement();
@@ -567,32 +784,35 @@ bool RTPSources::GotoPreviousSource()
 
 bool RTPSources::GotoFirstSourceWithData()
 {
-	bool found = false;
-	
-	sourcelist.GotoFirstElement();
-	while (!found && sourcelist.HasCurrentElement())
-	{
-		RTPInternalSourceData *srcdat;
-
-		srcdat = sourcelist.GetCurrentElement();
-		if (srcdat->HasData())
-			found = true;
-		else
-			sourcelist.GotoNextElement();
-	}
-			
-	return found;
+	return GotoSourceWithData(firstsourcewithdata,true);
 }
 
 bool RTPSources::GotoNextSourceWithData()
 {
+	if (!sourcelist.HasCurrentElement())
+		return false;
+
+	RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
+
+	if (srcdat == currentsourcewithdata)
+	{
+		RTPInternalSourceData *nextsrcdat = srcdat->datalistnext;
+
+		// If all packets of the current source have been retrieved, we
+		// can remove it from the list already
+		if (!srcdat->HasData())
+			RemoveFromDataList(srcdat);
+		return GotoSourceWithData(nextsrcdat,true);
+	}
+
+	// The current source wasn't selected using the list of sources with
+	// data, so we'll look for the next one in the table
+
 	bool found = false;
 	
 	sourcelist.GotoNextElement();
 	while (!found && sourcelist.HasCurrentElement())
 	{
-		RTPInternalSourceData *srcdat;
-
 		srcdat = sourcelist.GetCurrentElement();
 		if (srcdat->HasData())
 			found = true;
@@ -605,13 +825,27 @@ bool RTPSources::GotoNextSourceWithData()
 
 bool RTPSources::GotoPreviousSourceWithData()
 {
+	if (!sourcelist.HasCurrentElement())
+		return false;
+
+	RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
+
+	if (srcdat == currentsourcewithdata)
+	{
+		RTPInternalSourceData *nextsrcdat = srcdat->datalistprev;
+
+		// If all packets of the current source have been retrieved, we
+		// can remove it from the list already
+		if (!srcdat->HasData())
+			RemoveFromDataList(srcdat);
+		return GotoSourceWithData(nextsrcdat,false);
+	}
+
 	bool found = false;
 	
 	sourcelist.GotoPreviousElement();
 	while (!found && sourcelist.HasCurrentElement())
 	{
-		RTPInternalSourceData *srcdat;
-
 		srcdat = sourcelist.GetCurrentElement();
 		if (srcdat->HasData())
 			found = true;
@@ -629,6 +863,60 @@ RTPSourceData *RTPSources::GetCurrentSourceInfo()
 	return sourcelist.GetCurrentElement();
 }
 
+bool RTPSources::GotoFirstSource(Iterator &it)
+{
+	return SetIterator(it,sourcelist.GetFirstPosition());
+}
+
+bool RTPSources::GotoNextSource(Iterator &it)
+{
+	int pos = GetIteratorPosition(it);
+
+	if (pos < 0)
+		return SetIterator(it,-1);
+	return SetIterator(it,sourcelist.GetNextPosition(pos));
+}
+
+bool RTPSources::GotoPreviousSource(Iterator &it)
+{
+	int pos = GetIteratorPosition(it);
+
+	if (pos < 0)
+		return SetIterator(it,-1);
+	return SetIterator(it,sourcelist.GetPreviousPosition(pos));
+}
+
+RTPSourceData *RTPSources::GetSourceInfo(const Iterator &it)
+{
+	int pos = GetIteratorPosition(it);
+
+	if (!sourcelist.HasElementAt(pos))
+		return 0;
+	return sourcelist.GetElementAt(pos);
+}
+
+int RTPSources::GetIteratorPosition(const Iterator &it)
+{
+	if (it.position < 0)
+		return -1;
+	if (it.generation == sourcelist.GetGeneration())
+		return it.position;
+
+	// The table has been reorganized since the iterator was set, so we'll
+	// have to look up its source again
+	return sourcelist.GetPosition(it.ssrc);
+}
+
+bool RTPSources::SetIterator(Iterator &it,int pos)
+{
+	it.position = pos;
+	it.generation = sourcelist.GetGeneration();
+	if (pos < 0)
+		return false;
+	it.ssrc = sourcelist.GetKeyAt(pos);
+	return true;
+}
+
 RTPSourceData *RTPSources::GetSourceInfo(uint32_t ssrc)
 {
 	if (sourcelist.GotoElement(ssrc) < 0)
@@ -668,6 +956,7 @@ int RTPSources::ProcessRTCPSenderInfo(uint32_t ssrc,const RTPNTPTime &ntptime,ui
 		return 0;
 	
 	srcdat->ProcessSenderInfo(ntptime,rtptime,packetcount,octetcount,receivetime);
+	UpdateSourceIndexes(srcdat);
 	
 	// Call the callback
 	if (created)
@@ -693,6 +982,7 @@ int RTPSources::ProcessRTCPReportBlock(uint32_t ssrc,uint8_t fractionlost,int32_
 		return 0;
 	
 	srcdat->ProcessReportBlock(fractionlost,lostpackets,exthighseqnr,jitter,lsr,dlsr,receivetime);
+	UpdateSourceIndexes(srcdat);
 
 	// Call the callback
 	if (created)
@@ -747,6 +1037,7 @@ int RTPSources::ProcessSDESNormalItem(uint32_t ssrc,RTCPSDESPacket::ItemType t,s
 
 	prevactive = srcdat->IsActive();
 	status = srcdat->ProcessSDESItem(sdesid,(const uint8_t *)itemdata,itemlength,receivetime,&cnamecollis);
+	UpdateSourceIndexes(srcdat);
 	if (!prevactive && srcdat->IsActive())
 		activecount++;
 	
@@ -778,6 +1069,7 @@ int RTPSources::ProcessSDESPrivateItem(uint32_t ssrc,size_t prefixlen,const void
 		return 0;
 
 	status = srcdat->ProcessPrivateSDESItem((const uint8_t *)prefixdata,prefixlen,(const uint8_t *)valuedata,valuelen,receivetime);
+	UpdateSourceIndexes(srcdat);
 	// Call the callback
 	if (created)
 		OnNewSource(srcdat);
@@ -809,6 +1101,7 @@ int RTPSources::ProcessBYE(uint32_t ssrc,size_t reasonlength,const void *reasond
 	
 	prevactive = srcdat->IsActive();
 	srcdat->ProcessBYEPacket((const uint8_t *)reasondata,reasonlength,receivetime);
+	UpdateSourceIndexes(srcdat);
 	if (prevactive && !srcdat->IsActive())
 		activecount--;
 	
@@ -833,14 +1126,21 @@ int RTPSources::ObtainSourceDataInstance(uint32_t ssrc,RTPInternalSourceData **s
 #endif // RTP_SUPPORT_PROBATION
 		if (srcdat2 == 0)
 			return ERR_RTP_OUTOFMEM;
+		if ((status = reporttable.AddSource(srcdat2,&srcdat2->reportslot)) < 0)
+		{
+			RTPDelete(srcdat2,GetMemoryManager());
+			return status;
+		}
 		if ((status = sourcelist.AddElement(ssrc,srcdat2)) < 0)
 		{
+			reporttable.RemoveSource(srcdat2->reportslot); // was the last one, nothing is moved
 			RTPDelete(srcdat2,GetMemoryManager());
 			return status;
 		}
 		*srcdat = srcdat2;
 		*created = true;
 		totalcount++;
+		UpdateSourceIndexes(srcdat2);
 	}
 	else
 	{
@@ -894,6 +1194,7 @@ int RTPSources::UpdateReceiveTime(uint32_t ssrc,const RTPTime &receivetime,const
 	
 	// We got valid SSRC info
 	srcdat->UpdateMessageTime(receivetime);
+	UpdateSourceIndexes(srcdat);
 	
 	// Call the callback
 	if (created)
@@ -904,383 +1205,262 @@ int RTPSources::UpdateReceiveTime(uint32_t ssrc,const RTPTime &receivetime,const
 
 void RTPSources::Timeout(const RTPTime &curtime,const RTPTime &timeoutdelay)
 {
-	int newtotalcount = 0;
-	int newsendercount = 0;
-	int newactivecount = 0;
 	RTPTime checktime = curtime;
 	checktime -= timeoutdelay;
-	
-	sourcelist.GotoFirstElement();
-	while (sourcelist.HasCurrentElement())
+
+	// The list is ordered on the last message time, so we can stop as soon
+	// as we find a source that hasn't timed out. Our own source isn't in
+	// this list, we don't want to time out ourselves.
+
+	RTPSourceTimeoutList &timeoutlist = timeoutlists[RTPSOURCES_TIMEOUTLIST_MESSAGE];
+	RTPSourceTimeoutLink *link;
+
+	while ((link = timeoutlist.GetFirst()) != 0 && link->time < checktime)
 	{
-		RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
+		RTPInternalSourceData *srcdat = link->source;
 		RTPTime lastmsgtime = srcdat->INF_GetLastMessageTime();
 
-		// we don't want to time out ourselves
-		if ((srcdat != owndata) && (lastmsgtime < checktime)) // timeout
+		if (!(lastmsgtime < checktime)) // was updated in the mean time
 		{
-			
-			totalcount--;
-			if (srcdat->IsSender())
-				sendercount--;
-			if (srcdat->IsActive())
-				activecount--;
-			
-			sourcelist.DeleteCurrentElement();
-
-			OnTimeout(srcdat);
-			OnRemoveSource(srcdat);
-			RTPDelete(srcdat,GetMemoryManager());
+			timeoutlist.Update(*link,lastmsgtime);
+			continue;
 		}
-		else
-		{
-			newtotalcount++;
-			if (srcdat->IsSender())
-				newsendercount++;
-			if (srcdat->IsActive())
-				newactivecount++;
-			sourcelist.GotoNextElement();
-		}
-	}
-	
-#ifdef RTPDEBUG
-	if (newtotalcount != totalcount)
-	{
-		std::cout << "New total count " << newtotalcount << " doesnt match old total count " << totalcount << std::endl;
-		SafeCountTotal();
-	}
-	if (newsendercount != sendercount)
-	{
-		std::cout << "New sender count " << newsendercount << " doesnt match old sender count " << sendercount << std::endl;
-		SafeCountSenders();
-	}
-	if (newactivecount != activecount)
-	{
-		std::cout << "New active count " << newactivecount << " doesnt match old active count " << activecount << std::endl;
-		SafeCountActive();
+		
+		DeleteSource(srcdat);
+		OnTimeout(srcdat);
+		OnRemoveSource(srcdat);
+		RTPDelete(srcdat,GetMemoryManager());
 	}
-#endif // RTPDEBUG
-	
-	totalcount = newtotalcount; // just to play it safe
-	sendercount = newsendercount;
-	activecount = newactivecount;
 }
 
 void RTPSources::SenderTimeout(const RTPTime &curtime,const RTPTime &timeoutdelay)
 {
-	int newtotalcount = 0;
-	int newsendercount = 0;
-	int newactivecount = 0;
 	RTPTime checktime = curtime;
 	checktime -= timeoutdelay;
 	
-	sourcelist.GotoFirstElement();
-	while (sourcelist.HasCurrentElement())
-	{
-		RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
+	RTPSourceTimeoutList &timeoutlist = timeoutlists[RTPSOURCES_TIMEOUTLIST_SENDER];
+	RTPSourceTimeoutLink *link;
 
-		newtotalcount++;
-		if (srcdat->IsActive())
-			newactivecount++;
+	while ((link = timeoutlist.GetFirst()) != 0 && link->time < checktime)
+	{
+		RTPInternalSourceData *srcdat = link->source;
 
 		if (srcdat->IsSender())
 		{
 			RTPTime lastrtppacktime = srcdat->INF_GetLastRTPPacketTime();
 
-			if (lastrtppacktime < checktime) // timeout
+			if (!(lastrtppacktime < checktime)) // was updated in the mean time
 			{
-				srcdat->ClearSenderFlag();
-				sendercount--;
+				timeoutlist.Update(*link,lastrtppacktime);
+				continue;
 			}
-			else
-				newsendercount++;
+			srcdat->ClearSenderFlag();
+			snapshottable.MarkChanged(srcdat->reportslot);
+			sendercount--;
 		}
-		sourcelist.GotoNextElement();
-	}
-	
-#ifdef RTPDEBUG
-	if (newtotalcount != totalcount)
-	{
-		std::cout << "New total count " << newtotalcount << " doesnt match old total count " << totalcount << std::endl;
-		SafeCountTotal();
-	}
-	if (newsendercount != sendercount)
-	{
-		std::cout << "New sender count " << newsendercount << " doesnt match old sender count " << sendercount << std::endl;
-		SafeCountSenders();
+		timeoutlist.Remove(*link);
 	}
-	if (newactivecount != activecount)
-	{
-		std::cout << "New active count " << newactivecount << " doesnt match old active count " << activecount << std::endl;
-		SafeCountActive();
-	}
-#endif // RTPDEBUG
-	
-	totalcount = newtotalcount; // just to play it safe
-	sendercount = newsendercount;
-	activecount = newactivecount;
 }
 
 void RTPSources::BYETimeout(const RTPTime &curtime,const RTPTime &timeoutdelay)
 {
-	int newtotalcount = 0;
-	int newsendercount = 0;
-	int newactivecount = 0;
 	RTPTime checktime = curtime;
 	checktime -= timeoutdelay;
 	
-	sourcelist.GotoFirstElement();
-	while (sourcelist.HasCurrentElement())
+	// Only sources other than our own which have sent a BYE packet are
+	// in this list
+
+	RTPSourceTimeoutList &timeoutlist = timeoutlists[RTPSOURCES_TIMEOUTLIST_BYE];
+	RTPSourceTimeoutLink *link;
+
+	while ((link = timeoutlist.GetFirst()) != 0 && checktime > link->time)
 	{
-		RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
-		
-		if (srcdat->ReceivedBYE())
-		{
-			RTPTime byetime = srcdat->GetBYETime();
+		RTPInternalSourceData *srcdat = link->source;
+		RTPTime byetime = srcdat->GetBYETime();
 
-			if ((srcdat != owndata) && (checktime > byetime))
-			{
-				totalcount--;
-				if (srcdat->IsSender())
-					sendercount--;
-				if (srcdat->IsActive())
-					activecount--;
-				sourcelist.DeleteCurrentElement();
-				OnBYETimeout(srcdat);
-				OnRemoveSource(srcdat);
-				RTPDelete(srcdat,GetMemoryManager());
-			}
-			else
-			{
-				newtotalcount++;
-				if (srcdat->IsSender())
-					newsendercount++;
-				if (srcdat->IsActive())
-					newactivecount++;
-				sourcelist.GotoNextElement();
-			}
-		}
-		else
+		if (!(checktime > byetime)) // was updated in the mean time
 		{
-			newtotalcount++;
-			if (srcdat->IsSender())
-				newsendercount++;
-			if (srcdat->IsActive())
-				newactivecount++;
-			sourcelist.GotoNextElement();
+			timeoutlist.Update(*link,byetime);
+			continue;
 		}
+
+		DeleteSource(srcdat);
+		OnBYETimeout(srcdat);
+		OnRemoveSource(srcdat);
+		RTPDelete(srcdat,GetMemoryManager());
 	}
-	
-#ifdef RTPDEBUG
-	if (newtotalcount != totalcount)
-	{
-		std::cout << "New total count " << newtotalcount << " doesnt match old total count " << totalcount << std::endl;
-		SafeCountTotal();
-	}
-	if (newsendercount != sendercount)
-	{
-		std::cout << "New sender count " << newsendercount << " doesnt match old sender count " << sendercount << std::endl;
-		SafeCountSenders();
-	}
-	if (newactivecount != activecount)
-	{
-		std::cout << "New active count " << newactivecount << " doesnt match old active count " << activecount << std::endl;
-		SafeCountActive();
-	}
-#endif // RTPDEBUG
-	
-	totalcount = newtotalcount; // just to play it safe
-	sendercount = newsendercount;
-	activecount = newactivecount;
 }
 
 void RTPSources::NoteTimeout(const RTPTime &curtime,const RTPTime &timeoutdelay)
 {
-	int newtotalcount = 0;
-	int newsendercount = 0;
-	int newactivecount = 0;
 	RTPTime checktime = curtime;
 	checktime -= timeoutdelay;
 	
-	sourcelist.GotoFirstElement();
-	while (sourcelist.HasCurrentElement())
+	RTPSourceTimeoutList &timeoutlist = timeoutlists[RTPSOURCES_TIMEOUTLIST_NOTE];
+	RTPSourceTimeoutLink *link;
+
+	while ((link = timeoutlist.GetFirst()) != 0 && checktime > link->time)
 	{
-		RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
+		RTPInternalSourceData *srcdat = link->source;
+		RTPTime notetime = srcdat->INF_GetLastSDESNoteTime();
 		size_t notelen;
 
-        	srcdat->SDES_GetNote(&notelen);
+		if (!(checktime > notetime)) // was updated in the mean time
+		{
+			timeoutlist.Update(*link,notetime);
+			continue;
+		}
+
+		timeoutlist.Remove(*link);
+
+		srcdat->SDES_GetNote(&notelen);
 		if (notelen != 0) // Note has been set
 		{
-			RTPTime notetime = srcdat->INF_GetLastSDESNoteTime();
-			
-			if (checktime > notetime)
-			{
-				srcdat->ClearNote();
-				OnNoteTimeout(srcdat);
-			}
+			srcdat->ClearNote();
+			OnNoteTimeout(srcdat);
 		}
-		
-		newtotalcount++;
-		if (srcdat->IsSender())
-			newsendercount++;
-		if (srcdat->IsActive())
-			newactivecount++;
-		sourcelist.GotoNextElement();
-	}
-	
-#ifdef RTPDEBUG
-	if (newtotalcount != totalcount)
-	{
-		std::cout << "New total count " << newtotalcount << " doesnt match old total count " << totalcount << std::endl;
-		SafeCountTotal();
-	}
-	if (newsendercount != sendercount)
-	{
-		std::cout << "New sender count " << newsendercount << " doesnt match old sender count " << sendercount << std::endl;
-		SafeCountSenders();
-	}
-	if (newactivecount != activecount)
-	{
-		std::cout << "New active count " << newactivecount << " doesnt match old active count " << activecount << std::endl;
-		SafeCountActive();
 	}
-#endif // RTPDEBUG
-	
-	totalcount = newtotalcount; // just to play it safe
-	sendercount = newsendercount;
-	activecount = newactivecount;
-
 }
 	
 void RTPSources::MultipleTimeouts(const RTPTime &curtime,const RTPTime &sendertimeout,const RTPTime &byetimeout,const RTPTime &generaltimeout,const RTPTime &notetimeout)
 {
-	int newtotalcount = 0;
-	int newsendercount = 0;
-	int newactivecount = 0;
-	RTPTime senderchecktime = curtime;
-	RTPTime byechecktime = curtime;
-	RTPTime generaltchecktime = curtime;
-	RTPTime notechecktime = curtime;
-	senderchecktime -= sendertimeout;
-	byechecktime -= byetimeout;
-	generaltchecktime -= generaltimeout;
-	notechecktime -= notetimeout;
-	
-	sourcelist.GotoFirstElement();
-	while (sourcelist.HasCurrentElement())
-	{
-		RTPInternalSourceData *srcdat = sourcelist.GetCurrentElement();
-		bool deleted,issender,isactive;
-		bool byetimeout,normaltimeout,notetimeout;
-		
-		size_t notelen;
-		
-		issender = srcdat->IsSender();
-		isactive = srcdat->IsActive();
-		deleted = false;
-		byetimeout = false;
-		normaltimeout = false;
-		notetimeout = false;
-
-        	srcdat->SDES_GetNote(&notelen);
-		if (notelen != 0) // Note has been set
-		{
-			RTPTime notetime = srcdat->INF_GetLastSDESNoteTime();
-			
-			if (notechecktime > notetime)
-			{
-				notetimeout = true;
-				srcdat->ClearNote();
-			}
-		}
+	// Since each of these only looks at the sources which expire, there's no
+	// need to combine them in a single iteration anymore. The BYE timeout is
+	// checked first, so that a source which left is reported as a BYE timeout
+	// rather than a normal one.
+
+	BYETimeout(curtime,byetimeout);
+	Timeout(curtime,generaltimeout);
+	SenderTimeout(curtime,sendertimeout);
+	NoteTimeout(curtime,notetimeout);
+}
 
-		if (srcdat->ReceivedBYE())
-		{
-			RTPTime byetime = srcdat->GetBYETime();
+// Brings the timeout lists, the report table and the list of sources with
+// data in line with the state of the source
+void RTPSources::UpdateSourceIndexes(RTPInternalSourceData *srcdat)
+{
+	RTPSourceTimeoutLink *links = srcdat->timeoutlinks;
+	size_t notelen;
 
-			if ((srcdat != owndata) && (byechecktime > byetime))
-			{
-				sourcelist.DeleteCurrentElement();
-				deleted = true;
-				byetimeout = true;
-			}
-		}
+	reporttable.UpdateSource(srcdat->reportslot,srcdat);
+	snapshottable.MarkChanged(srcdat->reportslot);
 
-		if (!deleted)
-		{
-			RTPTime lastmsgtime = srcdat->INF_GetLastMessageTime();
+	// Packets which were stored during probation only become available when
+	// the source is validated, which can also happen when its CNAME arrives
+	if (srcdat->HasData())
+		AddToDataList(srcdat);
 
-			if ((srcdat != owndata) && (lastmsgtime < generaltchecktime))
-			{
-				sourcelist.DeleteCurrentElement();
-				deleted = true;
-				normaltimeout = true;
-			}
-		}
-		
-		if (!deleted)
-		{
-			newtotalcount++;
-			
-			if (issender)
-			{
-				RTPTime lastrtppacktime = srcdat->INF_GetLastRTPPacketTime();
+	if (srcdat != owndata)
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_MESSAGE].Update(links[RTPSOURCES_TIMEOUTLIST_MESSAGE],srcdat->INF_GetLastMessageTime());
+	else
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_MESSAGE].Remove(links[RTPSOURCES_TIMEOUTLIST_MESSAGE]);
 
-				if (lastrtppacktime < senderchecktime)
-				{
-					srcdat->ClearSenderFlag();
-					sendercount--;
-				}
-				else
-					newsendercount++;
-			}
+	if (srcdat->IsSender())
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_SENDER].Update(links[RTPSOURCES_TIMEOUTLIST_SENDER],srcdat->INF_GetLastRTPPacketTime());
+	else
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_SENDER].Remove(links[RTPSOURCES_TIMEOUTLIST_SENDER]);
 
-			if (isactive)
-				newactivecount++;
+	if (srcdat != owndata && srcdat->ReceivedBYE())
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_BYE].Update(links[RTPSOURCES_TIMEOUTLIST_BYE],srcdat->GetBYETime());
+	else
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_BYE].Remove(links[RTPSOURCES_TIMEOUTLIST_BYE]);
 
-			if (notetimeout)
-				OnNoteTimeout(srcdat);
+	srcdat->SDES_GetNote(&notelen);
+	if (notelen != 0)
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_NOTE].Update(links[RTPSOURCES_TIMEOUTLIST_NOTE],srcdat->INF_GetLastSDESNoteTime());
+	else
+		timeoutlists[RTPSOURCES_TIMEOUTLIST_NOTE].Remove(links[RTPSOURCES_TIMEOUTLIST_NOTE]);
+}
 
-			sourcelist.GotoNextElement();
-		}
-		else // deleted entry
+void RTPSources::RemoveFromSourceIndexes(RTPInternalSourceData *srcdat)
+{
+	for (int i = 0 ; i < RTPSOURCES_NUMTIMEOUTLISTS ; i++)
+		timeoutlists[i].Remove(srcdat->timeoutlinks[i]);
+
+	// The last slot of the report table is moved to the one that was freed
+	RTPInternalSourceData *moved = static_cast<RTPInternalSourceData *>(reporttable.RemoveSource(srcdat->reportslot));
+	if (moved)
+		moved->reportslot = srcdat->reportslot;
+	snapshottable.MarkChanged(srcdat->reportslot);
+	srcdat->reportslot = -1;
+}
+
+void RTPSources::DeleteSource(RTPInternalSourceData *srcdat)
+{
+	// Removes the source from the table and the timeout lists and adjusts
+	// the counts; the caller still needs to delete the instance itself
+
+	totalcount--;
+	if (srcdat->IsSender())
+		sendercount--;
+	if (srcdat->IsActive())
+		activecount--;
+
+	RemoveFromSourceIndexes(srcdat);
+	RemoveFromDataList(srcdat);
+	if (sourcelist.GotoElement(srcdat->GetSSRC()) >= 0)
+		sourcelist.DeleteCurrentElement();
+}
+
+void RTPSources::AddToDataList(RTPInternalSourceData *srcdat)
+{
+	if (srcdat->indatalist)
+		return;
+
+	srcdat->datalistprev = lastsourcewithdata;
+	srcdat->datalistnext = 0;
+	if (lastsourcewithdata)
+		lastsourcewithdata->datalistnext = srcdat;
+	else
+		firstsourcewithdata = srcdat;
+	lastsourcewithdata = srcdat;
+	srcdat->indatalist = true;
+}
+
+void RTPSources::RemoveFromDataList(RTPInternalSourceData *srcdat)
+{
+	if (!srcdat->indatalist)
+		return;
+
+	if (srcdat->datalistprev)
+		srcdat->datalistprev->datalistnext = srcdat->datalistnext;
+	else
+		firstsourcewithdata = srcdat->datalistnext;
+	if (srcdat->datalistnext)
+		srcdat->datalistnext->datalistprev = srcdat->datalistprev;
+	else
+		lastsourcewithdata = srcdat->datalistprev;
+	srcdat->datalistprev = 0;
+	srcdat->datalistnext = 0;
+	srcdat->indatalist = false;
+	if (srcdat == currentsourcewithdata)
+		currentsourcewithdata = 0;
+}
+
+bool RTPSources::GotoSourceWithData(RTPInternalSourceData *srcdat,bool forward)
+{
+	// Starting from srcdat, look for a source in the list which still has
+	// data; the ones whose packets have all been retrieved are removed
+
+	while (srcdat != 0)
+	{
+		RTPInternalSourceData *nextsrcdat = (forward)?srcdat->datalistnext:srcdat->datalistprev;
+
+		if (srcdat->HasData())
 		{
-			if (issender)
-				sendercount--;
-			if (isactive)
-				activecount--;
-			totalcount--;
-
-			if (byetimeout)
-				OnBYETimeout(srcdat);
-			if (normaltimeout)
-				OnTimeout(srcdat);
-			OnRemoveSource(srcdat);
-			RTPDelete(srcdat,GetMemoryManager());
+			sourcelist.GotoElement(srcdat->GetSSRC());
+			currentsourcewithdata = srcdat;
+			return true;
 		}
-	}	
-	
-#ifdef RTPDEBUG
-	if (newtotalcount != totalcount)
-	{
-		SafeCountTotal();
-		std::cout << "New total count " << newtotalcount << " doesnt match old total count " << totalcount << std::endl;
-	}
-	if (newsendercount != sendercount)
-	{
-		SafeCountSenders();
-		std::cout << "New sender count " << newsendercount << " doesnt match old sender count " << sendercount << std::endl;
-	}
-	if (newactivecount != activecount)
-	{
-		std::cout << "New active count " << newactivecount << " doesnt match old active count " << activecount << std::endl;
-		SafeCountActive();
+		RemoveFromDataList(srcdat);
+		srcdat = nextsrcdat;
 	}
-#endif // RTPDEBUG
-	
-	totalcount = newtotalcount; // just to play it safe
-	sendercount = newsendercount;
-	activecount = newactivecount;
+
+	// Like when iterating over the table, there's no current source anymore
+	currentsourcewithdata = 0;
+	sourcelist.GotoLastElement();
+	sourcelist.GotoNextElement();
+	return false;
 }
 
 #ifdef RTPDEBUG
@@ -39,20 +39,29 @@
 #define RTPSOURCES_H
 
 #include "rtpconfig.h"
-#include "rtpkeyhashtable.h"
+#include "rtpflatkeyhashtable.h"
 #include "rtcpsdespacket.h"
 #include "rtptypes.h"
 #include "rtpmemoryobject.h"
+#include "rtpsourcetimeoutlist.h"
+#include "rtpsourcereporttable.h"
+#include "rtpsourcesnapshot.h"
 
 #define RTPSOURCES_HASHSIZE							8317
 
+#define RTPSOURCES_TIMEOUTLIST_MESSAGE						0
+#define RTPSOURCES_TIMEOUTLIST_SENDER						1
+#define RTPSOURCES_TIMEOUTLIST_BYE						2
+#define RTPSOURCES_TIMEOUTLIST_NOTE						3
+#define RTPSOURCES_NUMTIMEOUTLISTS						4
+
 namespace jrtplib
 {
 
 class JRTPLIB_IMPORTEXPORT RTPSources_GetHashIndex
 {
 public:
-	static int GetIndex(const uint32_t &ssrc)				{ return ssrc%RTPSOURCES_HASHSIZE; }
+	static int GetIndex(const uint32_t &ssrc)				{ return ssrc; }
 };
 	
 class RTPNTPTime;
@@ -61,6 +70,7 @@ class RTCPAPPPacket;
 class RTPInternalSourceData;
 class RTPRawPacket;
 class RTPPacket;
+class RTPPacketView;
 class RTPTime;
 class RTPAddress;
 class RTPSourceData;
@@ -83,6 +93,24 @@ public:
 			ProbationStore 		/**< Store incoming RTP packet from a source that's on probation for later retrieval. */
 	};
 	
+	/** Keeps track of a position in the source table, independent of the current source.
+	 *  Keeps track of a position in the source table, independent of the current source. Unlike
+	 *  the current source, any number of iterators can be used at the same time, for example in
+	 *  nested loops or in a callback while the application is already iterating over the sources.
+	 *  Sources can be added and deleted while an iterator is being used; only if the source an
+	 *  iterator points to is deleted and other ones are added afterwards, the iteration stops early.
+	 */
+	class JRTPLIB_IMPORTEXPORT Iterator
+	{
+	public:
+		Iterator()									{ position = -1; generation = 0; ssrc = 0; }
+	private:
+		friend class RTPSources;
+		int position;
+		uint32_t generation;
+		uint32_t ssrc;
+	};
+
 	/** In the constructor you can select the probation type you'd like to use and also a memory manager. */
 	RTPSources(ProbationType = ProbationStore,RTPMemoryManager *mgr = 0);
 	virtual ~RTPSources();
@@ -94,6 +122,33 @@ public:
 	void SetProbationType(ProbationType probtype)							{ probationtype = probtype; }
 #endif // RTP_SUPPORT_PROBATION
 
+	/** Selects which callback is used for RTP packets that are about to be processed.
+	 *  Selects which callback is used for RTP packets that are about to be processed. Incoming RTP 
+	 *  packets are only parsed into an RTPPacketView, and an RTPPacket instance is only allocated when
+	 *  it is needed: when the packet is stored, or when it is passed to OnRTPPacket or OnValidatedRTPPacket.
+	 *  By default OnRTPPacket is called for every packet; if \c v is \c true, OnRTPPacketView is called
+	 *  instead, so that packets which are handled in OnValidatedRTPPacketView, or which are not accepted 
+	 *  (e.g. while a source is on probation with ProbationDiscard), don't cause any allocation.
+	 */
+	void SetUsePacketViews(bool v)									{ usepacketviews = v; }
+
+	/** Returns \c true if OnRTPPacketView is called instead of OnRTPPacket. */
+	bool GetUsePacketViews() const									{ return usepacketviews; }
+
+	/** Selects how incoming RTCP compound packets are processed.
+	 *  Selects how incoming RTCP compound packets are processed. By default, an RTCPCompoundPacket instance
+	 *  is created for every incoming compound packet, which allocates an RTCPPacket instance for each
+	 *  packet it contains, and OnRTCPCompoundPacket is called. If \c v is \c true, the compound packet is
+	 *  processed directly in the received data using ProcessRTCPCompoundPacketData, without creating these
+	 *  instances; OnRTCPCompoundPacketData is then called instead of OnRTCPCompoundPacket. The packets
+	 *  passed to OnAPPPacket, OnUnknownPacketType and OnUnknownPacketFormat are then temporary instances
+	 *  which only exist during the call.
+	 */
+	void SetParseRTCPInPlace(bool v)								{ parsertcpinplace = v; }
+
+	/** Returns \c true if incoming RTCP compound packets are processed without creating RTCPCompoundPacket instances. */
+	bool GetParseRTCPInPlace() const								{ return parsertcpinplace; }
+
 	/** Creates an entry for our own SSRC identifier. */
 	int CreateOwnSSRC(uint32_t ssrc);
 
@@ -135,6 +190,15 @@ public:
 	 */
 	int ProcessRTCPCompoundPacket(RTCPCompoundPacket *rtcpcomppack,const RTPTime &receivetime,
 	                              const RTPAddress *senderaddress);
+
+	/** Processes the RTCP compound packet in \c data with length \c datalen which was received at time \c receivetime from \c senderaddress.
+	 *  Processes the RTCP compound packet in \c data with length \c datalen which was received at time \c receivetime
+	 *  from \c senderaddress. The result is the same as for ProcessRTCPCompoundPacket, but the information is
+	 *  read directly from the data using an RTCPCompoundPacketParser, so no RTCPPacket instances need to be 
+	 *  allocated. The \c senderaddress parameter must be NULL if the packet was sent by the local participant.
+	 */
+	int ProcessRTCPCompoundPacketData(uint8_t *data,size_t datalen,const RTPTime &receivetime,
+	                                  const RTPAddress *senderaddress);
 	
 	/** Process the sender information of SSRC \c ssrc into the source table. 
 	 *  Process the sender information of SSRC \c ssrc into the source table. The information was received
@@ -212,7 +276,9 @@ public:
 	 *  that we haven't extracted yet.
 	 *  Sets the current source to be the first source in the table which has RTPPacket instances 
 	 *  that we haven't extracted yet. If no such member was found, the function returns \c false,
-	 *  otherwise it returns \c true.
+	 *  otherwise it returns \c true. The sources with data are kept in a separate list, so idle
+	 *  sources are never visited; starting from this function, the sources are iterated in the
+	 *  order in which they received their packets.
 	 */
 	bool GotoFirstSourceWithData();
 
@@ -235,6 +301,32 @@ public:
 	/** Returns the RTPSourceData instance for the currently selected participant. */
 	RTPSourceData *GetCurrentSourceInfo();
 
+	/** Returns the table with the statistics that are used to build RTCP report blocks. */
+	RTPSourceReportTable &GetReportTable()								{ return reporttable; }
+
+	/** Lets \c it point to the first member in the table, returns \c false if the table is empty. */
+	bool GotoFirstSource(Iterator &it);
+
+	/** Lets \c it point to the next member in the table, returns \c false if there are no more members. */
+	bool GotoNextSource(Iterator &it);
+
+	/** Lets \c it point to the previous member in the table, returns \c false if there are no more members. */
+	bool GotoPreviousSource(Iterator &it);
+
+	/** Returns the RTPSourceData instance for the participant \c it points to, or NULL if there is none. */
+	RTPSourceData *GetSourceInfo(const Iterator &it);
+
+	/** Copies the statistics of all participants to a new RTPSourceSnapshot instance.
+	 *  Copies the statistics of all participants to a new RTPSourceSnapshot instance, which is
+	 *  stored in \c snapshot. The time \c t is stored as the creation time of the snapshot. Only
+	 *  the statistics of participants that changed since the previous snapshot are copied again,
+	 *  the others are shared with that snapshot.
+	 */
+	int CreateSnapshot(RTPSourceSnapshot **snapshot,const RTPTime &t)				{ return snapshottable.CreateSnapshot(reporttable,t,snapshot); }
+
+	/** Returns \c true if the statistics of a participant changed since the last snapshot was made. */
+	bool HasSnapshotChanges() const									{ return snapshottable.HasChanges(); }
+
 	/** Returns the RTPSourceData instance for the participant identified by \c ssrc, or 
 	 *  NULL if no such entry exists.  
 	 */                         
@@ -270,8 +362,14 @@ public:
 	void NoteTimeout(const RTPTime &curtime,const RTPTime &timeoutdelay);
 
 	/** Combines the functions SenderTimeout, BYETimeout, Timeout and NoteTimeout.
-	 *  Combines the functions SenderTimeout, BYETimeout, Timeout and NoteTimeout. This is more efficient
-	 *  than calling all four functions since only one iteration is needed in this function.
+	 *  Combines the functions SenderTimeout, BYETimeout, Timeout and NoteTimeout. The sources are kept
+	 *  in lists which are ordered on the time of their last message, RTP packet, BYE packet and NOTE 
+	 *  item, so these functions only need to look at the sources which actually time out instead of 
+	 *  iterating over the entire source table. The callbacks are therefore grouped by kind instead of
+	 *  per source: first the sources which sent a BYE packet are removed (OnBYETimeout, then OnRemoveSource
+	 *  for each one), next the sources which timed out (OnTimeout, then OnRemoveSource), after that the
+	 *  sender flags are cleared and finally the SDES NOTE items (OnNoteTimeout). Within each group, the
+	 *  sources are handled in the order in which they expired.
 	 */
 	void MultipleTimeouts(const RTPTime &curtime,const RTPTime &sendertimeout,
 			      const RTPTime &byetimeout,const RTPTime &generaltimeout,
@@ -295,10 +393,24 @@ protected:
 	/** Is called when an RTP packet is about to be processed. */
 	virtual void OnRTPPacket(RTPPacket *pack,const RTPTime &receivetime, const RTPAddress *senderaddress);
 
+	/** Is called instead of OnRTPPacket when an RTP packet is about to be processed and SetUsePacketViews was enabled.
+	 *  Is called instead of OnRTPPacket when an RTP packet is about to be processed and SetUsePacketViews 
+	 *  was enabled. The view \c pack refers to the received data and can only be used during this call.
+	 */
+	virtual void OnRTPPacketView(const RTPPacketView &pack,const RTPTime &receivetime, const RTPAddress *senderaddress);
+
 	/** Is called when an RTCP compound packet is about to be processed. */
 	virtual void OnRTCPCompoundPacket(RTCPCompoundPacket *pack,const RTPTime &receivetime,
 	                                  const RTPAddress *senderaddress);
 
+	/** Is called instead of OnRTCPCompoundPacket when an RTCP compound packet is about to be processed and SetParseRTCPInPlace was enabled.
+	 *  Is called instead of OnRTCPCompoundPacket when an RTCP compound packet is about to be processed and 
+	 *  SetParseRTCPInPlace was enabled. The \c datalen bytes in \c data contain the valid compound packet, and can
+	 *  only be used during this call.
+	 */
+	virtual void OnRTCPCompoundPacketData(const uint8_t *data,size_t datalen,const RTPTime &receivetime,
+	                                      const RTPAddress *senderaddress);
+
 	/** Is called when an SSRC collision was detected.
 	 *  Is called when an SSRC collision was detected. The instance \c srcdat is the one present in 
 	 *  the table, the address \c senderaddress is the one that collided with one of the addresses 
@@ -313,13 +425,25 @@ protected:
 	/** Is called when a new entry \c srcdat is added to the source table. */
 	virtual void OnNewSource(RTPSourceData *srcdat);
 
-	/** Is called when the entry \c srcdat is about to be deleted from the source table. */
+	/** Is called when the entry \c srcdat is about to be deleted from the source table.
+	 *  Is called when the entry \c srcdat is about to be deleted from the source table. When the
+	 *  source is removed because it timed out, this is called right after OnTimeout or OnBYETimeout 
+	 *  for the same source; see RTPSources::MultipleTimeouts for the order in which that happens.
+	 */
 	virtual void OnRemoveSource(RTPSourceData *srcdat);
 
-	/** Is called when participant \c srcdat is timed out. */
+	/** Is called when participant \c srcdat is timed out.
+	 *  Is called when participant \c srcdat is timed out, right before OnRemoveSource is called for it.
+	 *  Sources which sent a BYE packet and timed out have already been handled at that point, see
+	 *  RTPSources::MultipleTimeouts.
+	 */
 	virtual void OnTimeout(RTPSourceData *srcdat);
 
-	/** Is called when participant \c srcdat is timed after having sent a BYE packet. */
+	/** Is called when participant \c srcdat is timed after having sent a BYE packet.
+	 *  Is called when participant \c srcdat is timed after having sent a BYE packet, right before 
+	 *  OnRemoveSource is called for it. These sources are handled before the ones for which OnTimeout
+	 *  is called, see RTPSources::MultipleTimeouts.
+	 */
 	virtual void OnBYETimeout(RTPSourceData *srcdat);
 
 	/** Is called when a BYE packet has been processed for source \c srcdat. */
@@ -363,13 +487,41 @@ protected:
 	 *  `ispackethandled` is set to `true`, the packet will no longer be stored in this
 	 *  source's packet list. */
 	virtual void OnValidatedRTPPacket(RTPSourceData *srcdat, RTPPacket *rtppack, bool isonprobation, bool *ispackethandled);
+
+	/** Allows you to use an RTP packet from the specified source without an RTPPacket instance being created for it.
+	 *  Allows you to use an RTP packet from the specified source without an RTPPacket instance being 
+	 *  created for it. This is called before OnValidatedRTPPacket; if `ispackethandled` is set to `true`,
+	 *  the packet is discarded afterwards, OnValidatedRTPPacket is not called and the packet is not stored.
+	 *  The view \c pack can only be used during this call.
+	 */
+	virtual void OnValidatedRTPPacketView(RTPSourceData *srcdat, const RTPPacketView &pack, bool isonprobation, bool *ispackethandled);
 private:
 	void ClearSourceList();
+	int ProcessRTPPacketView(RTPPacketView *view,const RTPTime &receivetime,const RTPAddress *senderaddress,bool *stored);
+	RTPPacket *MaterializePacket(RTPPacketView *view);
 	int ObtainSourceDataInstance(uint32_t ssrc,RTPInternalSourceData **srcdat,bool *created);
 	int GetRTCPSourceData(uint32_t ssrc,const RTPAddress *senderaddress,RTPInternalSourceData **srcdat,bool *newsource);
 	bool CheckCollision(RTPInternalSourceData *srcdat,const RTPAddress *senderaddress,bool isrtp);
+	void UpdateSourceIndexes(RTPInternalSourceData *srcdat);
+	void RemoveFromSourceIndexes(RTPInternalSourceData *srcdat);
+	void DeleteSource(RTPInternalSourceData *srcdat);
+	void AddToDataList(RTPInternalSourceData *srcdat);
+	void RemoveFromDataList(RTPInternalSourceData *srcdat);
+	bool GotoSourceWithData(RTPInternalSourceData *srcdat,bool forward);
+	int GetIteratorPosition(const Iterator &it);
+	bool SetIterator(Iterator &it,int pos);
 	
-	RTPKeyHashTable<const uint32_t,RTPInternalSourceData*,RTPSources_GetHashIndex,RTPSOURCES_HASHSIZE> sourcelist;
+	RTPFlatKeyHashTable<const uint32_t,RTPInternalSourceData*,RTPSources_GetHashIndex> sourcelist;
+	RTPSourceTimeoutList timeoutlists[RTPSOURCES_NUMTIMEOUTLISTS];
+	RTPSourceReportTable reporttable;
+	RTPSourceSnapshotTable snapshottable;
+
+	// Sources which have (or had) packets which weren't retrieved yet, in the
+	// order in which they got them. Sources are only removed from this list 
+	// when we notice that their packets have been retrieved, so every source
+	// with data is in the list but not every source in the list has data.
+	RTPInternalSourceData *firstsourcewithdata,*lastsourcewithdata;
+	RTPInternalSourceData *currentsourcewithdata; // the one selected using this list
 	
 	int sendercount;
 	int totalcount;
@@ -378,15 +530,20 @@ private:
 #ifdef RTP_SUPPORT_PROBATION
 	ProbationType probationtype;
 #endif // RTP_SUPPORT_PROBATION
+	bool usepacketviews;
+	bool parsertcpinplace;
 
 	RTPInternalSourceData *owndata;
 
 	friend class RTPInternalSourceData;
+	friend class RTPSourcesRTCPParser;
 };
 
 // Inlining the default implementations to avoid unused-parameter errors.
 inline void RTPSources::OnRTPPacket(RTPPacket *, const RTPTime &, const RTPAddress *)                               { }
+inline void RTPSources::OnRTPPacketView(const RTPPacketView &, const RTPTime &, const RTPAddress *)                 { }
 inline void RTPSources::OnRTCPCompoundPacket(RTCPCompoundPacket *, const RTPTime &, const RTPAddress *)             { }
+inline void RTPSources::OnRTCPCompoundPacketData(const uint8_t *, size_t, const RTPTime &, const RTPAddress *)      { }
 inline void RTPSources::OnSSRCCollision(RTPSourceData *, const RTPAddress *, bool)                                  { }
 inline void RTPSources::OnCNAMECollision(RTPSourceData *, const RTPAddress *, const uint8_t *, size_t)              { }
 inline void RTPSources::OnNewSource(RTPSourceData *)                                                                { }
@@ -405,6 +562,7 @@ inline void RTPSources::OnUnknownPacketType(RTCPPacket *, const RTPTime &, const
 inline void RTPSources::OnUnknownPacketFormat(RTCPPacket *, const RTPTime &, const RTPAddress *)                    { }
 inline void RTPSources::OnNoteTimeout(RTPSourceData *)                                                              { }
 inline void RTPSources::OnValidatedRTPPacket(RTPSourceData *, RTPPacket *, bool, bool *)                            { }
+inline void RTPSources::OnValidatedRTPPacketView(RTPSourceData *, const RTPPacketView &, bool, bool *)              { }
 
 } // end namespace
 
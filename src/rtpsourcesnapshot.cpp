@@ -0,0 +1,260 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+#include "rtpsourcesnapshot.h"
+#include "rtpsourcedata.h"
+#include "rtpsourcereporttable.h"
+#include "rtperrors.h"
+
+#include "rtpdebug.h"
+
+namespace jrtplib
+{
+
+RTPSourceStatistics::RTPSourceStatistics() : lastmsgtime(0,0),lastrtptime(0,0)
+{
+	ssrc = 0;
+	ownssrc = false;
+	iscsrc = false;
+	issender = false;
+	validated = false;
+	receivedbye = false;
+	numpacketsreceived = 0;
+	exthighseqnr = 0;
+	jitter = 0;
+	srhasinfo = false;
+	srpacketcount = 0;
+	srbytecount = 0;
+	rrhasinfo = false;
+	rrfractionlost = 0;
+	rrpacketslost = 0;
+	rrjitter = 0;
+}
+
+void RTPSourceStatistics::Set(const RTPSourceData *srcdat)
+{
+	ssrc = srcdat->GetSSRC();
+	ownssrc = srcdat->IsOwnSSRC();
+	iscsrc = srcdat->IsCSRC();
+	issender = srcdat->IsSender();
+	validated = srcdat->IsValidated();
+	receivedbye = srcdat->ReceivedBYE();
+	numpacketsreceived = (uint32_t)srcdat->INF_GetNumPacketsReceived();
+	exthighseqnr = srcdat->INF_GetExtendedHighestSequenceNumber();
+	jitter = srcdat->INF_GetJitter();
+	lastmsgtime = srcdat->INF_GetLastMessageTime();
+	lastrtptime = srcdat->INF_GetLastRTPPacketTime();
+	srhasinfo = srcdat->SR_HasInfo();
+	srpacketcount = srcdat->SR_GetPacketCount();
+	srbytecount = srcdat->SR_GetByteCount();
+	rrhasinfo = srcdat->RR_HasInfo();
+	rrfractionlost = srcdat->RR_GetFractionLost();
+	rrpacketslost = srcdat->RR_GetPacketsLost();
+	rrjitter = srcdat->RR_GetJitter();
+}
+
+void RTPSourceSnapshotChunk::Release(RTPSourceSnapshotChunk *chunk,RTPMemoryManager *mgr)
+{
+	if (chunk->refcount.FetchAdd(-1) == 1)
+		RTPDelete(chunk,mgr);
+}
+
+RTPSourceSnapshot::RTPSourceSnapshot(const RTPTime &t,RTPMemoryManager *mgr) : RTPMemoryObject(mgr),creationtime(t)
+{
+	chunks = 0;
+	numchunks = 0;
+	numsources = 0;
+	refcount = 1;
+}
+
+RTPSourceSnapshot::~RTPSourceSnapshot()
+{
+	for (int i = 0 ; i < numchunks ; i++)
+		RTPSourceSnapshotChunk::Release(chunks[i],GetMemoryManager());
+	if (chunks)
+		RTPDeleteByteArray((uint8_t *)chunks,GetMemoryManager());
+}
+
+int RTPSourceSnapshot::Init(int numsrcs,RTPSourceSnapshotChunk **chks,int numchks)
+{
+	if (chunks)
+		return ERR_RTP_SOURCESNAPSHOT_ALREADYINIT;
+	if (numchks <= 0)
+		return 0;
+
+	chunks = (RTPSourceSnapshotChunk **)RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_SOURCESNAPSHOT) uint8_t[sizeof(RTPSourceSnapshotChunk *)*numchks];
+	if (chunks == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	// The chunks are shared with the table they come from
+	for (int i = 0 ; i < numchks ; i++)
+	{
+		chunks[i] = chks[i];
+		chunks[i]->refcount.FetchAdd(1);
+	}
+	numchunks = numchks;
+	numsources = numsrcs;
+	return 0;
+}
+
+RTPSourceSnapshotTable::RTPSourceSnapshotTable(RTPMemoryManager *mgr) : RTPMemoryObject(mgr)
+{
+	block = 0;
+	chunks = 0;
+	changedmasks = 0;
+	capacity = 0;
+	numrecords = 0;
+	changed = true;
+}
+
+RTPSourceSnapshotTable::~RTPSourceSnapshotTable()
+{
+	Clear();
+	if (block)
+		RTPDeleteByteArray(block,GetMemoryManager());
+}
+
+void RTPSourceSnapshotTable::Clear()
+{
+	for (int i = 0 ; i < capacity ; i++)
+	{
+		if (chunks[i])
+			RTPSourceSnapshotChunk::Release(chunks[i],GetMemoryManager());
+		chunks[i] = 0;
+		changedmasks[i] = 0;
+	}
+	numrecords = 0;
+	changed = true;
+}
+
+int RTPSourceSnapshotTable::CreateSnapshot(const RTPSourceReportTable &table,const RTPTime &t,RTPSourceSnapshot **snapshot)
+{
+	int num = table.GetNumberOfSlots();
+	int numchunks = (num+RTPSOURCESNAPSHOT_CHUNKSIZE-1)/RTPSOURCESNAPSHOT_CHUNKSIZE;
+	int status;
+
+	if (numchunks > capacity)
+	{
+		if ((status = Resize(numchunks)) < 0)
+			return status;
+	}
+
+	// Chunks beyond the last slot are no longer needed
+	for (int i = numchunks ; i < capacity ; i++)
+	{
+		if (chunks[i])
+			RTPSourceSnapshotChunk::Release(chunks[i],GetMemoryManager());
+		chunks[i] = 0;
+		changedmasks[i] = 0;
+	}
+	if (numrecords > num)
+		numrecords = num;
+
+	for (int i = 0 ; i < numchunks ; i++)
+	{
+		int first = i*RTPSOURCESNAPSHOT_CHUNKSIZE;
+		int end = (num < first+RTPSOURCESNAPSHOT_CHUNKSIZE)?num:(first+RTPSOURCESNAPSHOT_CHUNKSIZE);
+		uint32_t mask = changedmasks[i];
+
+		// Slots that were added since the last snapshot are always copied
+		for (int j = (numrecords > first)?numrecords:first ; j < end ; j++)
+			mask |= (uint32_t)1 << (j-first);
+		if (mask == 0)
+			continue;
+
+		RTPSourceSnapshotChunk *chunk = chunks[i];
+
+		// A chunk that's still used by a snapshot can't be changed anymore
+		if (chunk == 0 || chunk->refcount.Get() > 1)
+		{
+			RTPSourceSnapshotChunk *newchunk = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_SOURCESNAPSHOT) RTPSourceSnapshotChunk;
+
+			if (newchunk == 0)
+				return ERR_RTP_OUTOFMEM;
+			if (chunk)
+			{
+				for (int j = first ; j < end ; j++)
+					newchunk->sources[j-first] = chunk->sources[j-first];
+				RTPSourceSnapshotChunk::Release(chunk,GetMemoryManager());
+			}
+			chunks[i] = newchunk;
+			chunk = newchunk;
+		}
+
+		for (int j = first ; j < end ; j++)
+		{
+			if (mask&((uint32_t)1 << (j-first)))
+				chunk->sources[j-first].Set(table.GetSource(j));
+		}
+		changedmasks[i] = 0;
+	}
+
+	RTPSourceSnapshot *s = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_SOURCESNAPSHOT) RTPSourceSnapshot(t,GetMemoryManager());
+
+	if (s == 0)
+		return ERR_RTP_OUTOFMEM;
+	if ((status = s->Init(num,chunks,numchunks)) < 0)
+	{
+		RTPDelete(s,GetMemoryManager());
+		return status;
+	}
+	numrecords = num;
+	changed = false;
+	*snapshot = s;
+	return 0;
+}
+
+int RTPSourceSnapshotTable::Resize(int newcapacity)
+{
+	uint8_t *newblock = RTPNew(GetMemoryManager(),RTPMEM_TYPE_BUFFER_SOURCESNAPSHOT) uint8_t[newcapacity*(sizeof(RTPSourceSnapshotChunk *)+sizeof(uint32_t))];
+
+	if (newblock == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	RTPSourceSnapshotChunk **newchunks = (RTPSourceSnapshotChunk **)newblock;
+	uint32_t *newmasks = (uint32_t *)(newblock+newcapacity*sizeof(RTPSourceSnapshotChunk *));
+
+	for (int i = 0 ; i < newcapacity ; i++)
+	{
+		newchunks[i] = (i < capacity)?chunks[i]:0;
+		newmasks[i] = (i < capacity)?changedmasks[i]:0;
+	}
+	if (block)
+		RTPDeleteByteArray(block,GetMemoryManager());
+	block = newblock;
+	chunks = newchunks;
+	changedmasks = newmasks;
+	capacity = newcapacity;
+	return 0;
+}
+
+} // end namespace
@@ -0,0 +1,228 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpsourcesnapshot.h
+ */
+
+#ifndef RTPSOURCESNAPSHOT_H
+
+#define RTPSOURCESNAPSHOT_H
+
+#include "rtpconfig.h"
+#include "rtptypes.h"
+#include "rtptimeutilities.h"
+#include "rtpmemoryobject.h"
+#include "rtpatomic.h"
+
+#define RTPSOURCESNAPSHOT_CHUNKSIZE						32
+
+namespace jrtplib
+{
+
+class RTPSourceData;
+class RTPSourceReportTable;
+class RTPSourceSnapshotTable;
+
+/** Contains a copy of the most important statistics of a participant.
+ *  Contains a copy of the most important statistics of a participant, as they were at the time the
+ *  RTPSourceSnapshot it belongs to was created. The member functions have the same names as
+ *  their counterparts in RTPSourceData.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSourceStatistics
+{
+public:
+	RTPSourceStatistics();
+
+	/** Copies the statistics of \c srcdat. */
+	void Set(const RTPSourceData *srcdat);
+
+	/** Returns the SSRC identifier of the participant. */
+	uint32_t GetSSRC() const								{ return ssrc; }
+
+	/** Returns \c true if the participant is the local one. */
+	bool IsOwnSSRC() const									{ return ownssrc; }
+
+	/** Returns \c true if the participant was only added to the table because it was in a CSRC list. */
+	bool IsCSRC() const									{ return iscsrc; }
+
+	/** Returns \c true if the participant was a sender. */
+	bool IsSender() const									{ return issender; }
+
+	/** Returns \c true if the participant was validated. */
+	bool IsValidated() const								{ return validated; }
+
+	/** Returns \c true if the participant was validated and hadn't sent a BYE packet yet. */
+	bool IsActive() const									{ return (validated && !receivedbye); }
+
+	/** Returns \c true if a BYE packet had been received from the participant. */
+	bool ReceivedBYE() const								{ return receivedbye; }
+
+	/** Returns the number of RTP packets received from the participant. */
+	uint32_t INF_GetNumPacketsReceived() const						{ return numpacketsreceived; }
+
+	/** Returns the extended highest sequence number received from the participant. */
+	uint32_t INF_GetExtendedHighestSequenceNumber() const					{ return exthighseqnr; }
+
+	/** Returns the current jitter value for the participant. */
+	uint32_t INF_GetJitter() const								{ return jitter; }
+
+	/** Returns the time at which something was last heard from the participant. */
+	RTPTime INF_GetLastMessageTime() const							{ return lastmsgtime; }
+
+	/** Returns the time at which the last RTP packet of the participant was received. */
+	RTPTime INF_GetLastRTPPacketTime() const						{ return lastrtptime; }
+
+	/** Returns \c true if a sender report had been received from the participant. */
+	bool SR_HasInfo() const									{ return srhasinfo; }
+
+	/** Returns the packet count from the last sender report. */
+	uint32_t SR_GetPacketCount() const							{ return srpacketcount; }
+
+	/** Returns the byte count from the last sender report. */
+	uint32_t SR_GetByteCount() const							{ return srbytecount; }
+
+	/** Returns \c true if the participant had sent a report block about the local participant. */
+	bool RR_HasInfo() const									{ return rrhasinfo; }
+
+	/** Returns the fraction lost value from the last report block about the local participant. */
+	double RR_GetFractionLost() const							{ return rrfractionlost; }
+
+	/** Returns the number of lost packets from the last report block about the local participant. */
+	int32_t RR_GetPacketsLost() const							{ return rrpacketslost; }
+
+	/** Returns the jitter value from the last report block about the local participant. */
+	uint32_t RR_GetJitter() const								{ return rrjitter; }
+private:
+	uint32_t ssrc;
+	bool ownssrc,iscsrc,issender,validated,receivedbye;
+	uint32_t numpacketsreceived,exthighseqnr,jitter;
+	RTPTime lastmsgtime,lastrtptime;
+	bool srhasinfo;
+	uint32_t srpacketcount,srbytecount;
+	bool rrhasinfo;
+	double rrfractionlost;
+	int32_t rrpacketslost;
+	uint32_t rrjitter;
+};
+
+/** A block of RTPSOURCESNAPSHOT_CHUNKSIZE consecutive records, which can be shared by several snapshots. */
+class JRTPLIB_IMPORTEXPORT RTPSourceSnapshotChunk
+{
+	JRTPLIB_NO_COPY(RTPSourceSnapshotChunk)
+public:
+	RTPSourceSnapshotChunk() : refcount(1)							{ }
+private:
+	friend class RTPSourceSnapshot;
+	friend class RTPSourceSnapshotTable;
+
+	static void Release(RTPSourceSnapshotChunk *chunk,RTPMemoryManager *mgr);
+
+	RTPAtomicInteger refcount;
+	RTPSourceStatistics sources[RTPSOURCESNAPSHOT_CHUNKSIZE];
+};
+
+/** A read-only copy of the statistics of all participants in a session.
+ *  A read-only copy of the statistics of all participants in a session, which can be obtained
+ *  using RTPSession::GetSourceSnapshot. Since the instance is never changed after it has been
+ *  created, it can be used by any number of threads without any locking, while the session
+ *  continues to process packets. When it is no longer needed, RTPSession::ReleaseSourceSnapshot
+ *  should be called.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSourceSnapshot : public RTPMemoryObject
+{
+	JRTPLIB_NO_COPY(RTPSourceSnapshot)
+public:
+	RTPSourceSnapshot(const RTPTime &creationtime,RTPMemoryManager *mgr = 0);
+	~RTPSourceSnapshot();
+
+	/** Returns the time at which the snapshot was created. */
+	RTPTime GetCreationTime() const								{ return creationtime; }
+
+	/** Returns the number of participants in the snapshot. */
+	int GetNumberOfSources() const								{ return numsources; }
+
+	/** Returns the statistics of the participant at position \c idx, which must be smaller than
+	 *  the value returned by RTPSourceSnapshot::GetNumberOfSources. */
+	const RTPSourceStatistics &GetSource(int idx) const					{ return chunks[idx/RTPSOURCESNAPSHOT_CHUNKSIZE]->sources[idx%RTPSOURCESNAPSHOT_CHUNKSIZE]; }
+private:
+	friend class RTPSourceSnapshotTable;
+	friend class RTPSession;
+
+	int Init(int numsrcs,RTPSourceSnapshotChunk **chks,int numchks);
+
+	RTPTime creationtime;
+	RTPSourceSnapshotChunk **chunks;
+	int numchunks;
+	int numsources;
+	int refcount; // protected by a mutex of the session
+};
+
+/** Keeps the records from which RTPSourceSnapshot instances are made up to date.
+ *  Keeps the records from which RTPSourceSnapshot instances are made up to date, using the same
+ *  slots as RTPSourceReportTable. The records are stored in chunks which are shared by the table
+ *  and the snapshots. When a new snapshot is made, only the records that were marked as changed
+ *  are copied again; a chunk is only duplicated when one of its records changed while an older
+ *  snapshot still uses it. The table is kept up to date by RTPSources.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSourceSnapshotTable : public RTPMemoryObject
+{
+	JRTPLIB_NO_COPY(RTPSourceSnapshotTable)
+public:
+	RTPSourceSnapshotTable(RTPMemoryManager *mgr = 0);
+	~RTPSourceSnapshotTable();
+
+	/** Marks the record in \c slot as changed; this is also needed for the slot that was freed when a participant was removed. */
+	void MarkChanged(int slot)									{ changed = true; if (slot < numrecords) changedmasks[slot/RTPSOURCESNAPSHOT_CHUNKSIZE] |= (uint32_t)1 << (slot%RTPSOURCESNAPSHOT_CHUNKSIZE); }
+
+	/** Returns \c true if a record was marked as changed since the last snapshot was made. */
+	bool HasChanges() const										{ return changed; }
+
+	/** Makes a new snapshot of the participants in \c table, with creation time \c t, and stores it in \c snapshot. */
+	int CreateSnapshot(const RTPSourceReportTable &table,const RTPTime &t,RTPSourceSnapshot **snapshot);
+
+	/** Removes all records. */
+	void Clear();
+private:
+	int Resize(int newcapacity);
+
+	uint8_t *block;
+	RTPSourceSnapshotChunk **chunks;
+	uint32_t *changedmasks;
+	int capacity;
+	int numrecords; // the number of records at the time of the last snapshot
+	bool changed;
+};
+
+} // end namespace
+
+#endif // RTPSOURCESNAPSHOT_H
@@ -0,0 +1,168 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpsourcetimeoutlist.h
+ */
+
+#ifndef RTPSOURCETIMEOUTLIST_H
+
+#define RTPSOURCETIMEOUTLIST_H
+
+#include "rtpconfig.h"
+#include "rtptimeutilities.h"
+#include <stddef.h>
+
+namespace jrtplib
+{
+
+class RTPInternalSourceData;
+
+/** Places a source in an RTPSourceTimeoutList; each source embeds one link per list. */
+class JRTPLIB_IMPORTEXPORT RTPSourceTimeoutLink
+{
+public:
+	RTPSourceTimeoutLink() : source(0), prev(0), next(0), inlist(false), time(0, 0)	{ }
+
+	/** The source this link belongs to. */
+	RTPInternalSourceData *source;
+
+	RTPSourceTimeoutLink *prev, *next;
+	bool inlist;
+
+	/** The time of the last event for this source, which determines its place in the list. */
+	RTPTime time;
+};
+
+/** Keeps sources ordered on the time of their last event of a specific kind.
+ *  Keeps sources ordered on the time of their last event of a specific kind, for example
+ *  the time at which the last RTP packet was received. The oldest source is at the front.
+ *  Because all sources are checked against the same timeout value, the sources which have
+ *  timed out are always found at the front of the list, so checking for timeouts only costs
+ *  as much as the number of sources that actually expire. Since the events mostly arrive in
+ *  chronological order, updating the time of a source usually just moves it to the back.
+ *  The list does not own the links, a source must be removed before it is deleted.
+ */
+class JRTPLIB_IMPORTEXPORT RTPSourceTimeoutList
+{
+public:
+	RTPSourceTimeoutList() : first(0), last(0), count(0)						{ }
+
+	/** Stores time \c t in \c link and (re)positions it in the list. */
+	void Update(RTPSourceTimeoutLink &link, const RTPTime &t);
+
+	/** Removes \c link from the list, if it is present. */
+	void Remove(RTPSourceTimeoutLink &link);
+
+	/** Forgets about all links; only use this when the sources themselves are being deleted. */
+	void Clear()											{ first = 0; last = 0; count = 0; }
+
+	/** Returns the link with the oldest time, or NULL if the list is empty. */
+	RTPSourceTimeoutLink *GetFirst() const								{ return first; }
+
+	/** Returns the number of sources in the list. */
+	size_t GetCount() const										{ return count; }
+private:
+	void Unlink(RTPSourceTimeoutLink &link);
+
+	RTPSourceTimeoutLink *first, *last;
+	size_t count;
+};
+
+inline void RTPSourceTimeoutList::Unlink(RTPSourceTimeoutLink &link)
+{
+	if (link.prev)
+		link.prev->next = link.next;
+	else
+		first = link.next;
+	if (link.next)
+		link.next->prev = link.prev;
+	else
+		last = link.prev;
+	link.prev = 0;
+	link.next = 0;
+	link.inlist = false;
+	count--;
+}
+
+inline void RTPSourceTimeoutList::Update(RTPSourceTimeoutLink &link, const RTPTime &t)
+{
+	if (link.inlist)
+	{
+		// Nothing changes if the time is the same, or if this is already the
+		// newest entry and the time only advanced
+		if (link.next == 0 && link.time <= t)
+		{
+			link.time = t;
+			return;
+		}
+		if (link.time <= t && link.time >= t)
+			return;
+		Unlink(link);
+	}
+
+	link.time = t;
+
+	// Look for the place to insert, starting with the newest entry
+	RTPSourceTimeoutLink *prev = last;
+	while (prev != 0 && t < prev->time)
+		prev = prev->prev;
+
+	link.prev = prev;
+	if (prev)
+	{
+		link.next = prev->next;
+		prev->next = &link;
+	}
+	else
+	{
+		link.next = first;
+		first = &link;
+	}
+	if (link.next)
+		link.next->prev = &link;
+	else
+		last = &link;
+	link.inlist = true;
+	count++;
+}
+
+inline void RTPSourceTimeoutList::Remove(RTPSourceTimeoutLink &link)
+{
+	if (link.inlist)
+		Unlink(link);
+}
+
+} // end namespace
+
+#endif // RTPSOURCETIMEOUTLIST_H
+
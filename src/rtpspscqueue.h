@@ -0,0 +1,201 @@
+/*
+
+  This file is a part of JRTPLIB
+  Copyright (c) 1999-2017 Jori Liesenborgs
+
+  Contact: jori.liesenborgs@gmail.com
+
+  This library was developed at the Expertise Centre for Digital Media
+  (http://www.edm.uhasselt.be), a research center of the Hasselt University
+  (http://www.uhasselt.be). The library is based upon work done for 
+  my thesis at the School for Knowledge Technology (Belgium/The Netherlands).
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  IN THE SOFTWARE.
+
+*/
+
+/**
+ * \file rtpspscqueue.h
+ */
+
+#ifndef RTPSPSCQUEUE_H
+
+#define RTPSPSCQUEUE_H
+
+#include "rtpconfig.h"
+#include "rtperrors.h"
+#include "rtpmemorymanager.h"
+#include "rtpatomic.h"
+
+#define RTPSPSCQUEUE_MAXSIZE								16777216
+#define RTPSPSCQUEUE_CACHELINESIZE							64
+
+namespace jrtplib
+{
+
+/** A bounded lock-free queue with a single producer and a single consumer.
+ *  A bounded lock-free queue with a single producer and a single consumer. The elements are
+ *  stored in a ring buffer which is allocated by RTPSPSCQueue::Init, using the memory manager with
+ *  memory type \c RTPMEM_TYPE_BUFFER_SPSCQUEUE. One thread may call RTPSPSCQueue::Push while
+ *  another one calls RTPSPSCQueue::Pop: neither of them ever waits for the other, and when the
+ *  queue is full, RTPSPSCQueue::Push simply fails. The elements are copied as plain memory, so
+ *  \c Element should be a simple type like a pointer. The queue does not take ownership of the
+ *  elements: remaining elements should be popped before the queue is destroyed.
+ */
+template<class Element>
+class RTPSPSCQueue
+{
+	JRTPLIB_NO_COPY(RTPSPSCQueue)
+public:
+	RTPSPSCQueue(RTPMemoryManager *mgr);
+	~RTPSPSCQueue();
+
+	/** Allocates room for at least \c size elements; the size is rounded up to a power of two
+	 *  and may not exceed \c RTPSPSCQUEUE_MAXSIZE. */
+	int Init(size_t size);
+
+	/** Releases the ring buffer, any elements that are still in the queue are discarded. */
+	void Destroy();
+
+	/** Returns \c true if RTPSPSCQueue::Init has been called successfully. */
+	bool IsInitialized() const										{ return (elements != 0); }
+
+	/** Adds \c e to the queue, returns \c false if the queue is full; may only be called by the producer. */
+	bool Push(const Element &e);
+
+	/** Stores the oldest element in \c e and removes it from the queue, returns \c false if the
+	 *  queue was empty; may only be called by the consumer. */
+	bool Pop(Element *e);
+
+	/** Returns the number of elements in the queue. */
+	uint32_t GetCount() const										{ return (uint32_t)tail.Get()-(uint32_t)head.Get(); }
+
+	/** Returns the number of elements the queue can hold. */
+	uint32_t GetCapacity() const									{ return (elements)?(mask+1):0; }
+private:
+	RTPMemoryManager *mgr;
+	Element *elements;
+	uint32_t mask;
+
+	// The producer and the consumer both keep a private copy of the position that
+	// the other one advances, and only read the shared one when the copy says that
+	// the queue is full or empty. Both sets of variables are kept in different cache
+	// lines, so that the two threads don't invalidate each other's cache on each call.
+
+	uint8_t padding1[RTPSPSCQUEUE_CACHELINESIZE];
+	RTPAtomicInteger tail;
+	uint32_t writepos,cachedhead;
+
+	uint8_t padding2[RTPSPSCQUEUE_CACHELINESIZE];
+	RTPAtomicInteger head;
+	uint32_t readpos,cachedtail;
+	uint8_t padding3[RTPSPSCQUEUE_CACHELINESIZE];
+};
+
+template<class Element>
+inline RTPSPSCQueue<Element>::RTPSPSCQueue(RTPMemoryManager *m) : mgr(m)
+{
+	elements = 0;
+	mask = 0;
+	writepos = 0;
+	cachedhead = 0;
+	readpos = 0;
+	cachedtail = 0;
+}
+
+template<class Element>
+inline RTPSPSCQueue<Element>::~RTPSPSCQueue()
+{
+	Destroy();
+}
+
+template<class Element>
+inline int RTPSPSCQueue<Element>::Init(size_t size)
+{
+	if (size == 0 || size > RTPSPSCQUEUE_MAXSIZE)
+		return ERR_RTP_SPSCQUEUE_INVALIDSIZE;
+
+	uint32_t capacity = 2;
+
+	while (capacity < size)
+		capacity <<= 1;
+
+	Element *newelements = (Element *)RTPNew(mgr,RTPMEM_TYPE_BUFFER_SPSCQUEUE) uint8_t[sizeof(Element)*capacity];
+	if (newelements == 0)
+		return ERR_RTP_OUTOFMEM;
+
+	Destroy();
+	elements = newelements;
+	mask = capacity-1;
+	return 0;
+}
+
+template<class Element>
+inline void RTPSPSCQueue<Element>::Destroy()
+{
+	if (elements)
+		RTPDeleteByteArray((uint8_t *)elements,mgr);
+	elements = 0;
+	mask = 0;
+	writepos = 0;
+	cachedhead = 0;
+	readpos = 0;
+	cachedtail = 0;
+	tail.Set(0);
+	head.Set(0);
+}
+
+template<class Element>
+inline bool RTPSPSCQueue<Element>::Push(const Element &e)
+{
+	if (writepos-cachedhead > mask)
+	{
+		cachedhead = (uint32_t)head.Get();
+		if (writepos-cachedhead > mask)
+			return false;
+	}
+
+	elements[writepos&mask] = e;
+	writepos++;
+
+	// The element must be stored completely before the consumer can see the
+	// new position; the atomic store takes care of that
+	tail.Set((int32_t)writepos);
+	return true;
+}
+
+template<class Element>
+inline bool RTPSPSCQueue<Element>::Pop(Element *e)
+{
+	if (readpos == cachedtail)
+	{
+		cachedtail = (uint32_t)tail.Get();
+		if (readpos == cachedtail)
+			return false;
+	}
+
+	*e = elements[readpos&mask];
+	readpos++;
+	head.Set((int32_t)readpos);
+	return true;
+}
+
+} // end namespace
+
+#endif // RTPSPSCQUEUE_H
@@ -63,6 +63,11 @@ bool RTPTCPAddress::IsFromSameHost(const RTPAddress *addr) const
 	return IsSameAddress(addr);
 }
 
+uint32_t RTPTCPAddress::GetHashValue() const
+{
+	return (uint32_t)m_socket;
+}
+
 RTPAddress *RTPTCPAddress::CreateCopy(RTPMemoryManager *mgr) const
 {
 	JRTPLIB_UNUSED(mgr); // possibly unused
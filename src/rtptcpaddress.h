@@ -73,6 +73,7 @@ public:
 	// Note that these functions are only used for received packets
 	bool IsSameAddress(const RTPAddress *addr) const;
 	bool IsFromSameHost(const RTPAddress *addr) const;
+	uint32_t GetHashValue() const;
 #ifdef RTPDEBUG
 	std::string GetAddressString() const;
 #endif // RTPDEBUG
@@ -42,6 +42,10 @@
 #include "rtptypes.h"
 #include "rtpmemoryobject.h"
 #include "rtptimeutilities.h"
+#include "rtperrors.h"
+
+/** The maximum number of parts a packet may consist of in RTPTransmitter::SendRTPDataGather. */
+#define RTPTRANSMITTER_MAXGATHERPARTS				16
 
 namespace jrtplib
 {
@@ -52,6 +56,24 @@ class RTPTransmissionParams;
 class RTPTime;
 class RTPTransmissionInfo;
 
+/** Describes a block of data which is passed to one of the batched send functions.
+ *  Describes a block of data which is passed to one of the batched send functions, like
+ *  RTPTransmitter::SendRTPDataBatch. The data is not copied, it only needs to be valid
+ *  during the call to the send function.
+ */
+class JRTPLIB_IMPORTEXPORT RTPDataSpan
+{
+public:
+	RTPDataSpan() : data(0), length(0)								{ }
+	RTPDataSpan(const void *d, size_t len) : data(d), length(len)					{ }
+
+	/** Points to the data of the packet. */
+	const void *data;
+
+	/** The length of the packet. */
+	size_t length;
+};
+
 /** Abstract class from which actual transmission components should be derived.
  *  Abstract class from which actual transmission components should be derived.
  *  The abstract class RTPTransmitter specifies the interface for
@@ -73,7 +95,9 @@ public:
 		IPv6UDPProto, /**< Specifies the internal UDP over IPv6 transmitter. */
 		TCPProto, /**< Specifies the internal TCP transmitter. */
 		ExternalProto, /**< Specifies the transmitter which can send packets using an external mechanism, and which can have received packets injected into it - see RTPExternalTransmitter for additional information. */
-		UserDefinedProto  /**< Specifies a user defined, external transmitter. */
+		UserDefinedProto,  /**< Specifies a user defined, external transmitter. */
+		PacketRingProto, /**< Specifies the receive-only transmitter which uses a memory mapped AF_PACKET ring (Linux only) - see RTPPacketRingTransmitter. */
+		LoopbackProto /**< Specifies the transmitter which exchanges packets with other sessions in the same process through memory - see RTPLoopbackTransmitter. */
 	};
 
 	/** Three kind of receive modes can be specified. */
@@ -160,6 +184,41 @@ public:
 	/** Send a packet with length \c len containing \c data to all RTCP addresses of the current destination list. */
 	virtual int SendRTCPData(const void *data,size_t len) = 0;
 
+	/** Sends the \c numpackets packets described by \c packets to all RTP addresses of the current destination list.
+	 *  Sends the \c numpackets packets described by \c packets to all RTP addresses of the current 
+	 *  destination list. The default implementation simply calls SendRTPData for each packet; a
+	 *  transmitter which can hand several packets to the underlying mechanism at once can override
+	 *  this. When an error occurs, the remaining packets are not sent.
+	 */
+	virtual int SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets);
+
+	/** Sends the \c numpackets packets described by \c packets to all RTCP addresses of the current destination list.
+	 *  Sends the \c numpackets packets described by \c packets to all RTCP addresses of the current 
+	 *  destination list. The default implementation simply calls SendRTCPData for each packet.
+	 */
+	virtual int SendRTCPDataBatch(const RTPDataSpan *packets, size_t numpackets);
+
+	/** Returns \c true if the transmitter can send a packet which consists of several parts without copying them first. */
+	virtual bool SupportsGatherSend()									{ return false; }
+
+	/** Sends a single packet, formed by the \c numparts parts described by \c parts, to all RTP addresses of the current destination list.
+	 *  Sends a single packet, formed by the \c numparts parts described by \c parts, to all RTP 
+	 *  addresses of the current destination list. This allows e.g. an RTP header and the payload to be 
+	 *  sent from different locations in memory, without joining them in one buffer first. At most
+	 *  RTPTRANSMITTER_MAXGATHERPARTS parts can be used. This only works if SupportsGatherSend returns 
+	 *  \c true, the default implementation returns ERR_RTP_TRANSMITTER_GATHERNOTSUPPORTED.
+	 */
+	virtual int SendRTPDataGather(const RTPDataSpan * /*parts*/, size_t /*numparts*/)		{ return ERR_RTP_TRANSMITTER_GATHERNOTSUPPORTED; }
+
+	/** Sends \c numpackets packets to all RTP addresses of the current destination list, each packet being formed by \c partsperpacket consecutive entries of \c parts.
+	 *  Sends \c numpackets packets to all RTP addresses of the current destination list, each packet 
+	 *  being formed by \c partsperpacket consecutive entries of \c parts, like in SendRTPDataGather.
+	 *  The default implementation calls SendRTPDataGather for each packet; a transmitter which can
+	 *  hand several packets to the underlying mechanism at once can override this. When an error
+	 *  occurs, the remaining packets are not sent.
+	 */
+	virtual int SendRTPDataGatherBatch(const RTPDataSpan *parts, size_t partsperpacket, size_t numpackets);
+
 	/** Adds the address specified by \c addr to the list of destinations. */
 	virtual int AddDestination(const RTPAddress &addr) = 0;
 
@@ -257,6 +316,39 @@ private:
 	RTPTransmitter::TransmissionProtocol protocol;
 };
 
+inline int RTPTransmitter::SendRTPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		int status = SendRTPData(packets[i].data, packets[i].length);
+		if (status < 0)
+			return status;
+	}
+	return 0;
+}
+
+inline int RTPTransmitter::SendRTPDataGatherBatch(const RTPDataSpan *parts, size_t partsperpacket, size_t numpackets)
+{
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		int status = SendRTPDataGather(parts + i*partsperpacket, partsperpacket);
+		if (status < 0)
+			return status;
+	}
+	return 0;
+}
+
+inline int RTPTransmitter::SendRTCPDataBatch(const RTPDataSpan *packets, size_t numpackets)
+{
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		int status = SendRTCPData(packets[i].data, packets[i].length);
+		if (status < 0)
+			return status;
+	}
+	return 0;
+}
+
 } // end namespace
 
 #endif // RTPTRANSMITTER_H
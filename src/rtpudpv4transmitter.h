@@ -41,10 +41,11 @@
 #include "rtpconfig.h"
 #include "rtptransmitter.h"
 #include "rtpipv4destination.h"
-#include "rtphashtable.h"
-#include "rtpkeyhashtable.h"
+#include "rtpflathashtable.h"
+#include "rtpflatkeyhashtable.h"
 #include "rtpsocketutil.h"
 #include "rtpabortdescriptors.h"
+#include "rtpsharedbuffer.h"
 #include <list>
 
 #ifdef RTP_SUPPORT_THREAD
@@ -138,6 +139,14 @@ public:
 	 *  to let the transmitter create its own instance. */
 	void SetCreatedAbortDescriptors(RTPAbortDescriptors *desc) { m_pAbortDesc = desc; }
 
+	/** If non null, incoming packets which fit in the buffers of \c pool are stored in such a buffer.
+	 *  If non null, incoming packets which fit in the buffers of \c pool are stored in such a buffer,
+	 *  instead of in memory that's allocated for each packet. The resulting RTPPacket instances can then
+	 *  be shared between several consumers using RTPPacket::CreateReference. The pool is not owned
+	 *  by the transmitter and must exist until all packets that were received have been deleted.
+	 */
+	void SetReceiveBufferPool(RTPSharedBufferPool *pool)			{ receivebufferpool = pool; }
+
 	/** Returns the RTP socket's send buffer size. */
 	int GetRTPSendBuffer() const								{ return rtpsendbuf; }
 
@@ -167,6 +176,9 @@ public:
 	 *  which can be useful when creating your own poll thread for multiple
 	 *  sessions. */
 	RTPAbortDescriptors *GetCreatedAbortDescriptors() const		{ return m_pAbortDesc; }
+
+	/** Returns the pool in which incoming packets will be stored, if any. */
+	RTPSharedBufferPool *GetReceiveBufferPool() const			{ return receivebufferpool; }
 private:
 	uint16_t portbase;
 	uint32_t bindIP, mcastifaceIP;
@@ -182,6 +194,7 @@ private:
 	bool useexistingsockets;
 
 	RTPAbortDescriptors *m_pAbortDesc;
+	RTPSharedBufferPool *receivebufferpool;
 };
 
 inline RTPUDPv4TransmissionParams::RTPUDPv4TransmissionParams() : RTPTransmissionParams(RTPTransmitter::IPv4UDPProto)	
@@ -201,6 +214,7 @@ inline RTPUDPv4TransmissionParams::RTPUDPv4TransmissionParams() : RTPTransmissio
 	rtpsock = 0;
 	rtcpsock = 0;
 	m_pAbortDesc = 0;
+	receivebufferpool = 0;
 }
 
 /** Additional information about the UDP over IPv4 transmitter. */
@@ -236,13 +250,13 @@ private:
 class JRTPLIB_IMPORTEXPORT RTPUDPv4Trans_GetHashIndex_IPv4Dest
 {
 public:
-	static int GetIndex(const RTPIPv4Destination &d)							{ return d.GetIP()%RTPUDPV4TRANS_HASHSIZE; }
+	static int GetIndex(const RTPIPv4Destination &d)							{ return d.GetIP()^(((uint32_t)d.GetRTPPort_NBO())<<16); }
 };
 
 class JRTPLIB_IMPORTEXPORT RTPUDPv4Trans_GetHashIndex_uint32_t
 {
 public:
-	static int GetIndex(const uint32_t &k)									{ return k%RTPUDPV4TRANS_HASHSIZE; }
+	static int GetIndex(const uint32_t &k)									{ return k; }
 };
 
 #define RTPUDPV4TRANS_HEADERSIZE						(20+8)
@@ -277,6 +291,10 @@ public:
 	
 	int SendRTPData(const void *data,size_t len);	
 	int SendRTCPData(const void *data,size_t len);
+	bool SupportsGatherSend()								{ return true; }
+	int SendRTPDataGather(const RTPDataSpan *parts,size_t numparts);
+	int SendRTPDataBatch(const RTPDataSpan *packets,size_t numpackets);
+	int SendRTPDataGatherBatch(const RTPDataSpan *parts,size_t partsperpacket,size_t numpackets);
 
 	int AddDestination(const RTPAddress &addr);
 	int DeleteDestination(const RTPAddress &addr);
@@ -302,6 +320,7 @@ public:
 	void Dump();
 #endif // RTPDEBUG
 private:
+	int SendRTPBatch(const RTPDataSpan *parts,size_t partsperpacket,size_t numpackets);
 	int CreateLocalIPList();
 	bool GetLocalIPList_Interfaces();
 	void GetLocalIPList_DNS();
@@ -329,9 +348,9 @@ private:
 	uint8_t *localhostname;
 	size_t localhostnamelength;
 	
-	RTPHashTable<const RTPIPv4Destination,RTPUDPv4Trans_GetHashIndex_IPv4Dest,RTPUDPV4TRANS_HASHSIZE> destinations;
+	RTPFlatHashTable<const RTPIPv4Destination,RTPUDPv4Trans_GetHashIndex_IPv4Dest> destinations;
 #ifdef RTP_SUPPORT_IPV4MULTICAST
-	RTPHashTable<const uint32_t,RTPUDPv4Trans_GetHashIndex_uint32_t,RTPUDPV4TRANS_HASHSIZE> multicastgroups;
+	RTPFlatHashTable<const uint32_t,RTPUDPv4Trans_GetHashIndex_uint32_t> multicastgroups;
 #endif // RTP_SUPPORT_IPV4MULTICAST
 	std::list<RTPRawPacket*> rawpacketlist;
 
@@ -347,11 +366,12 @@ private:
 		std::list<uint16_t> portlist;
 	};
 
-	RTPKeyHashTable<const uint32_t,PortInfo*,RTPUDPv4Trans_GetHashIndex_uint32_t,RTPUDPV4TRANS_HASHSIZE> acceptignoreinfo;
+	RTPFlatKeyHashTable<const uint32_t,PortInfo*,RTPUDPv4Trans_GetHashIndex_uint32_t> acceptignoreinfo;
 
 	bool closesocketswhendone;
 	RTPAbortDescriptors m_abortDesc;
 	RTPAbortDescriptors *m_pAbortDesc; // in case an external one was specified
+	RTPSharedBufferPool *receivebufferpool;
 
 #ifdef RTP_SUPPORT_THREAD
 	jthread::JMutex mainmutex,waitmutex;
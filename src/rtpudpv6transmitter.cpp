@@ -52,6 +52,7 @@
 
 #define RTPUDPV6TRANS_MAXPACKSIZE							65535
 #define RTPUDPV6TRANS_IFREQBUFSIZE							8192
+#define RTPUDPV6TRANS_SENDBATCHSIZE							32
 
 #define RTPUDPV6TRANS_IS_MCASTADDR(x)							(x.s6_addr[0] == 0xFF)
 
@@ -85,10 +86,11 @@ namespace jrtplib
 {
 
 RTPUDPv6Transmitter::RTPUDPv6Transmitter(RTPMemoryManager *mgr) : RTPTransmitter(mgr),
-								  destinations(GetMemoryManager(),RTPMEM_TYPE_CLASS_DESTINATIONLISTHASHELEMENT),
-								  multicastgroups(GetMemoryManager(),RTPMEM_TYPE_CLASS_MULTICASTHASHELEMENT),
-								  acceptignoreinfo(GetMemoryManager(),RTPMEM_TYPE_CLASS_ACCEPTIGNOREHASHELEMENT)
+								  destinations(GetMemoryManager(),RTPMEM_TYPE_BUFFER_DESTINATIONTABLE),
+								  multicastgroups(GetMemoryManager(),RTPMEM_TYPE_BUFFER_MULTICASTTABLE),
+								  acceptignoreinfo(GetMemoryManager(),RTPMEM_TYPE_BUFFER_ACCEPTIGNORETABLE)
 {
+	receivebufferpool = 0;
 	created = false;
 	init = false;
 }
@@ -313,6 +315,7 @@ int RTPUDPv6Transmitter::Create(size_t maximumpacketsize,const RTPTransmissionPa
 	}
 
 	maxpacksize = maximumpacketsize;
+	receivebufferpool = params->GetReceiveBufferPool();
 	portbase = params->GetPortbase();
 	multicastTTL = params->GetMulticastTTL();
 	receivemode = RTPTransmitter::AcceptAll;
@@ -713,6 +716,200 @@ int RTPUDPv6Transmitter::SendRTPData(const void *data,size_t len)
 	return 0;
 }
 
+int RTPUDPv6Transmitter::SendRTPDataGather(const RTPDataSpan *parts,size_t numparts)
+{
+	if (!init)
+		return ERR_RTP_UDPV6TRANS_NOTINIT;
+	if (numparts > RTPTRANSMITTER_MAXGATHERPARTS)
+		return ERR_RTP_TRANSMITTER_TOOMANYGATHERPARTS;
+
+	// The parts are passed to the socket as they are, so the data doesn't
+	// need to be joined in a single buffer first
+
+	size_t len = 0;
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSABUF bufs[RTPTRANSMITTER_MAXGATHERPARTS];
+
+	for (size_t i = 0 ; i < numparts ; i++)
+	{
+		bufs[i].buf = (CHAR *)parts[i].data;
+		bufs[i].len = (ULONG)parts[i].length;
+		len += parts[i].length;
+	}
+#else
+	struct iovec iov[RTPTRANSMITTER_MAXGATHERPARTS];
+	struct msghdr msg;
+
+	for (size_t i = 0 ; i < numparts ; i++)
+	{
+		iov[i].iov_base = (void *)parts[i].data;
+		iov[i].iov_len = parts[i].length;
+		len += parts[i].length;
+	}
+	memset(&msg,0,sizeof(struct msghdr));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = numparts;
+	msg.msg_namelen = sizeof(struct sockaddr_in6);
+#endif // RTP_SOCKETTYPE_WINSOCK
+
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_UDPV6TRANS_NOTCREATED;
+	}
+	if (len > maxpacksize)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_UDPV6TRANS_SPECIFIEDSIZETOOBIG;
+	}
+	
+	destinations.GotoFirstElement();
+	while (destinations.HasCurrentElement())
+	{
+#ifdef RTP_SOCKETTYPE_WINSOCK
+		DWORD numsent;
+
+		WSASendTo(rtpsock,bufs,(DWORD)numparts,&numsent,0,(const struct sockaddr *)destinations.GetCurrentElement().GetRTPSockAddr(),sizeof(struct sockaddr_in6),0,0);
+#else
+		msg.msg_name = (void *)destinations.GetCurrentElement().GetRTPSockAddr();
+		sendmsg(rtpsock,&msg,0);
+#endif // RTP_SOCKETTYPE_WINSOCK
+		destinations.GotoNextElement();
+	}
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
+int RTPUDPv6Transmitter::SendRTPDataBatch(const RTPDataSpan *packets,size_t numpackets)
+{
+	return SendRTPBatch(packets,1,numpackets);
+}
+
+int RTPUDPv6Transmitter::SendRTPDataGatherBatch(const RTPDataSpan *parts,size_t partsperpacket,size_t numpackets)
+{
+	return SendRTPBatch(parts,partsperpacket,numpackets);
+}
+
+int RTPUDPv6Transmitter::SendRTPBatch(const RTPDataSpan *parts,size_t partsperpacket,size_t numpackets)
+{
+	if (!init)
+		return ERR_RTP_UDPV6TRANS_NOTINIT;
+	if (partsperpacket == 0 || partsperpacket > RTPTRANSMITTER_MAXGATHERPARTS)
+		return ERR_RTP_TRANSMITTER_TOOMANYGATHERPARTS;
+
+	MAINMUTEX_LOCK
+	
+	if (!created)
+	{
+		MAINMUTEX_UNLOCK
+		return ERR_RTP_UDPV6TRANS_NOTCREATED;
+	}
+	for (size_t i = 0 ; i < numpackets ; i++)
+	{
+		size_t len = 0;
+
+		for (size_t j = 0 ; j < partsperpacket ; j++)
+			len += parts[i*partsperpacket+j].length;
+		if (len > maxpacksize)
+		{
+			MAINMUTEX_UNLOCK
+			return ERR_RTP_UDPV6TRANS_SPECIFIEDSIZETOOBIG;
+		}
+	}
+
+#ifdef RTP_HAVE_SENDMMSG
+	// The packets are handed to the kernel in groups, using a single system
+	// call for each group and destination
+
+	struct iovec iov[RTPUDPV6TRANS_SENDBATCHSIZE*RTPTRANSMITTER_MAXGATHERPARTS];
+	struct mmsghdr msgs[RTPUDPV6TRANS_SENDBATCHSIZE];
+
+	for (size_t first = 0 ; first < numpackets ; first += RTPUDPV6TRANS_SENDBATCHSIZE)
+	{
+		size_t num = numpackets-first;
+		if (num > RTPUDPV6TRANS_SENDBATCHSIZE)
+			num = RTPUDPV6TRANS_SENDBATCHSIZE;
+
+		memset(msgs,0,sizeof(struct mmsghdr)*num);
+		for (size_t i = 0 ; i < num ; i++)
+		{
+			for (size_t j = 0 ; j < partsperpacket ; j++)
+			{
+				const RTPDataSpan &part = parts[(first+i)*partsperpacket+j];
+
+				iov[i*partsperpacket+j].iov_base = (void *)part.data;
+				iov[i*partsperpacket+j].iov_len = part.length;
+			}
+			msgs[i].msg_hdr.msg_iov = iov+i*partsperpacket;
+			msgs[i].msg_hdr.msg_iovlen = partsperpacket;
+			msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+		}
+
+		destinations.GotoFirstElement();
+		while (destinations.HasCurrentElement())
+		{
+			void *addr = (void *)destinations.GetCurrentElement().GetRTPSockAddr();
+			size_t numsent = 0;
+
+			for (size_t i = 0 ; i < num ; i++)
+				msgs[i].msg_hdr.msg_name = addr;
+			while (numsent < num)
+			{
+				int status = sendmmsg(rtpsock,msgs+numsent,(unsigned int)(num-numsent),0);
+
+				// As with sendto, errors are ignored: just skip the packet that failed
+				if (status <= 0)
+					status = 1;
+				numsent += (size_t)status;
+			}
+			destinations.GotoNextElement();
+		}
+	}
+#else
+	destinations.GotoFirstElement();
+	while (destinations.HasCurrentElement())
+	{
+		for (size_t i = 0 ; i < numpackets ; i++)
+		{
+			const RTPDataSpan *packetparts = parts+i*partsperpacket;
+#ifdef RTP_SOCKETTYPE_WINSOCK
+			WSABUF bufs[RTPTRANSMITTER_MAXGATHERPARTS];
+			DWORD numsent;
+
+			for (size_t j = 0 ; j < partsperpacket ; j++)
+			{
+				bufs[j].buf = (CHAR *)packetparts[j].data;
+				bufs[j].len = (ULONG)packetparts[j].length;
+			}
+			WSASendTo(rtpsock,bufs,(DWORD)partsperpacket,&numsent,0,(const struct sockaddr *)destinations.GetCurrentElement().GetRTPSockAddr(),sizeof(struct sockaddr_in6),0,0);
+#else
+			struct iovec iov[RTPTRANSMITTER_MAXGATHERPARTS];
+			struct msghdr msg;
+
+			for (size_t j = 0 ; j < partsperpacket ; j++)
+			{
+				iov[j].iov_base = (void *)packetparts[j].data;
+				iov[j].iov_len = packetparts[j].length;
+			}
+			memset(&msg,0,sizeof(struct msghdr));
+			msg.msg_iov = iov;
+			msg.msg_iovlen = partsperpacket;
+			msg.msg_name = (void *)destinations.GetCurrentElement().GetRTPSockAddr();
+			msg.msg_namelen = sizeof(struct sockaddr_in6);
+			sendmsg(rtpsock,&msg,0);
+#endif // RTP_SOCKETTYPE_WINSOCK
+		}
+		destinations.GotoNextElement();
+	}
+#endif // RTP_HAVE_SENDMMSG
+	
+	MAINMUTEX_UNLOCK
+	return 0;
+}
+
 int RTPUDPv6Transmitter::SendRTCPData(const void *data,size_t len)
 {
 	if (!init)
@@ -1293,11 +1490,28 @@ int RTPUDPv6Transmitter::PollSocket(bool rtp)
 				addr = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPADDRESS) RTPIPv6Address(srcaddr.sin6_addr,ntohs(srcaddr.sin6_port));
 				if (addr == 0)
 					return ERR_RTP_OUTOFMEM;
-				datacopy = RTPNew(GetMemoryManager(),(rtp)?RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[recvlen];
-				if (datacopy == 0)
+				// Store the packet in a shared buffer if possible, so that it can be
+				// handed to several consumers without copying it
+				RTPSharedBuffer *sharedbuf = 0;
+
+				if (receivebufferpool != 0 && (size_t)recvlen <= receivebufferpool->GetBufferSize())
 				{
-					RTPDelete(addr,GetMemoryManager());
-					return ERR_RTP_OUTOFMEM;
+					sharedbuf = receivebufferpool->GetBuffer();
+					if (sharedbuf == 0)
+					{
+						RTPDelete(addr,GetMemoryManager());
+						return ERR_RTP_OUTOFMEM;
+					}
+					datacopy = sharedbuf->GetData();
+				}
+				else
+				{
+					datacopy = RTPNew(GetMemoryManager(),(rtp)?RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET:RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET) uint8_t[recvlen];
+					if (datacopy == 0)
+					{
+						RTPDelete(addr,GetMemoryManager());
+						return ERR_RTP_OUTOFMEM;
+					}
 				}
 				memcpy(datacopy,packetbuffer,recvlen);
 				
@@ -1305,9 +1519,14 @@ int RTPUDPv6Transmitter::PollSocket(bool rtp)
 				if (pack == 0)
 				{
 					RTPDelete(addr,GetMemoryManager());
-					RTPDeleteByteArray(datacopy,GetMemoryManager());
+					if (sharedbuf)
+						sharedbuf->Release();
+					else
+						RTPDeleteByteArray(datacopy,GetMemoryManager());
 					return ERR_RTP_OUTOFMEM;
 				}
+				if (sharedbuf)
+					pack->SetDataFreeCallback(RTPSharedBuffer::ReleaseData,sharedbuf);
 				rawpacketlist.push_back(pack);	
 			}
 		}
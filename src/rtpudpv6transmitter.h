@@ -44,10 +44,11 @@
 
 #include "rtptransmitter.h"
 #include "rtpipv6destination.h"
-#include "rtphashtable.h"
-#include "rtpkeyhashtable.h"
+#include "rtpflathashtable.h"
+#include "rtpflatkeyhashtable.h"
 #include "rtpsocketutil.h"
 #include "rtpabortdescriptors.h"
+#include "rtpsharedbuffer.h"
 #include <string.h>
 #include <list>
 
@@ -125,6 +126,14 @@ public:
 	 *  to let the transmitter create its own instance. */
 	void SetCreatedAbortDescriptors(RTPAbortDescriptors *desc) { m_pAbortDesc = desc; }
 
+	/** If non null, incoming packets which fit in the buffers of \c pool are stored in such a buffer.
+	 *  If non null, incoming packets which fit in the buffers of \c pool are stored in such a buffer,
+	 *  instead of in memory that's allocated for each packet. The resulting RTPPacket instances can then
+	 *  be shared between several consumers using RTPPacket::CreateReference. The pool is not owned
+	 *  by the transmitter and must exist until all packets that were received have been deleted.
+	 */
+	void SetReceiveBufferPool(RTPSharedBufferPool *pool)			{ receivebufferpool = pool; }
+
 	/** Returns the RTP socket's send buffer size. */
 	int GetRTPSendBuffer() const								{ return rtpsendbuf; }
 
@@ -141,6 +150,9 @@ public:
 	 *  which can be useful when creating your own poll thread for multiple
 	 *  sessions. */
 	RTPAbortDescriptors *GetCreatedAbortDescriptors() const		{ return m_pAbortDesc; }
+
+	/** Returns the pool in which incoming packets will be stored, if any. */
+	RTPSharedBufferPool *GetReceiveBufferPool() const			{ return receivebufferpool; }
 private:
 	uint16_t portbase;
 	in6_addr bindIP;
@@ -151,6 +163,7 @@ private:
 	int rtcpsendbuf, rtcprecvbuf;
 
 	RTPAbortDescriptors *m_pAbortDesc;
+	RTPSharedBufferPool *receivebufferpool;
 };
 
 inline RTPUDPv6TransmissionParams::RTPUDPv6TransmissionParams()
@@ -168,6 +181,7 @@ inline RTPUDPv6TransmissionParams::RTPUDPv6TransmissionParams()
 	rtcprecvbuf = RTPUDPV6TRANS_RTCPRECEIVEBUFFER; 
 
 	m_pAbortDesc = 0;
+	receivebufferpool = 0;
 }
 
 /** Additional information about the UDP over IPv6 transmitter. */
@@ -203,13 +217,13 @@ private:
 class JRTPLIB_IMPORTEXPORT RTPUDPv6Trans_GetHashIndex_IPv6Dest
 {
 public:
-	static int GetIndex(const RTPIPv6Destination &d)					{ in6_addr ip = d.GetIP(); return ((((uint32_t)ip.s6_addr[12])<<24)|(((uint32_t)ip.s6_addr[13])<<16)|(((uint32_t)ip.s6_addr[14])<<8)|((uint32_t)ip.s6_addr[15]))%RTPUDPV6TRANS_HASHSIZE; }
+	static int GetIndex(const RTPIPv6Destination &d)					{ in6_addr ip = d.GetIP(); return ((((uint32_t)ip.s6_addr[12])<<24)|(((uint32_t)ip.s6_addr[13])<<16)|(((uint32_t)ip.s6_addr[14])<<8)|((uint32_t)ip.s6_addr[15])); }
 };
 
 class JRTPLIB_IMPORTEXPORT RTPUDPv6Trans_GetHashIndex_in6_addr
 {
 public:
-	static int GetIndex(const in6_addr &ip)							{ return ((((uint32_t)ip.s6_addr[12])<<24)|(((uint32_t)ip.s6_addr[13])<<16)|(((uint32_t)ip.s6_addr[14])<<8)|((uint32_t)ip.s6_addr[15]))%RTPUDPV6TRANS_HASHSIZE; }
+	static int GetIndex(const in6_addr &ip)							{ return ((((uint32_t)ip.s6_addr[12])<<24)|(((uint32_t)ip.s6_addr[13])<<16)|(((uint32_t)ip.s6_addr[14])<<8)|((uint32_t)ip.s6_addr[15])); }
 };
 
 #define RTPUDPV6TRANS_HEADERSIZE								(40+8)
@@ -244,6 +258,10 @@ public:
 	
 	int SendRTPData(const void *data,size_t len);	
 	int SendRTCPData(const void *data,size_t len);
+	bool SupportsGatherSend()								{ return true; }
+	int SendRTPDataGather(const RTPDataSpan *parts,size_t numparts);
+	int SendRTPDataBatch(const RTPDataSpan *packets,size_t numpackets);
+	int SendRTPDataGatherBatch(const RTPDataSpan *parts,size_t partsperpacket,size_t numpackets);
 
 	int AddDestination(const RTPAddress &addr);
 	int DeleteDestination(const RTPAddress &addr);
@@ -269,6 +287,7 @@ public:
 	void Dump();
 #endif // RTPDEBUG
 private:
+	int SendRTPBatch(const RTPDataSpan *parts,size_t partsperpacket,size_t numpackets);
 	int CreateLocalIPList();
 	bool GetLocalIPList_Interfaces();
 	void GetLocalIPList_DNS();
@@ -297,9 +316,9 @@ private:
 	uint8_t *localhostname;
 	size_t localhostnamelength;
 	
-	RTPHashTable<const RTPIPv6Destination,RTPUDPv6Trans_GetHashIndex_IPv6Dest,RTPUDPV6TRANS_HASHSIZE> destinations;
+	RTPFlatHashTable<const RTPIPv6Destination,RTPUDPv6Trans_GetHashIndex_IPv6Dest> destinations;
 #ifdef RTP_SUPPORT_IPV6MULTICAST
-	RTPHashTable<const in6_addr,RTPUDPv6Trans_GetHashIndex_in6_addr,RTPUDPV6TRANS_HASHSIZE> multicastgroups;
+	RTPFlatHashTable<const in6_addr,RTPUDPv6Trans_GetHashIndex_in6_addr> multicastgroups;
 #endif // RTP_SUPPORT_IPV6MULTICAST
 	std::list<RTPRawPacket*> rawpacketlist;
 
@@ -315,9 +334,10 @@ private:
 		std::list<uint16_t> portlist;
 	};
 
-	RTPKeyHashTable<const in6_addr,PortInfo*,RTPUDPv6Trans_GetHashIndex_in6_addr,RTPUDPV6TRANS_HASHSIZE> acceptignoreinfo;
+	RTPFlatKeyHashTable<const in6_addr,PortInfo*,RTPUDPv6Trans_GetHashIndex_in6_addr> acceptignoreinfo;
 	RTPAbortDescriptors m_abortDesc;
 	RTPAbortDescriptors *m_pAbortDesc;
+	RTPSharedBufferPool *receivebufferpool;
 
 #ifdef RTP_SUPPORT_THREAD
 	jthread::JMutex mainmutex,waitmutex;
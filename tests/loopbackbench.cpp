@@ -0,0 +1,184 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+using namespace jrtplib;
+using namespace std;
+
+// Connects a number of sessions through an in-memory network and measures the
+// cost of the library itself per packet: building, sending, parsing, source
+// lookup, statistics and delivery to the application, without any sockets
+
+void createsession(RTPSession &sess, RTPLoopbackNetwork &network, uint16_t portbase, const RTPTime &delay)
+{
+	RTPLoopbackTransmissionParams transParams(&network);
+
+	transParams.SetPortbase(portbase);
+	transParams.SetDelay(delay);
+
+	checkerror(sess.Create(loopbacksessionparams(), &transParams, RTPTransmitter::LoopbackProto));
+	sess.SetDefaultPayloadType(96);
+	sess.SetDefaultMark(false);
+	sess.SetDefaultTimestampIncrement(160);
+}
+
+int drainpackets(RTPSession &sess)
+{
+	int num = 0;
+
+	sess.BeginDataAccess();
+	if (sess.GotoFirstSourceWithData())
+	{
+		do
+		{
+			RTPPacket *pack;
+
+			while ((pack = sess.GetNextPacket()) != 0)
+			{
+				num++;
+				sess.DeletePacket(pack);
+			}
+		} while (sess.GotoNextSourceWithData());
+	}
+	sess.EndDataAccess();
+	return num;
+}
+
+int main(int argc, char *argv[])
+{
+	int numpackets = 1000000;
+	int numreceivers = 2;
+
+	if (argc > 1)
+		numpackets = atoi(argv[1]);
+	if (argc > 2)
+		numreceivers = atoi(argv[2]);
+	if (numpackets <= 0 || numreceivers <= 0 || numreceivers > 16)
+	{
+		cerr << "Usage: loopbackbench [numpackets [numreceivers]]" << endl;
+		return -1;
+	}
+
+	RTPLoopbackNetwork network;
+	RTPSession sender;
+	RTPSession receivers[16];
+
+	createsession(sender, network, 5000, RTPTime(0, 0));
+	for (int i = 0 ; i < numreceivers ; i++)
+	{
+		createsession(receivers[i], network, (uint16_t)(6000+i*2), RTPTime(0, 0));
+		checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, (uint16_t)(6000+i*2))));
+	}
+	cout << "Attached " << network.GetNumberOfTransmitters() << " transmitters to the network" << endl;
+
+	// Sending and receiving are timed separately, receivers poll in bursts
+
+	const int burstsize = 64;
+	uint8_t payload[160];
+	RTPTime sendtime(0, 0), recvtime(0, 0);
+	int numreceived = 0;
+
+	memset(payload, 0, sizeof(payload));
+	for (int i = 0 ; i < numpackets ; i += burstsize)
+	{
+		int num = (numpackets-i < burstsize)?(numpackets-i):burstsize;
+		RTPTime t0 = RTPTime::CurrentTime();
+
+		for (int j = 0 ; j < num ; j++)
+			checkerror(sender.SendPacket(payload, sizeof(payload)));
+
+		RTPTime t1 = RTPTime::CurrentTime();
+
+		for (int j = 0 ; j < numreceivers ; j++)
+		{
+			checkerror(receivers[j].Poll());
+			numreceived += drainpackets(receivers[j]);
+		}
+
+		RTPTime t2 = RTPTime::CurrentTime();
+
+		t2 -= t1;
+		t1 -= t0;
+		sendtime += t1;
+		recvtime += t2;
+	}
+
+	double sendns = sendtime.GetDouble()*1e9/(double)numpackets;
+	double recvns = recvtime.GetDouble()*1e9/((double)numpackets*(double)numreceivers);
+
+	cout << "Sent " << numpackets << " packets to " << numreceivers << " receivers" << endl;
+	cout << "Received " << numreceived << " packets" << endl;
+	cout << "Send cost:    " << sendns << " ns per packet" << endl;
+	cout << "Receive cost: " << recvns << " ns per packet and receiver" << endl;
+
+	if (numreceived != numpackets*numreceivers)
+	{
+		cerr << "Not all packets were received" << endl;
+		return -1;
+	}
+
+	// Check that a simulated delay is honoured
+
+	RTPSession delayedsender, delayedreceiver;
+	RTPTime delay(0, 50000);
+
+	createsession(delayedsender, network, 7000, delay);
+	createsession(delayedreceiver, network, 7002, RTPTime(0, 0));
+	checkerror(delayedsender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 7002)));
+
+	// A new source needs a few packets before it's validated
+	const int numdelayedsent = 3;
+	RTPTime start = RTPTime::CurrentTime();
+
+	for (int i = 0 ; i < numdelayedsent ; i++)
+		checkerror(delayedsender.SendPacket(payload, sizeof(payload)));
+
+	checkerror(delayedreceiver.Poll());
+	if (drainpackets(delayedreceiver) != 0)
+	{
+		cerr << "Delayed packets arrived too early" << endl;
+		return -1;
+	}
+
+	int numdelayed = 0;
+	while (numdelayed < numdelayedsent)
+	{
+		bool available = false;
+
+		checkerror(delayedreceiver.WaitForIncomingData(RTPTime(1, 0), &available));
+		checkerror(delayedreceiver.Poll());
+		numdelayed += drainpackets(delayedreceiver);
+
+		RTPTime elapsed = RTPTime::CurrentTime();
+		elapsed -= start;
+		if (elapsed > RTPTime(1, 0))
+			break;
+	}
+
+	RTPTime elapsed = RTPTime::CurrentTime();
+	elapsed -= start;
+	cout << "Delayed packets received after " << elapsed.GetDouble()*1000.0 << " ms" << endl;
+	if (numdelayed != numdelayedsent || elapsed < delay)
+	{
+		cerr << "Delayed packets were not received correctly" << endl;
+		return -1;
+	}
+
+	delayedsender.Destroy();
+	delayedreceiver.Destroy();
+	for (int i = 0 ; i < numreceivers ; i++)
+		receivers[i].Destroy();
+	sender.Destroy();
+
+	return 0;
+}
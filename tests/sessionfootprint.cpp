@@ -0,0 +1,134 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtpudpv4transmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtppacket.h"
+#include "rtpmemorymanager.h"
+#include <stdlib.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Prints the size of the RTPSession and transmitter instances, and the heap
+// memory a session allocates through its memory manager when it's created and
+// after it has exchanged data with one other participant. The figures in the
+// "Memory footprint of a session" section of the documentation come from this.
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+// Keeps track of the number of bytes that are currently allocated
+class FootprintMemoryManager : public RTPMemoryManager
+{
+public:
+	FootprintMemoryManager()									{ numbytes = 0; }
+	void *AllocateBuffer(size_t len, int)
+	{
+		// The length is stored in front of the block, which is kept aligned
+		size_t *block = (size_t *)malloc(len+sizeof(size_t)*2);
+
+		if (block == 0)
+			return 0;
+		block[0] = len;
+		numbytes += len;
+		return block+2;
+	}
+	void FreeBuffer(void *buffer)
+	{
+		size_t *block = ((size_t *)buffer)-2;
+
+		numbytes -= block[0];
+		free(block);
+	}
+
+	size_t numbytes;
+};
+
+uint16_t createsession(RTPSession &sess)
+{
+	RTPSessionParams sessParams;
+	RTPUDPv4TransmissionParams transParams;
+
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetUsePollThread(false);
+	transParams.SetPortbase(0);
+	transParams.SetBindIP(ntohl(inet_addr("127.0.0.1")));
+
+	checkerror(sess.Create(sessParams, &transParams));
+	sess.SetDefaultPayloadType(96);
+	sess.SetDefaultMark(false);
+	sess.SetDefaultTimestampIncrement(160);
+
+	RTPUDPv4TransmissionInfo *pInf = (RTPUDPv4TransmissionInfo *)sess.GetTransmissionInfo();
+	uint16_t port = pInf->GetRTPPort();
+
+	sess.DeleteTransmissionInfo(pInf);
+	return port;
+}
+
+void exchangedata(RTPSession &sess)
+{
+	uint8_t payload[160] = { 0 };
+
+	for (int i = 0 ; i < 10 ; i++)
+		checkerror(sess.SendPacket(payload, sizeof(payload)));
+}
+
+void discardpackets(RTPSession &sess)
+{
+	checkerror(sess.Poll());
+	sess.BeginDataAccess();
+	if (sess.GotoFirstSourceWithData())
+	{
+		do
+		{
+			RTPPacket *pack;
+
+			while ((pack = sess.GetNextPacket()) != 0)
+				sess.DeletePacket(pack);
+		} while (sess.GotoNextSourceWithData());
+	}
+	sess.EndDataAccess();
+}
+
+int main(void)
+{
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSADATA dat;
+	WSAStartup(MAKEWORD(2,2),&dat);
+#endif // RTP_SOCKETTYPE_WINSOCK
+
+	FootprintMemoryManager mgr, peermgr;
+	RTPSession sess(0, &mgr), peer(0, &peermgr);
+	uint32_t localhost = ntohl(inet_addr("127.0.0.1"));
+
+	cout << "sizeof(RTPSession):          " << sizeof(RTPSession) << " bytes" << endl;
+	cout << "sizeof(RTPUDPv4Transmitter): " << sizeof(RTPUDPv4Transmitter) << " bytes" << endl;
+
+	uint16_t peerport = createsession(peer);
+	uint16_t port = createsession(sess);
+
+	checkerror(sess.AddDestination(RTPIPv4Address(localhost, peerport)));
+	cout << "Heap after creating the session and adding a destination: " << mgr.numbytes << " bytes" << endl;
+
+	checkerror(peer.AddDestination(RTPIPv4Address(localhost, port)));
+	exchangedata(sess);
+	exchangedata(peer);
+	RTPTime::Wait(RTPTime(0, 100000));
+	discardpackets(sess);
+	discardpackets(peer);
+	cout << "Heap after exchanging data with one participant: " << mgr.numbytes << " bytes" << endl;
+
+	sess.BYEDestroy(RTPTime(0,0), 0, 0);
+	peer.BYEDestroy(RTPTime(0,0), 0, 0);
+	return 0;
+}
+
@@ -0,0 +1,140 @@
+#include "rtpcollisionlist.h"
+#include "rtpipv4address.h"
+#include "rtpipv6address.h"
+#include "rtperrors.h"
+#include <stdlib.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that addresses can be found in the collision list after it has grown
+// a lot, that the ones which collided last are the ones that remain after a
+// timeout, and measures how long it takes to look up an address.
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+RTPIPv4Address getaddress(int i)
+{
+	return RTPIPv4Address((uint32_t)(0x0a000000+i/16), (uint16_t)(5000+(i%16)*2));
+}
+
+int main(void)
+{
+	const int numaddresses = 5000;
+	const int numlookups = 200000;
+	RTPCollisionList list;
+	RTPTime basetime(1000, 0);
+
+	// Every address is added with a separate collision time; the first
+	// half of the addresses collides again later on
+
+	for (int i = 0 ; i < numaddresses ; i++)
+	{
+		RTPIPv4Address addr = getaddress(i);
+		bool created;
+
+		checkerror(list.UpdateAddress(&addr, RTPTime(basetime.GetDouble()+i), &created));
+		if (!created)
+		{
+			cerr << "Address " << i << " was already in the list" << endl;
+			return -1;
+		}
+	}
+	for (int i = 0 ; i < numaddresses/2 ; i++)
+	{
+		RTPIPv4Address addr = getaddress(i);
+		bool created;
+
+		checkerror(list.UpdateAddress(&addr, RTPTime(basetime.GetDouble()+numaddresses+i), &created));
+		if (created)
+		{
+			cerr << "Address " << i << " was added twice" << endl;
+			return -1;
+		}
+	}
+
+	RTPIPv4Address otheraddr(0x0b000000, 5000);
+	RTPIPv6Address ipv6addr;
+
+	if (list.HasAddress(&otheraddr) || list.HasAddress(&ipv6addr) || list.HasAddress(0))
+	{
+		cerr << "Unknown address was found" << endl;
+		return -1;
+	}
+
+	RTPTime start = RTPTime::CurrentTime();
+	int numfound = 0;
+
+	for (int i = 0 ; i < numlookups ; i++)
+	{
+		RTPIPv4Address addr = getaddress(i%(numaddresses*2));
+
+		if (list.HasAddress(&addr))
+			numfound++;
+	}
+
+	RTPTime elapsed = RTPTime::CurrentTime();
+	elapsed -= start;
+
+	if (numfound != numlookups/2)
+	{
+		cerr << "Found " << numfound << " addresses, expected " << numlookups/2 << endl;
+		return -1;
+	}
+	cout << numlookups << " lookups in a list of " << numaddresses << " addresses: " << elapsed.GetDouble()*1e9/numlookups << " ns each" << endl;
+
+	// Only the addresses that collided during the last 'numaddresses' seconds
+	// may remain, which are the ones from the first half of the list
+
+	list.Timeout(RTPTime(basetime.GetDouble()+numaddresses*2), RTPTime((double)numaddresses+0.5));
+	for (int i = 0 ; i < numaddresses ; i++)
+	{
+		RTPIPv4Address addr = getaddress(i);
+
+		if (list.HasAddress(&addr) != (i < numaddresses/2))
+		{
+			cerr << "Address " << i << " was not timed out correctly" << endl;
+			return -1;
+		}
+	}
+
+	list.Timeout(RTPTime(basetime.GetDouble()+numaddresses*3), RTPTime(1.0));
+	for (int i = 0 ; i < numaddresses ; i++)
+	{
+		RTPIPv4Address addr = getaddress(i);
+
+		if (list.HasAddress(&addr))
+		{
+			cerr << "Address " << i << " is still in the list" << endl;
+			return -1;
+		}
+	}
+
+	// The list must still be usable after everything timed out
+
+	RTPIPv4Address addr = getaddress(0);
+	bool created;
+
+	checkerror(list.UpdateAddress(&addr, basetime, &created));
+	if (!created || !list.HasAddress(&addr))
+	{
+		cerr << "Unable to reuse the list" << endl;
+		return -1;
+	}
+	list.Clear();
+	if (list.HasAddress(&addr))
+	{
+		cerr << "Address is still present after Clear" << endl;
+		return -1;
+	}
+	cout << "All checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef TESTCOMMON_H
+
+#define TESTCOMMON_H
+
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtperrors.h"
+#include "rtpmemorymanager.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+// Helpers for the tests which exchange packets between sessions on a
+// loopback network
+
+#define COUNTINGMEMORYMANAGER_NUMMEMTYPES					64
+
+inline void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		std::cout << "ERROR: " << jrtplib::RTPGetErrorString(rtperr) << std::endl;
+		exit(-1);
+	}
+}
+
+// The session parameters that are used unless a test needs something else:
+// an 8 kHz timestamp unit, and no poll thread unless one is asked for
+inline jrtplib::RTPSessionParams loopbacksessionparams(bool pollthread = false)
+{
+	jrtplib::RTPSessionParams sessParams;
+
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetUsePollThread(pollthread); // fails without thread support, which is fine
+	return sessParams;
+}
+
+// Creates a session on the loopback network, bound to 'portbase', which sends
+// packets with payload type 96 and 160 samples each
+inline void createsession(jrtplib::RTPSession &sess, jrtplib::RTPLoopbackNetwork &network, uint16_t portbase,
+                          const jrtplib::RTPSessionParams &sessParams = loopbacksessionparams())
+{
+	jrtplib::RTPLoopbackTransmissionParams transParams(&network);
+
+	transParams.SetPortbase(portbase);
+
+	checkerror(sess.Create(sessParams, &transParams, jrtplib::RTPTransmitter::LoopbackProto));
+	sess.SetDefaultPayloadType(96);
+	sess.SetDefaultMark(false);
+	sess.SetDefaultTimestampIncrement(160);
+}
+
+// Allocates everything from the system, and counts the allocations in total
+// and for each memory type
+class CountingMemoryManager : public jrtplib::RTPMemoryManager
+{
+public:
+	CountingMemoryManager()										{ numallocations = 0; memset(typeallocations, 0, sizeof(typeallocations)); }
+	void *AllocateBuffer(size_t numbytes, int memtype)
+	{
+		numallocations++;
+		if (memtype >= 0 && memtype < COUNTINGMEMORYMANAGER_NUMMEMTYPES)
+			typeallocations[memtype]++;
+		return new uint8_t[numbytes];
+	}
+	void FreeBuffer(void *buffer)								{ delete [] (uint8_t *)buffer; }
+
+	int GetNumberOfAllocations(int memtype) const						{ return typeallocations[memtype]; }
+
+	int numallocations;
+private:
+	int typeallocations[COUNTINGMEMORYMANAGER_NUMMEMTYPES];
+};
+
+#endif // TESTCOMMON_H
+
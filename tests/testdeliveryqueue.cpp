@@ -0,0 +1,274 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtpspscqueue.h"
+#include "rtperrors.h"
+#include "rtppacket.h"
+#include "rtpsourcedata.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <iostream>
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jthread.h>
+#endif // RTP_SUPPORT_THREAD
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks the lock-free single producer, single consumer queue and the packet
+// delivery queue of RTPSession which is built on top of it; with thread support,
+// the packets are retrieved while the poll thread is processing new ones
+
+bool checkqueue()
+{
+	RTPSPSCQueue<uint32_t> queue(0);
+
+	if (queue.Init(0) != ERR_RTP_SPSCQUEUE_INVALIDSIZE || queue.Init(RTPSPSCQUEUE_MAXSIZE+1) != ERR_RTP_SPSCQUEUE_INVALIDSIZE)
+		return false;
+	checkerror(queue.Init(100));
+	if (queue.GetCapacity() != 128)
+		return false;
+
+	uint32_t pushed = 0, popped = 0, v;
+
+	// Fill and empty the queue in differently sized steps, so that the
+	// positions wrap around the ring many times
+	for (int i = 0 ; i < 100000 ; i++)
+	{
+		int num = rand()%200;
+
+		for (int j = 0 ; j < num ; j++)
+		{
+			bool full = (queue.GetCount() == queue.GetCapacity());
+
+			if (queue.Push(pushed) == full)
+				return false;
+			if (!full)
+				pushed++;
+		}
+
+		num = rand()%200;
+		for (int j = 0 ; j < num ; j++)
+		{
+			bool empty = (queue.GetCount() == 0);
+
+			if (queue.Pop(&v) == empty)
+				return false;
+			if (!empty)
+			{
+				if (v != popped)
+					return false;
+				popped++;
+			}
+		}
+	}
+	return (queue.GetCount() == pushed-popped);
+}
+
+// Returns the number of packets which were stored in the source table instead,
+// because the source was still on probation
+int drainsources(RTPSession &sess)
+{
+	int num = 0;
+
+	sess.BeginDataAccess();
+	if (sess.GotoFirstSourceWithData())
+	{
+		do
+		{
+			RTPPacket *pack;
+
+			while ((pack = sess.GetNextPacket()) != 0)
+			{
+				num++;
+				sess.DeletePacket(pack);
+			}
+		} while (sess.GotoNextSourceWithData());
+	}
+	sess.EndDataAccess();
+	return num;
+}
+
+bool checksession()
+{
+	RTPLoopbackNetwork network;
+	RTPSession sender, receiver;
+	uint8_t payload[160] = { 0 };
+
+	RTPSessionParams sessParams = loopbacksessionparams();
+
+	sessParams.SetPacketDeliveryQueueSize(64);
+	createsession(sender, network, 5000);
+	createsession(receiver, network, 6000, sessParams);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	const int numsent = 100;
+
+	for (int i = 0 ; i < numsent ; i++)
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+	checkerror(receiver.Poll());
+
+	int numprobation = drainsources(receiver);
+	int numdelivered = 0;
+	RTPPacket *pack;
+	uint16_t expectedseqnr = 0;
+
+	while ((pack = receiver.GetNextDeliveredPacket()) != 0)
+	{
+		if (numdelivered > 0 && pack->GetSequenceNumber() != expectedseqnr)
+		{
+			cerr << "Packets were not delivered in order" << endl;
+			return false;
+		}
+		expectedseqnr = pack->GetSequenceNumber()+1;
+		numdelivered++;
+		receiver.DeletePacket(pack);
+	}
+
+	cout << numdelivered << " packets delivered, " << receiver.GetNumberOfDroppedDeliveredPackets() << " dropped, "
+	     << numprobation << " stored during probation" << endl;
+
+	if (numdelivered != 64 || numdelivered+numprobation+(int)receiver.GetNumberOfDroppedDeliveredPackets() != numsent)
+		return false;
+
+	// Packets which are still queued must be released when the session is destroyed
+	for (int i = 0 ; i < 10 ; i++)
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+	checkerror(receiver.Poll());
+	receiver.Destroy();
+	sender.Destroy();
+	return true;
+}
+
+#ifdef RTP_SUPPORT_THREAD
+
+// Retrieves the packets from the delivery queue while the poll thread of the
+// session is storing them
+class ConsumerThread : public jthread::JThread
+{
+public:
+	ConsumerThread(RTPSession &s, int num) : sess(s), numexpected(num), numreceived(0), outoforder(false)
+	{
+	}
+
+	~ConsumerThread()
+	{
+		while (IsRunning())
+			RTPTime::Wait(RTPTime(0.01));
+	}
+
+	int GetNumberReceived() const							{ return numreceived; }
+	bool IsOutOfOrder() const							{ return outoforder; }
+private:
+	void *Thread()
+	{
+		JThread::ThreadStarted();
+
+		RTPTime start = RTPTime::CurrentTime();
+		uint32_t prevseqnr = 0;
+
+		while (numreceived+(int)sess.GetNumberOfDroppedDeliveredPackets() < numexpected)
+		{
+			RTPPacket *pack = sess.GetNextDeliveredPacket();
+
+			if (pack == 0)
+			{
+				RTPTime elapsed = RTPTime::CurrentTime();
+				elapsed -= start;
+				if (elapsed > RTPTime(10, 0))
+					break;
+				continue;
+			}
+
+			if (numreceived > 0 && pack->GetExtendedSequenceNumber() <= prevseqnr)
+				outoforder = true;
+			prevseqnr = pack->GetExtendedSequenceNumber();
+			numreceived++;
+			sess.DeletePacket(pack);
+		}
+		return 0;
+	}
+
+	RTPSession &sess;
+	int numexpected;
+	int numreceived;
+	bool outoforder;
+};
+
+bool checkthreads()
+{
+	RTPLoopbackNetwork network;
+	RTPSession sender, receiver;
+	uint8_t payload[160] = { 0 };
+
+	RTPSessionParams sessParams = loopbacksessionparams(true);
+
+	sessParams.SetPacketDeliveryQueueSize(65536);
+#ifdef RTP_SUPPORT_PROBATION
+	sessParams.SetProbationType(RTPSources::NoProbation);
+#endif // RTP_SUPPORT_PROBATION
+	createsession(receiver, network, 6000, sessParams);
+	createsession(sender, network, 5000);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	const int numsent = 200000;
+	ConsumerThread consumer(receiver, numsent);
+
+	if (consumer.Start() < 0)
+	{
+		cerr << "Unable to start consumer thread" << endl;
+		return false;
+	}
+
+	for (int i = 0 ; i < numsent ; i++)
+	{
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+		if (i%1000 == 0)
+			RTPTime::Wait(RTPTime(0, 100));
+	}
+
+	while (consumer.IsRunning())
+		RTPTime::Wait(RTPTime(0.01));
+
+	cout << consumer.GetNumberReceived() << " packets received by the consumer thread, " << receiver.GetNumberOfDroppedDeliveredPackets()
+	     << " dropped" << endl;
+
+	bool ok = (!consumer.IsOutOfOrder() && consumer.GetNumberReceived()+(int)receiver.GetNumberOfDroppedDeliveredPackets() == numsent);
+
+	receiver.Destroy();
+	sender.Destroy();
+	return ok;
+}
+
+#endif // RTP_SUPPORT_THREAD
+
+int main(void)
+{
+	srand(5678);
+
+	if (!checkqueue())
+	{
+		cerr << "Queue check FAILED" << endl;
+		return -1;
+	}
+	cout << "Queue checks passed" << endl;
+
+	if (!checksession())
+	{
+		cerr << "Session check FAILED" << endl;
+		return -1;
+	}
+
+#ifdef RTP_SUPPORT_THREAD
+	if (!checkthreads())
+	{
+		cerr << "Thread check FAILED" << endl;
+		return -1;
+	}
+#endif // RTP_SUPPORT_THREAD
+
+	cout << "All checks passed" << endl;
+	return 0;
+}
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <iostream>
 #include <string>
+#include <string.h>
 
 using namespace jrtplib;
 using namespace std;
@@ -24,8 +25,12 @@ void checkerror(int rtperr)
 class ExtSender : public RTPExternalSender
 {
 public:
-	ExtSender() { }
+	ExtSender() : numbatches(0), numbatchpackets(0), numbadmarkers(0), lastseqnr(0), lasttimestamp(0) { }
 	~ExtSender() { }
+
+	int numbatches, numbatchpackets, numbadmarkers;
+	uint16_t lastseqnr;
+	uint32_t lasttimestamp;
 private:
 	bool SendRTP(const void *pData, size_t len)
 	{
@@ -41,8 +46,33 @@ private:
 	{
 		return false;
 	}
+
+	bool SendRTPBatch(const RTPDataSpan *pPackets, size_t numPackets)
+	{
+		numbatches++;
+		for (size_t i = 0 ; i < numPackets ; i++)
+		{
+			const uint8_t *pData = (const uint8_t *)pPackets[i].data;
+			bool marker = (pData[1]&0x80)?true:false;
+
+			if (marker != (i == numPackets-1))
+				numbadmarkers++;
+			numbatchpackets++;
+			lastseqnr = (((uint16_t)pData[2])<<8)|((uint16_t)pData[3]);
+			lasttimestamp = (((uint32_t)pData[4])<<24)|(((uint32_t)pData[5])<<16)|(((uint32_t)pData[6])<<8)|((uint32_t)pData[7]);
+		}
+		return true;
+	}
 };
 
+static int numreleased = 0;
+
+void releasebuffer(uint8_t *data, void *)
+{
+	numreleased++;
+	delete [] data;
+}
+
 int main(void)
 {
 	ExtSender sender;
@@ -66,5 +96,81 @@ int main(void)
 		pPacketInjector->InjectRTP("12345", 5, addr);
 	}
 
+	// Hand over buffers in batches, the library should release each one exactly once
+
+	const int batchsize = 64;
+	const int numbatches = 1024;
+	RTPIPv4Address addr(0x7f000001, 1234);
+
+	for (int i = 0 ; i < numbatches ; i++)
+	{
+		RTPExternalInjectedPacket packets[batchsize];
+
+		for (int j = 0 ; j < batchsize ; j++)
+		{
+			uint8_t *pBuf = new uint8_t[5];
+			memcpy(pBuf, "12345", 5);
+			packets[j] = RTPExternalInjectedPacket(pBuf, 5, addr, RTPExternalInjectedPacket::RTP, releasebuffer, 0);
+		}
+		pPacketInjector->InjectPackets(packets, batchsize);
+	}
+
+	// Packets without an address are ignored, a buffer that was handed over
+	// must still be released
+
+	RTPExternalInjectedPacket noaddress[2];
+	uint8_t *pBuf = new uint8_t[5];
+
+	noaddress[1] = RTPExternalInjectedPacket(pBuf, 5, addr, RTPExternalInjectedPacket::RTP, releasebuffer, 0);
+	noaddress[1].address = 0;
+	pPacketInjector->InjectPackets(noaddress, 2);
+	if (numreleased < 1)
+		return -1;
+	numreleased--;
+
+	// Send some frames which are split over several packets, each frame should
+	// arrive at the sender as a single batch
+
+	const int numframes = 100;
+	const int numframepackets = 8;
+	uint8_t payload[1000];
+	RTPDataSpan payloads[numframepackets];
+
+	memset(payload, 0, sizeof(payload));
+	for (int j = 0 ; j < numframepackets ; j++)
+		payloads[j] = RTPDataSpan(payload, sizeof(payload));
+	for (int i = 0 ; i < numframes ; i++)
+	{
+		status = session.SendFrame(payloads, numframepackets, 96, 3000);
+		checkerror(status);
+	}
+	cout << "Sent " << sender.numbatchpackets << " packets in " << sender.numbatches << " batches" << endl;
+	if (sender.numbatches != numframes || sender.numbatchpackets != numframes*numframepackets || sender.numbadmarkers != 0)
+		return -1;
+
+	// A frame of which one packet is too large isn't sent at all, and the
+	// next frame continues where the last one that was sent stopped
+
+	uint8_t largepayload[2000];
+	uint16_t lastseqnr = sender.lastseqnr;
+	uint32_t lasttimestamp = sender.lasttimestamp;
+
+	memset(largepayload, 0, sizeof(largepayload));
+	payloads[numframepackets/2] = RTPDataSpan(largepayload, sizeof(largepayload));
+	if (session.SendFrame(payloads, numframepackets, 96, 3000) >= 0)
+		return -1;
+	payloads[numframepackets/2] = RTPDataSpan(payload, sizeof(payload));
+	checkerror(session.SendFrame(payloads, numframepackets, 96, 3000));
+	if (sender.numbatches != numframes+1 || sender.lastseqnr != (uint16_t)(lastseqnr+numframepackets) || sender.lasttimestamp != lasttimestamp+3000)
+	{
+		cerr << "Frame that couldn't be built changed the sequence number or timestamp" << endl;
+		return -1;
+	}
+
+	session.Destroy();
+	cout << "Released " << numreleased << " of " << batchsize*numbatches << " handed over buffers" << endl;
+	if (numreleased != batchsize*numbatches)
+		return -1;
+
 	return 0;
 }
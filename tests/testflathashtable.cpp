@@ -0,0 +1,261 @@
+#include "rtpflatkeyhashtable.h"
+#include "rtpflathashtable.h"
+#include "rtpkeyhashtable.h"
+#include "rtptimeutilities.h"
+#include "rtperrors.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks the open addressing hash table against a std::map and a vector which
+// keeps the insertion order, and compares the lookup speed with the chained
+// hash table that was used for the source table before; that one has a fixed
+// number of buckets, so it degrades quickly for a large number of elements
+
+class GetIndex_uint32_t
+{
+public:
+	static int GetIndex(const uint32_t &k)					{ return k; }
+};
+
+class GetIndex_uint32_t_Chained
+{
+public:
+	static int GetIndex(const uint32_t &k)					{ return k%8317; }
+};
+
+// A bad hash function, to test long probe sequences
+class GetIndex_uint32_t_Bad
+{
+public:
+	static int GetIndex(const uint32_t &k)					{ return k%7; }
+};
+
+uint32_t randomkey(uint32_t range)
+{
+	return (uint32_t)(rand()%range);
+}
+
+template<class Table>
+bool checkcontents(Table &table, const vector<uint32_t> &order, const map<uint32_t,int> &contents)
+{
+	if (table.GetNumberOfElements() != (int)contents.size())
+	{
+		cerr << "Number of elements is " << table.GetNumberOfElements() << ", expected " << contents.size() << endl;
+		return false;
+	}
+
+	// Iteration must follow the order in which the elements were added,
+	// both forward and backward
+
+	size_t idx = 0;
+	for (table.GotoFirstElement() ; table.HasCurrentElement() ; table.GotoNextElement(), idx++)
+	{
+		if (idx >= order.size() || table.GetCurrentKey() != order[idx] || table.GetCurrentElement() != contents.find(order[idx])->second)
+		{
+			cerr << "Bad element at position " << idx << endl;
+			return false;
+		}
+	}
+	if (idx != order.size())
+	{
+		cerr << "Only " << idx << " of " << order.size() << " elements were iterated" << endl;
+		return false;
+	}
+
+	for (table.GotoLastElement() ; table.HasCurrentElement() ; table.GotoPreviousElement())
+	{
+		idx--;
+		if (table.GetCurrentKey() != order[idx])
+		{
+			cerr << "Bad element at position " << idx << " when iterating backwards" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+template<class GetIndex>
+bool randomtest(int numoperations, uint32_t keyrange)
+{
+	RTPFlatKeyHashTable<const uint32_t,int,GetIndex> table;
+	map<uint32_t,int> contents;
+	vector<uint32_t> order;
+
+	for (int i = 0 ; i < numoperations ; i++)
+	{
+		uint32_t k = randomkey(keyrange);
+		int op = rand()%4;
+		bool exists = (contents.find(k) != contents.end());
+
+		if (op < 2) // add
+		{
+			int status = table.AddElement(k, i);
+
+			if (exists != (status == ERR_RTP_HASHTABLE_ELEMENTALREADYEXISTS) || (!exists && status < 0))
+			{
+				cerr << "Unexpected result when adding " << k << endl;
+				return false;
+			}
+			if (!exists)
+			{
+				contents[k] = i;
+				order.push_back(k);
+			}
+		}
+		else if (op == 2) // delete
+		{
+			int status = table.DeleteElement(k);
+
+			if (exists != (status >= 0))
+			{
+				cerr << "Unexpected result when deleting " << k << endl;
+				return false;
+			}
+			if (exists)
+			{
+				contents.erase(k);
+				for (size_t j = 0 ; j < order.size() ; j++)
+				{
+					if (order[j] == k)
+					{
+						order.erase(order.begin()+j);
+						break;
+					}
+				}
+			}
+		}
+		else // lookup
+		{
+			if (table.HasElement(k) != exists || (table.GotoElement(k) >= 0) != exists ||
+			    (exists && table.GetCurrentElement() != contents[k]))
+			{
+				cerr << "Unexpected result when looking up " << k << endl;
+				return false;
+			}
+		}
+
+		if (i%997 == 0 && !checkcontents(table, order, contents))
+			return false;
+	}
+
+	// Delete every other element while iterating, which must not skip
+	// any of them
+
+	bool del = true;
+	vector<uint32_t> neworder;
+
+	table.GotoFirstElement();
+	while (table.HasCurrentElement())
+	{
+		if (del)
+		{
+			contents.erase(table.GetCurrentKey());
+			table.DeleteCurrentElement();
+		}
+		else
+		{
+			neworder.push_back(table.GetCurrentKey());
+			table.GotoNextElement();
+		}
+		del = !del;
+	}
+	if (!checkcontents(table, neworder, contents))
+		return false;
+
+	table.Clear();
+	contents.clear();
+	neworder.clear();
+	return checkcontents(table, neworder, contents);
+}
+
+// Returns the best of several measurements, which is the least affected by
+// other processes
+template<class Table>
+double lookuptime(Table &table, const vector<uint32_t> &keys, int numrounds)
+{
+	double best = 0;
+
+	for (int m = 0 ; m < 50 ; m++)
+	{
+		RTPTime start = RTPTime::CurrentTime();
+		int found = 0;
+
+		for (int r = 0 ; r < numrounds ; r++)
+		{
+			for (size_t i = 0 ; i < keys.size() ; i++)
+			{
+				if (table.GotoElement(keys[i]) >= 0)
+					found++;
+			}
+		}
+
+		RTPTime t = RTPTime::CurrentTime();
+		t -= start;
+		if (found != (int)keys.size()*numrounds)
+			cerr << "Not all elements were found" << endl;
+
+		double ns = t.GetDouble()*1e9/((double)keys.size()*(double)numrounds);
+
+		if (m == 0 || ns < best)
+			best = ns;
+	}
+	return best;
+}
+
+int main(void)
+{
+	srand(1234);
+
+	if (!randomtest<GetIndex_uint32_t>(200000, 2000) || !randomtest<GetIndex_uint32_t>(200000, 100000) ||
+	    !randomtest<GetIndex_uint32_t_Bad>(20000, 500))
+	{
+		cerr << "FAILED" << endl;
+		return -1;
+	}
+	cout << "Random operations passed" << endl;
+
+	RTPFlatHashTable<const uint32_t,GetIndex_uint32_t> set;
+
+	if (set.AddElement(1) < 0 || set.AddElement(2) < 0 || set.AddElement(1) != ERR_RTP_HASHTABLE_ELEMENTALREADYEXISTS ||
+	    !set.HasElement(2) || set.DeleteElement(2) < 0 || set.HasElement(2) || set.GetNumberOfElements() != 1)
+	{
+		cerr << "FAILED" << endl;
+		return -1;
+	}
+
+	for (int numsources = 16 ; numsources <= 65536 ; numsources *= 16)
+	{
+		RTPFlatKeyHashTable<const uint32_t,int,GetIndex_uint32_t> flattable;
+		RTPKeyHashTable<const uint32_t,int,GetIndex_uint32_t_Chained,8317> chainedtable;
+		vector<uint32_t> keys;
+
+		while ((int)keys.size() < numsources)
+		{
+			uint32_t k = (((uint32_t)rand())<<16)^((uint32_t)rand());
+
+			if (flattable.AddElement(k, 0) >= 0)
+			{
+				chainedtable.AddElement(k, 0);
+				keys.push_back(k);
+			}
+		}
+
+		// Look up in a random order, so the hardware prefetcher can't
+		// hide the cost of the cache misses
+		for (size_t i = keys.size()-1 ; i > 0 ; i--)
+			swap(keys[i], keys[rand()%(i+1)]);
+
+		int numrounds = 100000/numsources+1;
+		double flatns = lookuptime(flattable, keys, numrounds);
+		double chainedns = lookuptime(chainedtable, keys, numrounds);
+
+		cout << numsources << " elements: " << flatns << " ns per lookup (chained table: " << chainedns << " ns)" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtpudpv4transmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Sends packets with and without header extensions over UDP, once with the
+// header and payload passed to the transmitter separately, and once using
+// a session which changes the outgoing data, which needs the complete packet
+// in a single buffer. The receiver must get the same packets in both cases.
+// Also measures how long it takes to send a packet in both cases.
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+class ChangeOutgoingDataSession : public RTPSession
+{
+public:
+	ChangeOutgoingDataSession() : numchanged(0)
+	{
+		SetChangeOutgoingData(true);
+	}
+
+	int GetNumberOfChangedPackets() const						{ return numchanged; }
+protected:
+	int OnChangeRTPOrRTCPData(const void *origdata, size_t origlen, bool isrtp, void **senddata, size_t *sendlen)
+	{
+		if (isrtp)
+			numchanged++;
+		*senddata = (void *)origdata;
+		*sendlen = origlen;
+		return 0;
+	}
+private:
+	int numchanged;
+};
+
+uint16_t createsession(RTPSession &sess)
+{
+	RTPSessionParams sessParams;
+	RTPUDPv4TransmissionParams transParams;
+
+	sessParams.SetOwnTimestampUnit(1.0/90000.0);
+	sessParams.SetUsePollThread(false);
+#ifdef RTP_SUPPORT_PROBATION
+	sessParams.SetProbationType(RTPSources::NoProbation);
+#endif // RTP_SUPPORT_PROBATION
+	transParams.SetPortbase(0);
+	transParams.SetBindIP(ntohl(inet_addr("127.0.0.1")));
+	transParams.SetRTPReceiveBuffer(1000000);
+
+	checkerror(sess.Create(sessParams, &transParams));
+	sess.SetDefaultPayloadType(96);
+	sess.SetDefaultMark(false);
+	sess.SetDefaultTimestampIncrement(3000);
+
+	RTPUDPv4TransmissionInfo *pInf = (RTPUDPv4TransmissionInfo *)sess.GetTransmissionInfo();
+	uint16_t port = pInf->GetRTPPort();
+
+	sess.DeleteTransmissionInfo(pInf);
+	return port;
+}
+
+const int numpackets = 40;
+const size_t payloadlen = 1200;
+const uint16_t extid = 0xbede;
+
+void sendpackets(RTPSession &sess)
+{
+	uint8_t payload[payloadlen];
+	uint32_t extdata[2] = { 0x01020304, 0x05060708 };
+
+	for (int i = 0 ; i < numpackets ; i++)
+	{
+		size_t len = payloadlen - i;
+
+		memset(payload, i, len);
+		switch (i%4)
+		{
+		case 0:
+			checkerror(sess.SendPacket(payload, len));
+			break;
+		case 1:
+			checkerror(sess.SendPacket(payload, len, 97, true, 0));
+			break;
+		case 2:
+			checkerror(sess.SendPacketEx(payload, len, extid, extdata, 2));
+			break;
+		default:
+			checkerror(sess.SendPacketEx(payload, len, 98, true, 3000, extid, extdata, 1));
+		}
+	}
+}
+
+bool checkpackets(RTPSession &receiver, uint32_t ssrc)
+{
+	RTPTime::Wait(RTPTime(0.1));
+	checkerror(receiver.Poll());
+
+	bool ok = true;
+	int count = 0;
+
+	receiver.BeginDataAccess();
+	if (receiver.GotoFirstSourceWithData())
+	{
+		do
+		{
+			RTPPacket *pack;
+
+			if (receiver.GetCurrentSourceInfo()->GetSSRC() != ssrc)
+				continue;
+
+			while ((pack = receiver.GetNextPacket()) != 0)
+			{
+				int i = count++;
+				uint8_t expectedpt[4] = { 96, 97, 96, 98 };
+				bool expectedext = ((i%4) >= 2);
+				size_t expectedextlen = ((i%4) == 2)?8:4;
+				const uint8_t *payload = pack->GetPayloadData();
+
+				if (pack->GetPayloadLength() != payloadlen - i || pack->GetPayloadType() != expectedpt[i%4] ||
+				    pack->HasMarker() != ((i%2) == 1) || pack->HasExtension() != expectedext)
+					ok = false;
+				else if (expectedext && (pack->GetExtensionID() != extid || pack->GetExtensionLength() != expectedextlen))
+					ok = false;
+				else
+				{
+					for (size_t j = 0 ; j < pack->GetPayloadLength() ; j++)
+					{
+						if (payload[j] != (uint8_t)i)
+							ok = false;
+					}
+				}
+				receiver.DeletePacket(pack);
+			}
+		} while (receiver.GotoNextSourceWithData());
+	}
+	receiver.EndDataAccess();
+
+	if (count != numpackets)
+	{
+		cerr << "Received " << count << " of " << numpackets << " packets" << endl;
+		return false;
+	}
+	return ok;
+}
+
+double measuresendtime(RTPSession &sess, RTPSession &receiver)
+{
+	const int numrounds = 50;
+	const int numsends = 100;
+	uint8_t payload[payloadlen] = { 0 };
+	RTPTime total(0, 0);
+
+	for (int r = 0 ; r < numrounds ; r++)
+	{
+		RTPTime start = RTPTime::CurrentTime();
+
+		for (int i = 0 ; i < numsends ; i++)
+			checkerror(sess.SendPacket(payload, sizeof(payload)));
+
+		RTPTime t = RTPTime::CurrentTime();
+		t -= start;
+		total += t;
+
+		// Don't let the packets pile up at the receiver
+		checkerror(receiver.Poll());
+		receiver.BeginDataAccess();
+		if (receiver.GotoFirstSourceWithData())
+		{
+			do
+			{
+				RTPPacket *pack;
+
+				while ((pack = receiver.GetNextPacket()) != 0)
+					receiver.DeletePacket(pack);
+			} while (receiver.GotoNextSourceWithData());
+		}
+		receiver.EndDataAccess();
+	}
+	return total.GetDouble()*1e6/(numrounds*numsends);
+}
+
+int main(void)
+{
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSADATA dat;
+	WSAStartup(MAKEWORD(2,2),&dat);
+#endif // RTP_SOCKETTYPE_WINSOCK
+
+	RTPSession receiver, gathersender;
+	ChangeOutgoingDataSession copysender;
+	uint16_t port = createsession(receiver);
+	uint32_t localhost = ntohl(inet_addr("127.0.0.1"));
+
+	createsession(gathersender);
+	createsession(copysender);
+	checkerror(gathersender.AddDestination(RTPIPv4Address(localhost, port)));
+	checkerror(copysender.AddDestination(RTPIPv4Address(localhost, port)));
+
+	sendpackets(gathersender);
+	if (!checkpackets(receiver, gathersender.GetLocalSSRC()))
+	{
+		cerr << "Packets sent from separate header and payload are not correct" << endl;
+		return -1;
+	}
+
+	sendpackets(copysender);
+	if (!checkpackets(receiver, copysender.GetLocalSSRC()) || copysender.GetNumberOfChangedPackets() != numpackets)
+	{
+		cerr << "Packets sent from a single buffer are not correct" << endl;
+		return -1;
+	}
+
+	double gathertime = measuresendtime(gathersender, receiver);
+	double copytime = measuresendtime(copysender, receiver);
+
+	cout << "Sending a packet with " << payloadlen << " bytes of payload: " << gathertime << " us without copying, "
+	     << copytime << " us when the outgoing data can be changed" << endl;
+
+	gathersender.BYEDestroy(RTPTime(0), 0, 0);
+	copysender.BYEDestroy(RTPTime(0), 0, 0);
+	receiver.Destroy();
+
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSACleanup();
+#endif // RTP_SOCKETTYPE_WINSOCK
+	cout << "All checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,133 @@
+#include "rtppacketbuilder.h"
+#include "rtppacket.h"
+#include "rtprandom.h"
+#include "rtperrors.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Builds packets while changing the payload type, marker, CSRC list, SSRC and
+// header extension, and compares each one to the packet that RTPPacket builds
+// from the same fields. Also measures how long it takes to build a packet.
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+const size_t maxpacksize = 1400;
+
+uint32_t csrcs[RTP_MAXCSRCS];
+int numcsrcs = 0;
+
+// Builds the packet and checks it against a packet made from scratch
+bool buildandcheck(RTPPacketBuilder &builder, const uint8_t *payload, size_t len, uint8_t pt, bool mark,
+                   bool ext, uint32_t timestampinc)
+{
+	uint32_t extdata[3] = { 1, 2, 3 };
+	uint16_t seqnr = builder.GetSequenceNumber();
+	uint32_t timestamp = builder.GetTimestamp();
+
+	if (ext)
+		checkerror(builder.BuildPacketEx(payload, len, pt, mark, timestampinc, 0x1234, extdata, 3));
+	else
+		checkerror(builder.BuildPacket(payload, len, pt, mark, timestampinc));
+
+	RTPPacket p(pt, payload, len, seqnr, timestamp, builder.GetSSRC(), mark, (uint8_t)numcsrcs, csrcs, ext, 0x1234, 3, extdata, maxpacksize);
+
+	checkerror(p.GetCreationError());
+	return (p.GetPacketLength() == builder.GetPacketLength() && memcmp(p.GetPacketData(), builder.GetPacket(), p.GetPacketLength()) == 0);
+}
+
+int main(void)
+{
+	RTPRandom *rnd = RTPRandom::CreateDefaultRandomNumberGenerator();
+	RTPPacketBuilder builder(*rnd);
+	uint8_t payload[160];
+
+	for (size_t i = 0 ; i < sizeof(payload) ; i++)
+		payload[i] = (uint8_t)i;
+	checkerror(builder.Init(maxpacksize));
+
+	for (int i = 0 ; i < 2000 ; i++)
+	{
+		// Every now and then, something in the header layout changes
+		if (i%97 == 96 && numcsrcs < RTP_MAXCSRCS)
+		{
+			csrcs[numcsrcs] = 0x1000+i;
+			checkerror(builder.AddCSRC(csrcs[numcsrcs]));
+			numcsrcs++;
+		}
+		if (i%311 == 310)
+		{
+			checkerror(builder.DeleteCSRC(csrcs[0]));
+			numcsrcs--;
+			if (numcsrcs > 0)
+				csrcs[0] = csrcs[numcsrcs];
+		}
+		if (i%500 == 499)
+			builder.CreateNewSSRC();
+		if (i == 1200)
+			builder.AdjustSSRC(0x12345678);
+		if (i == 1500)
+		{
+			builder.ClearCSRCList();
+			numcsrcs = 0;
+		}
+
+		uint8_t pt = (uint8_t)((i%50 < 25)?0:(96+i%3));
+		bool mark = (i%7 == 0);
+		bool ext = (i%13 == 0);
+
+		if (!buildandcheck(builder, payload, (size_t)(i%sizeof(payload)), pt, mark, ext, (i%2)*160))
+		{
+			cerr << "Packet " << i << " is not correct" << endl;
+			return -1;
+		}
+	}
+
+	// Errors must still be detected
+
+	if (builder.BuildPacket(payload, sizeof(payload), 72, false, 0) != ERR_RTP_PACKET_BADPAYLOADTYPE ||
+	    builder.BuildPacket(payload, sizeof(payload), 128, false, 0) != ERR_RTP_PACKET_BADPAYLOADTYPE)
+	{
+		cerr << "Bad payload type was not detected" << endl;
+		return -1;
+	}
+
+	uint8_t largepayload[maxpacksize];
+
+	if (builder.BuildPacket(largepayload, maxpacksize, 0, false, 0) != ERR_RTP_PACKET_DATAEXCEEDSMAXSIZE ||
+	    builder.BuildPacketHeader(maxpacksize, 0, false, 0) != ERR_RTP_PACKET_DATAEXCEEDSMAXSIZE)
+	{
+		cerr << "Packet size was not checked" << endl;
+		return -1;
+	}
+	if (!buildandcheck(builder, payload, sizeof(payload), 0, true, false, 160))
+	{
+		cerr << "Packet after error is not correct" << endl;
+		return -1;
+	}
+
+	const int numbuilds = 1000000;
+	RTPTime start = RTPTime::CurrentTime();
+
+	for (int i = 0 ; i < numbuilds ; i++)
+		builder.BuildPacket(payload, sizeof(payload), 0, false, 160);
+
+	RTPTime elapsed = RTPTime::CurrentTime();
+	elapsed -= start;
+	cout << "Building a packet with " << sizeof(payload) << " bytes of payload: " << elapsed.GetDouble()*1e9/numbuilds << " ns" << endl;
+
+	builder.Destroy();
+	delete rnd;
+	cout << "All checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "rtpinstrumentedmemorymanager.h"
+#include "rtppooledmemorymanager.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks the statistics kept by the instrumented memory manager, both for
+// direct allocations and for the allocations of a session
+
+void fail(const char *msg)
+{
+	cerr << msg << endl;
+	exit(-1);
+}
+
+uint64_t gethistogramtotal(const RTPMemoryTypeInfo &info)
+{
+	uint64_t total = 0;
+
+	for (int i = 0 ; i < RTPINSTRUMENTEDMEMORYMANAGER_NUMHISTOGRAMBINS ; i++)
+		total += info.GetHistogramCount(i);
+	return total;
+}
+
+void checkcounters()
+{
+	RTPInstrumentedMemoryManager mgr;
+	RTPMemoryTypeInfo info;
+	void *bufs[3];
+
+	bufs[0] = mgr.AllocateBuffer(100, RTPMEM_TYPE_BUFFER_SDESITEM);
+	bufs[1] = mgr.AllocateBuffer(200, RTPMEM_TYPE_BUFFER_SDESITEM);
+	memset(bufs[0], 0xff, 100);
+	memset(bufs[1], 0xff, 200);
+	mgr.FreeBuffer(bufs[0]);
+	bufs[2] = mgr.AllocateBuffer(50, RTPMEM_TYPE_BUFFER_SDESITEM);
+
+	mgr.GetMemoryTypeInfo(RTPMEM_TYPE_BUFFER_SDESITEM, info);
+	if (info.GetNumberOfAllocations() != 3 || info.GetNumberOfFrees() != 1 || info.GetLiveBlocks() != 2)
+		fail("Wrong number of allocations");
+	if (info.GetLiveBytes() != 250 || info.GetPeakBytes() != 300 || info.GetTotalBytes() != 350)
+		fail("Wrong number of bytes");
+	if (info.GetHistogramCount(6) != 1 || info.GetHistogramCount(7) != 1 || info.GetHistogramCount(8) != 1 || gethistogramtotal(info) != 3)
+		fail("Wrong size histogram");
+
+	mgr.FreeBuffer(bufs[1]);
+	mgr.FreeBuffer(bufs[2]);
+	mgr.GetMemoryTypeInfo(RTPMEM_TYPE_BUFFER_SDESITEM, info);
+	if (info.GetLiveBytes() != 0 || info.GetLiveBlocks() != 0 || info.GetPeakBytes() != 300)
+		fail("Wrong number of bytes after freeing everything");
+
+	// Other types are not affected, unknown types are counted as 'other'
+
+	mgr.GetMemoryTypeInfo(RTPMEM_TYPE_BUFFER_RTPPACKET, info);
+	if (info.GetNumberOfAllocations() != 0)
+		fail("Allocation was counted for the wrong type");
+	mgr.FreeBuffer(mgr.AllocateBuffer(10, 1000));
+	mgr.GetMemoryTypeInfo(RTPMEM_TYPE_OTHER, info);
+	if (info.GetNumberOfAllocations() != 1 || info.GetNumberOfFrees() != 1)
+		fail("Unknown type was not counted as 'other'");
+
+	if (strcmp(RTPInstrumentedMemoryManager::GetMemoryTypeName(RTPMEM_TYPE_CLASS_RTPPACKET), "RTPMEM_TYPE_CLASS_RTPPACKET") != 0)
+		fail("Wrong memory type name");
+	cout << "Counter checks passed" << endl;
+}
+
+void runsession(RTPInstrumentedMemoryManager &mgr)
+{
+	const int num = 1000;
+	RTPLoopbackNetwork network;
+	RTPSession sender, receiver(0, &mgr);
+	RTPMemoryTypeInfo info;
+	uint8_t payload[160];
+	int numreceived = 0;
+
+	createsession(receiver, network, 6000);
+	createsession(sender, network, 7000);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	mgr.StartRateInterval();
+	memset(payload, 0, sizeof(payload));
+	for (int i = 0 ; i < num ; i++)
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+	checkerror(receiver.Poll());
+
+	receiver.BeginDataAccess();
+	if (receiver.GotoFirstSourceWithData())
+	{
+		RTPPacket *pack;
+
+		while ((pack = receiver.GetNextPacket()) != 0)
+		{
+			numreceived++;
+			receiver.DeletePacket(pack);
+		}
+	}
+	receiver.EndDataAccess();
+	if (numreceived == 0)
+		fail("No packets were received");
+
+	// Every received packet needed a raw packet, a buffer and an RTPPacket, which
+	// have all been freed again
+
+	mgr.GetMemoryTypeInfo(RTPMEM_TYPE_CLASS_RTPPACKET, info);
+	if (info.GetNumberOfAllocations() != (uint64_t)numreceived || info.GetLiveBlocks() != 0 || info.GetPeakBytes() == 0)
+	{
+		cerr << "Counted " << info.GetNumberOfAllocations() << " packets, received " << numreceived << endl;
+		exit(-1);
+	}
+	if (info.GetAllocationRate() <= 0 || gethistogramtotal(info) != info.GetNumberOfAllocations())
+		fail("Wrong rate or histogram for packets");
+
+	mgr.GetMemoryTypeInfo(RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET, info);
+	if (info.GetNumberOfAllocations() != (uint64_t)num || info.GetLiveBytes() != 0 || info.GetTotalBytes() != (uint64_t)num*(12+sizeof(payload)))
+		fail("Wrong statistics for received packet buffers");
+
+	receiver.BYEDestroy(RTPTime(0,0), 0, 0);
+	sender.BYEDestroy(RTPTime(0,0), 0, 0);
+}
+
+int main(void)
+{
+	checkcounters();
+
+	RTPPooledMemoryManager pooledmgr;
+	RTPInstrumentedMemoryManager mgr(&pooledmgr);
+	RTPMemoryTypeInfo info;
+
+	runsession(mgr);
+
+	// Nothing may be left behind by the session
+
+	for (int i = 0 ; i < RTPINSTRUMENTEDMEMORYMANAGER_NUMMEMTYPES ; i++)
+	{
+		mgr.GetMemoryTypeInfo(i, info);
+		if (info.GetLiveBytes() != 0 || info.GetLiveBlocks() != 0)
+		{
+			cerr << info.GetLiveBytes() << " bytes of " << RTPInstrumentedMemoryManager::GetMemoryTypeName(i) << " are still allocated" << endl;
+			return -1;
+		}
+	}
+	cout << "Instrumented memory manager checks passed" << endl;
+	return 0;
+}
+
@@ -0,0 +1,164 @@
+#include "rtpconfig.h"
+#include <iostream>
+
+using namespace std;
+
+#ifdef RTP_SUPPORT_THREAD
+
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtpexternaltransmitter.h"
+#include "rtpipv4address.h"
+#include "rtppacket.h"
+#include "rtperrors.h"
+#include "rtptimeutilities.h"
+#include <jthread/jthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace jrtplib;
+using namespace jthread;
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+class ExtSender : public RTPExternalSender
+{
+public:
+	bool SendRTP(const void *, size_t)					{ return true; }
+	bool SendRTCP(const void *, size_t)					{ return true; }
+	bool ComesFromThisSender(const RTPAddress *)				{ return false; }
+};
+
+// Each thread injects a stream with its own SSRC, so that the session can check
+// that no packets were lost or reordered
+class InjectThread : public JThread
+{
+public:
+	InjectThread(RTPExternalPacketInjecter *p, uint32_t ssrc, int num) : m_pInjecter(p), m_ssrc(ssrc), m_num(num)
+	{
+	}
+
+	~InjectThread()
+	{
+		while (IsRunning())
+			RTPTime::Wait(RTPTime(0.01));
+	}
+private:
+	void *Thread()
+	{
+		JThread::ThreadStarted();
+
+		RTPIPv4Address addr(0x7f000001, 5000 + (uint16_t)m_ssrc);
+
+		for (int i = 0 ; i < m_num ; i++)
+		{
+			uint8_t packet[16] = { 0x80, 0x00 };
+			uint16_t seq = htons((uint16_t)i);
+			uint32_t ssrc = htonl(m_ssrc);
+
+			memcpy(packet+2, &seq, 2);
+			memcpy(packet+8, &ssrc, 4);
+			m_pInjecter->InjectRTP(packet, sizeof(packet), addr);
+		}
+		return 0;
+	}
+
+	RTPExternalPacketInjecter *m_pInjecter;
+	const uint32_t m_ssrc;
+	const int m_num;
+};
+
+int main(void)
+{
+	const int numthreads = 4;
+	const int numpackets = 10000;
+
+	ExtSender sender;
+	RTPSessionParams sessParams;
+	RTPExternalTransmissionParams transParams(&sender, 0);
+	RTPSession session;
+
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetUsePollThread(false);
+	sessParams.SetNeedThreadSafety(true);
+	checkerror(session.Create(sessParams, &transParams, RTPTransmitter::ExternalProto));
+
+	RTPExternalTransmissionInfo *pTransInf = static_cast<RTPExternalTransmissionInfo *>(session.GetTransmissionInfo());
+	RTPExternalPacketInjecter *pInjecter = pTransInf->GetPacketInjector();
+	session.DeleteTransmissionInfo(pTransInf);
+
+	InjectThread *threads[numthreads];
+	for (int i = 0 ; i < numthreads ; i++)
+	{
+		threads[i] = new InjectThread(pInjecter, i+1, numpackets);
+		threads[i]->Start();
+	}
+
+	int received = 0;
+	int errors = 0;
+	int32_t expected[numthreads+1];
+	for (int i = 0 ; i <= numthreads ; i++)
+		expected[i] = -1;
+
+	RTPTime start = RTPTime::CurrentTime();
+	while (received < numthreads*numpackets - numthreads*(RTP_PROBATIONCOUNT+1))
+	{
+		checkerror(session.WaitForIncomingData(RTPTime(0.1)));
+		checkerror(session.Poll());
+
+		session.BeginDataAccess();
+		if (session.GotoFirstSourceWithData())
+		{
+			do
+			{
+				RTPPacket *pack;
+
+				while ((pack = session.GetNextPacket()) != 0)
+				{
+					uint32_t ssrc = pack->GetSSRC();
+					int32_t seq = (int32_t)pack->GetSequenceNumber();
+
+					if (ssrc < 1 || ssrc > (uint32_t)numthreads || (expected[ssrc] >= 0 && seq != expected[ssrc]))
+						errors++;
+					expected[ssrc] = seq+1;
+					received++;
+					session.DeletePacket(pack);
+				}
+			} while (session.GotoNextSourceWithData());
+		}
+		session.EndDataAccess();
+
+		if (RTPTime::CurrentTime().GetDouble() - start.GetDouble() > 30.0)
+		{
+			cout << "Timeout" << endl;
+			errors++;
+			break;
+		}
+	}
+
+	for (int i = 0 ; i < numthreads ; i++)
+		delete threads[i];
+
+	session.Destroy();
+
+	cout << "Received " << received << " packets from " << numthreads << " injecting threads, " << errors << " errors" << endl;
+	return (errors == 0)?0:-1;
+}
+
+#else
+
+int main(void)
+{
+	cout << "Thread support is required for this test" << endl;
+	return 0;
+}
+
+#endif // RTP_SUPPORT_THREAD
+
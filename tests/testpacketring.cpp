@@ -0,0 +1,126 @@
+#include "rtpconfig.h"
+#include <iostream>
+
+#ifdef RTP_SUPPORT_PACKETRING
+
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtpudpv4transmitter.h"
+#include "rtppacketringtransmitter.h"
+#include "rtpipv4address.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "rtperrors.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+
+using namespace jrtplib;
+using namespace std;
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+// Sends packets from one UDP session to another one on the same host, while a
+// third session passively follows the stream using the packet ring transmitter.
+// Needs the CAP_NET_RAW capability; run it e.g. on 'lo' or on one end of a veth
+// pair while sending to the other end.
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		cerr << "Usage: " << argv[0] << " interface destinationIP" << endl;
+		return -1;
+	}
+
+	const uint16_t portbase = 5000;
+	const int numpackets = 1000;
+	uint32_t destip = ntohl(inet_addr(argv[2]));
+
+	RTPSessionParams sessParams;
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetUsePollThread(false);
+
+	RTPPacketRingTransmissionParams ringParams;
+	ringParams.SetInterfaceName(argv[1]);
+	ringParams.SetPortRange(portbase, portbase+1);
+
+	RTPSession probe;
+	checkerror(probe.Create(sessParams, &ringParams, RTPTransmitter::PacketRingProto));
+
+	RTPUDPv4TransmissionParams senderParams;
+	senderParams.SetPortbase(portbase+2);
+
+	RTPSession sender;
+	sessParams.SetAcceptOwnPackets(true);
+	checkerror(sender.Create(sessParams, &senderParams));
+	checkerror(sender.AddDestination(RTPIPv4Address(destip, portbase)));
+	sender.SetDefaultPayloadType(0);
+	sender.SetDefaultMark(false);
+	sender.SetDefaultTimestampIncrement(160);
+
+	int received = 0;
+	uint16_t expectedseq = 0;
+	bool first = true;
+	bool inorder = true;
+
+	for (int i = 0 ; i < numpackets ; i++)
+	{
+		uint8_t payload[160] = { 0 };
+
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+		checkerror(probe.Poll());
+
+		probe.BeginDataAccess();
+		if (probe.GotoFirstSourceWithData())
+		{
+			do
+			{
+				RTPPacket *pack;
+				
+				while ((pack = probe.GetNextPacket()) != 0)
+				{
+					if (!first && pack->GetSequenceNumber() != expectedseq)
+						inorder = false;
+					expectedseq = pack->GetSequenceNumber()+1;
+					first = false;
+					received++;
+					probe.DeletePacket(pack);
+				}
+			} while (probe.GotoNextSourceWithData());
+		}
+		probe.EndDataAccess();
+
+		RTPTime::Wait(RTPTime(0, 1000));
+	}
+
+	cout << "Sent " << numpackets << " packets, probe received " << received << ((inorder)?" (in order)":" (out of order)") << endl;
+
+	sender.BYEDestroy(RTPTime(1,0), 0, 0);
+	probe.Destroy();
+
+	// The last packets may still be underway when the loop ends
+	if (received < numpackets-10 || !inorder)
+	{
+		cerr << "Probe didn't receive the expected packets" << endl;
+		return -1;
+	}
+	return 0;
+}
+
+#else
+
+int main(void)
+{
+	std::cerr << "AF_PACKET receive ring support was not enabled" << std::endl;
+	return -1;
+}
+
+#endif // RTP_SUPPORT_PACKETRING
+
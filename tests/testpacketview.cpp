@@ -0,0 +1,225 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "rtppacketview.h"
+#include "rtpmemorymanager.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that RTPPacketView parses packets the same way as RTPPacket, and
+// that received packets which are handled using a view don't cause any
+// RTPPacket instances to be allocated
+
+void fail(const char *msg)
+{
+	cerr << msg << endl;
+	exit(-1);
+}
+
+class ViewSession : public RTPSession
+{
+public:
+	ViewSession(RTPMemoryManager *mgr) : RTPSession(0, mgr)		{ handle = true; numviews = 0; numvalidated = 0; numrtppackets = 0; }
+
+	bool handle;
+	int numviews, numvalidated, numrtppackets;
+	uint32_t lastseqnr;
+protected:
+	void OnRTPPacket(RTPPacket *, const RTPTime &, const RTPAddress *)		{ numrtppackets++; }
+	void OnValidatedRTPPacketView(RTPSourceData *, const RTPPacketView &pack, bool, bool *ispackethandled)
+	{
+		if (pack.GetPayloadLength() != 160 || pack.GetPayloadData()[0] != (uint8_t)(pack.GetSequenceNumber()&0xff))
+			fail("Payload of view is not correct");
+		lastseqnr = pack.GetExtendedSequenceNumber();
+		numviews++;
+		*ispackethandled = handle;
+	}
+	void OnValidatedRTPPacket(RTPSourceData *, RTPPacket *, bool, bool *)	{ numvalidated++; }
+};
+
+void comparefields(const RTPPacket &pack)
+{
+	RTPPacketView view;
+
+	checkerror(view.Parse(pack.GetPacketData(), pack.GetPacketLength(), RTPTime(0,0)));
+	if (view.HasExtension() != pack.HasExtension() || view.HasMarker() != pack.HasMarker() ||
+	    view.GetCSRCCount() != pack.GetCSRCCount() || view.GetPayloadType() != pack.GetPayloadType() ||
+	    view.GetExtendedSequenceNumber() != pack.GetExtendedSequenceNumber() ||
+	    view.GetSequenceNumber() != pack.GetSequenceNumber() || view.GetTimestamp() != pack.GetTimestamp() ||
+	    view.GetSSRC() != pack.GetSSRC() || view.GetPayloadLength() != pack.GetPayloadLength() ||
+	    view.GetPayloadData() != pack.GetPayloadData() || view.GetExtensionID() != pack.GetExtensionID() ||
+	    view.GetExtensionLength() != pack.GetExtensionLength())
+		fail("View and packet differ");
+	for (int i = 0 ; i < pack.GetCSRCCount() ; i++)
+	{
+		if (view.GetCSRC(i) != pack.GetCSRC(i))
+			fail("CSRC of view and packet differ");
+	}
+	if (pack.HasExtension() && view.GetExtensionData() != pack.GetPacketData()+12+pack.GetCSRCCount()*4+4)
+		fail("Extension data of view is not at the right position");
+}
+
+void checkparsing()
+{
+	uint8_t payload[100];
+	uint32_t csrcs[3] = { 0x11111111, 0x22222222, 0x33333333 };
+	uint8_t extdata[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+	for (int i = 0 ; i < (int)sizeof(payload) ; i++)
+		payload[i] = (uint8_t)i;
+
+	RTPPacket pack1(96, payload, sizeof(payload), 0xfffe, 0x12345678, 0xdeadbeef, false, 0, 0, false, 0, 0, 0, 1400);
+	RTPPacket pack2(127, payload, 17, 1234, 0xffffffff, 0x01020304, true, 3, csrcs, true, 0xbede, 2, extdata, 1400);
+	RTPPacket pack3(0, payload, 0, 0, 0, 0, true, 1, csrcs, false, 0, 0, 0, 1400);
+
+	checkerror(pack1.GetCreationError());
+	checkerror(pack2.GetCreationError());
+	checkerror(pack3.GetCreationError());
+	comparefields(pack1);
+	comparefields(pack2);
+	comparefields(pack3);
+
+	// Padding is removed from the payload
+
+	uint8_t buf[64];
+	RTPPacketView view;
+
+	memcpy(buf, pack1.GetPacketData(), 12+20);
+	buf[0] |= 0x20;
+	buf[12+19] = 4;
+	checkerror(view.Parse(buf, 12+20, RTPTime(0,0)));
+	if (view.GetPayloadLength() != 16)
+		fail("Padding was not taken into account");
+
+	// Invalid packets
+
+	if (view.Parse(buf, 11, RTPTime(0,0)) >= 0)
+		fail("Accepted a packet that's too short");
+	buf[12+19] = 21;
+	if (view.Parse(buf, 12+20, RTPTime(0,0)) >= 0)
+		fail("Accepted too many padding bytes");
+	buf[0] = 0x40;
+	if (view.Parse(buf, 12+20, RTPTime(0,0)) >= 0)
+		fail("Accepted a wrong version");
+	buf[0] = 0x80;
+	buf[1] = 200;
+	if (view.Parse(buf, 12+20, RTPTime(0,0)) >= 0)
+		fail("Accepted an RTCP sender report");
+	buf[1] = 96;
+	buf[0] = 0x90;
+	buf[14] = 0;
+	buf[15] = 10; // 40 bytes of extension data
+	if (view.Parse(buf, 12+20, RTPTime(0,0)) >= 0)
+		fail("Accepted a header extension that's too long");
+	if (view.Parse(buf, 14, RTPTime(0,0)) >= 0)
+		fail("Accepted a truncated header extension");
+	cout << "Parsing checks passed" << endl;
+}
+
+void sendpackets(RTPSession &sender, int num)
+{
+	uint8_t payload[160];
+
+	for (int i = 0 ; i < num ; i++)
+	{
+		// The payload allows the receiver to check that it got the right data
+		memset(payload, (int)(sender.GetNextSequenceNumber()&0xff), sizeof(payload));
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+	}
+}
+
+int main(void)
+{
+	checkparsing();
+
+	const int num = 100;
+	RTPLoopbackNetwork network;
+	CountingMemoryManager mgr;
+	ViewSession receiver(&mgr);
+	RTPSession sender;
+
+	RTPSessionParams sessParams = loopbacksessionparams();
+
+	sessParams.SetUsePacketViews(true);
+	createsession(receiver, network, 6000, sessParams);
+	createsession(sender, network, 7000);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	// The packets are handled using the view, so no RTPPacket instance
+	// is needed for them. The first ones are used for probation.
+
+	sendpackets(sender, num);
+	checkerror(receiver.Poll());
+	if (mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTPPACKET) != 0)
+	{
+		cerr << "Allocated " << mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTPPACKET) << " packets for handled views" << endl;
+		return -1;
+	}
+	if (receiver.numviews == 0 || receiver.numvalidated != 0 || receiver.numrtppackets != 0)
+		fail("Wrong callbacks were called for handled views");
+
+	int numhandled = receiver.numviews;
+
+	// Packets which aren't handled are stored and must still be intact
+
+	receiver.handle = false;
+	sendpackets(sender, num);
+	checkerror(receiver.Poll());
+	if (receiver.numviews-numhandled != num || receiver.numvalidated != num || mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTPPACKET) != num)
+	{
+		cerr << "Got " << receiver.numvalidated << " packets and allocated " << mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTPPACKET) << ", expected " << num << endl;
+		return -1;
+	}
+
+	int numstored = 0;
+
+	receiver.BeginDataAccess();
+	if (receiver.GotoFirstSourceWithData())
+	{
+		RTPPacket *pack;
+
+		while ((pack = receiver.GetNextPacket()) != 0)
+		{
+			if (pack->GetPayloadLength() != 160 || pack->GetPayloadData()[0] != (uint8_t)(pack->GetSequenceNumber()&0xff))
+				fail("Stored packet is not correct");
+			if (pack->GetExtendedSequenceNumber() != receiver.lastseqnr-num+1+numstored)
+				fail("Extended sequence number of stored packet is not correct");
+			numstored++;
+			receiver.DeletePacket(pack);
+		}
+	}
+	receiver.EndDataAccess();
+	if (numstored != num)
+	{
+		cerr << "Stored " << numstored << " packets, expected " << num << endl;
+		return -1;
+	}
+
+	// Without packet views, OnRTPPacket needs an RTPPacket for every packet
+
+	CountingMemoryManager mgr2;
+	ViewSession receiver2(&mgr2);
+
+	createsession(receiver2, network, 8000);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 8000)));
+	sendpackets(sender, num);
+	checkerror(receiver2.Poll());
+	if (receiver2.numrtppackets != num || mgr2.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTPPACKET) != num)
+		fail("OnRTPPacket wasn't called for every packet");
+
+	receiver.BYEDestroy(RTPTime(0,0), 0, 0);
+	receiver2.BYEDestroy(RTPTime(0,0), 0, 0);
+	sender.BYEDestroy(RTPTime(0,0), 0, 0);
+	cout << "Packet view checks passed" << endl;
+	return 0;
+}
+
@@ -0,0 +1,418 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "rtppooledmemorymanager.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jthread.h>
+#endif // RTP_SUPPORT_THREAD
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that the pooled memory manager reuses freed blocks, that blocks
+// allocated in one thread can be freed in another, and that a session which 
+// uses it doesn't need any system allocations anymore once the pools have 
+// grown large enough. Sessions with a poll thread must give the blocks that
+// thread kept for itself back when it stops, and so must other threads when
+// they exit
+
+void fail(const char *msg)
+{
+	cerr << msg << endl;
+	exit(-1);
+}
+
+void checkpools()
+{
+	RTPPooledMemoryManager mgr;
+
+	// Freed blocks are reused for the same type or size
+
+	void *pack1 = mgr.AllocateBuffer(sizeof(RTPPacket), RTPMEM_TYPE_CLASS_RTPPACKET);
+	void *pack2 = mgr.AllocateBuffer(sizeof(RTPPacket), RTPMEM_TYPE_CLASS_RTPPACKET);
+
+	if (pack1 == 0 || pack2 == 0 || pack1 == pack2)
+		fail("Couldn't allocate two blocks");
+	mgr.FreeBuffer(pack1);
+	if (mgr.AllocateBuffer(sizeof(RTPPacket), RTPMEM_TYPE_CLASS_RTPPACKET) != pack1)
+		fail("Freed class block was not reused");
+
+	void *buf1 = mgr.AllocateBuffer(1000, RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET);
+
+	memset(buf1, 0xff, 1000);
+	mgr.FreeBuffer(buf1);
+	if (mgr.AllocateBuffer(900, RTPMEM_TYPE_BUFFER_RTPPACKET) != buf1)
+		fail("Freed buffer was not reused for a buffer of similar size");
+	
+	// A larger instance of a class type, e.g. a different RTPAddress 
+	// implementation, must still get a large enough block
+
+	void *addr1 = mgr.AllocateBuffer(16, RTPMEM_TYPE_CLASS_RTPADDRESS);
+	void *addr2 = mgr.AllocateBuffer(200, RTPMEM_TYPE_CLASS_RTPADDRESS);
+
+	memset(addr1, 0xff, 16);
+	memset(addr2, 0xff, 200);
+	mgr.FreeBuffer(addr1);
+	mgr.FreeBuffer(addr2);
+
+	int32_t numsysalloc = mgr.GetNumberOfSystemAllocations();
+	void *big = mgr.AllocateBuffer(RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE+1, RTPMEM_TYPE_BUFFER_SRTPDATA);
+	
+	if (big == 0 || mgr.GetNumberOfSystemAllocations() != numsysalloc+1)
+		fail("Large buffer was not allocated from the system");
+	mgr.FreeBuffer(big);
+
+	// Preallocated blocks don't require system allocations anymore
+
+	checkerror(mgr.Preallocate(RTPMEM_TYPE_CLASS_RTPRAWPACKET, 100, 500));
+	numsysalloc = mgr.GetNumberOfSystemAllocations();
+	
+	void *blocks[500];
+
+	for (int i = 0 ; i < 500 ; i++)
+	{
+		if ((blocks[i] = mgr.AllocateBuffer(100, RTPMEM_TYPE_CLASS_RTPRAWPACKET)) == 0)
+			fail("Couldn't allocate preallocated block");
+	}
+	if (mgr.GetNumberOfSystemAllocations() != numsysalloc)
+		fail("Preallocated blocks caused system allocations");
+	for (int i = 0 ; i < 500 ; i++)
+		mgr.FreeBuffer(blocks[i]);
+	if (mgr.Preallocate(RTPMEM_TYPE_BUFFER_SRTPDATA, RTPPOOLEDMEMORYMANAGER_MAXBUCKETSIZE+1, 1) >= 0)
+		fail("Preallocated a block which is too large");
+
+	// Beyond the maximum, blocks are passed to the system directly
+
+	mgr.SetMaximumPooledMemory(mgr.GetPooledMemory());
+	if (mgr.Preallocate(RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET, 10000, 100) != ERR_RTP_POOLEDMEMORYMANAGER_MAXIMUMREACHED)
+		fail("Preallocation exceeded the maximum");
+	for (int i = 0 ; i < 10 ; i++)
+	{
+		if ((blocks[i] = mgr.AllocateBuffer(10000, RTPMEM_TYPE_BUFFER_RECEIVEDRTCPPACKET)) == 0)
+			fail("Couldn't allocate block beyond the maximum");
+		memset(blocks[i], 0xff, 10000);
+	}
+	if (mgr.GetPooledMemory() != mgr.GetMaximumPooledMemory())
+		fail("Pooled memory exceeded the maximum");
+	for (int i = 0 ; i < 10 ; i++)
+		mgr.FreeBuffer(blocks[i]);
+	mgr.FreeBuffer(pack2);
+	cout << "Pool checks passed" << endl;
+}
+
+#ifdef RTP_SUPPORT_THREAD
+
+// Allocates blocks like a poll thread would do for incoming packets; the
+// main thread checks and frees them
+
+class ProducerThread : public jthread::JThread
+{
+public:
+	ProducerThread(RTPPooledMemoryManager &m) : mgr(m), stop(0)			{ mutex.Init(); }
+
+	void Stop()
+	{
+		stop.Set(1);
+		while (IsRunning())
+			RTPTime::Wait(RTPTime(0.01));
+	}
+
+	vector<uint8_t *> GetBlocks()
+	{
+		vector<uint8_t *> b;
+
+		mutex.Lock();
+		b.swap(blocks);
+		mutex.Unlock();
+		return b;
+	}
+private:
+	void *Thread()
+	{
+		JThread::ThreadStarted();
+
+		uint8_t counter = 0;
+
+		while (!stop.Get())
+		{
+			mutex.Lock();
+			size_t num = blocks.size();
+			mutex.Unlock();
+
+			if (num > 1000)
+			{
+				RTPTime::Wait(RTPTime(0, 100));
+				continue;
+			}
+
+			uint8_t *pack = (uint8_t *)mgr.AllocateBuffer(sizeof(RTPPacket), RTPMEM_TYPE_CLASS_RTPPACKET);
+			uint8_t *data = (uint8_t *)mgr.AllocateBuffer(1200, RTPMEM_TYPE_BUFFER_RECEIVEDRTPPACKET);
+
+			if (pack == 0 || data == 0)
+				fail("Couldn't allocate block in producer thread");
+			memset(pack, counter, sizeof(RTPPacket));
+			memset(data, counter, 1200);
+			counter++;
+
+			mutex.Lock();
+			blocks.push_back(pack);
+			blocks.push_back(data);
+			mutex.Unlock();
+		}
+		mgr.FlushThreadCache();
+		return 0;
+	}
+
+	RTPPooledMemoryManager &mgr;
+	RTPAtomicInteger stop;
+	jthread::JMutex mutex;
+	vector<uint8_t *> blocks;
+};
+
+int consumeblocks(ProducerThread &producer, RTPPooledMemoryManager &mgr, int num)
+{
+	int count = 0;
+
+	while (count < num)
+	{
+		vector<uint8_t *> blocks = producer.GetBlocks();
+
+		for (size_t i = 0 ; i < blocks.size() ; i += 2)
+		{
+			for (size_t j = 0 ; j < sizeof(RTPPacket) ; j++)
+			{
+				if (blocks[i][j] != blocks[i][0])
+					fail("Block was changed before it was freed");
+			}
+			for (size_t j = 0 ; j < 1200 ; j++)
+			{
+				if (blocks[i+1][j] != blocks[i][0])
+					fail("Buffer was changed before it was freed");
+			}
+			mgr.FreeBuffer(blocks[i]);
+			mgr.FreeBuffer(blocks[i+1]);
+			count++;
+		}
+		if (blocks.empty())
+			RTPTime::Wait(RTPTime(0, 100));
+	}
+	return count;
+}
+
+void checkthreads()
+{
+	RTPPooledMemoryManager mgr;
+	ProducerThread producer(mgr);
+
+	if (producer.Start() < 0)
+		fail("Couldn't start producer thread");
+
+	// The blocks freed by this thread must flow back to the producer
+	
+	consumeblocks(producer, mgr, 20000);
+
+	int32_t numsysalloc = mgr.GetNumberOfSystemAllocations();
+
+	consumeblocks(producer, mgr, 100000);
+	if (mgr.GetNumberOfSystemAllocations() != numsysalloc)
+	{
+		cerr << "Freeing blocks in another thread needed " << (mgr.GetNumberOfSystemAllocations()-numsysalloc) << " system allocations" << endl;
+		exit(-1);
+	}
+	producer.Stop();
+	consumeblocks(producer, mgr, 0);
+
+	vector<uint8_t *> blocks = producer.GetBlocks();
+
+	for (size_t i = 0 ; i < blocks.size() ; i++)
+		mgr.FreeBuffer(blocks[i]);
+	mgr.FlushThreadCache();
+	cout << "Thread checks passed" << endl;
+}
+
+#ifdef RTP_HAVE_PTHREAD_KEY
+
+// Allocates and frees blocks, so that its magazines are filled, and exits
+// without flushing them
+
+class ExitingThread : public jthread::JThread
+{
+public:
+	ExitingThread(RTPPooledMemoryManager &m) : mgr(m)				{ }
+private:
+	void *Thread()
+	{
+		JThread::ThreadStarted();
+
+		uint8_t *blocks[200];
+
+		for (int i = 0 ; i < 200 ; i++)
+		{
+			if ((blocks[i] = (uint8_t *)mgr.AllocateBuffer(sizeof(RTPPacket), RTPMEM_TYPE_CLASS_RTPPACKET)) == 0)
+				fail("Couldn't allocate block in exiting thread");
+		}
+		for (int i = 0 ; i < 200 ; i++)
+			mgr.FreeBuffer(blocks[i]);
+		return 0;
+	}
+
+	RTPPooledMemoryManager &mgr;
+};
+
+void checkexitingthreads()
+{
+	RTPPooledMemoryManager mgr;
+	size_t pooledmemory = 0;
+
+	// If the blocks in the magazines of a thread that exits were not 
+	// returned, each new thread would need more of them from the pool
+
+	for (int i = 0 ; i < 40 ; i++)
+	{
+		ExitingThread thread(mgr);
+
+		if (thread.Start() < 0)
+			fail("Couldn't start exiting thread");
+		while (thread.IsRunning())
+			RTPTime::Wait(RTPTime(0, 1000));
+
+		// The magazines are returned after the thread function itself
+		// has finished
+		RTPTime::Wait(RTPTime(0, 20000));
+
+		if (i == 4)
+			pooledmemory = mgr.GetPooledMemory();
+		else if (i > 4 && mgr.GetPooledMemory() != pooledmemory)
+		{
+			cerr << "Pooled memory grew from " << pooledmemory << " to " << mgr.GetPooledMemory() << " bytes after " << (i+1) << " exiting threads" << endl;
+			exit(-1);
+		}
+	}
+	cout << "Exiting thread checks passed" << endl;
+}
+
+#endif // RTP_HAVE_PTHREAD_KEY
+
+#endif // RTP_SUPPORT_THREAD
+
+void exchangepackets(RTPSession &sender, RTPSession &receiver, int num)
+{
+	uint8_t payload[160];
+
+	for (int i = 0 ; i < num ; i++)
+	{
+		memset(payload, (int)(sender.GetNextSequenceNumber()&0xff), sizeof(payload));
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+		if (i%10 == 9)
+		{
+			checkerror(receiver.Poll());
+			receiver.BeginDataAccess();
+			if (receiver.GotoFirstSourceWithData())
+			{
+				RTPPacket *pack;
+
+				do
+				{
+					while ((pack = receiver.GetNextPacket()) != 0)
+					{
+						if (pack->GetPayloadLength() != sizeof(payload) || pack->GetPayloadData()[0] != (uint8_t)(pack->GetSequenceNumber()&0xff))
+							fail("Received packet is not correct");
+						receiver.DeletePacket(pack);
+					}
+				} while (receiver.GotoNextSourceWithData());
+			}
+			receiver.EndDataAccess();
+		}
+	}
+}
+
+#ifdef RTP_SUPPORT_THREAD
+
+void checkpollthreads()
+{
+	RTPPooledMemoryManager mgr;
+	RTPLoopbackNetwork network;
+	RTPSession sender(0, &mgr);
+	uint8_t payload[160] = { 0 };
+	size_t pooledmemory = 0;
+
+	createsession(sender, network, 7000);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	// Each receiver gets a new poll thread; if the blocks in the magazines of
+	// the previous ones were not returned, the pools would keep growing
+
+	for (int i = 0 ; i < 40 ; i++)
+	{
+		RTPSession receiver(0, &mgr);
+
+		createsession(receiver, network, 6000, loopbacksessionparams(true));
+		for (int j = 0 ; j < 200 ; j++)
+			checkerror(sender.SendPacket(payload, sizeof(payload)));
+		RTPTime::Wait(RTPTime(0, 100000));
+		receiver.BYEDestroy(RTPTime(0,0), 0, 0);
+
+		// The pools can still grow a bit during the first ones
+		if (i == 19)
+			pooledmemory = mgr.GetPooledMemory();
+		else if (i > 19 && mgr.GetPooledMemory() != pooledmemory)
+		{
+			cerr << "Pooled memory grew from " << pooledmemory << " to " << mgr.GetPooledMemory() << " bytes after " << (i+1) << " poll threads" << endl;
+			exit(-1);
+		}
+	}
+	sender.BYEDestroy(RTPTime(0,0), 0, 0);
+	cout << "Poll thread checks passed" << endl;
+}
+
+#endif // RTP_SUPPORT_THREAD
+
+int main(void)
+{
+	checkpools();
+#ifdef RTP_SUPPORT_THREAD
+	checkthreads();
+#ifdef RTP_HAVE_PTHREAD_KEY
+	checkexitingthreads();
+#endif // RTP_HAVE_PTHREAD_KEY
+	checkpollthreads();
+#endif // RTP_SUPPORT_THREAD
+
+	RTPPooledMemoryManager mgr;
+	RTPLoopbackNetwork network;
+	RTPSession sender(0, &mgr), receiver(0, &mgr);
+
+	createsession(receiver, network, 6000);
+	createsession(sender, network, 7000);
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	// Once the pools have grown during the first packets, receiving more
+	// packets must not need any memory from the system
+
+	exchangepackets(sender, receiver, 1000);
+
+	int32_t numsysalloc = mgr.GetNumberOfSystemAllocations();
+
+	exchangepackets(sender, receiver, 10000);
+	if (mgr.GetNumberOfSystemAllocations() != numsysalloc)
+	{
+		cerr << "Steady state needed " << (mgr.GetNumberOfSystemAllocations()-numsysalloc) << " system allocations" << endl;
+		return -1;
+	}
+	cout << "Used " << numsysalloc << " system allocations, " << mgr.GetPooledMemory() << " bytes pooled" << endl;
+
+	receiver.BYEDestroy(RTPTime(0,0), 0, 0);
+	sender.BYEDestroy(RTPTime(0,0), 0, 0);
+	cout << "Pooled memory manager checks passed" << endl;
+	return 0;
+}
+
@@ -0,0 +1,260 @@
+#include "rtpsources.h"
+#include "rtpsourcedata.h"
+#include "rtppacketbuilder.h"
+#include "rtcppacketbuilder.h"
+#include "rtcpcompoundpacket.h"
+#include "rtcprrpacket.h"
+#include "rtcpsrpacket.h"
+#include "rtppacket.h"
+#include "rtpipv4address.h"
+#include "rtprandom.h"
+#include "rtperrors.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <map>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that the RTCP packet builder adds exactly one report block for each
+// source that sent data, now that it looks for them in the report table
+// instead of in the sources themselves, also when sources are removed from
+// the table. Also measures how long it takes to build an RTCP packet when
+// most members are not sending.
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+const uint32_t firstsenderssrc = 0x10000;
+const uint32_t firstmemberssrc = 0x20000;
+const uint32_t csrc = 0x30000;
+
+uint16_t seqnrs[1000];
+
+void sendpacket(RTPSources &sources, int sender, bool withcsrc)
+{
+	uint8_t payload[20] = { 0 };
+	RTPPacket *pack = new RTPPacket(96, payload, sizeof(payload), seqnrs[sender]++, 0, firstsenderssrc+sender, false,
+	                                (withcsrc)?1:0, &csrc, false, 0, 0, 0, 0);
+	RTPIPv4Address addr(0x7f000001, (uint16_t)(10000+sender*2));
+	bool stored;
+
+	checkerror(pack->GetCreationError());
+	checkerror(sources.ProcessRTPPacket(pack, RTPTime::CurrentTime(), &addr, &stored));
+	if (!stored)
+		delete pack;
+}
+
+void addmember(RTPSources &sources, int member)
+{
+	RTPIPv4Address addr(0x7f000002, (uint16_t)(10000+member*2));
+
+	checkerror(sources.UpdateReceiveTime(firstmemberssrc+member, RTPTime::CurrentTime(), &addr));
+}
+
+// Adds the SSRCs of the report blocks in the packet to 'reported'; returns false
+// if a report block doesn't match the statistics of the source, or if a source
+// is reported twice in the same packet
+bool getreports(RTPSources &sources, RTCPCompoundPacket *pack, map<uint32_t,int> &reported)
+{
+	map<uint32_t,int> inpacket;
+	RTCPPacket *rtcppack;
+
+	pack->GotoFirstPacket();
+	while ((rtcppack = pack->GetNextPacket()) != 0)
+	{
+		int num = 0;
+
+		if (rtcppack->GetPacketType() == RTCPPacket::RR)
+			num = ((RTCPRRPacket *)rtcppack)->GetReceptionReportCount();
+		else if (rtcppack->GetPacketType() == RTCPPacket::SR)
+			num = ((RTCPSRPacket *)rtcppack)->GetReceptionReportCount();
+
+		for (int i = 0 ; i < num ; i++)
+		{
+			uint32_t ssrc;
+			uint32_t exthighseqnr;
+			int32_t lost;
+
+			if (rtcppack->GetPacketType() == RTCPPacket::RR)
+			{
+				RTCPRRPacket *rr = (RTCPRRPacket *)rtcppack;
+
+				ssrc = rr->GetSSRC(i);
+				exthighseqnr = rr->GetExtendedHighestSequenceNumber(i);
+				lost = rr->GetLostPacketCount(i);
+			}
+			else
+			{
+				RTCPSRPacket *sr = (RTCPSRPacket *)rtcppack;
+
+				ssrc = sr->GetSSRC(i);
+				exthighseqnr = sr->GetExtendedHighestSequenceNumber(i);
+				lost = sr->GetLostPacketCount(i);
+			}
+
+			RTPSourceData *srcdat = sources.GetSourceInfo(ssrc);
+
+			if (srcdat == 0 || srcdat->INF_GetExtendedHighestSequenceNumber() != exthighseqnr || lost != 0)
+				return false;
+			if (inpacket[ssrc]++ > 0)
+				return false;
+			reported[ssrc]++;
+		}
+	}
+	return true;
+}
+
+// Builds RTCP packets until each sender has been reported; once all senders
+// were handled, the builder may start over in the same packet
+bool checkround(RTPSources &sources, RTCPPacketBuilder &rtcpbuilder, const vector<int> &senders)
+{
+	map<uint32_t,int> reported;
+	int numpackets = 0;
+
+	while (reported.size() < senders.size() && numpackets < 10)
+	{
+		RTCPCompoundPacket *pack;
+
+		// Report blocks are only added for sources which sent data since
+		// the previous RTCP packet
+		RTPTime::Wait(RTPTime(0, 1000));
+		for (size_t i = 0 ; i < senders.size() ; i++)
+			sendpacket(sources, senders[i], false);
+
+		checkerror(rtcpbuilder.BuildNextPacket(&pack));
+		if (!getreports(sources, pack, reported))
+		{
+			cerr << "Report blocks don't match the source statistics" << endl;
+			delete pack;
+			return false;
+		}
+		delete pack;
+		numpackets++;
+	}
+
+	for (size_t i = 0 ; i < senders.size() ; i++)
+	{
+		map<uint32_t,int>::const_iterator it = reported.find(firstsenderssrc+senders[i]);
+
+		if (it == reported.end())
+		{
+			cerr << "Sender " << senders[i] << " was not reported" << endl;
+			return false;
+		}
+	}
+	if (reported.size() != senders.size())
+	{
+		cerr << "Report blocks for " << reported.size() << " sources, expected " << senders.size() << endl;
+		return false;
+	}
+	cout << senders.size() << " senders reported in " << numpackets << " RTCP packets" << endl;
+
+	return true;
+}
+
+int main(void)
+{
+	const int numsenders = 120; // more than fit in a single RTCP packet
+	const int nummembers = 500;
+	RTPRandom *rnd = RTPRandom::CreateDefaultRandomNumberGenerator();
+	RTPSources sources(RTPSources::NoProbation);
+	RTPPacketBuilder packetbuilder(*rnd);
+	RTCPPacketBuilder rtcpbuilder(sources, packetbuilder);
+
+	checkerror(packetbuilder.Init(1400));
+	checkerror(rtcpbuilder.Init(1400, 1.0/8000.0, "test", 4));
+	checkerror(sources.CreateOwnSSRC(packetbuilder.GetSSRC()));
+
+	// Members which are only known from RTCP packets are mixed with the senders
+
+	vector<int> senders;
+
+	for (int i = 0 ; i < numsenders ; i++)
+	{
+		addmember(sources, i*2);
+		addmember(sources, i*2+1);
+		sendpacket(sources, i, (i == 0));
+		senders.push_back(i);
+	}
+	for (int i = numsenders*2 ; i < nummembers ; i++)
+		addmember(sources, i);
+
+	if (sources.GetSourceInfo(csrc) == 0 || !sources.GetSourceInfo(csrc)->IsCSRC())
+	{
+		cerr << "CSRC was not added" << endl;
+		return -1;
+	}
+	if (!checkround(sources, rtcpbuilder, senders) || !checkround(sources, rtcpbuilder, senders))
+		return -1;
+
+	// Let the other members time out, so that the slots of the senders are
+	// moved around in the report table
+
+	RTPTime::Wait(RTPTime(0, 50000));
+	for (int i = 0 ; i < numsenders ; i++)
+		sendpacket(sources, i, false);
+
+	RTPTime longtime(1000, 0);
+	RTPTime shorttime(0, 25000);
+
+	sources.MultipleTimeouts(RTPTime::CurrentTime(), longtime, longtime, shorttime, longtime);
+	if (sources.GetTotalCount() != numsenders+1)
+	{
+		cerr << sources.GetTotalCount() << " sources left, expected " << numsenders+1 << endl;
+		return -1;
+	}
+	if (!checkround(sources, rtcpbuilder, senders))
+		return -1;
+
+	// Only a few sources keep sending
+
+	vector<int> activesenders;
+
+	activesenders.push_back(3);
+	activesenders.push_back(77);
+	activesenders.push_back(119);
+	if (!checkround(sources, rtcpbuilder, activesenders))
+		return -1;
+
+	// Measure how long it takes to build an RTCP packet when only a few of
+	// many members are sending
+
+	const int numidle = 20000;
+	const int numrounds = 200;
+
+	for (int i = nummembers ; i < nummembers+numidle ; i++)
+		addmember(sources, i);
+
+	RTPTime buildtime(0, 0);
+
+	for (int r = 0 ; r < numrounds ; r++)
+	{
+		RTCPCompoundPacket *pack;
+
+		for (size_t i = 0 ; i < activesenders.size() ; i++)
+			sendpacket(sources, activesenders[i], false);
+
+		RTPTime start = RTPTime::CurrentTime();
+		checkerror(rtcpbuilder.BuildNextPacket(&pack));
+		RTPTime t = RTPTime::CurrentTime();
+
+		t -= start;
+		buildtime += t;
+		delete pack;
+	}
+	cout << "Building an RTCP packet with " << sources.GetTotalCount() << " members: " << buildtime.GetDouble()*1e6/numrounds << " us" << endl;
+
+	rtcpbuilder.Destroy();
+	packetbuilder.Destroy();
+	sources.Clear();
+	delete rnd;
+	return 0;
+}
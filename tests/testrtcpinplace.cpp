@@ -0,0 +1,289 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtcpcompoundpacket.h"
+#include "rtcpcompoundpacketbuilder.h"
+#include "rtcpsdespacket.h"
+#include "rtpsourcedata.h"
+#include "rtpmemorymanager.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that RTCP compound packets which are built in place are identical
+// to the ones built the normal way, and that a session which builds its
+// RTCP packets in place doesn't allocate memory for them
+
+void fail(const char *msg)
+{
+	cerr << msg << endl;
+	exit(-1);
+}
+
+struct PacketContents
+{
+	bool sr;
+	int numblocks;
+	int numsdessources;
+	int numitems;
+	int numapp;
+	int numbye;
+};
+
+// Adds the same information to a builder, whichever way it was initialized;
+// returns the first error, if any
+int fillpacket(RTCPCompoundPacketBuilder &builder, const PacketContents &c)
+{
+	int status;
+
+	if (c.sr)
+		status = builder.StartSenderReport(0x12345678, RTPNTPTime(0x11223344, 0x55667788), 1000, 20, 3200);
+	else
+		status = builder.StartReceiverReport(0x12345678);
+	if (status < 0)
+		return status;
+
+	// Alternate between report blocks and SDES, the reports must still come first
+	for (int i = 0 ; i < c.numblocks || i < c.numsdessources ; i++)
+	{
+		if (i < c.numblocks)
+		{
+			if ((status = builder.AddReportBlock(0x1000+i, (uint8_t)i, i*100, 0x20000+i, i*7, 0xaabbccdd+i, i*3)) < 0)
+				return status;
+		}
+		if (i < c.numsdessources)
+		{
+			if ((status = builder.AddSDESSource(0x2000+i)) < 0)
+				return status;
+			for (int j = 0 ; j < c.numitems ; j++)
+			{
+				char value[64];
+
+				// Different lengths, to get different amounts of padding
+				memset(value, 'a'+j, sizeof(value));
+				if ((status = builder.AddSDESNormalItem(RTCPSDESPacket::CNAME, value, (uint8_t)((i+j*5)%40))) < 0)
+					return status;
+			}
+#ifdef RTP_SUPPORT_SDESPRIV
+			if (c.numitems > 0 && (status = builder.AddSDESPrivateItem("prefix", 6, "value", 5)) < 0)
+				return status;
+#endif // RTP_SUPPORT_SDESPRIV
+		}
+	}
+
+	uint8_t appdata[16];
+	uint32_t ssrcs[3] = { 0x12345678, 0x87654321, 0x0f0f0f0f };
+
+	memset(appdata, 0x5a, sizeof(appdata));
+	for (int i = 0 ; i < c.numapp ; i++)
+	{
+		if ((status = builder.AddAPPPacket((uint8_t)i, 0x12345678, (const uint8_t *)"TEST", appdata, (i%2)*sizeof(appdata))) < 0)
+			return status;
+	}
+	for (int i = 0 ; i < c.numbye ; i++)
+	{
+		if ((status = builder.AddBYEPacket(ssrcs, 1+i%3, "bye", (uint8_t)(i%4))) < 0)
+			return status;
+	}
+	return 0;
+}
+
+void comparebuilders(RTCPCompoundPacketBuilder &inplace, const PacketContents &c, size_t maxpacksize)
+{
+	RTCPCompoundPacketBuilder normal;
+
+	checkerror(normal.InitBuild(maxpacksize));
+	checkerror(inplace.InitBuildInPlace(maxpacksize));
+
+	int status1 = fillpacket(normal, c);
+	int status2 = fillpacket(inplace, c);
+
+	if (status1 != status2)
+	{
+		cerr << "Normal build returned " << status1 << ", in place build returned " << status2 << endl;
+		exit(-1);
+	}
+	checkerror(normal.EndBuild());
+	checkerror(inplace.EndBuild());
+
+	if (normal.GetCompoundPacketLength() != inplace.GetCompoundPacketLength() ||
+	    memcmp(normal.GetCompoundPacketData(), inplace.GetCompoundPacketData(), normal.GetCompoundPacketLength()) != 0)
+	{
+		cerr << "Packets differ for " << c.numblocks << " report blocks and " << c.numsdessources << " SDES sources" << endl;
+		exit(-1);
+	}
+
+	// The data must also be a valid compound packet
+	RTCPCompoundPacket parsed(inplace.GetCompoundPacketData(), inplace.GetCompoundPacketLength(), false);
+
+	checkerror(parsed.GetCreationError());
+}
+
+void checkbuilder()
+{
+	// The same builder is used for all in place builds, so this also checks
+	// that the buffers are reused correctly
+	CountingMemoryManager mgr;
+	RTCPCompoundPacketBuilder inplace(&mgr);
+	PacketContents contents[] =
+	{
+		{ false, 0, 0, 0, 0, 0 },
+		{ true, 1, 1, 1, 0, 0 },
+		{ true, 31, 2, 3, 1, 0 },
+		{ false, 32, 31, 1, 0, 1 },
+		{ true, 70, 40, 2, 3, 2 },
+		{ false, 5, 3, 0, 2, 3 },
+	};
+	const int numcontents = sizeof(contents)/sizeof(PacketContents);
+
+	for (int i = 0 ; i < numcontents ; i++)
+		comparebuilders(inplace, contents[i], 8192);
+
+	// The builders must run out of space at the same point
+	for (int i = 0 ; i < numcontents ; i++)
+	{
+		for (size_t size = RTP_MINPACKETSIZE ; size < 1500 ; size += 28)
+			comparebuilders(inplace, contents[i], size);
+	}
+
+	// Once the buffers are large enough, building doesn't allocate anything
+	int numallocations = mgr.numallocations;
+
+	for (int i = 0 ; i < numcontents ; i++)
+		comparebuilders(inplace, contents[i], 8192);
+	if (mgr.numallocations != numallocations)
+	{
+		cerr << "In place builder allocated " << (mgr.numallocations-numallocations) << " times" << endl;
+		exit(-1);
+	}
+
+	// SDES information can't be added after APP or BYE packets
+	checkerror(inplace.InitBuildInPlace(1400));
+	checkerror(inplace.StartReceiverReport(0x12345678));
+	checkerror(inplace.AddBYEPacket(0, 0, 0, 0));
+	if (inplace.AddSDESSource(0x11111111) != ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER)
+		fail("Adding an SDES source after a BYE packet should fail");
+	if (inplace.AddAPPPacket(0, 0x12345678, (const uint8_t *)"TEST", 0, 0) != ERR_RTP_RTCPCOMPPACKBUILDER_INVALIDORDER)
+		fail("Adding an APP packet after a BYE packet should fail");
+	checkerror(inplace.AddReportBlock(0x1000, 0, 0, 0, 0, 0, 0));
+	checkerror(inplace.EndBuild());
+	cout << "Builder checks passed" << endl;
+}
+
+class RTCPCountingSession : public RTPSession
+{
+public:
+	RTCPCountingSession(CountingMemoryManager *mgr) : RTPSession(0, mgr), memmgr(mgr)	{ numrtcp = 0; numallocations = 0; }
+
+	int numrtcp;
+	int numallocations;
+protected:
+	void OnSendRTCPCompoundPacket(RTCPCompoundPacket *pack)
+	{
+		RTCPCompoundPacket parsed(pack->GetCompoundPacketData(), pack->GetCompoundPacketLength(), false);
+
+		checkerror(parsed.GetCreationError());
+
+		// Skip the first packets, the buffers need to be allocated first
+		numrtcp++;
+		if (numrtcp == 2)
+			numallocations = memmgr->numallocations;
+	}
+private:
+	CountingMemoryManager *memmgr;
+};
+
+// Sends RTCP packets often, so the test doesn't take long
+RTPSessionParams rtcpsessionparams(bool inplace)
+{
+	RTPSessionParams sessParams = loopbacksessionparams();
+
+	sessParams.SetMinimumRTCPTransmissionInterval(RTPTime(1, 0));
+	sessParams.SetSessionBandwidth(1000000.0);
+	sessParams.SetBuildRTCPInPlace(inplace);
+	return sessParams;
+}
+
+int main(void)
+{
+	checkbuilder();
+
+	RTPLoopbackNetwork network;
+	RTPSession receiver;
+	RTPSessionParams sessParams;
+	RTPLoopbackTransmissionParams transParams(&network);
+
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetUsePollThread(false);
+	transParams.SetPortbase(6000);
+	checkerror(receiver.Create(sessParams, &transParams, RTPTransmitter::LoopbackProto));
+
+	// Both sessions send RTCP packets to the receiver at the same time, one
+	// of them builds them the normal way, the other one in place
+
+	CountingMemoryManager normalmgr, inplacemgr;
+	RTCPCountingSession normal(&normalmgr), inplace(&inplacemgr);
+	const int numrtcp = 6;
+
+	createsession(normal, network, 8000, rtcpsessionparams(false));
+	createsession(inplace, network, 10000, rtcpsessionparams(true));
+	checkerror(normal.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+	checkerror(inplace.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+
+	RTPTime start = RTPTime::CurrentTime();
+
+	while (normal.numrtcp < numrtcp || inplace.numrtcp < numrtcp)
+	{
+		if (normal.numrtcp < numrtcp)
+			checkerror(normal.Poll());
+		if (inplace.numrtcp < numrtcp)
+			checkerror(inplace.Poll());
+		RTPTime::Wait(RTPTime(0, 10000));
+
+		RTPTime diff = RTPTime::CurrentTime();
+		diff -= start;
+		if (diff.GetDouble() > 30.0)
+			fail("Sessions didn't send enough RTCP packets");
+	}
+
+	int numnormal = normalmgr.numallocations-normal.numallocations;
+	int numinplace = inplacemgr.numallocations-inplace.numallocations;
+
+	cout << "Allocations for " << (numrtcp-2) << " RTCP packets: " << numnormal << " normally, " << numinplace << " in place" << endl;
+	if (numnormal == 0 || numinplace != 0)
+		fail("RTCP packets built in place should not need any allocations");
+
+	// The receiver must have understood the packets
+	checkerror(receiver.Poll());
+	receiver.BeginDataAccess();
+
+	int numsources = 0;
+
+	if (receiver.GotoFirstSource())
+	{
+		do
+		{
+			RTPSourceData *srcdat = receiver.GetCurrentSourceInfo();
+			size_t cnamelen;
+
+			if (!srcdat->IsOwnSSRC() && srcdat->SDES_GetCNAME(&cnamelen) != 0 && cnamelen > 0)
+				numsources++;
+		} while (receiver.GotoNextSource());
+	}
+	receiver.EndDataAccess();
+	if (numsources != 2)
+		fail("Receiver didn't process the RTCP packets of both sessions");
+
+	normal.BYEDestroy(RTPTime(0,0), 0, 0);
+	inplace.BYEDestroy(RTPTime(0,0), 0, 0);
+	receiver.BYEDestroy(RTPTime(0,0), 0, 0);
+	cout << "RTCP in place checks passed" << endl;
+	return 0;
+}
+
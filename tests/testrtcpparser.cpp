@@ -0,0 +1,512 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtcpcompoundpacket.h"
+#include "rtcpcompoundpacketbuilder.h"
+#include "rtcpcompoundpacketparser.h"
+#include "rtcpsrpacket.h"
+#include "rtcprrpacket.h"
+#include "rtcpsdespacket.h"
+#include "rtcpbyepacket.h"
+#include "rtcpapppacket.h"
+#include "rtpmemorymanager.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that RTCPCompoundPacketParser reports the same information as the
+// RTCPCompoundPacket and RTCPPacket classes, and that a session which parses
+// RTCP packets in place doesn't allocate RTCPPacket instances
+
+void fail(const char *msg)
+{
+	cerr << msg << endl;
+	exit(-1);
+}
+
+string tostring(const uint8_t *data, size_t len)
+{
+	if (data == 0)
+		return (len == 0)?"-":"null?";
+	return string((const char *)data, len);
+}
+
+class RecordingParser : public RTCPCompoundPacketParser
+{
+public:
+	vector<string> events;
+protected:
+	int OnSenderInfo(uint32_t senderssrc, const RTPNTPTime &ntptime, uint32_t rtptime, uint32_t packetcount, uint32_t octetcount)
+	{
+		ostringstream s;
+		s << "sender " << senderssrc << " " << ntptime.GetMSW() << " " << ntptime.GetLSW() << " " << rtptime << " " << packetcount << " " << octetcount;
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnReportBlock(uint32_t senderssrc, uint32_t ssrc, uint8_t fractionlost, int32_t lostpackets, uint32_t exthighseqnr, uint32_t jitter, uint32_t lsr, uint32_t dlsr)
+	{
+		ostringstream s;
+		s << "block " << senderssrc << " " << ssrc << " " << (int)fractionlost << " " << lostpackets << " " << exthighseqnr << " " << jitter << " " << lsr << " " << dlsr;
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnEndOfReport(uint32_t senderssrc)
+	{
+		ostringstream s;
+		s << "endreport " << senderssrc;
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnSDESItem(uint32_t ssrc, RTCPSDESPacket::ItemType t, const uint8_t *itemdata, size_t itemlength)
+	{
+		ostringstream s;
+		s << "item " << ssrc << " " << (int)t << " " << string((const char *)itemdata, itemlength);
+		events.push_back(s.str());
+		return 0;
+	}
+#ifdef RTP_SUPPORT_SDESPRIV
+	int OnSDESPrivateItem(uint32_t ssrc, const uint8_t *prefixdata, size_t prefixlength, const uint8_t *valuedata, size_t valuelength)
+	{
+		ostringstream s;
+		s << "priv " << ssrc << " " << tostring(prefixdata, prefixlength) << " " << tostring(valuedata, valuelength);
+		events.push_back(s.str());
+		return 0;
+	}
+#endif // RTP_SUPPORT_SDESPRIV
+	int OnEndOfSDESChunk(uint32_t ssrc)
+	{
+		ostringstream s;
+		s << "endchunk " << ssrc;
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnBYE(uint32_t ssrc, const uint8_t *reasondata, size_t reasonlength)
+	{
+		ostringstream s;
+		s << "bye " << ssrc << " " << tostring(reasondata, reasonlength);
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnAPPPacket(uint8_t subtype, uint32_t ssrc, const uint8_t *name, const uint8_t *appdata, size_t appdatalength)
+	{
+		ostringstream s;
+		s << "app " << (int)subtype << " " << ssrc << " " << string((const char *)name, 4) << " " << tostring(appdata, appdatalength);
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnUnknownPacketType(uint8_t packettype)
+	{
+		ostringstream s;
+		s << "unknowntype " << (int)packettype << " " << GetCurrentPacketLength();
+		events.push_back(s.str());
+		return 0;
+	}
+	int OnUnknownPacketFormat(uint8_t packettype)
+	{
+		ostringstream s;
+		s << "unknownformat " << (int)packettype << " " << GetCurrentPacketLength();
+		events.push_back(s.str());
+		return 0;
+	}
+};
+
+// Describes the packet in the same way using the RTCPPacket classes
+vector<string> describeobjects(RTCPCompoundPacket &pack)
+{
+	vector<string> events;
+	RTCPPacket *p;
+
+	pack.GotoFirstPacket();
+	while ((p = pack.GetNextPacket()) != 0)
+	{
+		uint8_t packettype = p->GetPacketData()[1];
+		ostringstream s;
+
+		if (!p->IsKnownFormat())
+		{
+			s << "unknownformat " << (int)packettype << " " << p->GetPacketLength();
+			events.push_back(s.str());
+			continue;
+		}
+
+		switch (p->GetPacketType())
+		{
+		case RTCPPacket::SR:
+			{
+				RTCPSRPacket *sr = (RTCPSRPacket *)p;
+				uint32_t ssrc = sr->GetSenderSSRC();
+
+				s << "sender " << ssrc << " " << sr->GetNTPTimestamp().GetMSW() << " " << sr->GetNTPTimestamp().GetLSW() << " " << sr->GetRTPTimestamp()
+				  << " " << sr->GetSenderPacketCount() << " " << sr->GetSenderOctetCount();
+				events.push_back(s.str());
+				for (int i = 0 ; i < sr->GetReceptionReportCount() ; i++)
+				{
+					ostringstream s2;
+					s2 << "block " << ssrc << " " << sr->GetSSRC(i) << " " << (int)sr->GetFractionLost(i) << " " << sr->GetLostPacketCount(i) << " "
+					   << sr->GetExtendedHighestSequenceNumber(i) << " " << sr->GetJitter(i) << " " << sr->GetLSR(i) << " " << sr->GetDLSR(i);
+					events.push_back(s2.str());
+				}
+				ostringstream s3;
+				s3 << "endreport " << ssrc;
+				events.push_back(s3.str());
+			}
+			break;
+		case RTCPPacket::RR:
+			{
+				RTCPRRPacket *rr = (RTCPRRPacket *)p;
+				uint32_t ssrc = rr->GetSenderSSRC();
+
+				for (int i = 0 ; i < rr->GetReceptionReportCount() ; i++)
+				{
+					ostringstream s2;
+					s2 << "block " << ssrc << " " << rr->GetSSRC(i) << " " << (int)rr->GetFractionLost(i) << " " << rr->GetLostPacketCount(i) << " "
+					   << rr->GetExtendedHighestSequenceNumber(i) << " " << rr->GetJitter(i) << " " << rr->GetLSR(i) << " " << rr->GetDLSR(i);
+					events.push_back(s2.str());
+				}
+				s << "endreport " << ssrc;
+				events.push_back(s.str());
+			}
+			break;
+		case RTCPPacket::SDES:
+			{
+				RTCPSDESPacket *sdes = (RTCPSDESPacket *)p;
+
+				if (sdes->GotoFirstChunk())
+				{
+					do
+					{
+						uint32_t ssrc = sdes->GetChunkSSRC();
+
+						if (sdes->GotoFirstItem())
+						{
+							do
+							{
+								ostringstream s2;
+
+								if (sdes->GetItemType() != RTCPSDESPacket::PRIV)
+									s2 << "item " << ssrc << " " << (int)sdes->GetItemType() << " " << string((const char *)sdes->GetItemData(), sdes->GetItemLength());
+#ifdef RTP_SUPPORT_SDESPRIV
+								else
+									s2 << "priv " << ssrc << " " << tostring(sdes->GetPRIVPrefixData(), sdes->GetPRIVPrefixLength()) << " "
+									   << tostring(sdes->GetPRIVValueData(), sdes->GetPRIVValueLength());
+#endif // RTP_SUPPORT_SDESPRIV
+								if (!s2.str().empty())
+									events.push_back(s2.str());
+							} while (sdes->GotoNextItem());
+						}
+						ostringstream s3;
+						s3 << "endchunk " << ssrc;
+						events.push_back(s3.str());
+					} while (sdes->GotoNextChunk());
+				}
+			}
+			break;
+		case RTCPPacket::BYE:
+			{
+				RTCPBYEPacket *bye = (RTCPBYEPacket *)p;
+
+				for (int i = 0 ; i < bye->GetSSRCCount() ; i++)
+				{
+					ostringstream s2;
+					s2 << "bye " << bye->GetSSRC(i) << " " << tostring(bye->GetReasonData(), bye->GetReasonLength());
+					events.push_back(s2.str());
+				}
+			}
+			break;
+		case RTCPPacket::APP:
+			{
+				RTCPAPPPacket *app = (RTCPAPPPacket *)p;
+
+				s << "app " << (int)app->GetSubType() << " " << app->GetSSRC() << " " << string((const char *)app->GetName(), 4) << " "
+				  << tostring(app->GetAPPData(), app->GetAPPDataLength());
+				events.push_back(s.str());
+			}
+			break;
+		default:
+			s << "unknowntype " << (int)packettype << " " << p->GetPacketLength();
+			events.push_back(s.str());
+		}
+	}
+	return events;
+}
+
+void compare(uint8_t *data, size_t len, const char *description)
+{
+	RTCPCompoundPacket pack(data, len, false);
+	RecordingParser parser;
+	int status = parser.Parse(data, len);
+
+	if (pack.GetCreationError() < 0)
+	{
+		if (status != pack.GetCreationError() || !parser.events.empty())
+		{
+			cerr << description << ": parser accepted an invalid compound packet" << endl;
+			exit(-1);
+		}
+		return;
+	}
+	checkerror(status);
+
+	vector<string> expected = describeobjects(pack);
+
+	if (expected != parser.events)
+	{
+		cerr << description << ": parser reported different information" << endl;
+		for (size_t i = 0 ; i < expected.size() || i < parser.events.size() ; i++)
+		{
+			cerr << "  " << ((i < expected.size())?expected[i]:"") << " | " << ((i < parser.events.size())?parser.events[i]:"") << endl;
+		}
+		exit(-1);
+	}
+}
+
+void checkbuiltpackets()
+{
+	uint32_t ssrcs[3] = { 0x12345678, 0x87654321, 0x0f0f0f0f };
+	uint8_t appdata[8] = { 'a', 'p', 'p', 'd', 'a', 't', 'a', '!' };
+
+	// A bit of everything, with more report blocks and SDES chunks than fit in one packet
+	RTCPCompoundPacketBuilder builder;
+
+	checkerror(builder.InitBuild(8192));
+	checkerror(builder.StartSenderReport(0x12345678, RTPNTPTime(0x11223344, 0x55667788), 1000, 20, 3200));
+	for (int i = 0 ; i < 40 ; i++)
+		checkerror(builder.AddReportBlock(0x1000+i, (uint8_t)i, (i%2)?-i*1000:i*1000, 0x20000+i, i*7, 0xaabbccdd+i, i*3));
+	for (int i = 0 ; i < 35 ; i++)
+	{
+		checkerror(builder.AddSDESSource(0x2000+i));
+		if (i%5 == 4) // no items at all for some sources
+			continue;
+		checkerror(builder.AddSDESNormalItem(RTCPSDESPacket::CNAME, "user@host", 9));
+		checkerror(builder.AddSDESNormalItem(RTCPSDESPacket::NOTE, "note", (uint8_t)(i%5)));
+#ifdef RTP_SUPPORT_SDESPRIV
+		checkerror(builder.AddSDESPrivateItem("prefix", (uint8_t)(i%3), "value", (uint8_t)(i%4)));
+#endif // RTP_SUPPORT_SDESPRIV
+	}
+	checkerror(builder.AddAPPPacket(3, 0x12345678, (const uint8_t *)"TEST", appdata, sizeof(appdata)));
+	checkerror(builder.AddAPPPacket(4, 0x12345678, (const uint8_t *)"NONE", 0, 0));
+	checkerror(builder.AddBYEPacket(ssrcs, 3, "leaving", 7));
+	checkerror(builder.AddBYEPacket(ssrcs, 1, 0, 0));
+	checkerror(builder.EndBuild());
+	compare(builder.GetCompoundPacketData(), builder.GetCompoundPacketLength(), "Large packet");
+
+	RTCPCompoundPacketBuilder builder2;
+
+	checkerror(builder2.InitBuild(1400));
+	checkerror(builder2.StartReceiverReport(0x12345678));
+	checkerror(builder2.AddSDESSource(0x12345678));
+	checkerror(builder2.EndBuild());
+	compare(builder2.GetCompoundPacketData(), builder2.GetCompoundPacketLength(), "Small packet");
+	cout << "Built packet checks passed" << endl;
+}
+
+class PacketWriter
+{
+public:
+	vector<uint8_t> data;
+
+	size_t StartPacket(bool padding, uint8_t count, uint8_t packettype)
+	{
+		size_t offset = data.size();
+		data.push_back((uint8_t)(0x80|((padding)?0x20:0)|count));
+		data.push_back(packettype);
+		data.push_back(0);
+		data.push_back(0);
+		return offset;
+	}
+	void Add32(uint32_t x)			{ for (int i = 3 ; i >= 0 ; i--) data.push_back((uint8_t)(x>>(i*8))); }
+	void Add8(uint8_t x)			{ data.push_back(x); }
+	void EndPacket(size_t offset)
+	{
+		while ((data.size()-offset)%4 != 0)
+			data.push_back(0);
+		size_t words = (data.size()-offset)/4-1;
+		data[offset+2] = (uint8_t)(words>>8);
+		data[offset+3] = (uint8_t)(words&0xff);
+	}
+};
+
+void checkmalformedpackets()
+{
+	PacketWriter w;
+	size_t off;
+
+	off = w.StartPacket(false, 0, 201); // receiver report without blocks
+	w.Add32(0x11111111);
+	w.EndPacket(off);
+	off = w.StartPacket(false, 2, 200); // sender report which claims two blocks
+	w.Add32(0x22222222);
+	for (int i = 0 ; i < 5 ; i++)
+		w.Add32(i);
+	w.EndPacket(off);
+	off = w.StartPacket(false, 1, 202); // SDES item which is too long
+	w.Add32(0x33333333);
+	w.Add8(1);
+	w.Add8(100);
+	w.Add8('x');
+	w.EndPacket(off);
+	off = w.StartPacket(false, 2, 202); // SDES with a PRIV item with a bad prefix length
+	w.Add32(0x44444444);
+	w.Add8(8);
+	w.Add8(3);
+	w.Add8(10);
+	w.Add8('a');
+	w.Add8('b');
+	w.Add8(0);
+	w.Add32(0x55555555);
+	w.Add8(0);
+	w.EndPacket(off);
+	off = w.StartPacket(false, 1, 203); // BYE with a reason that's too long
+	w.Add32(0x66666666);
+	w.Add8(10);
+	w.Add8('b');
+	w.EndPacket(off);
+	off = w.StartPacket(false, 0, 204); // APP packet without a name
+	w.Add32(0x77777777);
+	w.EndPacket(off);
+	off = w.StartPacket(false, 5, 210); // unknown packet type
+	w.Add32(0x88888888);
+	w.EndPacket(off);
+	off = w.StartPacket(true, 1, 203); // BYE with invalid padding
+	w.Add32(0x99999999);
+	w.Add32(0x00000003);
+	w.EndPacket(off);
+	compare(&w.data[0], w.data.size(), "Malformed packets");
+
+	// Padding of the last packet is fine
+	w.data[w.data.size()-1] = 4;
+	compare(&w.data[0], w.data.size(), "Padded packet");
+
+	// Invalid compound packets
+	vector<uint8_t> copy = w.data;
+
+	copy[0] = 0x40;
+	compare(&copy[0], copy.size(), "Wrong version");
+	copy = w.data;
+	copy[1] = 202;
+	compare(&copy[0], copy.size(), "Starts with SDES");
+	copy = w.data;
+	copy[3] = 200;
+	compare(&copy[0], copy.size(), "Length too large");
+	copy = w.data;
+	copy.push_back(0);
+	compare(&copy[0], copy.size(), "Trailing bytes");
+	copy = w.data;
+	copy[0] |= 0x20;
+	compare(&copy[0], copy.size(), "Padding in first packet");
+	compare(&copy[0], 3, "Too short");
+
+	RecordingParser parser;
+
+	if (parser.Parse(&copy[0], copy.size()) != ERR_RTP_RTCPCOMPOUND_INVALIDPACKET || !parser.events.empty())
+		fail("Parser didn't reject an invalid compound packet");
+	cout << "Malformed packet checks passed" << endl;
+}
+
+// The number of RTCPPacket instances that were allocated
+int numrtcppackets(const CountingMemoryManager &mgr)
+{
+	return mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTCPSRPACKET)+mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTCPRRPACKET)+
+	       mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTCPSDESPACKET)+mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTCPBYEPACKET)+
+	       mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTCPAPPPACKET)+mgr.GetNumberOfAllocations(RTPMEM_TYPE_CLASS_RTCPUNKNOWNPACKET);
+}
+
+class ReceiverSession : public RTPSession
+{
+public:
+	ReceiverSession(RTPMemoryManager *mgr) : RTPSession(0, mgr)	{ numcompound = 0; numcompounddata = 0; numapp = 0; }
+
+	int numcompound, numcompounddata, numapp;
+protected:
+	void OnRTCPCompoundPacket(RTCPCompoundPacket *, const RTPTime &, const RTPAddress *)				{ numcompound++; }
+	void OnRTCPCompoundPacketData(const uint8_t *, size_t, const RTPTime &, const RTPAddress *)		{ numcompounddata++; }
+	void OnAPPPacket(RTCPAPPPacket *apppacket, const RTPTime &, const RTPAddress *)
+	{
+		if (apppacket->GetSubType() != 5 || memcmp(apppacket->GetName(), "TEST", 4) != 0 ||
+		    apppacket->GetAPPDataLength() != 4 || memcmp(apppacket->GetAPPData(), "DATA", 4) != 0)
+			fail("Received APP packet is not correct");
+		numapp++;
+	}
+};
+
+RTPSessionParams parsersessionparams(bool inplace)
+{
+	RTPSessionParams sessParams = loopbacksessionparams();
+
+	sessParams.SetParseRTCPInPlace(inplace);
+	sessParams.SetBuildRTCPInPlace(true); // so that our own RTCP packets don't allocate RTCPPacket instances either
+	return sessParams;
+}
+
+string checkreceiver(ReceiverSession &receiver, uint32_t ssrc, int numrtcp)
+{
+	checkerror(receiver.Poll());
+	if (receiver.numapp != numrtcp)
+		fail("Receiver didn't get all APP packets");
+
+	receiver.BeginDataAccess();
+
+	RTPSourceData *srcdat = receiver.GetSourceInfo(ssrc);
+	size_t cnamelen;
+	uint8_t *cname = (srcdat == 0)?0:srcdat->SDES_GetCNAME(&cnamelen);
+
+	if (cname == 0 || cnamelen == 0)
+		fail("Receiver doesn't know the CNAME of the sender");
+
+	string s((const char *)cname, cnamelen);
+
+	receiver.EndDataAccess();
+	return s;
+}
+
+int main(void)
+{
+	checkbuiltpackets();
+	checkmalformedpackets();
+
+	RTPLoopbackNetwork network;
+	CountingMemoryManager normalmgr, inplacemgr;
+	ReceiverSession normal(&normalmgr), inplace(&inplacemgr);
+	RTPSession sender;
+	const int numrtcp = 5;
+
+	createsession(normal, network, 6000, parsersessionparams(false));
+	createsession(inplace, network, 8000, parsersessionparams(true));
+	createsession(sender, network, 10000, parsersessionparams(false));
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+	checkerror(sender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 8000)));
+
+	uint8_t payload[160];
+
+	memset(payload, 0, sizeof(payload));
+	for (int i = 0 ; i < 10 ; i++)
+		checkerror(sender.SendPacket(payload, sizeof(payload)));
+	for (int i = 0 ; i < numrtcp ; i++)
+		checkerror(sender.SendRTCPAPPPacket(5, (const uint8_t *)"TEST", "DATA", 4));
+
+	if (checkreceiver(normal, sender.GetLocalSSRC(), numrtcp) != checkreceiver(inplace, sender.GetLocalSSRC(), numrtcp))
+		fail("Receivers have a different CNAME for the sender");
+
+	cout << "RTCP packet instances allocated: " << numrtcppackets(normalmgr) << " normally, " << numrtcppackets(inplacemgr) << " in place" << endl;
+	if (normal.numcompound != numrtcp || normal.numcompounddata != 0 || numrtcppackets(normalmgr) == 0)
+		fail("Normal session didn't process the RTCP packets as expected");
+	if (inplace.numcompounddata != numrtcp || inplace.numcompound != 0 || numrtcppackets(inplacemgr) != 0)
+		fail("RTCP packets parsed in place should not need any RTCPPacket instances");
+
+	sender.BYEDestroy(RTPTime(0,0), 0, 0);
+	normal.BYEDestroy(RTPTime(0,0), 0, 0);
+	inplace.BYEDestroy(RTPTime(0,0), 0, 0);
+	cout << "RTCP parser checks passed" << endl;
+	return 0;
+}
+
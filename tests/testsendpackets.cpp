@@ -0,0 +1,306 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtpudpv4transmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+
+using namespace jrtplib;
+using namespace std;
+
+// Sends batches of packets with different payload types, markers and
+// timestamp increments over UDP, both from a session which passes the
+// payloads to the transmitter directly and from one which changes the
+// outgoing data. Checks that the receiver gets the same packets as when they
+// are sent one by one, and compares the time needed to send the packets.
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+class ChangeOutgoingDataSession : public RTPSession
+{
+public:
+	ChangeOutgoingDataSession()
+	{
+		SetChangeOutgoingData(true);
+	}
+protected:
+	int OnChangeRTPOrRTCPData(const void *origdata, size_t origlen, bool /*isrtp*/, void **senddata, size_t *sendlen)
+	{
+		*senddata = (void *)origdata;
+		*sendlen = origlen;
+		return 0;
+	}
+};
+
+uint16_t createsession(RTPSession &sess)
+{
+	RTPSessionParams sessParams;
+	RTPUDPv4TransmissionParams transParams;
+
+	sessParams.SetOwnTimestampUnit(1.0/90000.0);
+	sessParams.SetUsePollThread(false);
+#ifdef RTP_SUPPORT_PROBATION
+	sessParams.SetProbationType(RTPSources::NoProbation);
+#endif // RTP_SUPPORT_PROBATION
+	transParams.SetPortbase(0);
+	transParams.SetBindIP(ntohl(inet_addr("127.0.0.1")));
+	transParams.SetRTPReceiveBuffer(4000000);
+
+	checkerror(sess.Create(sessParams, &transParams));
+	sess.SetDefaultPayloadType(96);
+	sess.SetDefaultMark(false);
+	sess.SetDefaultTimestampIncrement(3000);
+
+	RTPUDPv4TransmissionInfo *pInf = (RTPUDPv4TransmissionInfo *)sess.GetTransmissionInfo();
+	uint16_t port = pInf->GetRTPPort();
+
+	sess.DeleteTransmissionInfo(pInf);
+	return port;
+}
+
+const int numpackets = 100; // more than the UDP transmitters pass to sendmmsg at once
+const size_t payloadlen = 1000;
+
+void getpayloads(vector<RTPPayloadInfo> &payloads, uint8_t *payloaddata)
+{
+	payloads.resize(numpackets);
+	for (int i = 0 ; i < numpackets ; i++)
+	{
+		size_t len = payloadlen - i;
+
+		memset(payloaddata+i*payloadlen, i, len);
+		payloads[i] = RTPPayloadInfo(payloaddata+i*payloadlen, len, (uint8_t)(96+i%3), (i%5 == 4), (i%5 == 4)?3000:0);
+	}
+}
+
+// Returns the packets of source 'ssrc' in the order in which they were received
+void getpackets(RTPSession &receiver, uint32_t ssrc, vector<RTPPacket *> &packets)
+{
+	RTPTime::Wait(RTPTime(0.1));
+	checkerror(receiver.Poll());
+
+	receiver.BeginDataAccess();
+	if (receiver.GotoFirstSourceWithData())
+	{
+		do
+		{
+			RTPPacket *pack;
+
+			if (receiver.GetCurrentSourceInfo()->GetSSRC() != ssrc)
+				continue;
+			while ((pack = receiver.GetNextPacket()) != 0)
+				packets.push_back(pack);
+		} while (receiver.GotoNextSourceWithData());
+	}
+	receiver.EndDataAccess();
+}
+
+bool checkpackets(RTPSession &receiver, const vector<RTPPacket *> &packets, const vector<RTPPayloadInfo> &payloads)
+{
+	bool ok = (packets.size() == 2*payloads.size());
+
+	// The first half of the packets was sent one by one, the second half
+	// as a batch
+	for (size_t i = 0 ; ok && i < payloads.size() ; i++)
+	{
+		RTPPacket *single = packets[i];
+		RTPPacket *batched = packets[i+payloads.size()];
+
+		if (batched->GetPayloadLength() != payloads[i].length || batched->GetPayloadType() != payloads[i].payloadtype ||
+		    batched->HasMarker() != payloads[i].mark || memcmp(batched->GetPayloadData(), payloads[i].data, payloads[i].length) != 0)
+			ok = false;
+		else if (single->GetPayloadLength() != batched->GetPayloadLength() || single->GetPayloadType() != batched->GetPayloadType() ||
+		         single->HasMarker() != batched->HasMarker())
+			ok = false;
+		else if (batched->GetSequenceNumber() != (uint16_t)(single->GetSequenceNumber() + payloads.size()))
+			ok = false;
+		else if (batched->GetTimestamp() - single->GetTimestamp() != packets.back()->GetTimestamp() - packets[payloads.size()-1]->GetTimestamp())
+			ok = false;
+	}
+	for (size_t i = 0 ; i < packets.size() ; i++)
+		receiver.DeletePacket(packets[i]);
+	return ok;
+}
+
+bool checksession(RTPSession &sender, RTPSession &receiver, const vector<RTPPayloadInfo> &payloads)
+{
+	vector<RTPPacket *> packets;
+
+	for (size_t i = 0 ; i < payloads.size() ; i++)
+		checkerror(sender.SendPacket(payloads[i].data, payloads[i].length, payloads[i].payloadtype, payloads[i].mark, payloads[i].timestampinc));
+	checkerror(sender.SendPackets(&payloads[0], payloads.size()));
+
+	getpackets(receiver, sender.GetLocalSSRC(), packets);
+	if (packets.size() != payloads.size()*2)
+	{
+		cerr << "Received " << packets.size() << " of " << payloads.size()*2 << " packets" << endl;
+		return false;
+	}
+	return checkpackets(receiver, packets, payloads);
+}
+
+// A frame is sent as a batch as well; only its last packet has the marker set
+bool checkframe(RTPSession &sender, RTPSession &receiver, const vector<RTPPayloadInfo> &payloads)
+{
+	const size_t numframepackets = 5;
+	vector<RTPDataSpan> framepayloads;
+	vector<RTPPacket *> packets;
+
+	for (size_t i = 0 ; i < numframepackets ; i++)
+		framepayloads.push_back(RTPDataSpan(payloads[i].data, payloads[i].length));
+	checkerror(sender.SendFrame(&framepayloads[0], numframepackets, 100, 3000));
+
+	getpackets(receiver, sender.GetLocalSSRC(), packets);
+
+	bool ok = (packets.size() == numframepackets);
+
+	for (size_t i = 0 ; ok && i < numframepackets ; i++)
+	{
+		if (packets[i]->GetPayloadType() != 100 || packets[i]->HasMarker() != (i == numframepackets-1) ||
+		    packets[i]->GetTimestamp() != packets[0]->GetTimestamp() || packets[i]->GetPayloadLength() != payloads[i].length)
+			ok = false;
+	}
+	for (size_t i = 0 ; i < packets.size() ; i++)
+		receiver.DeletePacket(packets[i]);
+	return ok;
+}
+
+// If one of the packets can't be built, nothing is sent and the sequence
+// numbers are not used up
+bool checkfailedbatch(RTPSession &sender, RTPSession &receiver, const vector<RTPPayloadInfo> &payloads)
+{
+	vector<RTPPayloadInfo> badpayloads(payloads.begin(), payloads.begin()+10);
+	vector<RTPPacket *> packets;
+	uint16_t seqnr = sender.GetNextSequenceNumber();
+
+	badpayloads[5].length = 2000; // larger than the maximum packet size
+	if (sender.SendPackets(&badpayloads[0], badpayloads.size()) >= 0 || sender.GetNextSequenceNumber() != seqnr)
+		return false;
+	checkerror(sender.SendPackets(&payloads[0], 1));
+
+	getpackets(receiver, sender.GetLocalSSRC(), packets);
+
+	bool ok = (packets.size() == 1 && packets[0]->GetSequenceNumber() == seqnr);
+
+	for (size_t i = 0 ; i < packets.size() ; i++)
+		receiver.DeletePacket(packets[i]);
+	return ok;
+}
+
+void discardpackets(RTPSession &receiver)
+{
+	checkerror(receiver.Poll());
+	receiver.BeginDataAccess();
+	if (receiver.GotoFirstSourceWithData())
+	{
+		do
+		{
+			RTPPacket *pack;
+
+			while ((pack = receiver.GetNextPacket()) != 0)
+				receiver.DeletePacket(pack);
+		} while (receiver.GotoNextSourceWithData());
+	}
+	receiver.EndDataAccess();
+}
+
+void measuresendtime(RTPSession &sess, RTPSession &receiver, const vector<RTPPayloadInfo> &payloads, double &singletime, double &batchtime)
+{
+	const int numrounds = 50;
+	RTPTime single(0, 0), batch(0, 0);
+
+	for (int r = 0 ; r < numrounds ; r++)
+	{
+		RTPTime start = RTPTime::CurrentTime();
+		for (size_t i = 0 ; i < payloads.size() ; i++)
+			checkerror(sess.SendPacket(payloads[i].data, payloads[i].length, payloads[i].payloadtype, payloads[i].mark, payloads[i].timestampinc));
+		RTPTime t = RTPTime::CurrentTime();
+		t -= start;
+		single += t;
+		discardpackets(receiver);
+
+		start = RTPTime::CurrentTime();
+		checkerror(sess.SendPackets(&payloads[0], payloads.size()));
+		t = RTPTime::CurrentTime();
+		t -= start;
+		batch += t;
+		discardpackets(receiver);
+	}
+	singletime = single.GetDouble()*1e6/(numrounds*payloads.size());
+	batchtime = batch.GetDouble()*1e6/(numrounds*payloads.size());
+}
+
+int main(void)
+{
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSADATA dat;
+	WSAStartup(MAKEWORD(2,2),&dat);
+#endif // RTP_SOCKETTYPE_WINSOCK
+
+	RTPSession receiver, sender;
+	ChangeOutgoingDataSession copysender;
+	uint16_t port = createsession(receiver);
+	uint32_t localhost = ntohl(inet_addr("127.0.0.1"));
+	vector<uint8_t> payloaddata(numpackets*payloadlen);
+	vector<RTPPayloadInfo> payloads;
+
+	getpayloads(payloads, &payloaddata[0]);
+	createsession(sender);
+	createsession(copysender);
+	checkerror(sender.AddDestination(RTPIPv4Address(localhost, port)));
+	checkerror(copysender.AddDestination(RTPIPv4Address(localhost, port)));
+
+	if (!checksession(sender, receiver, payloads))
+	{
+		cerr << "Packets sent as a batch are not correct" << endl;
+		return -1;
+	}
+	if (!checksession(copysender, receiver, payloads))
+	{
+		cerr << "Packets sent as a batch while changing the outgoing data are not correct" << endl;
+		return -1;
+	}
+
+	if (!checkframe(sender, receiver, payloads) || !checkframe(copysender, receiver, payloads))
+	{
+		cerr << "Frame was not sent correctly" << endl;
+		return -1;
+	}
+
+	if (!checkfailedbatch(sender, receiver, payloads) || !checkfailedbatch(copysender, receiver, payloads))
+	{
+		cerr << "Batch with a packet that couldn't be built was not handled correctly" << endl;
+		return -1;
+	}
+
+	double singletime, batchtime;
+
+	measuresendtime(sender, receiver, payloads, singletime, batchtime);
+	cout << "Sending " << payloadlen << " byte payloads: " << singletime << " us per packet one by one, "
+	     << batchtime << " us per packet in batches of " << numpackets << endl;
+	measuresendtime(copysender, receiver, payloads, singletime, batchtime);
+	cout << "Same when changing the outgoing data: " << singletime << " us per packet one by one, "
+	     << batchtime << " us per packet in batches" << endl;
+
+	sender.BYEDestroy(RTPTime(0), 0, 0);
+	copysender.BYEDestroy(RTPTime(0), 0, 0);
+	receiver.Destroy();
+
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSACleanup();
+#endif // RTP_SOCKETTYPE_WINSOCK
+	cout << "All checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,252 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtpudpv4transmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "rtpsharedbuffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+
+using namespace jrtplib;
+using namespace std;
+
+// Receives packets in buffers of a shared buffer pool, hands every packet
+// to several consumers without copying it and checks that the buffers
+// are only reused when the last consumer has released the packet
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+void fail(const char *msg)
+{
+	cerr << msg << endl;
+	exit(-1);
+}
+
+uint16_t createsession(RTPSession &sess, RTPSharedBufferPool *pool)
+{
+	RTPSessionParams sessParams;
+	RTPUDPv4TransmissionParams transParams;
+
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetUsePollThread(false);
+	sessParams.SetMaximumPacketSize(2000);
+#ifdef RTP_SUPPORT_PROBATION
+	sessParams.SetProbationType(RTPSources::NoProbation);
+#endif // RTP_SUPPORT_PROBATION
+	transParams.SetPortbase(0);
+	transParams.SetBindIP(ntohl(inet_addr("127.0.0.1")));
+	transParams.SetRTPReceiveBuffer(1000000);
+	transParams.SetReceiveBufferPool(pool);
+
+	checkerror(sess.Create(sessParams, &transParams));
+	sess.SetDefaultPayloadType(96);
+	sess.SetDefaultMark(false);
+	sess.SetDefaultTimestampIncrement(160);
+
+	RTPUDPv4TransmissionInfo *pInf = (RTPUDPv4TransmissionInfo *)sess.GetTransmissionInfo();
+	uint16_t port = pInf->GetRTPPort();
+
+	sess.DeleteTransmissionInfo(pInf);
+	return port;
+}
+
+const int numpackets = 50;
+const int numconsumers = 3;
+
+void sendpackets(RTPSession &sender, size_t len)
+{
+	vector<uint8_t> payload(len);
+
+	for (int i = 0 ; i < numpackets ; i++)
+	{
+		memset(&payload[0], (int)(sender.GetNextSequenceNumber()&0xff), len);
+		checkerror(sender.SendPacket(&payload[0], len));
+	}
+}
+
+bool checkpacket(RTPPacket *pack, size_t len)
+{
+	if (pack->GetPayloadLength() != len)
+		return false;
+	for (size_t i = 0 ; i < len ; i++)
+	{
+		if (pack->GetPayloadData()[i] != (uint8_t)(pack->GetSequenceNumber()&0xff))
+			return false;
+	}
+	return true;
+}
+
+vector<RTPPacket *> getpackets(RTPSession &receiver)
+{
+	vector<RTPPacket *> packets;
+
+	RTPTime::Wait(RTPTime(0, 100000));
+	checkerror(receiver.Poll());
+	receiver.BeginDataAccess();
+	if (receiver.GotoFirstSourceWithData())
+	{
+		RTPPacket *pack;
+
+		while ((pack = receiver.GetNextPacket()) != 0)
+			packets.push_back(pack);
+	}
+	receiver.EndDataAccess();
+	if (packets.size() != (size_t)numpackets)
+	{
+		cerr << "Received " << packets.size() << " packets, expected " << numpackets << endl;
+		exit(-1);
+	}
+	return packets;
+}
+
+void checkpool()
+{
+	RTPSharedBufferPool pool(100);
+	RTPSharedBuffer *buf1 = pool.GetBuffer();
+	RTPSharedBuffer *buf2 = pool.GetBuffer();
+
+	if (buf1 == 0 || buf2 == 0 || buf1 == buf2 || buf1->GetCapacity() != 100 || buf1->GetReferenceCount() != 1)
+		fail("Pool didn't return two new buffers");
+
+	buf1->AddReference();
+	buf1->Release();
+
+	RTPSharedBuffer *buf3 = pool.GetBuffer();
+
+	if (buf3 == 0 || buf3 == buf1)
+		fail("Buffer was reused while it was still referenced");
+	buf1->Release();
+
+	RTPSharedBuffer *buf4 = pool.GetBuffer();
+
+	if (buf4 != buf1 || pool.GetNumberOfBuffers() != 3)
+		fail("Released buffer was not reused");
+
+	// All buffers must be released before the pool is destroyed
+	buf2->Release();
+	buf3->Release();
+	buf4->Release();
+	cout << "Pool checks passed" << endl;
+}
+
+int main(void)
+{
+#ifdef RTP_SOCKETTYPE_WINSOCK
+	WSADATA dat;
+	WSAStartup(MAKEWORD(2,2),&dat);
+#endif // RTP_SOCKETTYPE_WINSOCK
+
+	checkpool();
+
+	RTPSharedBufferPool pool(1500);
+	RTPSession sender, receiver, plainreceiver;
+	uint16_t port = createsession(receiver, &pool);
+	uint16_t plainport = createsession(plainreceiver, 0);
+
+	createsession(sender, 0);
+	checkerror(sender.AddDestination(RTPIPv4Address(ntohl(inet_addr("127.0.0.1")), port)));
+
+	// Every consumer gets its own RTPPacket instance for the same data
+
+	sendpackets(sender, 1000);
+	vector<RTPPacket *> packets = getpackets(receiver);
+	vector<RTPPacket *> consumers[numconsumers];
+
+	for (size_t i = 0 ; i < packets.size() ; i++)
+	{
+		if (!packets[i]->IsShared())
+			fail("Received packet is not stored in a shared buffer");
+		consumers[0].push_back(packets[i]);
+		for (int j = 1 ; j < numconsumers ; j++)
+		{
+			RTPPacket *ref = packets[i]->CreateReference();
+
+			if (ref == 0)
+				fail("Couldn't create a reference to a packet");
+			if (ref->GetPacketData() != packets[i]->GetPacketData() || ref->GetExtendedSequenceNumber() != packets[i]->GetExtendedSequenceNumber())
+				fail("Reference doesn't refer to the same packet");
+			consumers[j].push_back(ref);
+		}
+	}
+
+	int32_t numbuffers = pool.GetNumberOfBuffers();
+
+	// The consumers release the packets in a different order; the data
+	// must remain valid until the last one is done
+
+	for (int j = 0 ; j < numconsumers ; j++)
+	{
+		for (size_t i = 0 ; i < consumers[j].size() ; i++)
+		{
+			RTPPacket *pack = consumers[j][(i*7+j)%consumers[j].size()];
+
+			if (!checkpacket(pack, 1000))
+				fail("Shared packet was changed before it was released");
+		}
+		for (size_t i = 0 ; i < consumers[j].size() ; i++)
+		{
+			if (j == 0)
+				receiver.DeletePacket(consumers[j][i]);
+			else
+				delete consumers[j][i];
+		}
+	}
+
+	// All buffers were returned, so receiving the same number of packets
+	// again shouldn't need new ones
+
+	sendpackets(sender, 1000);
+	packets = getpackets(receiver);
+	for (size_t i = 0 ; i < packets.size() ; i++)
+	{
+		if (!checkpacket(packets[i], 1000))
+			fail("Packet in reused buffer is not correct");
+		receiver.DeletePacket(packets[i]);
+	}
+	if (pool.GetNumberOfBuffers() > numbuffers)
+	{
+		cerr << "Pool grew from " << numbuffers << " to " << pool.GetNumberOfBuffers() << " buffers" << endl;
+		return -1;
+	}
+
+	// Packets which don't fit in a buffer of the pool, or which are received
+	// without a pool, can't be shared
+
+	sendpackets(sender, 1600);
+	packets = getpackets(receiver);
+	for (size_t i = 0 ; i < packets.size() ; i++)
+	{
+		if (packets[i]->IsShared() || packets[i]->CreateReference() != 0 || !checkpacket(packets[i], 1600))
+			fail("Large packet should not be shared");
+		receiver.DeletePacket(packets[i]);
+	}
+
+	sender.ClearDestinations();
+	checkerror(sender.AddDestination(RTPIPv4Address(ntohl(inet_addr("127.0.0.1")), plainport)));
+	sendpackets(sender, 100);
+	packets = getpackets(plainreceiver);
+	for (size_t i = 0 ; i < packets.size() ; i++)
+	{
+		if (packets[i]->IsShared())
+			fail("Packet received without a pool should not be shared");
+		plainreceiver.DeletePacket(packets[i]);
+	}
+
+	sender.BYEDestroy(RTPTime(0,0), 0, 0);
+	plainreceiver.BYEDestroy(RTPTime(0,0), 0, 0);
+	receiver.BYEDestroy(RTPTime(0,0), 0, 0);
+	cout << "Shared buffer checks passed" << endl;
+	return 0;
+}
+
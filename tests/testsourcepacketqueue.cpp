@@ -0,0 +1,241 @@
+#include "rtpsourcepacketqueue.h"
+#include "rtppacket.h"
+#include "rtptimeutilities.h"
+#include "rtperrors.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <list>
+#include <set>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that the per-source packet queue behaves like the sorted list which
+// was used before: packets come out ordered by extended sequence number, gaps
+// are skipped and duplicates are refused. Also compares the cost of storing
+// and retrieving slightly reordered packets with that list.
+
+RTPPacket *createpacket(uint32_t extseqnr)
+{
+	uint8_t payload[4] = { 0, 1, 2, 3 };
+	RTPPacket *pack = new RTPPacket(96, payload, sizeof(payload), (uint16_t)extseqnr, 0, 0x12345678, false, 0, 0, false, 0, 0, 0, 0);
+
+	pack->SetExtendedSequenceNumber(extseqnr);
+	return pack;
+}
+
+bool checkrandom(int numpackets, uint32_t range, uint32_t startseqnr)
+{
+	RTPSourcePacketQueue queue;
+	set<uint32_t> stored;
+
+	for (int i = 0 ; i < numpackets ; i++)
+	{
+		uint32_t seqnr = startseqnr + (uint32_t)(rand()%range);
+		RTPPacket *pack = createpacket(seqnr);
+		bool wasstored;
+
+		if (queue.StorePacket(pack, &wasstored) < 0)
+		{
+			cerr << "Unable to store packet" << endl;
+			return false;
+		}
+		if (wasstored == (stored.find(seqnr) != stored.end()))
+		{
+			cerr << "Duplicate packet " << seqnr << " not detected correctly" << endl;
+			return false;
+		}
+		if (!wasstored)
+			delete pack;
+		else
+			stored.insert(seqnr);
+
+		// Now and then, take some packets out of the queue
+		if (rand()%8 == 0)
+		{
+			int num = rand()%4;
+
+			for (int j = 0 ; j < num && !stored.empty() ; j++)
+			{
+				RTPPacket *p = queue.GetNextPacket();
+
+				if (p == 0 || p->GetExtendedSequenceNumber() != *(stored.begin()))
+				{
+					cerr << "Packets are not retrieved in the right order" << endl;
+					return false;
+				}
+				stored.erase(stored.begin());
+				delete p;
+			}
+		}
+		if (queue.GetNumberOfPackets() != stored.size())
+		{
+			cerr << "Queue contains " << queue.GetNumberOfPackets() << " packets, expected " << stored.size() << endl;
+			return false;
+		}
+	}
+
+	while (!stored.empty())
+	{
+		RTPPacket *p = queue.GetNextPacket();
+
+		if (p == 0 || p->GetExtendedSequenceNumber() != *(stored.begin()))
+		{
+			cerr << "Packets are not retrieved in the right order" << endl;
+			return false;
+		}
+		stored.erase(stored.begin());
+		delete p;
+	}
+	return (queue.IsEmpty() && queue.GetNextPacket() == 0);
+}
+
+bool checkjump()
+{
+	RTPSourcePacketQueue queue;
+	bool wasstored;
+
+	// A jump which exceeds the maximum size discards the oldest packets
+	queue.StorePacket(createpacket(10), &wasstored);
+	queue.StorePacket(createpacket(11), &wasstored);
+	queue.StorePacket(createpacket(10+RTPSOURCEPACKETQUEUE_MAXSIZE), &wasstored);
+
+	if (!wasstored || queue.GetNumberOfPackets() != 2)
+		return false;
+
+	// A packet which is too old to fit in is refused
+	RTPPacket *old = createpacket(5);
+
+	queue.StorePacket(old, &wasstored);
+	delete old;
+	if (wasstored)
+		return false;
+
+	RTPPacket *p1 = queue.GetNextPacket();
+	RTPPacket *p2 = queue.GetNextPacket();
+	bool ok = (p1 && p2 && p1->GetExtendedSequenceNumber() == 11 && p2->GetExtendedSequenceNumber() == 10+RTPSOURCEPACKETQUEUE_MAXSIZE);
+
+	delete p1;
+	delete p2;
+	return ok && queue.IsEmpty();
+}
+
+// The insertion which was used before, kept for comparison
+void storeinlist(list<RTPPacket *> &packetlist, RTPPacket *pack)
+{
+	if (packetlist.empty())
+	{
+		packetlist.push_back(pack);
+		return;
+	}
+
+	list<RTPPacket *>::iterator it = packetlist.end();
+	uint32_t newseqnr = pack->GetExtendedSequenceNumber();
+
+	--it;
+	while (true)
+	{
+		uint32_t seqnr = (*it)->GetExtendedSequenceNumber();
+
+		if (seqnr > newseqnr)
+		{
+			if (it != packetlist.begin())
+				--it;
+			else
+			{
+				packetlist.push_front(pack);
+				return;
+			}
+		}
+		else if (seqnr < newseqnr)
+		{
+			++it;
+			packetlist.insert(it, pack);
+			return;
+		}
+		else
+		{
+			delete pack;
+			return;
+		}
+	}
+}
+
+int main(void)
+{
+	srand(4321);
+
+	if (!checkrandom(100000, 64, 1000) || !checkrandom(100000, 5000, 0xff00) || !checkrandom(20000, 60000, 0) || !checkjump())
+	{
+		cerr << "FAILED" << endl;
+		return -1;
+	}
+	cout << "Queue checks passed" << endl;
+
+	// Packets arrive mostly in order, every tenth one is swapped with its
+	// successor; the application retrieves them in bursts of 32
+
+	const int numpackets = 1000000;
+	const int burst = 32;
+	vector<uint32_t> order(numpackets);
+
+	for (int i = 0 ; i < numpackets ; i++)
+		order[i] = (uint32_t)i;
+	for (int i = 0 ; i+1 < numpackets ; i += 10)
+	{
+		uint32_t tmp = order[i];
+		order[i] = order[i+1];
+		order[i+1] = tmp;
+	}
+
+	vector<RTPPacket *> packets(numpackets);
+	RTPSourcePacketQueue queue;
+	list<RTPPacket *> packetlist;
+	double queuetime = 0, listtime = 0;
+
+	for (int pass = 0 ; pass < 2 ; pass++)
+	{
+		for (int i = 0 ; i < numpackets ; i++)
+			packets[i] = createpacket(order[i]);
+
+		RTPTime start = RTPTime::CurrentTime();
+
+		for (int i = 0 ; i < numpackets ; i += burst)
+		{
+			for (int j = i ; j < i+burst && j < numpackets ; j++)
+			{
+				if (pass == 0)
+				{
+					bool stored;
+					queue.StorePacket(packets[j], &stored);
+				}
+				else
+					storeinlist(packetlist, packets[j]);
+			}
+			for (int j = i ; j < i+burst && j < numpackets ; j++)
+			{
+				if (pass == 0)
+					packets[j] = queue.GetNextPacket();
+				else
+				{
+					packets[j] = packetlist.front();
+					packetlist.pop_front();
+				}
+			}
+		}
+
+		RTPTime t = RTPTime::CurrentTime();
+		t -= start;
+		if (pass == 0)
+			queuetime = t.GetDouble();
+		else
+			listtime = t.GetDouble();
+
+		for (int i = 0 ; i < numpackets ; i++)
+			delete packets[i];
+	}
+
+	cout << "Store and retrieve: " << queuetime*1e9/numpackets << " ns per packet (sorted list: " << listtime*1e9/numpackets << " ns)" << endl;
+	return 0;
+}
@@ -0,0 +1,263 @@
+#include "rtpconfig.h"
+#include <iostream>
+
+using namespace std;
+
+#ifdef RTP_SUPPORT_THREAD
+
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "rtpatomic.h"
+#include <jthread/jthread.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace jrtplib;
+using namespace jthread;
+
+// Several threads use the source table of a session while its poll thread is
+// processing incoming packets and sending RTCP packets. Sending RTCP data is
+// made artificially slow; since this no longer happens while the sources are
+// locked, the other threads should never have to wait that long.
+
+#define RTCPSENDDELAY_MS			50
+
+void checkerror(int rtperr)
+{
+	if (rtperr < 0)
+	{
+		cout << "ERROR: " << RTPGetErrorString(rtperr) << endl;
+		exit(-1);
+	}
+}
+
+class SlowRTCPSession : public RTPSession
+{
+public:
+	SlowRTCPSession() : numrtcp(0)
+	{
+		SetChangeOutgoingData(true);
+	}
+
+	int GetNumberOfRTCPPackets() const						{ return numrtcp.Get(); }
+protected:
+	int OnChangeRTPOrRTCPData(const void *origdata, size_t origlen, bool isrtp, void **senddata, size_t *sendlen)
+	{
+		// Simulate a system call that takes a long time
+		if (!isrtp)
+		{
+			RTPTime::Wait(RTPTime(0, RTCPSENDDELAY_MS*1000));
+			numrtcp.FetchAdd(1);
+		}
+		*senddata = (void *)origdata;
+		*sendlen = origlen;
+		return 0;
+	}
+private:
+	RTPAtomicInteger numrtcp;
+};
+
+class ReaderThread : public JThread
+{
+public:
+	ReaderThread(RTPSession &s, const vector<uint32_t> &ssrcs, bool getpackets)
+		: sess(s), senderssrcs(ssrcs), retrievepackets(getpackets), stop(0), numpackets(0), numlookups(0), numerrors(0), maxwait(0)
+	{
+	}
+
+	~ReaderThread()
+	{
+		Stop();
+	}
+
+	void Stop()
+	{
+		stop.Set(1);
+		while (IsRunning())
+			RTPTime::Wait(RTPTime(0.01));
+	}
+
+	int GetNumberOfPackets() const							{ return numpackets; }
+	int GetNumberOfLookups() const							{ return numlookups; }
+	int GetNumberOfErrors() const							{ return numerrors; }
+	double GetMaximumWait() const							{ return maxwait; }
+private:
+	void *Thread()
+	{
+		JThread::ThreadStarted();
+
+		while (!stop.Get())
+		{
+			RTPTime t0 = RTPTime::CurrentTime();
+			sess.BeginDataAccess();
+			RTPTime t1 = RTPTime::CurrentTime();
+
+			t1 -= t0;
+			if (t1.GetDouble() > maxwait)
+				maxwait = t1.GetDouble();
+
+			for (size_t i = 0 ; i < senderssrcs.size() ; i++)
+			{
+				RTPSourceData *srcdat = sess.GetSourceInfo(senderssrcs[i]);
+
+				// Once a sender is known, it must stay in the table
+				if (srcdat != 0 && srcdat->GetSSRC() != senderssrcs[i])
+					numerrors++;
+				numlookups++;
+			}
+
+			if (retrievepackets && sess.GotoFirstSourceWithData())
+			{
+				do
+				{
+					RTPPacket *pack;
+
+					while ((pack = sess.GetNextPacket()) != 0)
+					{
+						numpackets++;
+						sess.DeletePacket(pack);
+					}
+				} while (sess.GotoNextSourceWithData());
+			}
+			sess.EndDataAccess();
+
+			RTPTime::Wait(RTPTime(0, 200));
+		}
+		return 0;
+	}
+
+	RTPSession &sess;
+	vector<uint32_t> senderssrcs;
+	bool retrievepackets;
+	RTPAtomicInteger stop;
+	int numpackets, numlookups, numerrors;
+	double maxwait;
+};
+
+int main(void)
+{
+	const int numsenders = 4;
+	const int numreaders = 3;
+	uint8_t payload[160] = { 0 };
+	RTPLoopbackNetwork network;
+	SlowRTCPSession receiver;
+	RTPSession senders[numsenders];
+	vector<uint32_t> ssrcs;
+
+	for (int i = 0 ; i < numsenders ; i++)
+	{
+		RTPSessionParams sessParams;
+		RTPLoopbackTransmissionParams transParams(&network);
+
+		sessParams.SetOwnTimestampUnit(1.0/8000.0);
+		sessParams.SetUsePollThread(false);
+		transParams.SetPortbase((uint16_t)(5000+i*2));
+		checkerror(senders[i].Create(sessParams, &transParams, RTPTransmitter::LoopbackProto));
+		checkerror(senders[i].AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+		senders[i].SetDefaultPayloadType(96);
+		senders[i].SetDefaultMark(false);
+		senders[i].SetDefaultTimestampIncrement(160);
+		ssrcs.push_back(senders[i].GetLocalSSRC());
+	}
+
+	// The receiver sends RTCP packets as often as it is allowed to
+
+	RTPSessionParams sessParams;
+	RTPLoopbackTransmissionParams transParams(&network);
+
+	sessParams.SetOwnTimestampUnit(1.0/8000.0);
+	sessParams.SetMinimumRTCPTransmissionInterval(RTPTime(1, 0));
+	sessParams.SetSessionBandwidth(1000000.0);
+#ifdef RTP_SUPPORT_PROBATION
+	sessParams.SetProbationType(RTPSources::NoProbation);
+#endif // RTP_SUPPORT_PROBATION
+	transParams.SetPortbase(6000);
+	checkerror(receiver.Create(sessParams, &transParams, RTPTransmitter::LoopbackProto));
+
+	vector<ReaderThread *> readers;
+
+	for (int i = 0 ; i < numreaders ; i++)
+	{
+		readers.push_back(new ReaderThread(receiver, ssrcs, (i == 0)));
+		if (readers[i]->Start() < 0)
+		{
+			cerr << "Unable to start reader thread" << endl;
+			return -1;
+		}
+	}
+
+	const int numrounds = 2000;
+	RTPTime start = RTPTime::CurrentTime();
+
+	for (int r = 0 ; r < numrounds ; r++)
+	{
+		for (int i = 0 ; i < numsenders ; i++)
+			checkerror(senders[i].SendPacket(payload, sizeof(payload)));
+		RTPTime::Wait(RTPTime(0, 1000));
+	}
+
+	// Give the poll thread some time to process the last packets
+
+	RTPTime::Wait(RTPTime(0.2));
+	for (int i = 0 ; i < numreaders ; i++)
+		readers[i]->Stop();
+
+	RTPTime elapsed = RTPTime::CurrentTime();
+	elapsed -= start;
+
+	double maxwait = 0;
+	int numerrors = 0;
+	int numlookups = 0;
+
+	for (int i = 0 ; i < numreaders ; i++)
+	{
+		if (readers[i]->GetMaximumWait() > maxwait)
+			maxwait = readers[i]->GetMaximumWait();
+		numerrors += readers[i]->GetNumberOfErrors();
+		numlookups += readers[i]->GetNumberOfLookups();
+	}
+
+	int numreceived = readers[0]->GetNumberOfPackets();
+
+	cout << "Received " << numreceived << " of " << numrounds*numsenders << " packets in " << elapsed.GetDouble() << " s" << endl;
+	cout << "Sent " << receiver.GetNumberOfRTCPPackets() << " RTCP packets, taking " << RTCPSENDDELAY_MS << " ms each" << endl;
+	cout << numlookups << " source lookups, longest wait for the sources lock: " << maxwait*1000.0 << " ms" << endl;
+
+	bool ok = (numerrors == 0 && numreceived == numrounds*numsenders && receiver.GetNumberOfRTCPPackets() > 0);
+
+	// Sending RTCP data must not block the readers; half of the delay
+	// leaves plenty of room for scheduling noise
+	if (maxwait*1000.0 >= RTCPSENDDELAY_MS/2.0)
+	{
+		cerr << "Readers had to wait for RTCP packets to be sent" << endl;
+		ok = false;
+	}
+
+	for (int i = 0 ; i < numreaders ; i++)
+		delete readers[i];
+	receiver.Destroy();
+	for (int i = 0 ; i < numsenders ; i++)
+		senders[i].Destroy();
+
+	if (!ok)
+	{
+		cerr << "FAILED" << endl;
+		return -1;
+	}
+	return 0;
+}
+
+#else
+
+int main(void)
+{
+	cout << "Thread support is required for this test" << endl;
+	return 0;
+}
+
+#endif // RTP_SUPPORT_THREAD
@@ -0,0 +1,361 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtpsourcesnapshot.h"
+#include "rtppacket.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <set>
+
+#ifdef RTP_SUPPORT_THREAD
+	#include <jthread/jthread.h>
+#endif // RTP_SUPPORT_THREAD
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that several source iterators can be used at the same time, and
+// that snapshots of the source table contain the same statistics as the
+// table itself, also after only some of the sources changed; with thread
+// support, snapshots are taken while the poll thread is processing packets
+
+// Every packet must count, so the sources are validated right away
+RTPSessionParams noprobationparams(bool pollthread)
+{
+	RTPSessionParams sessParams = loopbacksessionparams(pollthread);
+
+#ifdef RTP_SUPPORT_PROBATION
+	sessParams.SetProbationType(RTPSources::NoProbation);
+#endif // RTP_SUPPORT_PROBATION
+	return sessParams;
+}
+
+void sendpackets(vector<RTPSession *> &senders, int first, int num, int numpackets)
+{
+	uint8_t payload[160] = { 0 };
+
+	for (int i = first ; i < first+num ; i++)
+	{
+		for (int j = 0 ; j < numpackets ; j++)
+			checkerror(senders[i]->SendPacket(payload, sizeof(payload)));
+	}
+}
+
+bool checkiterators(RTPSession &receiver, vector<RTPSession *> &senders, int numsenders)
+{
+	receiver.BeginDataAccess();
+
+	// Every pair of sources must be visited once by two nested loops, even
+	// if the current source is changed inside them
+
+	RTPSources::Iterator outer, inner;
+	int numsources = 0, numpairs = 0;
+	bool ok = true;
+
+	for (bool found = receiver.GotoFirstSource(outer) ; found ; found = receiver.GotoNextSource(outer))
+	{
+		uint32_t ssrc = receiver.GetSourceInfo(outer)->GetSSRC();
+
+		numsources++;
+		for (bool found2 = receiver.GotoFirstSource(inner) ; found2 ; found2 = receiver.GotoNextSource(inner))
+			numpairs++;
+		if (receiver.GotoFirstSource())
+		{
+			while (receiver.GotoNextSource())
+				;
+		}
+		if (receiver.GetSourceInfo(outer)->GetSSRC() != ssrc)
+			ok = false;
+	}
+
+	int numbackward = 0;
+
+	if (receiver.GotoFirstSource(outer))
+	{
+		RTPSources::Iterator last = outer;
+
+		while (receiver.GotoNextSource(outer))
+			last = outer;
+		numbackward++;
+		while (receiver.GotoPreviousSource(last))
+			numbackward++;
+	}
+	receiver.EndDataAccess();
+
+	cout << numsources << " sources, " << numpairs << " pairs, " << numbackward << " visited backward" << endl;
+	if (!ok || numsources != numsenders+1 || numpairs != numsources*numsources || numbackward != numsources)
+		return false;
+
+	// An iterator must keep pointing to the same source when many sources
+	// are added to the table
+
+	receiver.BeginDataAccess();
+	receiver.GotoFirstSource(outer);
+	uint32_t ssrc = receiver.GetSourceInfo(outer)->GetSSRC();
+	receiver.EndDataAccess();
+
+	sendpackets(senders, numsenders, (int)senders.size()-numsenders, 1);
+	checkerror(receiver.Poll());
+
+	receiver.BeginDataAccess();
+	RTPSourceData *srcdat = receiver.GetSourceInfo(outer);
+	if (srcdat == 0 || srcdat->GetSSRC() != ssrc)
+		ok = false;
+
+	set<uint32_t> visited;
+
+	visited.insert(ssrc);
+	while (receiver.GotoNextSource(outer))
+	{
+		if (!visited.insert(receiver.GetSourceInfo(outer)->GetSSRC()).second)
+			ok = false;
+	}
+	receiver.EndDataAccess();
+	return ok;
+}
+
+// Compares the snapshot to the source table of the session
+bool comparesnapshot(RTPSession &receiver, RTPSourceSnapshot *snapshot)
+{
+	bool ok = true;
+
+	receiver.BeginDataAccess();
+	for (int i = 0 ; ok && i < snapshot->GetNumberOfSources() ; i++)
+	{
+		const RTPSourceStatistics &stats = snapshot->GetSource(i);
+		RTPSourceData *srcdat = receiver.GetSourceInfo(stats.GetSSRC());
+
+		if (srcdat == 0 || (uint32_t)srcdat->INF_GetNumPacketsReceived() != stats.INF_GetNumPacketsReceived() ||
+		    srcdat->INF_GetExtendedHighestSequenceNumber() != stats.INF_GetExtendedHighestSequenceNumber() ||
+		    srcdat->IsOwnSSRC() != stats.IsOwnSSRC() || srcdat->IsSender() != stats.IsSender())
+			ok = false;
+	}
+	int numsources = 0;
+	if (receiver.GotoFirstSource())
+	{
+		do
+		{
+			numsources++;
+		} while (receiver.GotoNextSource());
+	}
+	receiver.EndDataAccess();
+	return (ok && snapshot->GetNumberOfSources() == numsources);
+}
+
+uint32_t countpackets(RTPSourceSnapshot *snapshot)
+{
+	uint32_t count = 0;
+
+	for (int i = 0 ; i < snapshot->GetNumberOfSources() ; i++)
+		count += snapshot->GetSource(i).INF_GetNumPacketsReceived();
+	return count;
+}
+
+bool checksnapshot(RTPSession &receiver, vector<RTPSession *> &senders)
+{
+	// The first snapshot is made right away
+	RTPSourceSnapshot *snapshot = receiver.GetSourceSnapshot();
+
+	if (snapshot == 0 || !comparesnapshot(receiver, snapshot))
+	{
+		receiver.ReleaseSourceSnapshot(snapshot);
+		return false;
+	}
+
+	// Nothing changed, so the same snapshot is still the most recent one
+
+	RTPSourceSnapshot *snapshot2 = receiver.GetSourceSnapshot();
+	bool ok = (snapshot2 == snapshot);
+
+	receiver.ReleaseSourceSnapshot(snapshot2);
+
+	// When only a few sources change, Poll publishes a new snapshot with
+	// their new statistics; the old one must stay the same until released
+
+	uint32_t count = countpackets(snapshot);
+
+	sendpackets(senders, 3, 2, 1);
+	sendpackets(senders, 40, 1, 1);
+	checkerror(receiver.Poll());
+
+	snapshot2 = receiver.GetSourceSnapshot();
+	ok = (ok && snapshot2 != 0 && snapshot2 != snapshot && comparesnapshot(receiver, snapshot2) &&
+	      countpackets(snapshot) == count && countpackets(snapshot2) == count+3);
+	receiver.ReleaseSourceSnapshot(snapshot);
+
+	// Once the old snapshot is released, the next update can reuse its records
+
+	sendpackets(senders, 0, 1, 1);
+	checkerror(receiver.Poll());
+
+	RTPSourceSnapshot *snapshot3 = receiver.GetSourceSnapshot();
+
+	ok = (ok && snapshot3 != 0 && snapshot3 != snapshot2 && comparesnapshot(receiver, snapshot3) &&
+	      countpackets(snapshot2) == count+3 && countpackets(snapshot3) == count+4);
+	receiver.ReleaseSourceSnapshot(snapshot2);
+	receiver.ReleaseSourceSnapshot(snapshot3);
+	return ok;
+}
+
+#ifdef RTP_SUPPORT_THREAD
+
+// Keeps taking snapshots while the poll thread of the session is processing
+// packets; the number of received packets must never decrease
+class MonitorThread : public jthread::JThread
+{
+public:
+	MonitorThread(RTPSession &s) : sess(s), stop(0), numsnapshots(0), numerrors(0)
+	{
+	}
+
+	~MonitorThread()
+	{
+		Stop();
+	}
+
+	void Stop()
+	{
+		stop.Set(1);
+		while (IsRunning())
+			RTPTime::Wait(RTPTime(0.01));
+	}
+
+	int GetNumberOfSnapshots() const						{ return numsnapshots; }
+	int GetNumberOfErrors() const							{ return numerrors; }
+private:
+	void *Thread()
+	{
+		JThread::ThreadStarted();
+
+		RTPSourceSnapshot *prevsnapshot = 0;
+		uint32_t prevcount = 0;
+
+		while (!stop.Get())
+		{
+			RTPSourceSnapshot *snapshot = sess.GetSourceSnapshot();
+
+			if (snapshot != 0 && snapshot != prevsnapshot)
+			{
+				uint32_t count = 0;
+
+				for (int i = 0 ; i < snapshot->GetNumberOfSources() ; i++)
+					count += snapshot->GetSource(i).INF_GetNumPacketsReceived();
+				if (count < prevcount)
+					numerrors++;
+				prevcount = count;
+				numsnapshots++;
+			}
+			sess.ReleaseSourceSnapshot(prevsnapshot);
+			prevsnapshot = snapshot;
+			RTPTime::Wait(RTPTime(0, 500));
+		}
+		sess.ReleaseSourceSnapshot(prevsnapshot);
+		return 0;
+	}
+
+	RTPSession &sess;
+	RTPAtomicInteger stop;
+	int numsnapshots, numerrors;
+};
+
+bool checkthreads(RTPLoopbackNetwork &network, vector<RTPSession *> &senders)
+{
+	RTPSession receiver;
+
+	createsession(receiver, network, 7000, noprobationparams(true));
+	for (size_t i = 0 ; i < senders.size() ; i++)
+	{
+		senders[i]->ClearDestinations();
+		checkerror(senders[i]->AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 7000)));
+	}
+
+	MonitorThread monitor(receiver);
+
+	if (monitor.Start() < 0)
+	{
+		cerr << "Unable to start monitor thread" << endl;
+		return false;
+	}
+
+	const int numrounds = 500;
+
+	for (int r = 0 ; r < numrounds ; r++)
+	{
+		sendpackets(senders, 0, (int)senders.size(), 1);
+		RTPTime::Wait(RTPTime(0, 1000));
+	}
+	RTPTime::Wait(RTPTime(0.2));
+	monitor.Stop();
+
+	checkerror(receiver.UpdateSourceSnapshot());
+
+	RTPSourceSnapshot *snapshot = receiver.GetSourceSnapshot();
+	uint32_t count = 0;
+
+	for (int i = 0 ; i < snapshot->GetNumberOfSources() ; i++)
+		count += snapshot->GetSource(i).INF_GetNumPacketsReceived();
+	receiver.ReleaseSourceSnapshot(snapshot);
+
+	cout << monitor.GetNumberOfSnapshots() << " snapshots taken, " << count << " of " << numrounds*senders.size()
+	     << " packets counted" << endl;
+
+	bool ok = (monitor.GetNumberOfErrors() == 0 && monitor.GetNumberOfSnapshots() > 0 && count == numrounds*senders.size());
+
+	receiver.Destroy();
+	return ok;
+}
+
+#endif // RTP_SUPPORT_THREAD
+
+int main(void)
+{
+	const int numsenders = 20;
+	const int numextra = 200;
+	RTPLoopbackNetwork network;
+	RTPSession receiver;
+	vector<RTPSession *> senders(numsenders+numextra);
+
+	createsession(receiver, network, 6000, noprobationparams(false));
+	for (int i = 0 ; i < numsenders+numextra ; i++)
+	{
+		senders[i] = new RTPSession();
+		createsession(*senders[i], network, (uint16_t)(8000+i*2), noprobationparams(false));
+		checkerror(senders[i]->AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+	}
+
+	sendpackets(senders, 0, numsenders, 5);
+	checkerror(receiver.Poll());
+
+	if (!checkiterators(receiver, senders, numsenders))
+	{
+		cerr << "Iterator check FAILED" << endl;
+		return -1;
+	}
+	if (!checksnapshot(receiver, senders))
+	{
+		cerr << "Snapshot check FAILED" << endl;
+		return -1;
+	}
+
+#ifdef RTP_SUPPORT_THREAD
+	if (!checkthreads(network, senders))
+	{
+		cerr << "Thread check FAILED" << endl;
+		return -1;
+	}
+#endif // RTP_SUPPORT_THREAD
+
+	receiver.Destroy();
+	for (size_t i = 0 ; i < senders.size() ; i++)
+	{
+		senders[i]->Destroy();
+		delete senders[i];
+	}
+	cout << "All checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include "rtpsession.h"
+#include "rtpsessionparams.h"
+#include "rtploopbacktransmitter.h"
+#include "rtpipv4address.h"
+#include "rtperrors.h"
+#include "rtpsourcedata.h"
+#include "rtppacket.h"
+#include "testcommon.h"
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <map>
+
+using namespace jrtplib;
+using namespace std;
+
+// Checks that GotoFirstSourceWithData and friends find exactly the sources
+// which have packets when most of the known sources are idle, and measures
+// how long it takes to find them
+
+// Counts the packets per source; if maxpersource is positive, only that
+// many packets are taken from each source
+map<uint32_t,int> getpackets(RTPSession &sess, int maxpersource)
+{
+	map<uint32_t,int> counts;
+	bool found = sess.GotoFirstSourceWithData();
+
+	while (found)
+	{
+		uint32_t ssrc = sess.GetCurrentSourceInfo()->GetSSRC();
+		RTPPacket *pack;
+		int num = 0;
+
+		if (counts.find(ssrc) != counts.end())
+		{
+			cerr << "Source " << ssrc << " was visited twice" << endl;
+			exit(-1);
+		}
+		while ((maxpersource <= 0 || num < maxpersource) && (pack = sess.GetNextPacket()) != 0)
+		{
+			num++;
+			sess.DeletePacket(pack);
+		}
+		if (num == 0)
+		{
+			cerr << "Source " << ssrc << " has no data" << endl;
+			exit(-1);
+		}
+		counts[ssrc] = num;
+		found = sess.GotoNextSourceWithData();
+	}
+	return counts;
+}
+
+int main(void)
+{
+	const int numsenders = 200;
+	uint8_t payload[160] = { 0 };
+	RTPLoopbackNetwork network;
+	RTPSession receiver;
+	vector<RTPSession *> senders(numsenders);
+
+	createsession(receiver, network, 6000);
+	for (int i = 0 ; i < numsenders ; i++)
+	{
+		senders[i] = new RTPSession();
+		createsession(*senders[i], network, (uint16_t)(8000+i*2));
+		checkerror(senders[i]->AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+	}
+
+	// Let every sender become a validated source
+
+	for (int j = 0 ; j < 3 ; j++)
+	{
+		for (int i = 0 ; i < numsenders ; i++)
+			checkerror(senders[i]->SendPacket(payload, sizeof(payload)));
+	}
+	checkerror(receiver.Poll());
+
+	receiver.BeginDataAccess();
+	map<uint32_t,int> counts = getpackets(receiver, 0);
+	receiver.EndDataAccess();
+	if ((int)counts.size() != numsenders)
+	{
+		cerr << "Got data from " << counts.size() << " sources, expected " << numsenders << endl;
+		return -1;
+	}
+
+	// Only a few senders remain active, the order in which they send
+	// differs from the order in which they were added
+
+	int active[] = { 150, 3, 77, 199 };
+	int numactive = sizeof(active)/sizeof(int);
+	map<uint32_t,int> expected;
+
+	for (int i = 0 ; i < numactive ; i++)
+	{
+		for (int j = 0 ; j <= i ; j++)
+			checkerror(senders[active[i]]->SendPacket(payload, sizeof(payload)));
+		expected[senders[active[i]]->GetLocalSSRC()] = i+1;
+	}
+	checkerror(receiver.Poll());
+
+	// The sources are visited in the order in which they received data,
+	// both forward and backward
+
+	receiver.BeginDataAccess();
+	bool ordered = receiver.GotoFirstSourceWithData();
+	for (int i = 1 ; ordered && i < numactive ; i++)
+		ordered = (receiver.GotoNextSourceWithData() && receiver.GetCurrentSourceInfo()->GetSSRC() == senders[active[i]]->GetLocalSSRC());
+	for (int i = numactive-2 ; ordered && i >= 0 ; i--)
+		ordered = (receiver.GotoPreviousSourceWithData() && receiver.GetCurrentSourceInfo()->GetSSRC() == senders[active[i]]->GetLocalSSRC());
+	ordered = ordered && !receiver.GotoPreviousSourceWithData();
+	receiver.EndDataAccess();
+	if (!ordered)
+	{
+		cerr << "Sources are not visited in the right order" << endl;
+		return -1;
+	}
+
+	// Take one packet per source, then get the rest
+
+	receiver.BeginDataAccess();
+	counts = getpackets(receiver, 1);
+	receiver.EndDataAccess();
+	if (counts.size() != expected.size())
+	{
+		cerr << "Got data from " << counts.size() << " sources, expected " << expected.size() << endl;
+		return -1;
+	}
+
+	receiver.BeginDataAccess();
+	counts = getpackets(receiver, 0);
+	bool more = receiver.GotoFirstSourceWithData();
+	receiver.EndDataAccess();
+	if (more)
+	{
+		cerr << "Sources still have data" << endl;
+		return -1;
+	}
+	for (map<uint32_t,int>::const_iterator it = expected.begin() ; it != expected.end() ; ++it)
+	{
+		int num = (counts.find(it->first) == counts.end())?0:counts[it->first];
+
+		if (num != it->second-1)
+		{
+			cerr << "Got " << num << " remaining packets from " << it->first << ", expected " << it->second-1 << endl;
+			return -1;
+		}
+	}
+
+	// Continuing from a source selected with GotoFirstSource must also work
+
+	checkerror(senders[active[0]]->SendPacket(payload, sizeof(payload)));
+	checkerror(receiver.Poll());
+	receiver.BeginDataAccess();
+	int numfound = 0;
+	if (receiver.GotoFirstSource())
+	{
+		if (receiver.GetCurrentSourceInfo()->HasData())
+			numfound++;
+		while (receiver.GotoNextSourceWithData())
+		{
+			numfound++;
+			receiver.DeletePacket(receiver.GetNextPacket());
+		}
+	}
+	getpackets(receiver, 0);
+	receiver.EndDataAccess();
+	if (numfound != 1)
+	{
+		cerr << "Found " << numfound << " sources with data, expected 1" << endl;
+		return -1;
+	}
+
+#ifdef RTP_SUPPORT_SENDAPP
+	// Packets stored while a source is on probation become available when the
+	// source is validated by its CNAME instead of by a next RTP packet
+
+	RTPSession probationsender;
+
+	createsession(probationsender, network, (uint16_t)(8000+numsenders*2));
+	checkerror(probationsender.AddDestination(RTPIPv4Address(RTPLOOPBACKTRANS_DEFAULTBINDIP, 6000)));
+	checkerror(probationsender.SendPacket(payload, sizeof(payload)));
+	checkerror(receiver.Poll());
+	receiver.BeginDataAccess();
+	more = receiver.GotoFirstSourceWithData();
+	receiver.EndDataAccess();
+	if (more)
+	{
+		cerr << "Source on probation should not have data yet" << endl;
+		return -1;
+	}
+
+	// The compound packet with the APP packet also contains the CNAME
+	checkerror(probationsender.SendRTCPAPPPacket(0, (const uint8_t *)"TEST", 0, 0));
+	checkerror(receiver.Poll());
+	receiver.BeginDataAccess();
+	counts = getpackets(receiver, 0);
+	receiver.EndDataAccess();
+	if (counts.size() != 1 || counts[probationsender.GetLocalSSRC()] != 1)
+	{
+		cerr << "Packet of source validated by its CNAME was not found" << endl;
+		return -1;
+	}
+	probationsender.Destroy();
+#endif // RTP_SUPPORT_SENDAPP
+	cout << "Source iteration checks passed" << endl;
+
+	// One source sends while all the others stay idle
+
+	const int numrounds = 100000;
+	RTPTime itertime(0, 0);
+
+	for (int r = 0 ; r < numrounds ; r++)
+	{
+		checkerror(senders[active[r%numactive]]->SendPacket(payload, sizeof(payload)));
+		checkerror(receiver.Poll());
+
+		RTPTime start = RTPTime::CurrentTime();
+
+		receiver.BeginDataAccess();
+		counts = getpackets(receiver, 0);
+		receiver.EndDataAccess();
+
+		RTPTime t = RTPTime::CurrentTime();
+		t -= start;
+		itertime += t;
+		if (counts.size() != 1)
+		{
+			cerr << "Got data from " << counts.size() << " sources, expected 1" << endl;
+			return -1;
+		}
+	}
+	cout << "Finding one active source among " << numsenders << ": " << itertime.GetDouble()*1e9/numrounds << " ns" << endl;
+
+	for (int i = 0 ; i < numsenders ; i++)
+	{
+		senders[i]->Destroy();
+		delete senders[i];
+	}
+	receiver.Destroy();
+	return 0;
+}
@@ -0,0 +1,16 @@
+int main(void)
+{
+	volatile int x = 0;
+	int expected = 0;
+	int *volatile p = 0;
+	int *q = 0;
+
+	__atomic_fetch_add(&x, 1, __ATOMIC_SEQ_CST);
+	__atomic_exchange_n(&x, 2, __ATOMIC_SEQ_CST);
+	__atomic_compare_exchange_n(&x, &expected, 3, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&p, q, __ATOMIC_SEQ_CST);
+	q = __atomic_exchange_n(&p, q, __ATOMIC_SEQ_CST);
+	q = __atomic_load_n(&p, __ATOMIC_SEQ_CST);
+
+	return __atomic_load_n(&x, __ATOMIC_SEQ_CST) + (q != 0);
+}
@@ -0,0 +1,33 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+
+int main(void)
+{
+	struct tpacket_req3 req;
+	struct tpacket_block_desc *desc = 0;
+	struct tpacket3_hdr *hdr = 0;
+	struct sock_fprog prog;
+	int version = TPACKET_V3;
+
+	req.tp_retire_blk_tov = 0;
+	prog.len = 0;
+	prog.filter = 0;
+	(void)desc;
+	(void)hdr;
+	(void)version;
+
+	int s = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	setsockopt(s, SOL_PACKET, PACKET_VERSION, &version, sizeof(int));
+	setsockopt(s, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+	setsockopt(s, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+	mmap(0, 0, PROT_READ|PROT_WRITE, MAP_SHARED, s, 0);
+	__sync_synchronize();
+
+	return (int)if_nametoindex("lo");
+}
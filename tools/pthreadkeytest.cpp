@@ -0,0 +1,14 @@
+#include <pthread.h>
+
+static void destructor(void *)
+{
+}
+
+int main(void)
+{
+	pthread_key_t key;
+
+	if (pthread_key_create(&key, destructor) != 0)
+		return 1;
+	return pthread_setspecific(key, &key);
+}
@@ -0,0 +1,13 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+int main(void)
+{
+	struct mmsghdr msgs[2];
+	struct iovec iov[2];
+
+	msgs[0].msg_hdr.msg_iov = iov;
+	msgs[0].msg_hdr.msg_iovlen = 2;
+	return sendmmsg(-1, msgs, 2, 0);
+}
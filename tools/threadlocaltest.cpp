@@ -0,0 +1,9 @@
+static __thread int x = 0;
+static __thread void *p[4];
+
+int main(void)
+{
+	x++;
+	p[x] = &x;
+	return (p[1] == &x)?0:1;
+}